@@ -0,0 +1,98 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/allocation_counter.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Sanitizers interpose malloc themselves.
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer) || \
+    __has_feature(thread_sanitizer)
+#define OPENCENSUS_SANITIZER 1
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define OPENCENSUS_SANITIZER 1
+#endif
+
+#if defined(__GLIBC__) && !defined(OPENCENSUS_SANITIZER)
+#define OPENCENSUS_COUNT_MALLOC 1
+#endif
+
+namespace {
+
+// initial-exec, so that reading it never calls __tls_get_addr, which may
+// itself allocate.
+__attribute__((tls_model("initial-exec"))) thread_local int64_t
+    thread_allocations = 0;
+
+}  // namespace
+
+#ifdef OPENCENSUS_COUNT_MALLOC
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t size);
+
+// libstdc++'s operator new calls malloc, so this counts both.
+void* malloc(size_t size) {
+  ++thread_allocations;
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+  ++thread_allocations;
+  return __libc_calloc(n, size);
+}
+
+void* realloc(void* p, size_t size) {
+  ++thread_allocations;
+  return __libc_realloc(p, size);
+}
+
+}  // extern "C"
+
+#else
+
+void* operator new(size_t size) {
+  ++thread_allocations;
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+#endif  // OPENCENSUS_COUNT_MALLOC
+
+namespace opencensus {
+namespace common {
+
+AllocationCounter::AllocationCounter() : start_(thread_allocations) {}
+
+int64_t AllocationCounter::count() const {
+  return thread_allocations - start_;
+}
+
+void AllocationCounter::Reset() { start_ = thread_allocations; }
+
+}  // namespace common
+}  // namespace opencensus
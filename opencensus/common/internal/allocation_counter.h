@@ -0,0 +1,49 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_COMMON_INTERNAL_ALLOCATION_COUNTER_H_
+#define OPENCENSUS_COMMON_INTERNAL_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+namespace opencensus {
+namespace common {
+
+// Counts the heap allocations made by the current thread while it is in
+// scope, for tests that hold hot paths to an allocation budget:
+//
+//   AllocationCounter counter;
+//   span.End();
+//   EXPECT_EQ(0, counter.count());
+//
+// Linking the allocation_counter target replaces the global operator new and,
+// with glibc and no sanitizer, malloc, calloc and realloc, with versions that
+// count. Allocations on other threads, e.g. exporter threads, aren't counted.
+class AllocationCounter final {
+ public:
+  AllocationCounter();
+
+  // The number of allocations since construction or the last Reset().
+  int64_t count() const;
+
+  void Reset();
+
+ private:
+  int64_t start_;
+};
+
+}  // namespace common
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_COMMON_INTERNAL_ALLOCATION_COUNTER_H_
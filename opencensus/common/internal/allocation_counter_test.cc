@@ -0,0 +1,49 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/allocation_counter.h"
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+TEST(AllocationCounterTest, CountsOperatorNew) {
+  AllocationCounter counter;
+  EXPECT_EQ(0, counter.count());
+  auto p = std::make_unique<int>(1);
+  EXPECT_EQ(1, counter.count());
+  auto s = std::make_unique<std::string>(100, 'x');  // And its buffer.
+  EXPECT_EQ(3, counter.count());
+  counter.Reset();
+  EXPECT_EQ(0, counter.count());
+}
+
+TEST(AllocationCounterTest, IgnoresOtherThreads) {
+  AllocationCounter counter;
+  std::unique_ptr<int> p;
+  std::thread t([&p]() { p = std::make_unique<int>(1); });
+  const int64_t after_spawn = counter.count();
+  t.join();
+  EXPECT_EQ(after_spawn, counter.count());
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace opencensus
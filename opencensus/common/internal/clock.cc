@@ -0,0 +1,291 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/clock.h"
+
+#include <time.h>
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define OPENCENSUS_HAVE_TSC 1
+#endif
+
+namespace opencensus {
+namespace common {
+
+namespace {
+
+absl::Time WallNow() { return absl::Now(); }
+
+#ifdef CLOCK_REALTIME_COARSE
+absl::Time CoarseNow() {
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+  return absl::TimeFromTimespec(ts);
+}
+#endif
+
+#ifdef OPENCENSUS_HAVE_TSC
+
+// How often the TSC clock is recalibrated against the wall clock.
+constexpr absl::Duration kRecalibrationInterval = absl::Seconds(1);
+// The largest error, relative to the wall clock, that recalibration corrects
+// by slewing over the next interval rather than by stepping. Larger errors
+// mean the wall clock itself was stepped.
+constexpr absl::Duration kMaxSlew = absl::Microseconds(500);
+
+// Converts TSC ticks to wall time as base_nanos + (ticks - base_ticks) *
+// nanos_per_tick, plus slew_nanos_per_tick for each of the first slew_ticks
+// ticks. The conversion is published under a sequence lock so that Now()
+// doesn't take a mutex; a reader that sees an odd or changed sequence number
+// retries.
+class TscClock {
+ public:
+  static TscClock* Get() {
+    static TscClock* global_tsc_clock = new TscClock;
+    return global_tsc_clock;
+  }
+
+  static bool Available() {
+    unsigned int eax, ebx, ecx, edx;
+    // CPUID.80000007H:EDX[8] is the invariant TSC flag: the TSC ticks at a
+    // constant rate regardless of frequency scaling and sleep states.
+    return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) &&
+           (edx & (1u << 8)) != 0;
+  }
+
+  absl::Time Now() {
+    const int64_t ticks = __rdtsc();
+    Conversion conversion;
+    while (true) {
+      const uint32_t seq = seq_.load(std::memory_order_acquire);
+      conversion.base_ticks = base_ticks_.load(std::memory_order_relaxed);
+      conversion.base_nanos = base_nanos_.load(std::memory_order_relaxed);
+      conversion.nanos_per_tick =
+          nanos_per_tick_.load(std::memory_order_relaxed);
+      conversion.slew_nanos_per_tick =
+          slew_nanos_per_tick_.load(std::memory_order_relaxed);
+      conversion.slew_ticks = slew_ticks_.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if ((seq & 1) == 0 && seq == seq_.load(std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    if (ticks - conversion.base_ticks >
+        recalibration_ticks_.load(std::memory_order_relaxed)) {
+      MaybeRecalibrate();
+    }
+    return absl::FromUnixNanos(conversion.ToNanos(ticks));
+  }
+
+ private:
+  struct Sample {
+    int64_t ticks;
+    int64_t nanos;
+  };
+
+  struct Conversion {
+    int64_t ToNanos(int64_t ticks) const {
+      const int64_t elapsed = ticks - base_ticks;
+      const int64_t slewed = elapsed < slew_ticks ? elapsed : slew_ticks;
+      return base_nanos + static_cast<int64_t>(elapsed * nanos_per_tick +
+                                               slewed * slew_nanos_per_tick);
+    }
+
+    int64_t base_ticks;
+    int64_t base_nanos;
+    double nanos_per_tick;
+    double slew_nanos_per_tick;
+    int64_t slew_ticks;
+  };
+
+  // Calibrates over a short sleep. Later recalibrations measure the rate over
+  // the whole time since this first sample, so it converges.
+  TscClock() : first_(TakeSample()) {
+    absl::SleepFor(absl::Milliseconds(10));
+    absl::MutexLock l(&mu_);
+    Recalibrate();
+  }
+
+  static Sample TakeSample() {
+    // Bracket the wall clock read, so the sample is exact to within the time
+    // one read takes.
+    const int64_t before = __rdtsc();
+    const int64_t nanos = absl::GetCurrentTimeNanos();
+    const int64_t after = __rdtsc();
+    return {before + (after - before) / 2, nanos};
+  }
+
+  void MaybeRecalibrate() LOCKS_EXCLUDED(mu_) {
+    // Only one caller recalibrates; the others carry on with the old values.
+    if (!mu_.TryLock()) return;
+    Recalibrate();
+    mu_.Unlock();
+  }
+
+  // Measures the TSC rate again. Rather than snapping to the wall clock,
+  // which would make Now() jump by the drift since the last calibration,
+  // the new conversion starts where the old one is at the sample, and runs
+  // slightly fast or slow until it has caught up with the wall clock at the
+  // next recalibration.
+  void Recalibrate() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const Sample sample = TakeSample();
+    const int64_t recalibration_ticks =
+        recalibration_ticks_.load(std::memory_order_relaxed);
+    const Conversion old{base_ticks_.load(std::memory_order_relaxed),
+                         base_nanos_.load(std::memory_order_relaxed),
+                         nanos_per_tick_.load(std::memory_order_relaxed),
+                         slew_nanos_per_tick_.load(std::memory_order_relaxed),
+                         slew_ticks_.load(std::memory_order_relaxed)};
+    if (sample.ticks - old.base_ticks <= recalibration_ticks) {
+      return;  // Another caller just did it.
+    }
+    const double nanos_per_tick =
+        static_cast<double>(sample.nanos - first_.nanos) /
+        (sample.ticks - first_.ticks);
+    const int64_t interval_ticks = static_cast<int64_t>(
+        absl::ToDoubleNanoseconds(kRecalibrationInterval) / nanos_per_tick);
+    Conversion conversion{sample.ticks, sample.nanos, nanos_per_tick, 0, 0};
+    if (recalibration_ticks >= 0) {
+      const int64_t nanos = old.ToNanos(sample.ticks);
+      const int64_t error = sample.nanos - nanos;
+      if (error < absl::ToInt64Nanoseconds(kMaxSlew) &&
+          error > -absl::ToInt64Nanoseconds(kMaxSlew)) {
+        conversion.base_nanos = nanos;
+        conversion.slew_nanos_per_tick =
+            static_cast<double>(error) / interval_ticks;
+        conversion.slew_ticks = interval_ticks;
+      }
+    }
+    const uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    base_ticks_.store(conversion.base_ticks, std::memory_order_relaxed);
+    base_nanos_.store(conversion.base_nanos, std::memory_order_relaxed);
+    nanos_per_tick_.store(conversion.nanos_per_tick,
+                          std::memory_order_relaxed);
+    slew_nanos_per_tick_.store(conversion.slew_nanos_per_tick,
+                               std::memory_order_relaxed);
+    slew_ticks_.store(conversion.slew_ticks, std::memory_order_relaxed);
+    seq_.store(seq + 2, std::memory_order_release);
+    recalibration_ticks_.store(interval_ticks, std::memory_order_relaxed);
+  }
+
+  absl::Mutex mu_;
+  const Sample first_;
+  std::atomic<uint32_t> seq_{0};
+  std::atomic<int64_t> base_ticks_{0};
+  std::atomic<int64_t> base_nanos_{0};
+  std::atomic<double> nanos_per_tick_{0};
+  std::atomic<double> slew_nanos_per_tick_{0};
+  std::atomic<int64_t> slew_ticks_{0};
+  // -1 until calibrated, so that Recalibrate() always runs the first time.
+  std::atomic<int64_t> recalibration_ticks_{-1};
+};
+
+absl::Time TscNow() { return TscClock::Get()->Now(); }
+
+#endif  // OPENCENSUS_HAVE_TSC
+
+// The source selected by SetSource(), and the virtual clock, if any.
+std::atomic<Clock::Source> selected_source{Clock::Source::kWall};
+std::atomic<absl::Time (*)()> selected_now{&WallNow};
+std::atomic<VirtualClock*> virtual_clock{nullptr};
+absl::Mutex set_source_mu;
+
+absl::Time VirtualNow() {
+  const VirtualClock* clock = virtual_clock.load(std::memory_order_acquire);
+  // Null if a caller read Clock::now_ just before the clock was removed.
+  if (clock == nullptr) return selected_now.load(std::memory_order_relaxed)();
+  return clock->Now();
+}
+
+}  // namespace
+
+std::atomic<absl::Time (*)()> Clock::now_{&WallNow};
+
+// static
+bool Clock::SetSource(Source source) {
+  absl::Time (*now)() = nullptr;
+  switch (source) {
+    case Source::kWall:
+      now = &WallNow;
+      break;
+    case Source::kTsc:
+#ifdef OPENCENSUS_HAVE_TSC
+      if (TscClock::Available()) {
+        TscClock::Get();  // Calibrate now rather than on first use.
+        now = &TscNow;
+      }
+#endif
+      break;
+    case Source::kCoarse:
+#ifdef CLOCK_REALTIME_COARSE
+      timespec ts;
+      if (clock_gettime(CLOCK_REALTIME_COARSE, &ts) == 0) {
+        now = &CoarseNow;
+      }
+#endif
+      break;
+  }
+  if (now == nullptr) return false;
+  absl::MutexLock l(&set_source_mu);
+  selected_source.store(source, std::memory_order_relaxed);
+  selected_now.store(now, std::memory_order_relaxed);
+  if (virtual_clock.load(std::memory_order_relaxed) == nullptr) {
+    now_.store(now, std::memory_order_release);
+  }
+  return true;
+}
+
+// static
+Clock::Source Clock::source() {
+  return selected_source.load(std::memory_order_relaxed);
+}
+
+// static
+void Clock::SetVirtualClock(VirtualClock* clock) {
+  absl::MutexLock l(&set_source_mu);
+  virtual_clock.store(clock, std::memory_order_release);
+  now_.store(clock != nullptr
+                 ? &VirtualNow
+                 : selected_now.load(std::memory_order_relaxed),
+             std::memory_order_release);
+}
+
+VirtualClock::VirtualClock(absl::Time now) : nanos_(absl::ToUnixNanos(now)) {}
+
+absl::Time VirtualClock::Now() const {
+  return absl::FromUnixNanos(nanos_.load(std::memory_order_relaxed));
+}
+
+void VirtualClock::Set(absl::Time now) {
+  nanos_.store(absl::ToUnixNanos(now), std::memory_order_relaxed);
+}
+
+void VirtualClock::Advance(absl::Duration d) {
+  nanos_.fetch_add(absl::ToInt64Nanoseconds(d), std::memory_order_relaxed);
+}
+
+}  // namespace common
+}  // namespace opencensus
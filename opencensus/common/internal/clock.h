@@ -0,0 +1,101 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_COMMON_INTERNAL_CLOCK_H_
+#define OPENCENSUS_COMMON_INTERNAL_CLOCK_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/time/time.h"
+
+namespace opencensus {
+namespace common {
+
+class VirtualClock;
+
+// Clock is the source of the timestamps of spans, span events and stats.
+//
+// By default it reads the wall clock, like absl::Now(). Programs that create
+// many spans or record many stats can pick a cheaper source at startup,
+// before creating any spans or views:
+//   opencensus::common::Clock::SetSource(
+//       opencensus::common::Clock::Source::kTsc);
+// Changing the source while spans are running can make their timestamps
+// inconsistent, since sources differ slightly in their idea of the time.
+//
+// This class is thread-safe.
+class Clock final {
+ public:
+  enum class Source {
+    // absl::Now().
+    kWall,
+    // The invariant TSC of x86 processors, calibrated against the wall clock
+    // at startup and once a second after that. Reading it costs a few
+    // nanoseconds, without a system call or vDSO. Timestamps follow the wall
+    // clock to within the drift of the TSC over one second, typically
+    // microseconds. Recalibration slews them back to the wall clock over the
+    // following second instead of stepping them, so they don't jump, unless
+    // the wall clock itself was stepped.
+    kTsc,
+    // CLOCK_REALTIME_COARSE on Linux: as cheap as reading a variable, but
+    // only as precise as the kernel tick, typically 1-4ms. Too coarse for
+    // the latency of short spans.
+    kCoarse,
+  };
+
+  // Returns the current time from the selected source.
+  static absl::Time Now() { return now_.load(std::memory_order_relaxed)(); }
+
+  // Selects the source used by Now(). Returns false, leaving the source
+  // unchanged, if it isn't available on this machine. Selecting kTsc takes
+  // about 10ms to calibrate.
+  static bool SetSource(Source source);
+
+  // Returns the selected source.
+  static Source source();
+
+  // Makes Now() return clock->Now() until called with nullptr, which restores
+  // the selected source. The clock must outlive its use. For tests and
+  // benchmarks: this lets long interval windows and stuck span thresholds be
+  // exercised without sleeping.
+  static void SetVirtualClock(VirtualClock* clock);
+
+ private:
+  Clock() = delete;
+
+  static std::atomic<absl::Time (*)()> now_;
+};
+
+// A clock that only moves when told to. Install with Clock::SetVirtualClock().
+// This class is thread-safe.
+class VirtualClock final {
+ public:
+  explicit VirtualClock(absl::Time now = absl::UnixEpoch());
+
+  VirtualClock(const VirtualClock&) = delete;
+  VirtualClock& operator=(const VirtualClock&) = delete;
+
+  absl::Time Now() const;
+  void Set(absl::Time now);
+  void Advance(absl::Duration d);
+
+ private:
+  std::atomic<int64_t> nanos_;
+};
+
+}  // namespace common
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_COMMON_INTERNAL_CLOCK_H_
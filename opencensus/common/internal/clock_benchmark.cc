@@ -0,0 +1,59 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "opencensus/common/internal/clock.h"
+
+namespace {
+
+using ::opencensus::common::Clock;
+
+void BM_AbslNow(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(absl::Now());
+  }
+}
+BENCHMARK(BM_AbslNow);
+
+// Arg is the Clock::Source.
+void BM_ClockNow(benchmark::State& state) {
+  const auto source = static_cast<Clock::Source>(state.range(0));
+  if (!Clock::SetSource(source)) {
+    state.SkipWithError("Source not available.");
+    return;
+  }
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(Clock::Now());
+  }
+  Clock::SetSource(Clock::Source::kWall);
+}
+BENCHMARK(BM_ClockNow)
+    ->Arg(static_cast<int>(Clock::Source::kWall))
+    ->Arg(static_cast<int>(Clock::Source::kTsc))
+    ->Arg(static_cast<int>(Clock::Source::kCoarse));
+
+void BM_VirtualClockNow(benchmark::State& state) {
+  ::opencensus::common::VirtualClock clock;
+  Clock::SetVirtualClock(&clock);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(Clock::Now());
+  }
+  Clock::SetVirtualClock(nullptr);
+}
+BENCHMARK(BM_VirtualClockNow);
+
+}  // namespace
+BENCHMARK_MAIN();
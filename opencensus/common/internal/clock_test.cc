@@ -0,0 +1,111 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/clock.h"
+
+#include <algorithm>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+// Checks that Clock::Now() agrees with the wall clock to within tolerance and
+// doesn't go backwards over a short run.
+void ExpectFollowsWallClock(absl::Duration tolerance) {
+  absl::Time last = absl::InfinitePast();
+  for (int i = 0; i < 1000; ++i) {
+    const absl::Time before = absl::Now();
+    const absl::Time now = Clock::Now();
+    const absl::Time after = absl::Now();
+    EXPECT_LE(before - tolerance, now);
+    EXPECT_GE(after + tolerance, now);
+    EXPECT_LE(last, now);
+    last = now;
+  }
+}
+
+TEST(ClockTest, DefaultsToWallClock) {
+  EXPECT_EQ(Clock::Source::kWall, Clock::source());
+  ExpectFollowsWallClock(absl::ZeroDuration());
+}
+
+TEST(ClockTest, Tsc) {
+  if (!Clock::SetSource(Clock::Source::kTsc)) {
+    EXPECT_EQ(Clock::Source::kWall, Clock::source());
+    return;  // Not an x86 machine with an invariant TSC.
+  }
+  EXPECT_EQ(Clock::Source::kTsc, Clock::source());
+  ExpectFollowsWallClock(absl::Milliseconds(1));
+  // The clock has nanosecond resolution.
+  const absl::Time start = Clock::Now();
+  while (Clock::Now() == start) {
+  }
+  EXPECT_GT(absl::Microseconds(1), Clock::Now() - start);
+  ASSERT_TRUE(Clock::SetSource(Clock::Source::kWall));
+}
+
+TEST(ClockTest, TscDoesNotJumpOnRecalibration) {
+  if (!Clock::SetSource(Clock::Source::kTsc)) {
+    return;  // Not an x86 machine with an invariant TSC.
+  }
+  // Run through a few recalibrations, which happen once a second.
+  const absl::Time end = absl::Now() + absl::Milliseconds(2500);
+  absl::Time last = Clock::Now();
+  absl::Duration max_step = absl::ZeroDuration();
+  while (absl::Now() < end) {
+    const absl::Time now = Clock::Now();
+    ASSERT_LE(last, now);
+    max_step = std::max(max_step, now - last);
+    last = now;
+  }
+  // Consecutive reads are only the loop's few absl::Now() calls apart, unless
+  // the thread was descheduled.
+  EXPECT_GT(absl::Milliseconds(100), max_step);
+  ExpectFollowsWallClock(absl::Milliseconds(1));
+  ASSERT_TRUE(Clock::SetSource(Clock::Source::kWall));
+}
+
+TEST(ClockTest, Coarse) {
+  if (!Clock::SetSource(Clock::Source::kCoarse)) {
+    return;  // Not Linux.
+  }
+  EXPECT_EQ(Clock::Source::kCoarse, Clock::source());
+  ExpectFollowsWallClock(absl::Milliseconds(50));
+  ASSERT_TRUE(Clock::SetSource(Clock::Source::kWall));
+}
+
+TEST(ClockTest, VirtualClock) {
+  const absl::Time start = absl::FromUnixSeconds(1500000000);
+  VirtualClock clock(start);
+  Clock::SetVirtualClock(&clock);
+  EXPECT_EQ(start, Clock::Now());
+  clock.Advance(absl::Hours(24));
+  EXPECT_EQ(start + absl::Hours(24), Clock::Now());
+  clock.Set(start);
+  EXPECT_EQ(start, Clock::Now());
+
+  // Selecting a source takes effect once the virtual clock is removed.
+  ASSERT_TRUE(Clock::SetSource(Clock::Source::kWall));
+  EXPECT_EQ(start, Clock::Now());
+  Clock::SetVirtualClock(nullptr);
+  ExpectFollowsWallClock(absl::ZeroDuration());
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace opencensus
@@ -0,0 +1,255 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/executor.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace opencensus {
+namespace common {
+
+constexpr Executor::TaskId Executor::kInvalidTask;
+
+// static
+Executor* Executor::Get() {
+  static Executor* global_executor = new Executor(Options());
+  return global_executor;
+}
+
+// static
+bool Executor::Configure(const Options& options) {
+  Executor* executor = Get();
+  absl::MutexLock l(&executor->mu_);
+  if (!executor->threads_.empty() || executor->shutdown_) return false;
+  executor->options_ = options;
+  return true;
+}
+
+// static
+void Executor::ConfigureCurrentThread() {
+  Executor* executor = Get();
+  Options options;
+  {
+    absl::MutexLock l(&executor->mu_);
+    options = executor->options_;
+  }
+  ConfigureThread(options);
+}
+
+Executor::Executor(const Options& options) : options_(options) {}
+
+Executor::~Executor() { Shutdown(); }
+
+Executor::TaskId Executor::Schedule(std::function<void()> fn,
+                                    absl::Time earliest, absl::Time deadline) {
+  return AddTask({std::make_shared<std::function<void()>>(std::move(fn)),
+                  earliest, std::max(earliest, deadline),
+                  absl::ZeroDuration()});
+}
+
+Executor::TaskId Executor::Schedule(std::function<void()> fn,
+                                    absl::Time earliest) {
+  absl::Duration slack;
+  {
+    absl::MutexLock l(&mu_);
+    slack = options_.slack;
+  }
+  return Schedule(std::move(fn), earliest, earliest + slack);
+}
+
+Executor::TaskId Executor::SchedulePeriodic(std::function<void()> fn,
+                                            absl::Duration period) {
+  absl::Duration slack;
+  {
+    absl::MutexLock l(&mu_);
+    slack = options_.slack;
+  }
+  const absl::Time earliest = absl::Now() + period;
+  return AddTask({std::make_shared<std::function<void()>>(std::move(fn)),
+                  earliest, earliest + slack, period});
+}
+
+Executor::TaskId Executor::AddTask(Task task) {
+  absl::MutexLock l(&mu_);
+  if (shutdown_) return kInvalidTask;
+  if (threads_.empty()) StartThreads();
+  if (!wakeups_.empty() && task.deadline < *wakeups_.begin()) {
+    ++generation_;
+  }
+  const TaskId id = next_id_++;
+  tasks_.emplace(id, std::move(task));
+  return id;
+}
+
+bool Executor::Cancel(TaskId id) {
+  absl::MutexLock l(&mu_);
+  bool found = tasks_.erase(id) > 0;
+  const auto running = running_.find(id);
+  if (running != running_.end()) {
+    found = true;
+    // A task may cancel itself.
+    if (running->second != std::this_thread::get_id()) {
+      std::pair<Executor*, TaskId> args(this, id);
+      mu_.Await(absl::Condition(
+          +[](std::pair<Executor*, TaskId>* args) {
+            return args->first->running_.count(args->second) == 0;
+          },
+          &args));
+    }
+  }
+  return found;
+}
+
+void Executor::Shutdown() {
+  std::vector<std::thread> threads;
+  {
+    absl::MutexLock l(&mu_);
+    shutdown_ = true;
+    tasks_.clear();
+    threads.swap(threads_);
+  }
+  for (auto& thread : threads) {
+    // A task may shut the executor down; its thread exits on return.
+    if (thread.get_id() == std::this_thread::get_id()) {
+      thread.detach();
+    } else {
+      thread.join();
+    }
+  }
+}
+
+Executor::Stats Executor::stats() const {
+  absl::MutexLock l(&mu_);
+  return stats_;
+}
+
+void Executor::StartThreads() {
+  for (int i = 0; i < std::max(1, options_.num_threads); ++i) {
+    threads_.emplace_back(&Executor::RunThread, this, options_);
+  }
+}
+
+void Executor::RunThread(Options options) {
+  ConfigureThread(options);
+  absl::MutexLock l(&mu_);
+  while (!shutdown_) {
+    absl::Time now = absl::Now();
+    absl::Time next_deadline;
+    const auto it = NextTask(now, &next_deadline);
+    if (it == tasks_.end()) {
+      std::pair<Executor*, uint64_t> args(this, generation_);
+      const auto wakeup = wakeups_.insert(next_deadline);
+      mu_.AwaitWithDeadline(
+          absl::Condition(
+              +[](std::pair<Executor*, uint64_t>* args) {
+                return args->first->shutdown_ ||
+                       args->first->generation_ != args->second;
+              },
+              &args),
+          next_deadline);
+      wakeups_.erase(wakeup);
+      ++stats_.wakeups;
+      continue;
+    }
+
+    const TaskId id = it->first;
+    const std::shared_ptr<std::function<void()>> fn = it->second.fn;
+    const bool periodic = it->second.period > absl::ZeroDuration();
+    if (now > it->second.deadline) ++stats_.tasks_late;
+    ++stats_.tasks_run;
+    if (!periodic) tasks_.erase(it);
+    running_[id] = std::this_thread::get_id();
+    mu_.Unlock();
+    (*fn)();
+    mu_.Lock();
+    running_.erase(id);
+
+    if (!periodic) continue;
+    const auto task = tasks_.find(id);
+    if (task == tasks_.end()) continue;  // Cancelled.
+    Task& t = task->second;
+    const absl::Duration slack = t.deadline - t.earliest;
+    t.earliest += t.period;
+    now = absl::Now();
+    if (t.earliest <= now) {
+      // Skip the runs that were missed.
+      t.earliest += t.period * ((now - t.earliest) / t.period + 1);
+    }
+    t.deadline = t.earliest + slack;
+  }
+}
+
+std::map<Executor::TaskId, Executor::Task>::iterator Executor::NextTask(
+    absl::Time now, absl::Time* next_deadline) {
+  auto next = tasks_.end();
+  *next_deadline = absl::InfiniteFuture();
+  for (auto it = tasks_.begin(); it != tasks_.end(); ++it) {
+    // A periodic task doesn't overlap with itself.
+    if (running_.count(it->first) != 0) continue;
+    if (it->second.earliest <= now) {
+      // Of the tasks that may start, the one with the nearest deadline.
+      if (next == tasks_.end() ||
+          it->second.deadline < next->second.deadline) {
+        next = it;
+      }
+    } else {
+      *next_deadline = std::min(*next_deadline, it->second.deadline);
+    }
+  }
+  return next;
+}
+
+// static
+void Executor::ConfigureThread(const Options& options) {
+#ifdef __linux__
+  pthread_setname_np(pthread_self(), "opencensus");
+  if (!options.cpus.empty()) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : options.cpus) {
+      if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &cpus);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+  if (options.nice != 0) {
+    // On Linux, the nice level is per thread.
+    const id_t tid = syscall(SYS_gettid);
+    setpriority(PRIO_PROCESS, tid,
+                getpriority(PRIO_PROCESS, tid) + options.nice);
+  }
+#endif
+}
+
+}  // namespace common
+}  // namespace opencensus
@@ -0,0 +1,168 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_COMMON_INTERNAL_EXECUTOR_H_
+#define OPENCENSUS_COMMON_INTERNAL_EXECUTOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace opencensus {
+namespace common {
+
+// Executor runs background work, such as periodic exports and span store
+// scans, on a small pool of threads, so that the library's background CPU
+// use is confined to threads the application can configure.
+//
+// Each task has a window in which it should start, from its earliest time to
+// its deadline. Threads sleep until the nearest deadline and then start every
+// task whose earliest time has passed, so tasks due close together share one
+// wake-up. A task that can't start by its deadline because every thread is
+// busy starts late; stats() counts those.
+//
+// Tasks should not block for long: a slow task delays the tasks behind it
+// unless there are spare threads. Background work that must block, such as
+// the file exporter's writes, runs on its own threads instead, which call
+// ConfigureCurrentThread() to take on the shared executor's CPUs and nice
+// level.
+//
+// The library's background work runs on the shared executor, Get(). To
+// configure it, call Configure() at startup, before registering any
+// exporters:
+//   opencensus::common::Executor::Options options;
+//   options.cpus = {7};
+//   options.nice = 10;
+//   opencensus::common::Executor::Configure(options);
+//
+// This class is thread-safe.
+class Executor final {
+ public:
+  struct Options {
+    // The number of threads, started on the first Schedule() call.
+    int num_threads = 1;
+    // The CPUs the threads may run on. Empty means any. Linux only.
+    std::vector<int> cpus;
+    // Added to the threads' nice level. Linux only.
+    int nice = 0;
+    // How late a task may start when no deadline is given. Larger values
+    // coalesce more wake-ups.
+    absl::Duration slack = absl::Milliseconds(50);
+  };
+
+  struct Stats {
+    // The number of times threads woke up to look for tasks.
+    uint64_t wakeups = 0;
+    uint64_t tasks_run = 0;
+    // Tasks that started after their deadline.
+    uint64_t tasks_late = 0;
+  };
+
+  using TaskId = uint64_t;
+  // Returned by Schedule() after Shutdown().
+  static constexpr TaskId kInvalidTask = 0;
+
+  // Returns the shared executor.
+  static Executor* Get();
+
+  // Sets the options of the shared executor. Returns false, changing nothing,
+  // if it has already started its threads.
+  static bool Configure(const Options& options);
+
+  // Applies the shared executor's cpus and nice options to the calling
+  // thread.
+  static void ConfigureCurrentThread();
+
+  explicit Executor(const Options& options);
+  ~Executor();
+
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+
+  // Runs fn once, starting no earlier than earliest and, unless the executor
+  // is busy, no later than deadline.
+  TaskId Schedule(std::function<void()> fn, absl::Time earliest,
+                  absl::Time deadline) LOCKS_EXCLUDED(mu_);
+
+  // As above, with a deadline of earliest plus the configured slack.
+  TaskId Schedule(std::function<void()> fn, absl::Time earliest)
+      LOCKS_EXCLUDED(mu_);
+
+  // Runs fn every period, starting one period from now, until cancelled. A
+  // run that starts late doesn't move later runs, unless it ran past the
+  // next one, which is then skipped.
+  TaskId SchedulePeriodic(std::function<void()> fn, absl::Duration period)
+      LOCKS_EXCLUDED(mu_);
+
+  // Cancels a task. If it is running on another thread, waits for it to
+  // finish. Returns true if the task was pending or running.
+  bool Cancel(TaskId id) LOCKS_EXCLUDED(mu_);
+
+  // Stops the threads once the running tasks finish, and drops the pending
+  // tasks. Later calls to Schedule() do nothing.
+  void Shutdown() LOCKS_EXCLUDED(mu_);
+
+  Stats stats() const LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Task {
+    // Shared so that a running task can be cancelled.
+    std::shared_ptr<std::function<void()>> fn;
+    absl::Time earliest;
+    absl::Time deadline;
+    // Zero for one-shot tasks.
+    absl::Duration period;
+  };
+
+  TaskId AddTask(Task task) LOCKS_EXCLUDED(mu_);
+  void StartThreads() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void RunThread(Options options) LOCKS_EXCLUDED(mu_);
+  // Applies options.cpus and options.nice to the calling thread.
+  static void ConfigureThread(const Options& options);
+
+  // Returns a task that may start now, and sets *next_deadline to the
+  // nearest deadline of the remaining tasks.
+  std::map<TaskId, Task>::iterator NextTask(absl::Time now,
+                                            absl::Time* next_deadline)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutable absl::Mutex mu_;
+  Options options_ GUARDED_BY(mu_);
+  // Tasks by ID. There are only a handful, so lookups scan them all.
+  std::map<TaskId, Task> tasks_ GUARDED_BY(mu_);
+  // The running tasks, and the threads running them.
+  std::map<TaskId, std::thread::id> running_ GUARDED_BY(mu_);
+  TaskId next_id_ GUARDED_BY(mu_) = 1;
+  // When each idle thread will wake up.
+  std::multiset<absl::Time> wakeups_ GUARDED_BY(mu_);
+  // Incremented to wake the idle threads when a task is due before any of
+  // them would wake up.
+  uint64_t generation_ GUARDED_BY(mu_) = 0;
+  bool shutdown_ GUARDED_BY(mu_) = false;
+  Stats stats_ GUARDED_BY(mu_);
+  std::vector<std::thread> threads_ GUARDED_BY(mu_);
+};
+
+}  // namespace common
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_COMMON_INTERNAL_EXECUTOR_H_
@@ -0,0 +1,220 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/executor.h"
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+Executor::Options TestOptions() {
+  Executor::Options options;
+  options.slack = absl::ZeroDuration();
+  return options;
+}
+
+TEST(ExecutorTest, RunsTaskAfterEarliest) {
+  Executor executor(TestOptions());
+  absl::Notification done;
+  absl::Time ran;
+  const absl::Time earliest = absl::Now() + absl::Milliseconds(20);
+  ASSERT_NE(Executor::kInvalidTask, executor.Schedule(
+                                        [&]() {
+                                          ran = absl::Now();
+                                          done.Notify();
+                                        },
+                                        earliest));
+  ASSERT_TRUE(done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  EXPECT_LE(earliest, ran);
+  EXPECT_EQ(1, executor.stats().tasks_run);
+}
+
+TEST(ExecutorTest, CoalescesWakeups) {
+  Executor::Options options = TestOptions();
+  options.slack = absl::Milliseconds(100);
+  Executor executor(options);
+  absl::Mutex mu;
+  int num_run = 0;
+  const absl::Time start = absl::Now();
+  // Due 10ms apart, but they can all wait for the first one's deadline.
+  for (int i = 0; i < 5; ++i) {
+    executor.Schedule(
+        [&]() {
+          absl::MutexLock l(&mu);
+          ++num_run;
+        },
+        start + absl::Milliseconds(10 * i));
+  }
+  {
+    absl::MutexLock l(&mu);
+    ASSERT_TRUE(mu.AwaitWithTimeout(
+        absl::Condition(
+            +[](int* num_run) { return *num_run == 5; }, &num_run),
+        absl::Seconds(10)));
+  }
+  // One wake-up at the first deadline; allow one more in case the machine
+  // is slow.
+  EXPECT_GE(2, executor.stats().wakeups);
+}
+
+TEST(ExecutorTest, RunsInDeadlineOrder) {
+  Executor executor(TestOptions());
+  absl::Mutex mu;
+  std::vector<int> order;
+  absl::Notification started;
+  absl::Notification block;
+  // Keep the only thread busy while the others become due.
+  executor.Schedule(
+      [&]() {
+        started.Notify();
+        block.WaitForNotification();
+      },
+      absl::Now(), absl::Now() + absl::Seconds(1));
+  started.WaitForNotification();
+  const absl::Time now = absl::Now();
+  for (int i = 0; i < 3; ++i) {
+    executor.Schedule(
+        [&order, &mu, i]() {
+          absl::MutexLock l(&mu);
+          order.push_back(i);
+        },
+        now, now + absl::Milliseconds(30 - 10 * i));
+  }
+  absl::SleepFor(absl::Milliseconds(50));
+  block.Notify();
+  absl::MutexLock l(&mu);
+  ASSERT_TRUE(mu.AwaitWithTimeout(
+      absl::Condition(
+          +[](std::vector<int>* order) { return order->size() == 3; },
+          &order),
+      absl::Seconds(10)));
+  EXPECT_EQ(std::vector<int>({2, 1, 0}), order);
+  // All three started after their deadlines.
+  EXPECT_EQ(3, executor.stats().tasks_late);
+}
+
+TEST(ExecutorTest, PeriodicTask) {
+  Executor executor(TestOptions());
+  std::atomic<int> num_run(0);
+  const Executor::TaskId id =
+      executor.SchedulePeriodic([&]() { ++num_run; }, absl::Milliseconds(5));
+  while (num_run < 3) absl::SleepFor(absl::Milliseconds(5));
+  EXPECT_TRUE(executor.Cancel(id));
+  const int after_cancel = num_run;
+  absl::SleepFor(absl::Milliseconds(30));
+  EXPECT_EQ(after_cancel, num_run);
+  EXPECT_FALSE(executor.Cancel(id));
+}
+
+TEST(ExecutorTest, CancelWaitsForRunningTask) {
+  Executor executor(TestOptions());
+  absl::Notification started;
+  std::atomic<bool> finished(false);
+  const Executor::TaskId id = executor.Schedule(
+      [&]() {
+        started.Notify();
+        absl::SleepFor(absl::Milliseconds(50));
+        finished = true;
+      },
+      absl::Now());
+  started.WaitForNotification();
+  EXPECT_TRUE(executor.Cancel(id));
+  EXPECT_TRUE(finished);
+}
+
+TEST(ExecutorTest, TaskCanCancelItself) {
+  Executor executor(TestOptions());
+  absl::Notification done;
+  Executor::TaskId id;
+  absl::Mutex mu;
+  {
+    absl::MutexLock l(&mu);
+    id = executor.SchedulePeriodic(
+        [&]() {
+          absl::MutexLock l(&mu);
+          EXPECT_TRUE(executor.Cancel(id));
+          done.Notify();
+        },
+        absl::Milliseconds(1));
+  }
+  ASSERT_TRUE(done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+}
+
+TEST(ExecutorTest, MultipleThreads) {
+  Executor::Options options = TestOptions();
+  options.num_threads = 2;
+  Executor executor(options);
+  absl::Notification first_started;
+  absl::Notification second_ran;
+  // The second task runs while the first is still blocked.
+  executor.Schedule(
+      [&]() {
+        first_started.Notify();
+        second_ran.WaitForNotification();
+      },
+      absl::Now());
+  first_started.WaitForNotification();
+  executor.Schedule([&]() { second_ran.Notify(); }, absl::Now());
+  EXPECT_TRUE(second_ran.WaitForNotificationWithTimeout(absl::Seconds(10)));
+}
+
+TEST(ExecutorTest, ConfiguresThreads) {
+  Executor::Options options = TestOptions();
+  options.cpus = {0};
+  options.nice = 1;
+  Executor executor(options);
+  absl::Notification done;
+  executor.Schedule([&]() { done.Notify(); }, absl::Now());
+  EXPECT_TRUE(done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+}
+
+TEST(ExecutorTest, Shutdown) {
+  Executor executor(TestOptions());
+  std::atomic<bool> ran(false);
+  executor.Schedule([&]() { ran = true; }, absl::Now() + absl::Hours(1));
+  executor.Shutdown();
+  EXPECT_FALSE(ran);
+  EXPECT_EQ(Executor::kInvalidTask,
+            executor.Schedule([&]() { ran = true; }, absl::Now()));
+}
+
+TEST(ExecutorTest, ConfigureSharedExecutor) {
+  Executor::Options options;
+  options.num_threads = 2;
+  EXPECT_TRUE(Executor::Configure(options));
+  absl::Notification done;
+  Executor::Get()->Schedule([&]() { done.Notify(); }, absl::Now());
+  ASSERT_TRUE(done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  // Too late once the threads are running.
+  EXPECT_FALSE(Executor::Configure(options));
+}
+
+TEST(ExecutorTest, ConfigureCurrentThread) {
+  std::thread thread([]() { Executor::ConfigureCurrentThread(); });
+  thread.join();
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace opencensus
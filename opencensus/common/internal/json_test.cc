@@ -0,0 +1,37 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/json.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+TEST(JsonTest, AppendJsonString) {
+  std::string out = "x";
+  AppendJsonString("plain", &out);
+  EXPECT_EQ("x\"plain\"", out);
+
+  out.clear();
+  AppendJsonString(std::string("a\"b\\c\nd\x01\xc3\xa9", 10), &out);
+  EXPECT_EQ("\"a\\\"b\\\\c\\nd\\u0001\xc3\xa9\"", out);
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace opencensus
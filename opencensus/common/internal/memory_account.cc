@@ -0,0 +1,105 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/memory_account.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace opencensus {
+namespace common {
+
+namespace {
+
+class Registry {
+ public:
+  static Registry* Get() {
+    static Registry* global_registry = new Registry;
+    return global_registry;
+  }
+
+  void Add(const MemoryAccount* account) LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    accounts_.push_back(account);
+  }
+
+  void Remove(const MemoryAccount* account) LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    accounts_.erase(std::find(accounts_.begin(), accounts_.end(), account));
+  }
+
+  std::vector<MemoryAccount::Usage> GetAll() const LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    std::vector<MemoryAccount::Usage> usages;
+    usages.reserve(accounts_.size());
+    for (const MemoryAccount* account : accounts_) {
+      usages.push_back(account->usage());
+    }
+    return usages;
+  }
+
+ private:
+  mutable absl::Mutex mu_;
+  std::vector<const MemoryAccount*> accounts_ GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+MemoryAccount::MemoryAccount(absl::string_view component,
+                             absl::string_view name)
+    : component_(component), name_(name) {
+  Registry::Get()->Add(this);
+}
+
+MemoryAccount::~MemoryAccount() { Registry::Get()->Remove(this); }
+
+void MemoryAccount::Add(int64_t entries, int64_t key_bytes,
+                        int64_t data_bytes) {
+  entries_.fetch_add(entries, std::memory_order_relaxed);
+  key_bytes_.fetch_add(key_bytes, std::memory_order_relaxed);
+  data_bytes_.fetch_add(data_bytes, std::memory_order_relaxed);
+}
+
+void MemoryAccount::Set(int64_t entries, int64_t key_bytes,
+                        int64_t data_bytes) {
+  entries_.store(entries, std::memory_order_relaxed);
+  key_bytes_.store(key_bytes, std::memory_order_relaxed);
+  data_bytes_.store(data_bytes, std::memory_order_relaxed);
+}
+
+MemoryAccount::Usage MemoryAccount::usage() const {
+  return {component_, name_, entries_.load(std::memory_order_relaxed),
+          key_bytes_.load(std::memory_order_relaxed),
+          data_bytes_.load(std::memory_order_relaxed)};
+}
+
+// static
+std::vector<MemoryAccount::Usage> MemoryAccount::GetAll() {
+  return Registry::Get()->GetAll();
+}
+
+// static
+int64_t MemoryAccount::StringBytes(absl::string_view s) {
+  static const size_t inline_capacity = std::string().capacity();
+  return sizeof(std::string) + (s.size() > inline_capacity ? s.size() + 1 : 0);
+}
+
+}  // namespace common
+}  // namespace opencensus
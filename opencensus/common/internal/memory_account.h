@@ -0,0 +1,88 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_COMMON_INTERNAL_MEMORY_ACCOUNT_H_
+#define OPENCENSUS_COMMON_INTERNAL_MEMORY_ACCOUNT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace opencensus {
+namespace common {
+
+// MemoryAccount tracks the estimated heap usage of one of the library's data
+// structures, e.g. a view's rows or a span store. Owners keep it up to date as
+// they add and remove data, so that reading it is O(1) and doesn't need the
+// owner's lock. The estimates count the sizes of the stored objects and their
+// strings and containers, but not allocator overhead.
+//
+// Accounts register themselves on construction and unregister on destruction;
+// GetAll() returns the usage of all live accounts.
+//
+// This class is thread-safe.
+class MemoryAccount final {
+ public:
+  struct Usage {
+    // What owns the memory, e.g. "stats/view".
+    std::string component;
+    // Which instance of the component, e.g. the view name. May be empty.
+    std::string name;
+    // The number of entries: rows, measures or spans.
+    int64_t entries;
+    // Bytes of the keys identifying the entries, e.g. tag values.
+    int64_t key_bytes;
+    // All other bytes: the entries' data and the container overhead.
+    int64_t data_bytes;
+
+    int64_t bytes() const { return key_bytes + data_bytes; }
+  };
+
+  explicit MemoryAccount(absl::string_view component,
+                         absl::string_view name = "");
+  ~MemoryAccount();
+
+  MemoryAccount(const MemoryAccount&) = delete;
+  MemoryAccount& operator=(const MemoryAccount&) = delete;
+
+  // Adds to the totals. Pass negative values when data is removed.
+  void Add(int64_t entries, int64_t key_bytes, int64_t data_bytes);
+
+  // Replaces the totals.
+  void Set(int64_t entries, int64_t key_bytes, int64_t data_bytes);
+
+  Usage usage() const;
+
+  // Returns the usage of every live account.
+  static std::vector<Usage> GetAll();
+
+  // Returns the estimated bytes of a string: the object itself, and its heap
+  // buffer if the contents are too long to be stored inline.
+  static int64_t StringBytes(absl::string_view s);
+
+ private:
+  const std::string component_;
+  const std::string name_;
+  std::atomic<int64_t> entries_{0};
+  std::atomic<int64_t> key_bytes_{0};
+  std::atomic<int64_t> data_bytes_{0};
+};
+
+}  // namespace common
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_COMMON_INTERNAL_MEMORY_ACCOUNT_H_
@@ -0,0 +1,79 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/memory_account.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+// Returns the usage of the live account with the given component and name.
+bool FindUsage(absl::string_view component, absl::string_view name,
+               MemoryAccount::Usage* usage) {
+  for (const auto& u : MemoryAccount::GetAll()) {
+    if (u.component == component && u.name == name) {
+      *usage = u;
+      return true;
+    }
+  }
+  return false;
+}
+
+TEST(MemoryAccountTest, AddAndSet) {
+  MemoryAccount account("test/component", "instance");
+  account.Add(2, 10, 100);
+  account.Add(-1, -5, 50);
+  MemoryAccount::Usage usage = account.usage();
+  EXPECT_EQ("test/component", usage.component);
+  EXPECT_EQ("instance", usage.name);
+  EXPECT_EQ(1, usage.entries);
+  EXPECT_EQ(5, usage.key_bytes);
+  EXPECT_EQ(150, usage.data_bytes);
+  EXPECT_EQ(155, usage.bytes());
+
+  account.Set(3, 0, 7);
+  usage = account.usage();
+  EXPECT_EQ(3, usage.entries);
+  EXPECT_EQ(0, usage.key_bytes);
+  EXPECT_EQ(7, usage.data_bytes);
+}
+
+TEST(MemoryAccountTest, GetAllReturnsLiveAccounts) {
+  MemoryAccount::Usage usage;
+  {
+    MemoryAccount account("test/get_all");
+    account.Add(1, 2, 3);
+    ASSERT_TRUE(FindUsage("test/get_all", "", &usage));
+    EXPECT_EQ(1, usage.entries);
+    EXPECT_EQ(2, usage.key_bytes);
+    EXPECT_EQ(3, usage.data_bytes);
+  }
+  EXPECT_FALSE(FindUsage("test/get_all", "", &usage));
+}
+
+TEST(MemoryAccountTest, StringBytes) {
+  EXPECT_EQ(sizeof(std::string), MemoryAccount::StringBytes(""));
+  const std::string long_string(100, 'x');
+  EXPECT_EQ(sizeof(std::string) + 101,
+            MemoryAccount::StringBytes(long_string));
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace opencensus
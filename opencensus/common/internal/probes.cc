@@ -0,0 +1,27 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/probes.h"
+
+#ifdef OPENCENSUS_USDT_PROBES
+
+// Tools find the semaphores through the probe notes and increment them while
+// attached. The .probes section is where sdt.h tooling expects them.
+#define OPENCENSUS_DEFINE_PROBE_SEMAPHORE(name) \
+  unsigned short opencensus_##name##_semaphore  \
+      __attribute__((unused)) __attribute__((section(".probes"))) = 0;
+OPENCENSUS_PROBES(OPENCENSUS_DEFINE_PROBE_SEMAPHORE)
+#undef OPENCENSUS_DEFINE_PROBE_SEMAPHORE
+
+#endif  // OPENCENSUS_USDT_PROBES
@@ -0,0 +1,107 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_COMMON_INTERNAL_PROBES_H_
+#define OPENCENSUS_COMMON_INTERNAL_PROBES_H_
+
+// Static tracepoints (USDT probes) for tools like perf, bpftrace and
+// SystemTap, so that spans and stats records in a production binary can be
+// watched without registering any exporter.
+//
+// Probes are compiled in only when OPENCENSUS_USDT_PROBES is defined, which
+// the :probes target does for builds with
+//
+//   bazel build --define opencensus_usdt=true ...
+//
+// That needs <sys/sdt.h>, e.g. from the systemtap-sdt-dev package. Otherwise
+// the macros below expand to nothing and probe arguments are not evaluated.
+//
+// Every probe has a semaphore that tools increment while they are attached.
+// Call sites test it with OPENCENSUS_PROBE_ENABLED before computing the
+// arguments, so an unattached probe costs a load, a branch and a NOP:
+//
+//   if (OPENCENSUS_PROBE_ENABLED(span_end)) {
+//     OPENCENSUS_PROBE(span_end, ...);
+//   }
+//
+// The probes, all under the provider "opencensus", and their arguments. IDs
+// are passed as big-endian 64-bit integers, so that printing them as 16 hex
+// digits gives the usual hex form, and names as a pointer and size, since they
+// aren't NUL-terminated.
+//
+//   span_start(trace_id_high, trace_id_low, span_id, parent_span_id, name,
+//              name_size, sampled)
+//     A span was started. parent_span_id is 0 for root spans.
+//   span_end(trace_id_high, trace_id_low, span_id, name, name_size,
+//            latency_ns)
+//     A recording span was ended.
+//   measure_register(measure_index, name, name_size)
+//     A measure was registered. stats_record_* probes identify measures by
+//     measure_index. Measures are usually registered at startup, so a tool
+//     that needs names must be attached by then.
+//   stats_record_int(measure_index, value, num_tags)
+//   stats_record_double(measure_index, value, num_tags)
+//     A measurement was recorded.
+//   span_export_start(num_spans)
+//   span_export_done(num_spans)
+//     A batch of spans is being passed to the span exporter's handlers.
+//     num_spans in span_export_done excludes spans dropped by processors.
+//   stats_export_start(num_views)
+//   stats_export_done(num_views)
+//     The stats exporter is passing view data to its handlers.
+//
+// For example, a histogram of span latencies by name:
+//
+//   bpftrace -e 'usdt:./binary:opencensus:span_end
+//                { @[str(arg3, arg4)] = hist(arg5); }'
+
+#define OPENCENSUS_PROBES(X) \
+  X(span_start)              \
+  X(span_end)                \
+  X(measure_register)        \
+  X(stats_record_int)        \
+  X(stats_record_double)     \
+  X(span_export_start)       \
+  X(span_export_done)        \
+  X(stats_export_start)      \
+  X(stats_export_done)
+
+#ifdef OPENCENSUS_USDT_PROBES
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+// The semaphores are referenced by name from the probe notes, so they have C
+// linkage. They are defined in probes.cc.
+#define OPENCENSUS_DECLARE_PROBE_SEMAPHORE(name) \
+  extern "C" unsigned short opencensus_##name##_semaphore;
+OPENCENSUS_PROBES(OPENCENSUS_DECLARE_PROBE_SEMAPHORE)
+#undef OPENCENSUS_DECLARE_PROBE_SEMAPHORE
+
+#define OPENCENSUS_PROBE_ENABLED(name) \
+  __builtin_expect(opencensus_##name##_semaphore != 0, 0)
+
+#define OPENCENSUS_PROBE(name, ...) STAP_PROBEV(opencensus, name, ##__VA_ARGS__)
+
+#else  // OPENCENSUS_USDT_PROBES
+
+#define OPENCENSUS_PROBE_ENABLED(name) false
+
+#define OPENCENSUS_PROBE(name, ...) \
+  do {                              \
+  } while (0)
+
+#endif  // OPENCENSUS_USDT_PROBES
+
+#endif  // OPENCENSUS_COMMON_INTERNAL_PROBES_H_
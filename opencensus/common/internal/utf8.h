@@ -0,0 +1,42 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef OPENCENSUS_COMMON_INTERNAL_UTF8_H_
+#define OPENCENSUS_COMMON_INTERNAL_UTF8_H_
+
+#include <cstddef>
+
+#include "absl/strings/string_view.h"
+
+namespace opencensus {
+namespace common {
+
+// Returns the longest prefix of s that is at most max_size bytes long and
+// doesn't split a UTF-8 sequence. Bytes that aren't valid UTF-8 are treated as
+// whole characters.
+inline absl::string_view Utf8Prefix(absl::string_view s, size_t max_size) {
+  if (s.size() <= max_size) return s;
+  size_t size = max_size;
+  // Back up over continuation bytes to the start of a character.
+  while (size > 0 && (static_cast<unsigned char>(s[size]) & 0xC0) == 0x80) {
+    --size;
+  }
+  return s.substr(0, size);
+}
+
+}  // namespace common
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_COMMON_INTERNAL_UTF8_H_
@@ -0,0 +1,45 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "opencensus/common/internal/utf8.h"
+
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+TEST(Utf8PrefixTest, ShortStringsAreUnchanged) {
+  EXPECT_EQ("abc", Utf8Prefix("abc", 3));
+  EXPECT_EQ("abc", Utf8Prefix("abc", 10));
+  EXPECT_EQ("", Utf8Prefix("", 0));
+}
+
+TEST(Utf8PrefixTest, CutsAtCharacterBoundaries) {
+  EXPECT_EQ("ab", Utf8Prefix("abc", 2));
+  EXPECT_EQ("", Utf8Prefix("abc", 0));
+  // U+00E9 is two bytes and U+20AC is three.
+  const absl::string_view s = "a\xc3\xa9\xe2\x82\xac";
+  EXPECT_EQ("a", Utf8Prefix(s, 1));
+  EXPECT_EQ("a", Utf8Prefix(s, 2));
+  EXPECT_EQ("a\xc3\xa9", Utf8Prefix(s, 3));
+  EXPECT_EQ("a\xc3\xa9", Utf8Prefix(s, 4));
+  EXPECT_EQ("a\xc3\xa9", Utf8Prefix(s, 5));
+  EXPECT_EQ(s, Utf8Prefix(s, 6));
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace opencensus
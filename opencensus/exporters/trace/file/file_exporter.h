@@ -0,0 +1,82 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_EXPORTERS_TRACE_FILE_FILE_EXPORTER_H_
+#define OPENCENSUS_EXPORTERS_TRACE_FILE_FILE_EXPORTER_H_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include "absl/time/time.h"
+
+namespace opencensus {
+namespace exporters {
+namespace trace {
+
+// FileExporter writes exported spans to rotating files in a local directory,
+// for hosts that can't run an agent.
+//
+// Spans are encoded on the exporter thread into an in-memory buffer, and a
+// separate writer thread writes the buffer to disk. Tracing never waits on
+// disk I/O. If the buffer is full, or a write fails (e.g. the disk is full),
+// the spans are dropped.
+//
+// Files are named <prefix>.<unix seconds>.<sequence number>.<extension>, and
+// a new file is started once the current one reaches max_file_bytes or
+// max_file_age. Existing files are never overwritten: if the name is taken,
+// e.g. by another process with the same prefix, the next sequence number is
+// tried. Closed files can be handed to a compression callback, which
+// runs on its own thread.
+class FileExporter {
+ public:
+  enum class Format {
+    // One Zipkin v2 JSON span per line, extension "jsonl".
+    kZipkinJsonLines,
+    // Batches encoded by opencensus::trace::exporter::SpanBatchEncoder, each
+    // preceded by its length as a little-endian uint32, extension "bin".
+    kBinary,
+  };
+
+  struct Options {
+    // The directory to write to. It must exist.
+    std::string directory;
+    std::string file_prefix = "spans";
+    Format format = Format::kZipkinJsonLines;
+    // The Zipkin localEndpoint.serviceName of the spans.
+    std::string service_name;
+    size_t max_file_bytes = 64 << 20;
+    absl::Duration max_file_age = absl::Hours(1);
+    // The maximum number of encoded bytes waiting to be written. Spans that
+    // don't fit are dropped.
+    size_t max_buffer_bytes = 4 << 20;
+    // How long the writer thread waits for more spans before writing.
+    absl::Duration flush_interval = absl::Seconds(1);
+    // Called with the path of each closed file on a background thread, e.g.
+    // to compress it. May be empty.
+    std::function<void(const std::string& path)> on_file_closed;
+  };
+
+  // Registers the exporter.
+  static void Register(const Options& options);
+
+ private:
+  FileExporter() = delete;
+};
+
+}  // namespace trace
+}  // namespace exporters
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_EXPORTERS_TRACE_FILE_FILE_EXPORTER_H_
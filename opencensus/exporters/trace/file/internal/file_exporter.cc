@@ -0,0 +1,33 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/exporters/trace/file/file_exporter.h"
+
+#include "absl/memory/memory.h"
+#include "opencensus/exporters/trace/file/internal/file_exporter_impl.h"
+#include "opencensus/trace/exporter/span_exporter.h"
+
+namespace opencensus {
+namespace exporters {
+namespace trace {
+
+// static
+void FileExporter::Register(const Options& options) {
+  ::opencensus::trace::exporter::SpanExporter::RegisterHandler(
+      absl::make_unique<FileExporterImpl>(options));
+}
+
+}  // namespace trace
+}  // namespace exporters
+}  // namespace opencensus
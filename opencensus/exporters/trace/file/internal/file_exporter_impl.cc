@@ -0,0 +1,334 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/exporters/trace/file/internal/file_exporter_impl.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/internal/endian.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "opencensus/common/internal/executor.h"
+#include "opencensus/common/internal/json.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/span_data.h"
+
+namespace opencensus {
+namespace exporters {
+namespace trace {
+
+namespace {
+
+using ::opencensus::common::AppendJsonString;
+using ::opencensus::trace::exporter::AttributeValue;
+using ::opencensus::trace::exporter::SpanData;
+
+std::string AttributeValueToString(const AttributeValue& value) {
+  switch (value.type()) {
+    case AttributeValue::Type::kString:
+      return value.string_value();
+    case AttributeValue::Type::kInt:
+      return absl::StrCat(value.int_value());
+    case AttributeValue::Type::kBool:
+      return value.bool_value() ? "true" : "false";
+  }
+  return "";
+}
+
+// Appends a span in the Zipkin v2 JSON format, followed by a newline.
+void AppendZipkinSpan(const SpanData& span, absl::string_view service_name,
+                      std::string* out) {
+  absl::StrAppend(out, "{\"traceId\":\"", span.context().trace_id().ToHex(),
+                  "\",\"id\":\"", span.context().span_id().ToHex(), "\"");
+  if (span.parent_span_id().IsValid()) {
+    absl::StrAppend(out, ",\"parentId\":\"", span.parent_span_id().ToHex(),
+                    "\"");
+  }
+  out->append(",\"name\":");
+  AppendJsonString(span.name(), out);
+  absl::StrAppend(
+      out, ",\"timestamp\":", absl::ToUnixMicros(span.start_time()),
+      ",\"duration\":",
+      absl::ToInt64Microseconds(span.end_time() - span.start_time()));
+  if (!service_name.empty()) {
+    out->append(",\"localEndpoint\":{\"serviceName\":");
+    AppendJsonString(service_name, out);
+    out->append("}");
+  }
+  if (!span.annotations().events().empty()) {
+    out->append(",\"annotations\":[");
+    bool first = true;
+    for (const auto& annotation : span.annotations().events()) {
+      if (!first) out->push_back(',');
+      first = false;
+      absl::StrAppend(out, "{\"timestamp\":",
+                      absl::ToUnixMicros(annotation.timestamp()),
+                      ",\"value\":");
+      AppendJsonString(annotation.event().description(), out);
+      out->append("}");
+    }
+    out->append("]");
+  }
+  if (!span.attributes().empty() || !span.status().ok()) {
+    out->append(",\"tags\":{");
+    bool first = true;
+    for (const auto& attribute : span.attributes()) {
+      if (!first) out->push_back(',');
+      first = false;
+      AppendJsonString(attribute.first, out);
+      out->push_back(':');
+      AppendJsonString(AttributeValueToString(attribute.second), out);
+    }
+    if (!span.status().ok()) {
+      if (!first) out->push_back(',');
+      out->append("\"error\":");
+      AppendJsonString(span.status().ToString(), out);
+    }
+    out->append("}");
+  }
+  out->append("}\n");
+}
+
+}  // namespace
+
+FileExporterImpl::FileExporterImpl(const FileExporter::Options& options)
+    : options_(options) {
+  writer_thread_ = std::thread(&FileExporterImpl::RunWriterLoop, this);
+  if (options_.on_file_closed) {
+    closed_file_thread_ =
+        std::thread(&FileExporterImpl::RunClosedFileLoop, this);
+  }
+}
+
+FileExporterImpl::~FileExporterImpl() {
+  {
+    absl::MutexLock l(&mu_);
+    shutdown_ = true;
+  }
+  writer_thread_.join();
+  if (closed_file_thread_.joinable()) {
+    {
+      absl::MutexLock l(&closed_mu_);
+      closed_shutdown_ = true;
+    }
+    closed_file_thread_.join();
+  }
+}
+
+void FileExporterImpl::Export(const std::vector<SpanData>& spans) {
+  if (spans.empty()) return;
+  Batch batch{"", static_cast<int>(spans.size())};
+  Encode(spans, &batch.data);
+  absl::MutexLock l(&mu_);
+  if (pending_bytes_ + batch.data.size() > options_.max_buffer_bytes) {
+    num_spans_dropped_ += batch.num_spans;
+    return;
+  }
+  pending_bytes_ += batch.data.size();
+  pending_.push_back(std::move(batch));
+  ++num_batches_pending_;
+}
+
+void FileExporterImpl::Flush() {
+  absl::MutexLock l(&mu_);
+  const uint64_t target = num_batches_pending_;
+  flush_requested_ = true;
+  std::pair<FileExporterImpl*, uint64_t> args(this, target);
+  mu_.Await(absl::Condition(
+      +[](std::pair<FileExporterImpl*, uint64_t>* args) {
+        return args->first->num_batches_done_ >= args->second;
+      },
+      &args));
+}
+
+uint64_t FileExporterImpl::num_spans_written() const {
+  absl::MutexLock l(&mu_);
+  return num_spans_written_;
+}
+
+uint64_t FileExporterImpl::num_spans_dropped() const {
+  absl::MutexLock l(&mu_);
+  return num_spans_dropped_;
+}
+
+void FileExporterImpl::Encode(const std::vector<SpanData>& spans,
+                              std::string* out) {
+  switch (options_.format) {
+    case FileExporter::Format::kZipkinJsonLines:
+      for (const auto& span : spans) {
+        AppendZipkinSpan(span, options_.service_name, out);
+      }
+      break;
+    case FileExporter::Format::kBinary: {
+      const absl::string_view batch = encoder_.Encode(spans);
+      out->resize(sizeof(uint32_t));
+      absl::little_endian::Store32(&(*out)[0], batch.size());
+      out->append(batch.data(), batch.size());
+      break;
+    }
+  }
+}
+
+void FileExporterImpl::RunWriterLoop() {
+  common::Executor::ConfigureCurrentThread();
+  while (true) {
+    bool shutdown;
+    {
+      absl::MutexLock l(&mu_);
+      mu_.AwaitWithTimeout(
+          absl::Condition(
+              +[](FileExporterImpl* self) {
+                return self->shutdown_ || self->flush_requested_ ||
+                       (self->pending_bytes_ > 0 &&
+                        self->pending_bytes_ >=
+                            self->options_.max_buffer_bytes / 2);
+              },
+              this),
+          options_.flush_interval);
+      std::swap(pending_, writing_);
+      pending_bytes_ = 0;
+      flush_requested_ = false;
+      shutdown = shutdown_;
+    }
+    uint64_t num_spans = 0;
+    for (const auto& batch : writing_) {
+      num_spans += batch.num_spans;
+    }
+    const uint64_t num_written = WriteBatches(writing_);
+    {
+      absl::MutexLock l(&mu_);
+      num_batches_done_ += writing_.size();
+      num_spans_written_ += num_written;
+      num_spans_dropped_ += num_spans - num_written;
+    }
+    writing_.clear();
+    if (shutdown) break;
+  }
+  CloseFile();
+}
+
+uint64_t FileExporterImpl::WriteBatches(const std::vector<Batch>& batches) {
+  uint64_t num_written = 0;
+  std::vector<iovec> iov;
+  size_t i = 0;
+  while (i < batches.size()) {
+    if (fd_ >= 0 && (file_bytes_ >= options_.max_file_bytes ||
+                     absl::Now() - file_open_time_ >= options_.max_file_age)) {
+      CloseFile();
+    }
+    if (fd_ < 0 && !OpenFile()) {
+      break;  // Drop the rest.
+    }
+    // Write as many batches as fit in the current file in one writev(),
+    // always at least one.
+    iov.clear();
+    size_t bytes = 0;
+    uint64_t num_spans = 0;
+    while (i < batches.size() && iov.size() < IOV_MAX &&
+           (iov.empty() || file_bytes_ + bytes + batches[i].data.size() <=
+                               options_.max_file_bytes)) {
+      iov.push_back({const_cast<char*>(batches[i].data.data()),
+                     batches[i].data.size()});
+      bytes += batches[i].data.size();
+      num_spans += batches[i].num_spans;
+      ++i;
+    }
+    const ssize_t written = writev(fd_, iov.data(), iov.size());
+    if (written == static_cast<ssize_t>(bytes)) {
+      file_bytes_ += bytes;
+      num_written += num_spans;
+      continue;
+    }
+    // Out of space or some other error. Drop these spans, and cut off any
+    // partial write so the file only holds whole records.
+    if (written < 0) {
+      std::cerr << "FileExporter: write to " << path_
+                << " failed: " << strerror(errno) << "\n";
+    }
+    if (ftruncate(fd_, file_bytes_) != 0 ||
+        lseek(fd_, file_bytes_, SEEK_SET) < 0) {
+      CloseFile();
+    }
+  }
+  return num_written;
+}
+
+bool FileExporterImpl::OpenFile() {
+  const absl::string_view extension =
+      options_.format == FileExporter::Format::kBinary ? "bin" : "jsonl";
+  file_open_time_ = absl::Now();
+  // O_EXCL, so that a restart within the same second, or another process
+  // writing to the same prefix, doesn't overwrite an existing file.
+  do {
+    path_ = absl::StrCat(options_.directory, "/", options_.file_prefix, ".",
+                         absl::ToUnixSeconds(file_open_time_), ".",
+                         file_sequence_++, ".", extension);
+    fd_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  } while (fd_ < 0 && errno == EEXIST);
+  if (fd_ < 0) {
+    std::cerr << "FileExporter: can't open " << path_ << ": "
+              << strerror(errno) << "\n";
+    return false;
+  }
+  file_bytes_ = 0;
+  return true;
+}
+
+void FileExporterImpl::CloseFile() {
+  if (fd_ < 0) return;
+  close(fd_);
+  fd_ = -1;
+  if (options_.on_file_closed) {
+    absl::MutexLock l(&closed_mu_);
+    closed_files_.push_back(path_);
+  }
+}
+
+void FileExporterImpl::RunClosedFileLoop() {
+  common::Executor::ConfigureCurrentThread();
+  while (true) {
+    std::string path;
+    {
+      absl::MutexLock l(&closed_mu_);
+      closed_mu_.Await(absl::Condition(
+          +[](FileExporterImpl* self) {
+            return self->closed_shutdown_ || !self->closed_files_.empty();
+          },
+          this));
+      if (closed_files_.empty()) return;  // Shut down.
+      path = std::move(closed_files_.front());
+      closed_files_.pop_front();
+    }
+    options_.on_file_closed(path);
+  }
+}
+
+}  // namespace trace
+}  // namespace exporters
+}  // namespace opencensus
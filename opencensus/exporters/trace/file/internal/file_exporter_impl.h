@@ -0,0 +1,116 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_EXPORTERS_TRACE_FILE_INTERNAL_FILE_EXPORTER_IMPL_H_
+#define OPENCENSUS_EXPORTERS_TRACE_FILE_INTERNAL_FILE_EXPORTER_IMPL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "opencensus/exporters/trace/file/file_exporter.h"
+#include "opencensus/trace/exporter/span_batch_encoder.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/span_exporter.h"
+
+namespace opencensus {
+namespace exporters {
+namespace trace {
+
+// FileExporterImpl is the SpanExporter::Handler behind FileExporter.
+//
+// Export() encodes spans into a pending buffer. The writer thread swaps the
+// pending buffer with its own, so that Export() can keep filling one while the
+// other is written with writev(). Closed files are passed to
+// Options::on_file_closed on a third thread. Both threads block on I/O or
+// user code, so they stay off the shared executor, but run with its CPU
+// affinity and nice level.
+class FileExporterImpl
+    : public ::opencensus::trace::exporter::SpanExporter::Handler {
+ public:
+  explicit FileExporterImpl(const FileExporter::Options& options);
+  // Writes out pending spans, closes the current file, and stops the
+  // background threads.
+  ~FileExporterImpl() override;
+
+  void Export(const std::vector<::opencensus::trace::exporter::SpanData>& spans)
+      override LOCKS_EXCLUDED(mu_);
+
+  // Blocks until all spans exported so far have been written or dropped.
+  void Flush() LOCKS_EXCLUDED(mu_);
+
+  uint64_t num_spans_written() const LOCKS_EXCLUDED(mu_);
+  uint64_t num_spans_dropped() const LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Batch {
+    std::string data;
+    int num_spans;
+  };
+
+  void Encode(const std::vector<::opencensus::trace::exporter::SpanData>& spans,
+              std::string* out);
+
+  void RunWriterLoop() LOCKS_EXCLUDED(mu_);
+  // Writes batches to the current file, rotating as needed. Returns the number
+  // of spans written.
+  uint64_t WriteBatches(const std::vector<Batch>& batches);
+  bool OpenFile();
+  void CloseFile() LOCKS_EXCLUDED(closed_mu_);
+
+  void RunClosedFileLoop() LOCKS_EXCLUDED(closed_mu_);
+
+  const FileExporter::Options options_;
+
+  // Only used by Export(), which isn't called concurrently.
+  ::opencensus::trace::exporter::SpanBatchEncoder encoder_;
+
+  mutable absl::Mutex mu_;
+  std::vector<Batch> pending_ GUARDED_BY(mu_);
+  size_t pending_bytes_ GUARDED_BY(mu_) = 0;
+  // Batches added to pending_, and batches written or dropped by the writer.
+  uint64_t num_batches_pending_ GUARDED_BY(mu_) = 0;
+  uint64_t num_batches_done_ GUARDED_BY(mu_) = 0;
+  uint64_t num_spans_written_ GUARDED_BY(mu_) = 0;
+  uint64_t num_spans_dropped_ GUARDED_BY(mu_) = 0;
+  bool flush_requested_ GUARDED_BY(mu_) = false;
+  bool shutdown_ GUARDED_BY(mu_) = false;
+
+  // Only used by the writer thread.
+  std::vector<Batch> writing_;
+  int fd_ = -1;
+  std::string path_;
+  size_t file_bytes_ = 0;
+  absl::Time file_open_time_;
+  uint64_t file_sequence_ = 0;
+
+  absl::Mutex closed_mu_;
+  std::deque<std::string> closed_files_ GUARDED_BY(closed_mu_);
+  bool closed_shutdown_ GUARDED_BY(closed_mu_) = false;
+
+  std::thread writer_thread_;
+  std::thread closed_file_thread_;
+};
+
+}  // namespace trace
+}  // namespace exporters
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_EXPORTERS_TRACE_FILE_INTERNAL_FILE_EXPORTER_IMPL_H_
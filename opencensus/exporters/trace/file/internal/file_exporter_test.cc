@@ -0,0 +1,260 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/exporters/trace/file/internal/file_exporter_impl.h"
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "absl/base/internal/endian.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "opencensus/exporters/trace/file/file_exporter.h"
+#include "opencensus/trace/attribute_value_ref.h"
+#include "opencensus/trace/exporter/annotation.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/link.h"
+#include "opencensus/trace/exporter/message_event.h"
+#include "opencensus/trace/exporter/span_batch_encoder.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/status.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/status_code.h"
+#include "opencensus/trace/trace_id.h"
+
+namespace opencensus {
+namespace exporters {
+namespace trace {
+namespace {
+
+using ::opencensus::trace::AttributeValueRef;
+using ::opencensus::trace::SpanContext;
+using ::opencensus::trace::SpanId;
+using ::opencensus::trace::StatusCode;
+using ::opencensus::trace::TraceId;
+using ::opencensus::trace::exporter::Annotation;
+using ::opencensus::trace::exporter::AttributeValue;
+using ::opencensus::trace::exporter::Link;
+using ::opencensus::trace::exporter::MessageEvent;
+using ::opencensus::trace::exporter::SpanData;
+using ::opencensus::trace::exporter::Status;
+
+constexpr uint8_t trace_id[] = {1, 2,  3,  4,  5,  6,  7,  8,
+                                9, 10, 11, 12, 13, 14, 15, 16};
+constexpr uint8_t span_id[] = {1, 0, 0, 0, 0, 0, 0, 1};
+
+SpanData MakeSpan(absl::string_view name) {
+  const absl::Time start = absl::FromUnixMicros(1500000000000000);
+  std::vector<SpanData::TimeEvent<Annotation>> annotations;
+  annotations.emplace_back(start + absl::Microseconds(1),
+                           Annotation("Annotation"));
+  return SpanData(
+      name, SpanContext(TraceId(trace_id), SpanId(span_id)), SpanId(),
+      SpanData::TimeEvents<Annotation>(std::move(annotations), 0),
+      SpanData::TimeEvents<MessageEvent>({}, 0), std::vector<Link>(), 0,
+      {{"key", AttributeValue(AttributeValueRef("value"))}}, 0,
+      /*has_ended=*/true, start, start + absl::Microseconds(25),
+      Status(StatusCode::NOT_FOUND, "missing"), /*has_remote_parent=*/false);
+}
+
+class FileExporterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const char* tmp = getenv("TEST_TMPDIR");
+    std::string pattern =
+        absl::StrCat(tmp != nullptr ? tmp : "/tmp", "/file_exporter.XXXXXX");
+    ASSERT_NE(nullptr, mkdtemp(&pattern[0]));
+    dir_ = pattern;
+  }
+
+  void TearDown() override {
+    for (const auto& file : Files()) {
+      unlink(file.c_str());
+    }
+    rmdir(dir_.c_str());
+  }
+
+  FileExporter::Options DefaultOptions() {
+    FileExporter::Options options;
+    options.directory = dir_;
+    options.service_name = "service";
+    return options;
+  }
+
+  // Returns the paths of the files in dir_, sorted.
+  std::vector<std::string> Files() {
+    std::vector<std::string> files;
+    DIR* dir = opendir(dir_.c_str());
+    if (dir == nullptr) return files;
+    while (const dirent* entry = readdir(dir)) {
+      const std::string name = entry->d_name;
+      if (name != "." && name != "..") {
+        files.push_back(absl::StrCat(dir_, "/", name));
+      }
+    }
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+    return files;
+  }
+
+  static std::string ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+  }
+
+  std::string dir_;
+};
+
+TEST_F(FileExporterTest, WritesZipkinJsonLines) {
+  FileExporterImpl exporter(DefaultOptions());
+  exporter.Export({MakeSpan("Span1"), MakeSpan("Span \"2\"")});
+  exporter.Flush();
+  EXPECT_EQ(2, exporter.num_spans_written());
+
+  const auto files = Files();
+  ASSERT_EQ(1, files.size());
+  EXPECT_EQ(".jsonl", files[0].substr(files[0].size() - 6));
+  EXPECT_EQ(
+      "{\"traceId\":\"0102030405060708090a0b0c0d0e0f10\","
+      "\"id\":\"0100000000000001\",\"name\":\"Span1\","
+      "\"timestamp\":1500000000000000,\"duration\":25,"
+      "\"localEndpoint\":{\"serviceName\":\"service\"},"
+      "\"annotations\":[{\"timestamp\":1500000000000001,"
+      "\"value\":\"Annotation\"}],"
+      "\"tags\":{\"key\":\"value\",\"error\":\"NOT_FOUND: missing\"}}\n"
+      "{\"traceId\":\"0102030405060708090a0b0c0d0e0f10\","
+      "\"id\":\"0100000000000001\",\"name\":\"Span \\\"2\\\"\","
+      "\"timestamp\":1500000000000000,\"duration\":25,"
+      "\"localEndpoint\":{\"serviceName\":\"service\"},"
+      "\"annotations\":[{\"timestamp\":1500000000000001,"
+      "\"value\":\"Annotation\"}],"
+      "\"tags\":{\"key\":\"value\",\"error\":\"NOT_FOUND: missing\"}}\n",
+      ReadFile(files[0]));
+}
+
+TEST_F(FileExporterTest, WritesBinaryBatches) {
+  auto options = DefaultOptions();
+  options.format = FileExporter::Format::kBinary;
+  const std::vector<SpanData> spans = {MakeSpan("Span1"), MakeSpan("Span2")};
+  {
+    FileExporterImpl exporter(options);
+    exporter.Export(spans);
+    exporter.Export(spans);
+  }
+  const auto files = Files();
+  ASSERT_EQ(1, files.size());
+  const std::string contents = ReadFile(files[0]);
+
+  ::opencensus::trace::exporter::SpanBatchEncoder encoder;
+  const std::string batch(encoder.Encode(spans));
+  ASSERT_EQ(2 * (4 + batch.size()), contents.size());
+  for (int i = 0; i < 2; ++i) {
+    const size_t offset = i * (4 + batch.size());
+    EXPECT_EQ(batch.size(),
+              absl::little_endian::Load32(contents.data() + offset));
+    EXPECT_EQ(batch, contents.substr(offset + 4, batch.size()));
+  }
+}
+
+TEST_F(FileExporterTest, RotatesBySize) {
+  absl::Mutex mu;
+  std::vector<std::string> closed_files;
+  auto options = DefaultOptions();
+  options.max_file_bytes = 1;
+  options.on_file_closed = [&](const std::string& path) {
+    absl::MutexLock l(&mu);
+    closed_files.push_back(path);
+  };
+  {
+    FileExporterImpl exporter(options);
+    for (int i = 0; i < 3; ++i) {
+      exporter.Export({MakeSpan("Span")});
+      exporter.Flush();
+    }
+    EXPECT_EQ(3, exporter.num_spans_written());
+  }
+  const auto files = Files();
+  EXPECT_EQ(3, files.size());
+  absl::MutexLock l(&mu);
+  std::sort(closed_files.begin(), closed_files.end());
+  EXPECT_EQ(files, closed_files);
+}
+
+TEST_F(FileExporterTest, RotatesByAge) {
+  auto options = DefaultOptions();
+  options.max_file_age = absl::ZeroDuration();
+  FileExporterImpl exporter(options);
+  exporter.Export({MakeSpan("Span")});
+  exporter.Flush();
+  exporter.Export({MakeSpan("Span")});
+  exporter.Flush();
+  EXPECT_EQ(2, Files().size());
+}
+
+TEST_F(FileExporterTest, DoesNotOverwriteExistingFiles) {
+  // Both exporters start at the same sequence number, most likely within the
+  // same second.
+  FileExporterImpl exporter1(DefaultOptions());
+  FileExporterImpl exporter2(DefaultOptions());
+  exporter1.Export({MakeSpan("Span1")});
+  exporter1.Flush();
+  exporter2.Export({MakeSpan("Span2")});
+  exporter2.Flush();
+
+  const auto files = Files();
+  ASSERT_EQ(2, files.size());
+  std::vector<std::string> contents = {ReadFile(files[0]),
+                                       ReadFile(files[1])};
+  std::sort(contents.begin(), contents.end());
+  EXPECT_NE(std::string::npos, contents[0].find("\"name\":\"Span1\""));
+  EXPECT_NE(std::string::npos, contents[1].find("\"name\":\"Span2\""));
+}
+
+TEST_F(FileExporterTest, DropsSpansWhenBufferIsFull) {
+  auto options = DefaultOptions();
+  options.max_buffer_bytes = 10;
+  FileExporterImpl exporter(options);
+  exporter.Export({MakeSpan("Span1"), MakeSpan("Span2")});
+  exporter.Flush();
+  EXPECT_EQ(0, exporter.num_spans_written());
+  EXPECT_EQ(2, exporter.num_spans_dropped());
+}
+
+TEST_F(FileExporterTest, DropsSpansWhenWritesFail) {
+  auto options = DefaultOptions();
+  options.directory = absl::StrCat(dir_, "/does_not_exist");
+  FileExporterImpl exporter(options);
+  exporter.Export({MakeSpan("Span1"), MakeSpan("Span2")});
+  exporter.Flush();
+  EXPECT_EQ(0, exporter.num_spans_written());
+  EXPECT_EQ(2, exporter.num_spans_dropped());
+}
+
+}  // namespace
+}  // namespace trace
+}  // namespace exporters
+}  // namespace opencensus
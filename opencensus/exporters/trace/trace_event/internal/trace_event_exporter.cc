@@ -0,0 +1,255 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/exporters/trace/trace_event/trace_event_exporter.h"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "opencensus/common/internal/json.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/local_span_store.h"
+#include "opencensus/trace/exporter/message_event.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/span_exporter.h"
+
+namespace opencensus {
+namespace exporters {
+namespace trace {
+
+namespace {
+
+using ::opencensus::common::AppendJsonString;
+using ::opencensus::trace::exporter::AttributeValue;
+using ::opencensus::trace::exporter::MessageEvent;
+using ::opencensus::trace::exporter::SpanData;
+
+// Appends a timestamp or duration in microseconds, keeping nanosecond
+// precision in the fraction.
+void AppendMicros(absl::Duration d, std::string* out) {
+  int64_t nanos = absl::ToInt64Nanoseconds(d);
+  if (nanos < 0) nanos = 0;
+  const int64_t fraction = nanos % 1000;
+  absl::StrAppend(out, nanos / 1000);
+  if (fraction != 0) {
+    out->push_back('.');
+    out->push_back('0' + fraction / 100);
+    out->push_back('0' + fraction / 10 % 10);
+    out->push_back('0' + fraction % 10);
+  }
+}
+
+void AppendAttributes(
+    const std::unordered_map<std::string, AttributeValue>& attributes,
+    std::string* out) {
+  for (const auto& attribute : attributes) {
+    out->push_back(',');
+    AppendJsonString(attribute.first, out);
+    out->push_back(':');
+    switch (attribute.second.type()) {
+      case AttributeValue::Type::kString:
+        AppendJsonString(attribute.second.string_value(), out);
+        break;
+      case AttributeValue::Type::kInt:
+        absl::StrAppend(out, attribute.second.int_value());
+        break;
+      case AttributeValue::Type::kBool:
+        out->append(attribute.second.bool_value() ? "true" : "false");
+        break;
+    }
+  }
+}
+
+// Appends the fields common to all events of a span, starting with a comma.
+void AppendThread(const SpanData& span, absl::string_view pid,
+                  std::string* out) {
+  absl::StrAppend(out, ",\"pid\":", pid, ",\"tid\":", span.thread_id());
+}
+
+void AppendInstantEvent(const SpanData& span, absl::string_view pid,
+                        absl::string_view name, absl::string_view category,
+                        absl::Time timestamp, std::string* out) {
+  out->append(",\n{\"name\":");
+  AppendJsonString(name, out);
+  absl::StrAppend(out, ",\"cat\":\"", category, "\",\"ph\":\"i\",\"s\":\"t\"");
+  out->append(",\"ts\":");
+  AppendMicros(timestamp - absl::UnixEpoch(), out);
+  AppendThread(span, pid, out);
+}
+
+void AppendSpan(const SpanData& span, absl::string_view pid,
+                std::string* out) {
+  out->append(",\n{\"name\":");
+  AppendJsonString(span.name(), out);
+  out->append(",\"cat\":\"span\",\"ph\":\"X\",\"ts\":");
+  AppendMicros(span.start_time() - absl::UnixEpoch(), out);
+  out->append(",\"dur\":");
+  AppendMicros(span.end_time() - span.start_time(), out);
+  AppendThread(span, pid, out);
+  absl::StrAppend(out, ",\"args\":{\"trace_id\":\"",
+                  span.context().trace_id().ToHex(), "\",\"span_id\":\"",
+                  span.context().span_id().ToHex(), "\"");
+  if (span.parent_span_id().IsValid()) {
+    absl::StrAppend(out, ",\"parent_span_id\":\"",
+                    span.parent_span_id().ToHex(), "\"");
+  }
+  out->append(",\"status\":");
+  AppendJsonString(span.status().ToString(), out);
+  AppendAttributes(span.attributes(), out);
+  out->append("}}");
+
+  for (const auto& annotation : span.annotations().events()) {
+    AppendInstantEvent(span, pid, annotation.event().description(),
+                       "annotation", annotation.timestamp(), out);
+    out->append(",\"args\":{\"span_id\":\"");
+    absl::StrAppend(out, span.context().span_id().ToHex(), "\"");
+    AppendAttributes(annotation.event().attributes(), out);
+    out->append("}}");
+  }
+  for (const auto& message_event : span.message_events().events()) {
+    const MessageEvent& event = message_event.event();
+    AppendInstantEvent(
+        span, pid,
+        event.type() == MessageEvent::Type::SENT ? "SENT" : "RECEIVED",
+        "message", message_event.timestamp(), out);
+    absl::StrAppend(out, ",\"args\":{\"span_id\":\"",
+                    span.context().span_id().ToHex(), "\",\"id\":", event.id(),
+                    ",\"compressed_size\":", event.compressed_size(),
+                    ",\"uncompressed_size\":", event.uncompressed_size(),
+                    "}}");
+  }
+}
+
+template <typename Iterable, typename Deref>
+std::string SpansToJson(const Iterable& spans, Deref deref) {
+  const std::string pid = absl::StrCat(getpid());
+  std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  const size_t start = out.size();
+  for (const auto& span : spans) {
+    AppendSpan(deref(span), pid, &out);
+  }
+  if (out.size() > start) {
+    out.erase(start, 1);  // The leading comma.
+  }
+  out.append("]}\n");
+  return out;
+}
+
+// Records exported spans between StartCapture() and StopCapture().
+class Capture {
+ public:
+  static Capture* Get() {
+    static Capture* global_capture = new Capture;
+    return global_capture;
+  }
+
+  void Start(size_t max_spans) LOCKS_EXCLUDED(mu_);
+  std::vector<SpanData> Stop() LOCKS_EXCLUDED(mu_);
+  void Add(const std::vector<SpanData>& spans) LOCKS_EXCLUDED(mu_);
+
+ private:
+  class Handler : public ::opencensus::trace::exporter::SpanExporter::Handler {
+   public:
+    void Export(const std::vector<SpanData>& spans) override {
+      Capture::Get()->Add(spans);
+    }
+  };
+
+  absl::Mutex mu_;
+  bool registered_ GUARDED_BY(mu_) = false;
+  bool capturing_ GUARDED_BY(mu_) = false;
+  size_t max_spans_ GUARDED_BY(mu_) = 0;
+  std::vector<SpanData> spans_ GUARDED_BY(mu_);
+};
+
+void Capture::Start(size_t max_spans) {
+  bool needs_registration;
+  {
+    absl::MutexLock l(&mu_);
+    needs_registration = !registered_;
+    registered_ = true;
+    capturing_ = true;
+    max_spans_ = max_spans;
+    spans_.clear();
+  }
+  // Not under mu_: the SpanExporter calls Export() while holding its own lock.
+  if (needs_registration) {
+    ::opencensus::trace::exporter::SpanExporter::RegisterHandler(
+        absl::make_unique<Handler>());
+  }
+}
+
+std::vector<SpanData> Capture::Stop() {
+  absl::MutexLock l(&mu_);
+  capturing_ = false;
+  std::vector<SpanData> spans;
+  spans.swap(spans_);
+  return spans;
+}
+
+void Capture::Add(const std::vector<SpanData>& spans) {
+  absl::MutexLock l(&mu_);
+  if (!capturing_) return;
+  for (const auto& span : spans) {
+    if (spans_.size() >= max_spans_) break;
+    spans_.push_back(span);
+  }
+}
+
+}  // namespace
+
+// static
+std::string TraceEventExporter::ToJson(const std::vector<SpanData>& spans) {
+  return SpansToJson(spans, [](const SpanData& span) -> const SpanData& {
+    return span;
+  });
+}
+
+// static
+std::string TraceEventExporter::ToJson(
+    const std::vector<std::shared_ptr<const SpanData>>& spans) {
+  return SpansToJson(
+      spans, [](const std::shared_ptr<const SpanData>& span)
+                 -> const SpanData& { return *span; });
+}
+
+// static
+std::string TraceEventExporter::DumpLocalSpanStore() {
+  return ToJson(::opencensus::trace::exporter::LocalSpanStore::GetSpans());
+}
+
+// static
+void TraceEventExporter::StartCapture(size_t max_spans) {
+  Capture::Get()->Start(max_spans);
+}
+
+// static
+std::string TraceEventExporter::StopCapture() {
+  return ToJson(Capture::Get()->Stop());
+}
+
+}  // namespace trace
+}  // namespace exporters
+}  // namespace opencensus
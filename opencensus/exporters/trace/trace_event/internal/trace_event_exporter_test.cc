@@ -0,0 +1,154 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/exporters/trace/trace_event/trace_event_exporter.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "opencensus/trace/attribute_value_ref.h"
+#include "opencensus/trace/exporter/annotation.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/link.h"
+#include "opencensus/trace/exporter/message_event.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/span_exporter.h"
+#include "opencensus/trace/exporter/status.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/status_code.h"
+#include "opencensus/trace/trace_id.h"
+
+namespace opencensus {
+namespace exporters {
+namespace trace {
+namespace {
+
+using ::opencensus::trace::AttributeValueRef;
+using ::opencensus::trace::SpanContext;
+using ::opencensus::trace::SpanId;
+using ::opencensus::trace::StatusCode;
+using ::opencensus::trace::TraceId;
+using ::opencensus::trace::exporter::Annotation;
+using ::opencensus::trace::exporter::AttributeValue;
+using ::opencensus::trace::exporter::Link;
+using ::opencensus::trace::exporter::MessageEvent;
+using ::opencensus::trace::exporter::SpanData;
+using ::opencensus::trace::exporter::Status;
+
+constexpr uint8_t trace_id[] = {1, 2,  3,  4,  5,  6,  7,  8,
+                                9, 10, 11, 12, 13, 14, 15, 16};
+constexpr uint8_t span_id[] = {1, 0, 0, 0, 0, 0, 0, 1};
+constexpr uint8_t parent_span_id[] = {2, 0, 0, 0, 0, 0, 0, 2};
+
+SpanData MakeSpan() {
+  const absl::Time start = absl::FromUnixNanos(1500000000000000250);
+  std::vector<SpanData::TimeEvent<Annotation>> annotations;
+  annotations.emplace_back(
+      start + absl::Microseconds(1),
+      Annotation("Cache \"miss\"",
+                 {{"hit", AttributeValue(AttributeValueRef(false))}}));
+  std::vector<SpanData::TimeEvent<MessageEvent>> message_events;
+  message_events.emplace_back(
+      start + absl::Microseconds(2),
+      MessageEvent(MessageEvent::Type::SENT, 3, 100, 200));
+  return SpanData(
+      "Span", SpanContext(TraceId(trace_id), SpanId(span_id)),
+      SpanId(parent_span_id),
+      SpanData::TimeEvents<Annotation>(std::move(annotations), 0),
+      SpanData::TimeEvents<MessageEvent>(std::move(message_events), 0),
+      std::vector<Link>(), 0,
+      {{"size", AttributeValue(AttributeValueRef(12))}}, 0,
+      /*has_ended=*/true, start, start + absl::Nanoseconds(25500),
+      Status(StatusCode::NOT_FOUND, "missing"), /*has_remote_parent=*/false,
+      /*thread_id=*/42);
+}
+
+TEST(TraceEventExporterTest, ToJson) {
+  const std::string pid = absl::StrCat(getpid());
+  EXPECT_EQ(
+      absl::StrCat(
+          "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+          "{\"name\":\"Span\",\"cat\":\"span\",\"ph\":\"X\","
+          "\"ts\":1500000000000000.250,\"dur\":25.500,\"pid\":",
+          pid,
+          ",\"tid\":42,\"args\":{\"trace_id\":"
+          "\"0102030405060708090a0b0c0d0e0f10\","
+          "\"span_id\":\"0100000000000001\","
+          "\"parent_span_id\":\"0200000000000002\","
+          "\"status\":\"NOT_FOUND: missing\",\"size\":12}},\n"
+          "{\"name\":\"Cache \\\"miss\\\"\",\"cat\":\"annotation\","
+          "\"ph\":\"i\",\"s\":\"t\",\"ts\":1500000000000001.250,\"pid\":",
+          pid,
+          ",\"tid\":42,\"args\":{\"span_id\":\"0100000000000001\","
+          "\"hit\":false}},\n"
+          "{\"name\":\"SENT\",\"cat\":\"message\",\"ph\":\"i\",\"s\":\"t\","
+          "\"ts\":1500000000000002.250,\"pid\":",
+          pid,
+          ",\"tid\":42,\"args\":{\"span_id\":\"0100000000000001\","
+          "\"id\":3,\"compressed_size\":100,\"uncompressed_size\":200}}]}\n"),
+      TraceEventExporter::ToJson(std::vector<SpanData>{MakeSpan()}));
+}
+
+TEST(TraceEventExporterTest, Empty) {
+  EXPECT_EQ("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[]}\n",
+            TraceEventExporter::ToJson(std::vector<SpanData>()));
+}
+
+// Counts exported spans, so the test knows when the capture handler, which is
+// registered first, has seen them.
+std::atomic<int> num_exported(0);
+
+class CountingHandler
+    : public ::opencensus::trace::exporter::SpanExporter::Handler {
+ public:
+  void Export(const std::vector<SpanData>& spans) override {
+    num_exported += spans.size();
+  }
+};
+
+TEST(TraceEventExporterTest, Capture) {
+  TraceEventExporter::StartCapture();
+  ::opencensus::trace::exporter::SpanExporter::RegisterHandler(
+      absl::make_unique<CountingHandler>());
+  ::opencensus::trace::AlwaysSampler sampler;
+  auto span = ::opencensus::trace::Span::StartSpan("CapturedSpan", nullptr,
+                                                   {&sampler});
+  span.End();
+  for (int i = 0; i < 100 && num_exported == 0; ++i) {
+    absl::SleepFor(absl::Milliseconds(100));
+  }
+  const std::string json = TraceEventExporter::StopCapture();
+  EXPECT_NE(std::string::npos, json.find("\"name\":\"CapturedSpan\""));
+  // The span's thread is recorded.
+  EXPECT_EQ(std::string::npos, json.find("\"tid\":0,"));
+  EXPECT_NE(std::string::npos, json.find("\"tid\":"));
+}
+
+}  // namespace
+}  // namespace trace
+}  // namespace exporters
+}  // namespace opencensus
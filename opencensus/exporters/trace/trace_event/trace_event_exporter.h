@@ -0,0 +1,76 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_EXPORTERS_TRACE_TRACE_EVENT_TRACE_EVENT_EXPORTER_H_
+#define OPENCENSUS_EXPORTERS_TRACE_TRACE_EVENT_TRACE_EVENT_EXPORTER_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "opencensus/trace/exporter/span_data.h"
+
+namespace opencensus {
+namespace exporters {
+namespace trace {
+
+// TraceEventExporter converts spans to the Trace Event JSON format, which can
+// be loaded into chrome://tracing or https://ui.perfetto.dev to see how spans
+// overlap across threads.
+//
+// Each span becomes a complete ("X") event on the thread that started it, with
+// its IDs, status, and attributes as args. Annotations and message events
+// become thread-scoped instant ("i") events on the same thread.
+//
+// Spans can be dumped from the LocalSpanStore, or captured from the
+// SpanExporter for a window of time:
+//
+//   TraceEventExporter::StartCapture();
+//   ... run the workload ...
+//   WriteToFile(TraceEventExporter::StopCapture());
+//
+// This class is thread-safe.
+class TraceEventExporter {
+ public:
+  // Returns the spans in Trace Event JSON format.
+  static std::string ToJson(
+      const std::vector<::opencensus::trace::exporter::SpanData>& spans);
+  static std::string ToJson(
+      const std::vector<
+          std::shared_ptr<const ::opencensus::trace::exporter::SpanData>>&
+          spans);
+
+  // Returns the spans currently in the LocalSpanStore in Trace Event JSON
+  // format.
+  static std::string DumpLocalSpanStore();
+
+  // Starts capturing exported spans, keeping up to max_spans. Any previous
+  // capture is discarded. The first call registers a SpanExporter handler.
+  static void StartCapture(size_t max_spans = 100000);
+
+  // Stops capturing and returns the captured spans in Trace Event JSON format.
+  // Spans that ended shortly before this call may not have reached the
+  // exporter yet.
+  static std::string StopCapture();
+
+ private:
+  TraceEventExporter() = delete;
+};
+
+}  // namespace trace
+}  // namespace exporters
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_EXPORTERS_TRACE_TRACE_EVENT_TRACE_EVENT_EXPORTER_H_
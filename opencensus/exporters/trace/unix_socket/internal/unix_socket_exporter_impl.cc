@@ -0,0 +1,227 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/exporters/trace/unix_socket/internal/unix_socket_exporter_impl.h"
+
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/base/internal/endian.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "opencensus/trace/exporter/span_data.h"
+
+namespace opencensus {
+namespace exporters {
+namespace trace {
+
+using ::opencensus::trace::exporter::SpanData;
+
+UnixSocketExporterImpl::UnixSocketExporterImpl(
+    const UnixSocketExporter::Options& options)
+    : options_(options), reconnect_backoff_(options.min_reconnect_backoff) {
+  // Periodic rather than scheduled on demand, so that the destructor can
+  // cancel it, and wait for it, by a fixed ID.
+  flush_task_ = common::Executor::Get()->SchedulePeriodic(
+      [this]() { Flush(); }, options_.flush_interval);
+}
+
+UnixSocketExporterImpl::UnixSocketExporterImpl(
+    const UnixSocketExporter::Options& options, int fd)
+    : UnixSocketExporterImpl(options) {
+  absl::MutexLock l(&mu_);
+  fd_ = fd;
+}
+
+UnixSocketExporterImpl::~UnixSocketExporterImpl() {
+  common::Executor::Get()->Cancel(flush_task_);
+  absl::MutexLock l(&mu_);
+  if (fd_ >= 0) close(fd_);
+}
+
+void UnixSocketExporterImpl::Export(const std::vector<SpanData>& spans) {
+  absl::MutexLock l(&mu_);
+  MaybeConnect();
+  if (fd_ >= 0) SendBuffered();
+  if (spans.empty()) return;
+
+  const absl::string_view batch = encoder_.Encode(spans);
+  char header[sizeof(uint32_t)];
+  absl::little_endian::Store32(header, batch.size());
+  const size_t size = sizeof(header) + batch.size();
+  size_t sent = 0;
+  if (fd_ >= 0 && buffer_.empty()) {
+    const iovec iov[] = {{header, sizeof(header)},
+                         {const_cast<char*>(batch.data()), batch.size()}};
+    const ssize_t n = Send(iov, 2);
+    if (n < 0) {
+      Disconnect();
+    } else {
+      sent = n;
+    }
+    if (sent == size) {
+      num_spans_sent_ += spans.size();
+      return;
+    }
+  }
+  // A partly sent batch is kept even if the buffer is full: dropping the rest
+  // would leave the agent mid-batch.
+  if (sent == 0 && buffered_bytes_ + size > options_.max_buffer_bytes) {
+    num_spans_dropped_ += spans.size();
+    return;
+  }
+  Batch buffered{std::string(header, sizeof(header)),
+                 static_cast<int>(spans.size()), sent};
+  buffered.data.append(batch.data(), batch.size());
+  buffered_bytes_ += size - sent;
+  buffer_.push_back(std::move(buffered));
+}
+
+void UnixSocketExporterImpl::Flush() {
+  absl::MutexLock l(&mu_);
+  if (buffer_.empty()) return;
+  MaybeConnect();
+  if (fd_ >= 0) SendBuffered();
+}
+
+bool UnixSocketExporterImpl::connected() const {
+  absl::MutexLock l(&mu_);
+  return fd_ >= 0;
+}
+
+size_t UnixSocketExporterImpl::buffered_bytes() const {
+  absl::MutexLock l(&mu_);
+  return buffered_bytes_;
+}
+
+uint64_t UnixSocketExporterImpl::num_spans_sent() const {
+  absl::MutexLock l(&mu_);
+  return num_spans_sent_;
+}
+
+uint64_t UnixSocketExporterImpl::num_spans_dropped() const {
+  absl::MutexLock l(&mu_);
+  return num_spans_dropped_;
+}
+
+void UnixSocketExporterImpl::MaybeConnect() {
+  if (fd_ >= 0 || absl::Now() < next_connect_time_) return;
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (options_.socket_path.size() >= sizeof(address.sun_path)) {
+    if (!logged_connect_failure_) {
+      std::cerr << "UnixSocketExporter: socket path is too long: "
+                << options_.socket_path << "\n";
+      logged_connect_failure_ = true;
+    }
+    next_connect_time_ = absl::InfiniteFuture();
+    return;
+  }
+  memcpy(address.sun_path, options_.socket_path.data(),
+         options_.socket_path.size());
+  const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd >= 0 && connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                         sizeof(address)) == 0) {
+    fd_ = fd;
+    reconnect_backoff_ = options_.min_reconnect_backoff;
+    logged_connect_failure_ = false;
+    return;
+  }
+  if (!logged_connect_failure_) {
+    std::cerr << "UnixSocketExporter: can't connect to "
+              << options_.socket_path << ": " << strerror(errno) << "\n";
+    logged_connect_failure_ = true;
+  }
+  if (fd >= 0) close(fd);
+  next_connect_time_ = absl::Now() + reconnect_backoff_;
+  reconnect_backoff_ =
+      std::min(2 * reconnect_backoff_, options_.max_reconnect_backoff);
+}
+
+void UnixSocketExporterImpl::Disconnect() {
+  close(fd_);
+  fd_ = -1;
+  // Reconnect on the next export; the backoff applies if that fails.
+  next_connect_time_ = absl::InfinitePast();
+  if (!buffer_.empty() && buffer_.front().offset > 0) {
+    const Batch& partial = buffer_.front();
+    buffered_bytes_ -= partial.data.size() - partial.offset;
+    num_spans_dropped_ += partial.num_spans;
+    buffer_.pop_front();
+  }
+}
+
+void UnixSocketExporterImpl::SendBuffered() {
+  std::vector<iovec> iov;
+  while (!buffer_.empty()) {
+    iov.clear();
+    for (const auto& batch : buffer_) {
+      if (iov.size() == IOV_MAX) break;
+      iov.push_back({const_cast<char*>(batch.data.data()) + batch.offset,
+                     batch.data.size() - batch.offset});
+    }
+    const ssize_t n = Send(iov.data(), iov.size());
+    if (n < 0) {
+      Disconnect();
+      return;
+    }
+    if (n == 0) return;  // The socket is full.
+    buffered_bytes_ -= n;
+    size_t remaining = n;
+    while (remaining > 0) {
+      Batch& batch = buffer_.front();
+      const size_t unsent = batch.data.size() - batch.offset;
+      if (remaining < unsent) {
+        batch.offset += remaining;
+        break;
+      }
+      remaining -= unsent;
+      num_spans_sent_ += batch.num_spans;
+      buffer_.pop_front();
+    }
+  }
+}
+
+ssize_t UnixSocketExporterImpl::Send(const iovec* iov, size_t iov_count) {
+  msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = const_cast<iovec*>(iov);
+  message.msg_iovlen = iov_count;
+  while (true) {
+    const ssize_t n = sendmsg(fd_, &message, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n >= 0) return n;
+    if (errno == EINTR) continue;
+    if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+    std::cerr << "UnixSocketExporter: send failed: " << strerror(errno)
+              << "\n";
+    return -1;
+  }
+}
+
+}  // namespace trace
+}  // namespace exporters
+}  // namespace opencensus
@@ -0,0 +1,117 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_EXPORTERS_TRACE_UNIX_SOCKET_INTERNAL_UNIX_SOCKET_EXPORTER_IMPL_H_
+#define OPENCENSUS_EXPORTERS_TRACE_UNIX_SOCKET_INTERNAL_UNIX_SOCKET_EXPORTER_IMPL_H_
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "opencensus/common/internal/executor.h"
+#include "opencensus/exporters/trace/unix_socket/unix_socket_exporter.h"
+#include "opencensus/trace/exporter/span_batch_encoder.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/span_exporter.h"
+
+namespace opencensus {
+namespace exporters {
+namespace trace {
+
+// UnixSocketExporterImpl is the SpanExporter::Handler behind
+// UnixSocketExporter.
+//
+// Socket I/O happens in Export(), on the exporter thread, and in Flush(),
+// which runs every options.flush_interval on the shared executor, with
+// non-blocking sends. A batch is sent straight from the encoder's buffer with
+// one sendmsg() when nothing is buffered ahead of it; only the part the socket
+// doesn't take is copied into the outbound buffer.
+class UnixSocketExporterImpl
+    : public ::opencensus::trace::exporter::SpanExporter::Handler {
+ public:
+  explicit UnixSocketExporterImpl(const UnixSocketExporter::Options& options);
+  // Takes ownership of the connected socket 'fd', e.g. one end of a
+  // socketpair(). If the connection breaks, reconnects to
+  // options.socket_path.
+  UnixSocketExporterImpl(const UnixSocketExporter::Options& options, int fd);
+  // Stops flushing and closes the socket. Buffered spans are dropped.
+  ~UnixSocketExporterImpl() override;
+
+  // Sends any buffered batches, then the new one. If 'spans' is empty, only
+  // sends buffered batches.
+  void Export(const std::vector<::opencensus::trace::exporter::SpanData>& spans)
+      override LOCKS_EXCLUDED(mu_);
+
+  // Reconnects if needed, and sends buffered batches.
+  void Flush() LOCKS_EXCLUDED(mu_);
+
+  bool connected() const LOCKS_EXCLUDED(mu_);
+  // The number of encoded bytes waiting to be sent.
+  size_t buffered_bytes() const LOCKS_EXCLUDED(mu_);
+  // Spans written to the socket. The agent may not have read them yet.
+  uint64_t num_spans_sent() const LOCKS_EXCLUDED(mu_);
+  uint64_t num_spans_dropped() const LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Batch {
+    // The length prefix and the encoded batch.
+    std::string data;
+    int num_spans;
+    // How much of data has been sent.
+    size_t offset;
+  };
+
+  // Connects to options_.socket_path if not connected and the backoff has
+  // expired.
+  void MaybeConnect() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Closes the socket. A partly sent batch is dropped, since the agent can't
+  // resume it on a new connection.
+  void Disconnect() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Sends buffered batches until the socket would block.
+  void SendBuffered() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Sends without blocking. Returns the number of bytes sent, or -1 if the
+  // connection is broken.
+  ssize_t Send(const iovec* iov, size_t iov_count)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const UnixSocketExporter::Options options_;
+  // The periodic Flush().
+  common::Executor::TaskId flush_task_;
+
+  mutable absl::Mutex mu_;
+  ::opencensus::trace::exporter::SpanBatchEncoder encoder_ GUARDED_BY(mu_);
+  int fd_ GUARDED_BY(mu_) = -1;
+  absl::Time next_connect_time_ GUARDED_BY(mu_) = absl::InfinitePast();
+  absl::Duration reconnect_backoff_ GUARDED_BY(mu_);
+  // Whether a connection failure has been logged since the last success.
+  bool logged_connect_failure_ GUARDED_BY(mu_) = false;
+  std::deque<Batch> buffer_ GUARDED_BY(mu_);
+  size_t buffered_bytes_ GUARDED_BY(mu_) = 0;
+  uint64_t num_spans_sent_ GUARDED_BY(mu_) = 0;
+  uint64_t num_spans_dropped_ GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace trace
+}  // namespace exporters
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_EXPORTERS_TRACE_UNIX_SOCKET_INTERNAL_UNIX_SOCKET_EXPORTER_IMPL_H_
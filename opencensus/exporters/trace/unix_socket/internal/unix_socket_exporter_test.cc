@@ -0,0 +1,302 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/exporters/trace/unix_socket/internal/unix_socket_exporter_impl.h"
+
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "absl/base/internal/endian.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "opencensus/exporters/trace/unix_socket/unix_socket_exporter.h"
+#include "opencensus/trace/attribute_value_ref.h"
+#include "opencensus/trace/exporter/annotation.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/link.h"
+#include "opencensus/trace/exporter/message_event.h"
+#include "opencensus/trace/exporter/span_batch_encoder.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/status.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_id.h"
+
+namespace opencensus {
+namespace exporters {
+namespace trace {
+namespace {
+
+using ::opencensus::trace::AttributeValueRef;
+using ::opencensus::trace::SpanContext;
+using ::opencensus::trace::SpanId;
+using ::opencensus::trace::TraceId;
+using ::opencensus::trace::exporter::Annotation;
+using ::opencensus::trace::exporter::AttributeValue;
+using ::opencensus::trace::exporter::Link;
+using ::opencensus::trace::exporter::MessageEvent;
+using ::opencensus::trace::exporter::SpanBatchEncoder;
+using ::opencensus::trace::exporter::SpanData;
+using ::opencensus::trace::exporter::Status;
+
+constexpr uint8_t trace_id[] = {1, 2,  3,  4,  5,  6,  7,  8,
+                                9, 10, 11, 12, 13, 14, 15, 16};
+constexpr uint8_t span_id[] = {1, 0, 0, 0, 0, 0, 0, 1};
+
+SpanData MakeSpan(absl::string_view name) {
+  const absl::Time start = absl::FromUnixMicros(1500000000000000);
+  return SpanData(
+      name, SpanContext(TraceId(trace_id), SpanId(span_id)), SpanId(),
+      SpanData::TimeEvents<Annotation>({}, 0),
+      SpanData::TimeEvents<MessageEvent>({}, 0), std::vector<Link>(), 0,
+      {{"key", AttributeValue(AttributeValueRef("value"))}}, 0,
+      /*has_ended=*/true, start, start + absl::Microseconds(25), Status(),
+      /*has_remote_parent=*/false);
+}
+
+std::string Encode(const std::vector<SpanData>& spans) {
+  SpanBatchEncoder encoder;
+  return std::string(encoder.Encode(spans));
+}
+
+// Reads everything available from 'fd' without blocking.
+std::string ReadAvailable(int fd) {
+  std::string data;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+    data.append(buffer, n);
+  }
+  return data;
+}
+
+// Splits length-prefixed batches. Fails if 'data' ends mid-batch.
+std::vector<std::string> ParseBatches(absl::string_view data) {
+  std::vector<std::string> batches;
+  while (!data.empty()) {
+    EXPECT_LE(4, data.size());
+    if (data.size() < 4) break;
+    const uint32_t length = absl::little_endian::Load32(data.data());
+    data.remove_prefix(4);
+    EXPECT_LE(length, data.size());
+    batches.emplace_back(data.substr(0, length));
+    data.remove_prefix(std::min<size_t>(length, data.size()));
+  }
+  return batches;
+}
+
+TEST(UnixSocketExporterTest, SendsLengthPrefixedBatches) {
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  UnixSocketExporterImpl exporter(UnixSocketExporter::Options(), fds[0]);
+  const std::vector<SpanData> batch1 = {MakeSpan("Span1"), MakeSpan("Span2")};
+  const std::vector<SpanData> batch2 = {MakeSpan("Span3")};
+  exporter.Export(batch1);
+  exporter.Export(batch2);
+  EXPECT_EQ(3, exporter.num_spans_sent());
+  EXPECT_EQ(0, exporter.buffered_bytes());
+
+  const auto batches = ParseBatches(ReadAvailable(fds[1]));
+  ASSERT_EQ(2, batches.size());
+  EXPECT_EQ(Encode(batch1), batches[0]);
+  EXPECT_EQ(Encode(batch2), batches[1]);
+  close(fds[1]);
+}
+
+TEST(UnixSocketExporterTest, BuffersWhenSocketIsFull) {
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  const int buffer_size = 4096;
+  setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+  setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+  UnixSocketExporter::Options options;
+  options.max_buffer_bytes = 8192;
+  UnixSocketExporterImpl exporter(options, fds[0]);
+
+  const std::vector<SpanData> spans(10, MakeSpan("Span"));
+  const int num_batches = 200;
+  for (int i = 0; i < num_batches; ++i) {
+    exporter.Export(spans);  // Never blocks.
+  }
+  EXPECT_LT(0, exporter.buffered_bytes());
+  EXPECT_LT(0, exporter.num_spans_dropped());
+
+  // The agent catches up, and the buffer drains on later exports.
+  std::string received;
+  for (int i = 0; i < 1000 && exporter.buffered_bytes() > 0; ++i) {
+    received.append(ReadAvailable(fds[1]));
+    exporter.Export({});
+  }
+  received.append(ReadAvailable(fds[1]));
+  EXPECT_EQ(0, exporter.buffered_bytes());
+  EXPECT_EQ(num_batches * spans.size(),
+            exporter.num_spans_sent() + exporter.num_spans_dropped());
+
+  // Only whole batches were sent.
+  const auto batches = ParseBatches(received);
+  EXPECT_EQ(exporter.num_spans_sent(), batches.size() * spans.size());
+  const std::string expected = Encode(spans);
+  for (const auto& batch : batches) {
+    EXPECT_EQ(expected, batch);
+  }
+  close(fds[1]);
+}
+
+TEST(UnixSocketExporterTest, FlushesWithoutFurtherExports) {
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  const int buffer_size = 4096;
+  setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+  setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+  UnixSocketExporter::Options options;
+  options.flush_interval = absl::Milliseconds(1);
+  UnixSocketExporterImpl exporter(options, fds[0]);
+
+  const std::vector<SpanData> spans(10, MakeSpan("Span"));
+  const int num_batches = 50;
+  for (int i = 0; i < num_batches; ++i) {
+    exporter.Export(spans);
+  }
+  ASSERT_LT(0, exporter.buffered_bytes());
+
+  // No more exports: the agent reads, and the periodic flush sends the rest.
+  std::string received;
+  const absl::Time deadline = absl::Now() + absl::Seconds(10);
+  while (exporter.num_spans_sent() < num_batches * spans.size() &&
+         absl::Now() < deadline) {
+    received.append(ReadAvailable(fds[1]));
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  received.append(ReadAvailable(fds[1]));
+  EXPECT_EQ(0, exporter.buffered_bytes());
+  EXPECT_EQ(0, exporter.num_spans_dropped());
+  EXPECT_EQ(num_batches, ParseBatches(received).size());
+  close(fds[1]);
+}
+
+class UnixSocketExporterReconnectTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const char* tmp = getenv("TEST_TMPDIR");
+    std::string pattern = absl::StrCat(tmp != nullptr ? tmp : "/tmp",
+                                       "/unix_socket_exporter.XXXXXX");
+    ASSERT_NE(nullptr, mkdtemp(&pattern[0]));
+    dir_ = pattern;
+    path_ = absl::StrCat(dir_, "/agent.sock");
+  }
+
+  void TearDown() override {
+    if (listen_fd_ >= 0) close(listen_fd_);
+    unlink(path_.c_str());
+    rmdir(dir_.c_str());
+  }
+
+  void Listen() {
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_LE(0, listen_fd_);
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    ASSERT_LT(path_.size(), sizeof(address.sun_path));
+    memcpy(address.sun_path, path_.data(), path_.size());
+    ASSERT_EQ(0, bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address),
+                      sizeof(address)));
+    ASSERT_EQ(0, listen(listen_fd_, 1));
+  }
+
+  int Accept() { return accept(listen_fd_, nullptr, nullptr); }
+
+  std::string dir_;
+  std::string path_;
+  int listen_fd_ = -1;
+};
+
+TEST_F(UnixSocketExporterReconnectTest, ReconnectsWithBackoff) {
+  UnixSocketExporter::Options options;
+  options.socket_path = path_;
+  options.min_reconnect_backoff = absl::Milliseconds(200);
+  options.max_reconnect_backoff = absl::Milliseconds(200);
+  // Only reconnect on exports.
+  options.flush_interval = absl::Hours(1);
+  UnixSocketExporterImpl exporter(options);
+  const std::vector<SpanData> spans = {MakeSpan("Span")};
+
+  // The agent isn't up yet, so spans are buffered.
+  exporter.Export(spans);
+  EXPECT_FALSE(exporter.connected());
+  Listen();
+  // Still backing off.
+  exporter.Export(spans);
+  EXPECT_FALSE(exporter.connected());
+  absl::SleepFor(absl::Milliseconds(250));
+  exporter.Export(spans);
+  ASSERT_TRUE(exporter.connected());
+  int agent_fd = Accept();
+  ASSERT_LE(0, agent_fd);
+  EXPECT_EQ(3, ParseBatches(ReadAvailable(agent_fd)).size());
+  EXPECT_EQ(3, exporter.num_spans_sent());
+
+  // The agent restarts. The broken connection is noticed on the next send,
+  // and the exporter reconnects on the export after that.
+  close(agent_fd);
+  exporter.Export(spans);
+  EXPECT_FALSE(exporter.connected());
+  exporter.Export(spans);
+  ASSERT_TRUE(exporter.connected());
+  agent_fd = Accept();
+  ASSERT_LE(0, agent_fd);
+  EXPECT_EQ(2, ParseBatches(ReadAvailable(agent_fd)).size());
+  EXPECT_EQ(5, exporter.num_spans_sent());
+  EXPECT_EQ(0, exporter.num_spans_dropped());
+  close(agent_fd);
+}
+
+TEST_F(UnixSocketExporterReconnectTest, ReconnectsWithoutFurtherExports) {
+  UnixSocketExporter::Options options;
+  options.socket_path = path_;
+  options.min_reconnect_backoff = absl::Milliseconds(1);
+  options.flush_interval = absl::Milliseconds(1);
+  UnixSocketExporterImpl exporter(options);
+
+  // The agent isn't up yet, so the spans are buffered until it is.
+  exporter.Export({MakeSpan("Span")});
+  EXPECT_EQ(0, exporter.num_spans_sent());
+  Listen();
+  const absl::Time deadline = absl::Now() + absl::Seconds(10);
+  while (exporter.num_spans_sent() == 0 && absl::Now() < deadline) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  ASSERT_TRUE(exporter.connected());
+  const int agent_fd = Accept();
+  ASSERT_LE(0, agent_fd);
+  EXPECT_EQ(1, ParseBatches(ReadAvailable(agent_fd)).size());
+  EXPECT_EQ(1, exporter.num_spans_sent());
+  close(agent_fd);
+}
+
+}  // namespace
+}  // namespace trace
+}  // namespace exporters
+}  // namespace opencensus
@@ -0,0 +1,67 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_EXPORTERS_TRACE_UNIX_SOCKET_UNIX_SOCKET_EXPORTER_H_
+#define OPENCENSUS_EXPORTERS_TRACE_UNIX_SOCKET_UNIX_SOCKET_EXPORTER_H_
+
+#include <cstddef>
+#include <string>
+
+#include "absl/time/time.h"
+
+namespace opencensus {
+namespace exporters {
+namespace trace {
+
+// UnixSocketExporter streams exported spans to a local agent over a Unix
+// domain stream socket, avoiding a TCP or HTTP connection per process.
+//
+// Each export is sent as one batch encoded by
+// opencensus::trace::exporter::SpanBatchEncoder, preceded by its length as a
+// little-endian uint32 (the same framing as FileExporter's binary format).
+//
+// Writes never block the exporter thread. Whatever the socket won't take is
+// buffered, up to max_buffer_bytes, and sent on the next export or flush;
+// spans that don't fit are dropped. If the agent isn't listening or the
+// connection breaks, the exporter reconnects with exponential backoff,
+// buffering in the meantime.
+class UnixSocketExporter {
+ public:
+  struct Options {
+    // The path of the agent's listening socket.
+    std::string socket_path;
+    // The maximum number of encoded bytes waiting to be sent. Spans that don't
+    // fit are dropped.
+    size_t max_buffer_bytes = 4 << 20;
+    // The delay before reconnecting doubles after each failed attempt, from
+    // min_reconnect_backoff up to max_reconnect_backoff.
+    absl::Duration min_reconnect_backoff = absl::Milliseconds(100);
+    absl::Duration max_reconnect_backoff = absl::Seconds(30);
+    // How often buffered spans are retried on the shared executor, so that
+    // they don't wait for the next export.
+    absl::Duration flush_interval = absl::Seconds(1);
+  };
+
+  // Registers the exporter.
+  static void Register(const Options& options);
+
+ private:
+  UnixSocketExporter() = delete;
+};
+
+}  // namespace trace
+}  // namespace exporters
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_EXPORTERS_TRACE_UNIX_SOCKET_UNIX_SOCKET_EXPORTER_H_
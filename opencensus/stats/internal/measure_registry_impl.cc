@@ -14,8 +14,11 @@
 
 #include "opencensus/stats/internal/measure_registry_impl.h"
 
+#include <cstdint>
 #include <iostream>
+#include <string>
 
+#include "opencensus/common/internal/probes.h"
 #include "opencensus/stats/internal/stats_manager.h"
 
 namespace opencensus {
@@ -31,6 +34,11 @@ constexpr uint64_t kTypeMask = 0x4000000000000000ull;
 constexpr uint64_t kDoubleType = 0x0000000000000000ull;
 constexpr uint64_t kIntType = 0x4000000000000000ull;
 
+// The bytes of a string's heap buffer, if any.
+int64_t HeapBytes(const std::string& s) {
+  return common::MemoryAccount::StringBytes(s) - sizeof(std::string);
+}
+
 }  // namespace
 
 // static
@@ -77,6 +85,19 @@ uint64_t MeasureRegistryImpl::RegisterImpl(MeasureDescriptor descriptor) {
   const uint64_t id =
       CreateMeasureId(registered_descriptors_.size(), true, descriptor.type());
   id_map_.emplace_hint(it, descriptor.name(), id);
+  // Not gated on the semaphore: measures are usually registered at startup,
+  // and this is rare enough that the arguments don't matter.
+  OPENCENSUS_PROBE(measure_register, IdToIndex(id), descriptor.name().data(),
+                   descriptor.name().size());
+  // The key is the copy of the name in id_map_, with its node; the data is the
+  // descriptor.
+  memory_account_.Add(
+      1,
+      common::MemoryAccount::StringBytes(descriptor.name()) +
+          sizeof(uint64_t) + 2 * sizeof(void*),
+      sizeof(MeasureDescriptor) +
+          HeapBytes(descriptor.name()) + HeapBytes(descriptor.units()) +
+          HeapBytes(descriptor.description()));
   registered_descriptors_.push_back(std::move(descriptor));
   return id;
 }
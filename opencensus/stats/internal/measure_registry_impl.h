@@ -22,6 +22,7 @@
 
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "opencensus/common/internal/memory_account.h"
 #include "opencensus/stats/measure.h"
 #include "opencensus/stats/measure_descriptor.h"
 
@@ -80,6 +81,8 @@ class MeasureRegistryImpl {
   std::vector<MeasureDescriptor> registered_descriptors_ GUARDED_BY(mu_);
   // A map from measure names to IDs.
   std::unordered_map<std::string, uint64_t> id_map_ GUARDED_BY(mu_);
+  // Updated as measures are registered.
+  common::MemoryAccount memory_account_{"stats/measure_registry"};
 };
 
 template <typename MeasureT>
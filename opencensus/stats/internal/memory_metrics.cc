@@ -0,0 +1,190 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/stats/memory_metrics.h"
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "opencensus/stats/aggregation.h"
+#include "opencensus/stats/aggregation_window.h"
+#include "opencensus/stats/measure_registry.h"
+#include "opencensus/stats/recording.h"
+#include "opencensus/stats/stats_exporter.h"
+
+namespace opencensus {
+namespace stats {
+
+namespace {
+
+constexpr char kBytesMeasureName[] = "opencensus.io/memory/bytes";
+constexpr char kEntriesMeasureName[] = "opencensus.io/memory/entries";
+constexpr char kComponentKey[] = "component";
+constexpr char kNameKey[] = "name";
+constexpr char kKindKey[] = "kind";
+
+// The views are sums, so Update() records the change in each estimate since
+// the last update.
+class Updater {
+ public:
+  static Updater* Get() {
+    static Updater* global_updater = new Updater;
+    return global_updater;
+  }
+
+  void set_enabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_release);
+  }
+
+  void Update() LOCKS_EXCLUDED(mu_) {
+    if (!enabled_.load(std::memory_order_acquire)) return;
+    // Accounts may share a component and name, e.g. two views with the same
+    // name on different measures.
+    std::map<std::pair<std::string, std::string>, Totals> current;
+    for (const auto& usage : common::MemoryAccount::GetAll()) {
+      Totals& totals = current[{usage.component, usage.name}];
+      totals.entries += usage.entries;
+      totals.key_bytes += usage.key_bytes;
+      totals.data_bytes += usage.data_bytes;
+    }
+    absl::MutexLock l(&mu_);
+    for (const auto& entry : current) {
+      Totals& last = last_[entry.first];
+      RecordChange(entry.first, entry.second, last);
+      last = entry.second;
+    }
+    // Accounts that went away, e.g. views that were removed.
+    for (auto it = last_.begin(); it != last_.end();) {
+      if (current.find(it->first) == current.end()) {
+        RecordChange(it->first, Totals(), it->second);
+        it = last_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+ private:
+  struct Totals {
+    int64_t entries = 0;
+    int64_t key_bytes = 0;
+    int64_t data_bytes = 0;
+  };
+
+  static void RecordChange(const std::pair<std::string, std::string>& key,
+                           const Totals& now, const Totals& last) {
+    const std::string& component = key.first;
+    const std::string& name = key.second;
+    if (now.entries != last.entries) {
+      Record({{MemoryMetrics::EntriesMeasure(),
+               static_cast<double>(now.entries - last.entries)}},
+             {{kComponentKey, component}, {kNameKey, name}});
+    }
+    if (now.key_bytes != last.key_bytes) {
+      Record({{MemoryMetrics::BytesMeasure(),
+               static_cast<double>(now.key_bytes - last.key_bytes)}},
+             {{kComponentKey, component}, {kNameKey, name}, {kKindKey, "key"}});
+    }
+    if (now.data_bytes != last.data_bytes) {
+      Record(
+          {{MemoryMetrics::BytesMeasure(),
+            static_cast<double>(now.data_bytes - last.data_bytes)}},
+          {{kComponentKey, component}, {kNameKey, name}, {kKindKey, "data"}});
+    }
+  }
+
+  std::atomic<bool> enabled_{false};
+  absl::Mutex mu_;
+  std::map<std::pair<std::string, std::string>, Totals> last_ GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+// static
+void MemoryMetrics::Enable() {
+  BytesMeasure();
+  EntriesMeasure();
+  StatsExporter::AddView(BytesView());
+  StatsExporter::AddView(EntriesView());
+  Updater::Get()->set_enabled(true);
+  Update();
+}
+
+// static
+void MemoryMetrics::Disable() { Updater::Get()->set_enabled(false); }
+
+// static
+void MemoryMetrics::Update() { Updater::Get()->Update(); }
+
+// static
+std::vector<MemoryMetrics::Usage> MemoryMetrics::GetUsage() {
+  return common::MemoryAccount::GetAll();
+}
+
+// static
+MeasureDouble MemoryMetrics::BytesMeasure() {
+  static const MeasureDouble measure = MeasureRegistry::RegisterDouble(
+      kBytesMeasureName, "By",
+      "Estimated memory used by OpenCensus data structures.");
+  return measure;
+}
+
+// static
+MeasureDouble MemoryMetrics::EntriesMeasure() {
+  static const MeasureDouble measure = MeasureRegistry::RegisterDouble(
+      kEntriesMeasureName, "1",
+      "Number of entries in OpenCensus data structures.");
+  return measure;
+}
+
+// static
+const ViewDescriptor& MemoryMetrics::BytesView() {
+  static const ViewDescriptor* descriptor = new ViewDescriptor(
+      ViewDescriptor()
+          .set_name("opencensus.io/memory/bytes")
+          .set_measure(kBytesMeasureName)
+          .set_aggregation(Aggregation::Sum())
+          .set_aggregation_window(AggregationWindow::Cumulative())
+          .add_column(kComponentKey)
+          .add_column(kNameKey)
+          .add_column(kKindKey)
+          .set_description(
+              "Estimated bytes used by OpenCensus data structures, by "
+              "component, name and kind."));
+  return *descriptor;
+}
+
+// static
+const ViewDescriptor& MemoryMetrics::EntriesView() {
+  static const ViewDescriptor* descriptor = new ViewDescriptor(
+      ViewDescriptor()
+          .set_name("opencensus.io/memory/entries")
+          .set_measure(kEntriesMeasureName)
+          .set_aggregation(Aggregation::Sum())
+          .set_aggregation_window(AggregationWindow::Cumulative())
+          .add_column(kComponentKey)
+          .add_column(kNameKey)
+          .set_description(
+              "Number of view rows, measures or spans held by OpenCensus "
+              "data structures, by component and name."));
+  return *descriptor;
+}
+
+}  // namespace stats
+}  // namespace opencensus
@@ -0,0 +1,143 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/stats/memory_metrics.h"
+
+#include <cstdint>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "opencensus/stats/stats.h"
+
+namespace opencensus {
+namespace stats {
+namespace {
+
+constexpr char kMeasureName[] = "test/memory_metrics/measure";
+constexpr char kViewName[] = "test/memory_metrics/view";
+
+MeasureDouble TestMeasure() {
+  static const MeasureDouble measure =
+      MeasureRegistry::RegisterDouble(kMeasureName, "1", "");
+  return measure;
+}
+
+ViewDescriptor TestDescriptor() {
+  return ViewDescriptor()
+      .set_name(kViewName)
+      .set_measure(kMeasureName)
+      .set_aggregation(Aggregation::Sum())
+      .add_column("key");
+}
+
+// Returns the usage of the test view's account.
+MemoryMetrics::Usage GetViewUsage() {
+  for (const auto& usage : MemoryMetrics::GetUsage()) {
+    if (usage.component == "stats/view" && usage.name == kViewName) {
+      return usage;
+    }
+  }
+  return MemoryMetrics::Usage();
+}
+
+TEST(MemoryMetricsTest, CountsViewRows) {
+  TestMeasure();
+  {
+    View view(TestDescriptor());
+    ASSERT_TRUE(view.IsValid());
+    const MemoryMetrics::Usage empty = GetViewUsage();
+    EXPECT_EQ(0, empty.entries);
+    EXPECT_EQ(0, empty.key_bytes);
+    EXPECT_LT(0, empty.data_bytes);
+
+    Record({{TestMeasure(), 1.0}}, {{"key", "a"}});
+    const MemoryMetrics::Usage one_row = GetViewUsage();
+    EXPECT_EQ(1, one_row.entries);
+    EXPECT_LT(0, one_row.key_bytes);
+    EXPECT_LT(empty.data_bytes, one_row.data_bytes);
+
+    // Recording to an existing row costs nothing.
+    Record({{TestMeasure(), 1.0}}, {{"key", "a"}});
+    EXPECT_EQ(one_row.bytes(), GetViewUsage().bytes());
+
+    // Long tag values cost more than short ones.
+    Record({{TestMeasure(), 1.0}}, {{"key", "b"}});
+    const int64_t short_key_bytes = GetViewUsage().key_bytes;
+    Record({{TestMeasure(), 1.0}}, {{"key", std::string(100, 'c')}});
+    const MemoryMetrics::Usage three_rows = GetViewUsage();
+    EXPECT_EQ(3, three_rows.entries);
+    EXPECT_LT(short_key_bytes - one_row.key_bytes + 100,
+              three_rows.key_bytes - short_key_bytes);
+  }
+  // The account goes away with the view.
+  EXPECT_EQ(0, GetViewUsage().entries);
+}
+
+TEST(MemoryMetricsTest, CountsMeasures) {
+  auto find_registry = []() {
+    for (const auto& usage : MemoryMetrics::GetUsage()) {
+      if (usage.component == "stats/measure_registry") return usage;
+    }
+    return MemoryMetrics::Usage();
+  };
+  const MemoryMetrics::Usage before = find_registry();
+  MeasureRegistry::RegisterInt("test/memory_metrics/new_measure", "1", "");
+  const MemoryMetrics::Usage after = find_registry();
+  EXPECT_EQ(before.entries + 1, after.entries);
+  EXPECT_LT(before.bytes(), after.bytes());
+}
+
+TEST(MemoryMetricsTest, ExportsViews) {
+  MemoryMetrics::Enable();
+  View entries_view(MemoryMetrics::EntriesView());
+  View bytes_view(MemoryMetrics::BytesView());
+  ASSERT_TRUE(entries_view.IsValid());
+  ASSERT_TRUE(bytes_view.IsValid());
+
+  TestMeasure();
+  {
+    View view(TestDescriptor());
+    Record({{TestMeasure(), 1.0}}, {{"key", "a"}});
+    Record({{TestMeasure(), 1.0}}, {{"key", "b"}});
+    MemoryMetrics::Update();
+    EXPECT_EQ(2, entries_view.GetData().double_data().at(
+                     {"stats/view", kViewName}));
+    EXPECT_EQ(GetViewUsage().key_bytes,
+              bytes_view.GetData().double_data().at(
+                  {"stats/view", kViewName, "key"}));
+    EXPECT_EQ(GetViewUsage().data_bytes,
+              bytes_view.GetData().double_data().at(
+                  {"stats/view", kViewName, "data"}));
+  }
+  // Removed accounts are recorded as zero.
+  MemoryMetrics::Update();
+  EXPECT_EQ(0, entries_view.GetData().double_data().at(
+                   {"stats/view", kViewName}));
+  EXPECT_EQ(0, bytes_view.GetData().double_data().at(
+                   {"stats/view", kViewName, "data"}));
+
+  // Updates stop when disabled.
+  MemoryMetrics::Disable();
+  {
+    View view(TestDescriptor());
+    Record({{TestMeasure(), 1.0}}, {{"key", "a"}});
+    MemoryMetrics::Update();
+    EXPECT_EQ(0, entries_view.GetData().double_data().at(
+                     {"stats/view", kViewName}));
+  }
+}
+
+}  // namespace
+}  // namespace stats
+}  // namespace opencensus
@@ -0,0 +1,40 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_STATS_INTERNAL_RECORDING_NOOP_H_
+#define OPENCENSUS_STATS_INTERNAL_RECORDING_NOOP_H_
+
+// Inline no-op definition of Record(), used instead of recording.cc in builds
+// with --define opencensus_noop=true. Included by recording.h; don't include
+// directly.
+
+#include <initializer_list>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "opencensus/stats/measure.h"
+#include "opencensus/stats/recording.h"
+
+namespace opencensus {
+namespace stats {
+
+inline void Record(
+    std::initializer_list<Measurement> /*measurements*/,
+    std::initializer_list<std::pair<absl::string_view, absl::string_view>>
+    /*tags*/) {}
+
+}  // namespace stats
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_STATS_INTERNAL_RECORDING_NOOP_H_
@@ -0,0 +1,110 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Allocation budgets for the stats recording hot path. A failure here means a
+// change added heap allocations to Record(); either remove them or, if they
+// are unavoidable, change the budget with a comment saying why.
+
+#include <string>
+
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "opencensus/common/internal/allocation_counter.h"
+#include "opencensus/stats/stats.h"
+
+namespace opencensus {
+namespace stats {
+namespace {
+
+using ::opencensus::common::AllocationCounter;
+
+constexpr char kMeasureName[] = "allocation_test/measure";
+constexpr char kUnusedMeasureName[] = "allocation_test/unused";
+constexpr char kKey1[] = "key1";
+constexpr char kKey2[] = "key2";
+
+MeasureDouble TestMeasure() {
+  static const MeasureDouble measure =
+      MeasureRegistry::RegisterDouble(kMeasureName, "", "");
+  return measure;
+}
+
+ViewDescriptor TestDescriptor(const Aggregation& aggregation,
+                              const AggregationWindow& window) {
+  return ViewDescriptor()
+      .set_name("allocation_test/view")
+      .set_measure(kMeasureName)
+      .set_aggregation(aggregation)
+      .set_aggregation_window(window)
+      .add_column(kKey1)
+      .add_column(kKey2);
+}
+
+class StatsAllocationTest : public ::testing::Test {
+ protected:
+  void SetUp() override { TestMeasure(); }
+
+  // Records to a row, then checks that recording to it again doesn't allocate.
+  void ExpectNoAllocationsForExistingRow(const ViewDescriptor& descriptor) {
+    View view(descriptor);
+    const std::string long_value(100, 'x');
+    Record({{TestMeasure(), 1.0}}, {{kKey1, "value"}, {kKey2, long_value}});
+    Record({{TestMeasure(), 1.0}});
+
+    AllocationCounter counter;
+    Record({{TestMeasure(), 2.0}}, {{kKey1, "value"}, {kKey2, long_value}});
+    Record({{TestMeasure(), 3.0}}, {{kKey2, long_value}, {kKey1, "value"}});
+    Record({{TestMeasure(), 4.0}});
+    Record({{TestMeasure(), 5.0}}, {{"other_key", "value"}});
+    EXPECT_EQ(0, counter.count()) << descriptor.DebugString();
+  }
+};
+
+TEST_F(StatsAllocationTest, RecordToExistingRow) {
+  ExpectNoAllocationsForExistingRow(
+      TestDescriptor(Aggregation::Count(), AggregationWindow::Cumulative()));
+  ExpectNoAllocationsForExistingRow(
+      TestDescriptor(Aggregation::Sum(), AggregationWindow::Cumulative()));
+  ExpectNoAllocationsForExistingRow(TestDescriptor(
+      Aggregation::Distribution(BucketBoundaries::Explicit({0, 10})),
+      AggregationWindow::Cumulative()));
+}
+
+TEST_F(StatsAllocationTest, RecordToExistingIntervalRow) {
+  ExpectNoAllocationsForExistingRow(TestDescriptor(
+      Aggregation::Sum(), AggregationWindow::Interval(absl::Minutes(1))));
+  ExpectNoAllocationsForExistingRow(TestDescriptor(
+      Aggregation::Distribution(BucketBoundaries::Explicit({0, 10})),
+      AggregationWindow::Interval(absl::Minutes(1))));
+}
+
+TEST_F(StatsAllocationTest, RecordWithoutViews) {
+  const MeasureDouble unused =
+      MeasureRegistry::RegisterDouble(kUnusedMeasureName, "", "");
+  AllocationCounter counter;
+  Record({{unused, 1.0}}, {{kKey1, "value"}});
+  EXPECT_EQ(0, counter.count());
+}
+
+TEST_F(StatsAllocationTest, RecordToNewRowAllocates) {
+  View view(
+      TestDescriptor(Aggregation::Sum(), AggregationWindow::Cumulative()));
+  AllocationCounter counter;
+  Record({{TestMeasure(), 1.0}}, {{kKey1, "new row"}});
+  EXPECT_GT(counter.count(), 0);  // Make sure allocations are counted.
+}
+
+}  // namespace
+}  // namespace stats
+}  // namespace opencensus
@@ -14,12 +14,15 @@
 
 #include "opencensus/stats/stats_exporter.h"
 
-#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/synchronization/mutex.h"
-#include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "opencensus/common/internal/executor.h"
+#include "opencensus/common/internal/probes.h"
+#include "opencensus/stats/memory_metrics.h"
 
 namespace opencensus {
 namespace stats {
@@ -42,22 +45,38 @@ class StatsExporterImpl {
     views_.erase(std::string(name));
   }
 
+  std::vector<std::pair<ViewDescriptor, ViewData>> GetViewData() {
+    absl::MutexLock l(&mu_);
+    std::vector<std::pair<ViewDescriptor, ViewData>> data;
+    data.reserve(views_.size());
+    for (const auto& view : views_) {
+      data.emplace_back(view.second->descriptor(), view.second->GetData());
+    }
+    return data;
+  }
+
   // Adds a handler, which cannot be subsequently removed (except by
-  // ClearHandlersForTesting()). The background thread is started when the
-  // first handler is registered.
+  // ClearHandlersForTesting()). Periodic exports start when the first handler
+  // is registered.
   void RegisterHandler(std::unique_ptr<StatsExporter::Handler> handler) {
     absl::MutexLock l(&mu_);
     handlers_.push_back(std::move(handler));
-    if (!thread_started_) {
-      StartExportThread();
+    if (!export_scheduled_) {
+      common::Executor::Get()->SchedulePeriodic([this]() { Export(); },
+                                                export_interval_);
+      export_scheduled_ = true;
     }
   }
 
   void Export() {
+    // Before taking mu_: this records to views.
+    MemoryMetrics::Update();
     absl::MutexLock l(&mu_);
+    OPENCENSUS_PROBE(stats_export_start, views_.size());
     for (const auto& view : views_) {
       SendToHandlers(view.second->descriptor(), view.second->GetData());
     }
+    OPENCENSUS_PROBE(stats_export_done, views_.size());
   }
 
   void ClearHandlersForTesting() {
@@ -75,24 +94,6 @@ class StatsExporterImpl {
     }
   }
 
-  void StartExportThread() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    t_ = std::thread(&StatsExporterImpl::RunWorkerLoop, this);
-    thread_started_ = true;
-  }
-
-  // Loops forever, calling Export() every export_interval_.
-  void RunWorkerLoop() {
-    absl::Time next_export_time = absl::Now() + export_interval_;
-    while (true) {
-      // SleepFor() returns immediately when given a negative duration.
-      absl::SleepFor(next_export_time - absl::Now());
-      // In case the last export took longer than the export interval, we
-      // calculate the next time from now.
-      next_export_time = absl::Now() + export_interval_;
-      Export();
-    }
-  }
-
   const absl::Duration export_interval_ = absl::Seconds(10);
 
   mutable absl::Mutex mu_;
@@ -101,8 +102,7 @@ class StatsExporterImpl {
       GUARDED_BY(mu_);
   std::unordered_map<std::string, std::unique_ptr<View>> views_ GUARDED_BY(mu_);
 
-  bool thread_started_ GUARDED_BY(mu_) = false;
-  std::thread t_ GUARDED_BY(mu_);
+  bool export_scheduled_ GUARDED_BY(mu_) = false;
 };
 
 void StatsExporter::AddView(const ViewDescriptor& view) {
@@ -113,6 +113,11 @@ void StatsExporter::RemoveView(absl::string_view name) {
   StatsExporterImpl::Get()->RemoveView(name);
 }
 
+std::vector<std::pair<ViewDescriptor, ViewData>>
+StatsExporter::GetViewData() {
+  return StatsExporterImpl::Get()->GetViewData();
+}
+
 void StatsExporter::RegisterHandler(std::unique_ptr<Handler> handler) {
   StatsExporterImpl::Get()->RegisterHandler(std::move(handler));
 }
@@ -0,0 +1,53 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_STATS_INTERNAL_STATS_EXPORTER_NOOP_H_
+#define OPENCENSUS_STATS_INTERNAL_STATS_EXPORTER_NOOP_H_
+
+// Inline no-op definitions of the StatsExporter API, used instead of
+// stats_exporter.cc in builds with --define opencensus_noop=true. Views are not
+// kept and handlers are destroyed immediately. Included by stats_exporter.h;
+// don't include directly.
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "opencensus/stats/stats_exporter.h"
+#include "opencensus/stats/view_descriptor.h"
+
+namespace opencensus {
+namespace stats {
+
+inline void StatsExporter::AddView(const ViewDescriptor& /*view*/) {}
+
+inline void StatsExporter::RemoveView(absl::string_view /*name*/) {}
+
+inline std::vector<std::pair<ViewDescriptor, ViewData>>
+StatsExporter::GetViewData() {
+  return {};
+}
+
+inline void StatsExporter::RegisterHandler(
+    std::unique_ptr<Handler> /*handler*/) {}
+
+inline void StatsExporter::ExportForTesting() {}
+
+inline void StatsExporter::ClearHandlersForTesting() {}
+
+}  // namespace stats
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_STATS_INTERNAL_STATS_EXPORTER_NOOP_H_
@@ -18,6 +18,8 @@
 
 #include "absl/base/macros.h"
 #include "absl/time/time.h"
+#include "opencensus/common/internal/clock.h"
+#include "opencensus/common/internal/probes.h"
 
 namespace opencensus {
 namespace stats {
@@ -31,7 +33,13 @@ namespace stats {
 
 StatsManager::ViewInformation::ViewInformation(const ViewDescriptor& descriptor,
                                                absl::Mutex* mu)
-    : descriptor_(descriptor), mu_(mu), data_(absl::Now(), descriptor) {}
+    : descriptor_(descriptor),
+      mu_(mu),
+      data_(common::Clock::Now(), descriptor),
+      tag_values_(descriptor.columns().size()),
+      memory_account_("stats/view", descriptor.name()) {
+  memory_account_.Add(0, 0, sizeof(ViewInformation));
+}
 
 bool StatsManager::ViewInformation::Matches(
     const ViewDescriptor& descriptor) const {
@@ -57,25 +65,34 @@ int StatsManager::ViewInformation::RemoveConsumer() {
 
 void StatsManager::ViewInformation::Record(
     double value,
-    absl::Span<const std::pair<absl::string_view, absl::string_view>> tags) {
+    absl::Span<const std::pair<absl::string_view, absl::string_view>> tags,
+    absl::Time now) {
   mu_->AssertHeld();
-  std::vector<std::string> tag_values(descriptor_.columns().size());
-  for (int i = 0; i < tag_values.size(); ++i) {
+  for (int i = 0; i < tag_values_.size(); ++i) {
     const std::string& column = descriptor_.columns()[i];
+    tag_values_[i].clear();
     for (const auto& tag : tags) {
       if (tag.first == column) {
-        tag_values[i] = std::string(tag.second);
+        tag_values_[i].assign(tag.second.data(), tag.second.size());
         break;
       }
     }
   }
-  data_.Add(value, tag_values, absl::Now());
+  const size_t num_rows = data_.num_rows();
+  data_.Add(value, tag_values_, now);
+  if (data_.num_rows() != num_rows) {
+    int64_t key_bytes = 0;
+    for (const auto& tag_value : tag_values_) {
+      key_bytes += common::MemoryAccount::StringBytes(tag_value);
+    }
+    memory_account_.Add(1, key_bytes, data_.row_data_bytes());
+  }
 }
 
 ViewDataImpl StatsManager::ViewInformation::GetData() const {
   absl::ReaderMutexLock l(mu_);
   if (data_.type() == ViewDataImpl::Type::kStatsObject) {
-    return ViewDataImpl(data_, absl::Now());
+    return ViewDataImpl(data_, common::Clock::Now());
   } else {
     return data_;
   }
@@ -86,10 +103,11 @@ ViewDataImpl StatsManager::ViewInformation::GetData() const {
 
 void StatsManager::MeasureInformation::Record(
     double value,
-    absl::Span<const std::pair<absl::string_view, absl::string_view>> tags) {
+    absl::Span<const std::pair<absl::string_view, absl::string_view>> tags,
+    absl::Time now) {
   mu_->AssertHeld();
   for (auto& view : views_) {
-    view->Record(value, tags);
+    view->Record(value, tags, now);
   }
 }
 
@@ -135,15 +153,26 @@ void StatsManager::Record(
     std::initializer_list<std::pair<absl::string_view, absl::string_view>>
         tags) {
   absl::MutexLock l(&mu_);
+  // Read under mu_, so that each view sees times in order. One read serves
+  // every view of every measurement.
+  const absl::Time now = common::Clock::Now();
   for (const auto& measurement : measurements) {
     if (MeasureRegistryImpl::IdValid(measurement.id_)) {
       const uint64_t index = MeasureRegistryImpl::IdToIndex(measurement.id_);
       switch (MeasureRegistryImpl::IdToType(measurement.id_)) {
         case MeasureDescriptor::Type::kDouble:
-          measures_[index].Record(measurement.value_double_, tags);
+          if (OPENCENSUS_PROBE_ENABLED(stats_record_double)) {
+            OPENCENSUS_PROBE(stats_record_double, index,
+                             measurement.value_double_, tags.size());
+          }
+          measures_[index].Record(measurement.value_double_, tags, now);
           break;
         case MeasureDescriptor::Type::kInt64:
-          measures_[index].Record(measurement.value_int_, tags);
+          if (OPENCENSUS_PROBE_ENABLED(stats_record_int)) {
+            OPENCENSUS_PROBE(stats_record_int, index, measurement.value_int_,
+                             tags.size());
+          }
+          measures_[index].Record(measurement.value_int_, tags, now);
           break;
       }
     }
@@ -16,9 +16,13 @@
 #define OPENCENSUS_STATS_INTERNAL_STATS_MANAGER_H_
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
+#include "opencensus/common/internal/memory_account.h"
 #include "opencensus/common/internal/stats_object.h"
 #include "opencensus/stats/distribution.h"
 #include "opencensus/stats/internal/measure_registry_impl.h"
@@ -56,7 +60,8 @@ class StatsManager final {
     // Requires holding *mu_.
     void Record(
         double value,
-        absl::Span<const std::pair<absl::string_view, absl::string_view>> tags);
+        absl::Span<const std::pair<absl::string_view, absl::string_view>> tags,
+        absl::Time now);
 
     // Retrieves a copy of the data.
     ViewDataImpl GetData() const LOCKS_EXCLUDED(*mu_);
@@ -76,6 +81,11 @@ class StatsManager final {
     static DataType DataTypeForDescriptor(const ViewDescriptor& descriptor);
 
     ViewDataImpl data_ GUARDED_BY(*mu_);
+    // Scratch space for Record(), reused so that recording to an existing row
+    // doesn't allocate.
+    std::vector<std::string> tag_values_ GUARDED_BY(*mu_);
+    // Updated as rows are added.
+    common::MemoryAccount memory_account_;
   };
 
  public:
@@ -110,7 +120,8 @@ class StatsManager final {
     // supports doubles; recorded ints are converted to doubles internally.
     void Record(
         double value,
-        absl::Span<const std::pair<absl::string_view, absl::string_view>> tags);
+        absl::Span<const std::pair<absl::string_view, absl::string_view>> tags,
+        absl::Time now);
 
     ViewInformation* AddConsumer(const ViewDescriptor& descriptor);
     void RemoveView(const ViewInformation* handle);
@@ -111,8 +111,9 @@ BENCHMARK_TEMPLATE2(BM_Record, DistributionAggregation, IntervalWindow)
     ->Range(1, 16);
 
 // TODO: Other useful benchmarks:
-//  - Multithreaded recording against one/different measures.
 //  - Recording with parameterized numbers of tag keys.
+// Multithreaded recording and cardinality are covered by
+// stats_scaling_benchmark.cc.
 
 }  // namespace
 }  // namespace stats
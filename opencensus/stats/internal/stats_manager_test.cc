@@ -15,6 +15,7 @@
 #include "absl/types/optional.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "opencensus/common/internal/clock.h"
 #include "opencensus/stats/measure.h"
 #include "opencensus/stats/measure_registry.h"
 #include "opencensus/stats/recording.h"
@@ -39,6 +40,19 @@ MeasureInt SecondMeasure() {
   return measure;
 }
 
+// Installs a VirtualClock until it goes out of scope, including when a fatal
+// assertion returns early.
+class ScopedVirtualClock {
+ public:
+  explicit ScopedVirtualClock(common::VirtualClock* clock) {
+    common::Clock::SetVirtualClock(clock);
+  }
+  ~ScopedVirtualClock() { common::Clock::SetVirtualClock(nullptr); }
+
+  ScopedVirtualClock(const ScopedVirtualClock&) = delete;
+  ScopedVirtualClock& operator=(const ScopedVirtualClock&) = delete;
+};
+
 // These tests use the public stats interfaces, View and Measure--these are a
 // thin layer around the StatsManager.
 class StatsManagerTest : public ::testing::Test {
@@ -170,6 +184,34 @@ TEST_F(StatsManagerTest, IntervalCount) {
           ::testing::Pair(::testing::ElementsAre("value1", "value2"), 1.0)));
 }
 
+TEST_F(StatsManagerTest, IntervalWindowWithVirtualClock) {
+  common::VirtualClock clock(absl::Now());
+  ScopedVirtualClock scoped_clock(&clock);
+  ViewDescriptor view_descriptor =
+      ViewDescriptor()
+          .set_measure(kFirstMeasureId)
+          .set_name("virtual-interval-sum")
+          .set_aggregation(Aggregation::Sum())
+          .set_aggregation_window(AggregationWindow::Interval(absl::Hours(1)))
+          .add_column(key1_);
+  View view(view_descriptor);
+
+  Record({{FirstMeasure(), 2.0}}, {{key1_, "value1"}});
+  clock.Advance(absl::Minutes(59));
+  Record({{FirstMeasure(), 3.0}}, {{key1_, "value1"}});
+  EXPECT_EQ(5.0, view.GetData().double_data().at({"value1"}));
+  EXPECT_EQ(clock.Now(), view.GetData().end_time());
+
+  // The first value leaves the window, gradually since the oldest bucket is
+  // prorated, then the second.
+  clock.Advance(absl::Minutes(30));
+  const double partial = view.GetData().double_data().at({"value1"});
+  EXPECT_LE(3.0, partial);
+  EXPECT_GT(5.0, partial);
+  clock.Advance(absl::Hours(2));
+  EXPECT_EQ(0.0, view.GetData().double_data().at({"value1"}));
+}
+
 TEST_F(StatsManagerTest, IntervalSum) {
   ViewDescriptor view_descriptor =
       ViewDescriptor()
@@ -0,0 +1,193 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks for how the stats recording and export paths scale: with
+// threads, with the number of rows (distinct tag values) in a view, and with a
+// concurrent snapshot. See stats_manager_benchmark.cc for single-threaded
+// recording against different aggregations.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "opencensus/stats/stats.h"
+
+namespace opencensus {
+namespace stats {
+
+// StatsExporter only allows synchronous exports from its test.
+class StatsExporterTest {
+ public:
+  static void Export() { StatsExporter::ExportForTesting(); }
+};
+
+namespace {
+
+constexpr char kTagKey[] = "key";
+
+// The number of rows for the cardinality sweeps: 1, 32, 1K, 32K and 1M.
+constexpr int kMaxRows = 1 << 20;
+constexpr int kRowsMultiplier = 32;
+
+// Measure names must be unique, since measures can't be unregistered.
+std::string MakeUniqueName() {
+  static std::atomic<int> counter(0);
+  return absl::StrCat("scaling", counter++);
+}
+
+// A measure with a sum view over kTagKey.
+struct TestView {
+  TestView()
+      : measure_name(MakeUniqueName()),
+        measure(MeasureRegistry::RegisterDouble(measure_name, "", "")),
+        descriptor(ViewDescriptor()
+                       .set_name(absl::StrCat(measure_name, "_sum"))
+                       .set_measure(measure_name)
+                       .set_aggregation(Aggregation::Sum())
+                       .add_column(kTagKey)),
+        view(absl::make_unique<View>(descriptor)) {}
+
+  // Records once for each tag value, creating their rows.
+  void Fill(const std::vector<std::string>& tag_values) {
+    for (const auto& value : tag_values) {
+      Record({{measure, 1.0}}, {{kTagKey, value}});
+    }
+  }
+
+  const std::string measure_name;
+  const MeasureDouble measure;
+  const ViewDescriptor descriptor;
+  const std::unique_ptr<View> view;
+};
+
+std::vector<std::string> MakeTagValues(int n) {
+  std::vector<std::string> values;
+  values.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    values.push_back(absl::StrCat("value", i));
+  }
+  return values;
+}
+
+class NullHandler : public StatsExporter::Handler {
+ public:
+  void ExportViewData(const ViewDescriptor& /*descriptor*/,
+                      const ViewData& data) override {
+    benchmark::DoNotOptimize(&data);
+  }
+};
+
+// Records from many threads into one view. With range(0) == 0 all threads
+// record into the same row; otherwise each thread has its own row.
+void BM_RecordThreads(benchmark::State& state) {
+  // Shared by all threads and all runs.
+  static TestView* const test_view = new TestView;
+  const bool distinct_rows = state.range(0);
+  const std::string tag_value =
+      distinct_rows ? absl::StrCat("thread", state.thread_index()) : "shared";
+  while (state.KeepRunning()) {
+    Record({{test_view->measure, 1.0}}, {{kTagKey, tag_value}});
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RecordThreads)
+    ->Arg(0)
+    ->Arg(1)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+// Records into a view with range(0) rows, cycling through all of them.
+void BM_RecordCardinality(benchmark::State& state) {
+  const std::vector<std::string> tag_values = MakeTagValues(state.range(0));
+  TestView test_view;
+  test_view.Fill(tag_values);
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    Record({{test_view.measure, 1.0}}, {{kTagKey, tag_values[i]}});
+    if (++i == tag_values.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RecordCardinality)
+    ->RangeMultiplier(kRowsMultiplier)
+    ->Range(1, kMaxRows);
+
+// Snapshots a view with range(0) rows.
+void BM_GetData(benchmark::State& state) {
+  TestView test_view;
+  test_view.Fill(MakeTagValues(state.range(0)));
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(test_view.view->GetData());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetData)->RangeMultiplier(kRowsMultiplier)->Range(1, kMaxRows);
+
+// Exports a view with range(0) rows to a handler that discards the data.
+void BM_Export(benchmark::State& state) {
+  static bool registered = false;
+  if (!registered) {
+    StatsExporter::RegisterHandler(absl::make_unique<NullHandler>());
+    registered = true;
+  }
+  TestView test_view;
+  StatsExporter::AddView(test_view.descriptor);
+  test_view.Fill(MakeTagValues(state.range(0)));
+  while (state.KeepRunning()) {
+    StatsExporterTest::Export();
+  }
+  StatsExporter::RemoveView(test_view.descriptor.name());
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Export)->RangeMultiplier(kRowsMultiplier)->Range(1, kMaxRows);
+
+// Records into a view with range(0) rows while another thread snapshots it
+// continuously, as an exporter would.
+void BM_RecordWhileSnapshotting(benchmark::State& state) {
+  const std::vector<std::string> tag_values = MakeTagValues(state.range(0));
+  TestView test_view;
+  test_view.Fill(tag_values);
+  std::atomic<bool> done(false);
+  std::atomic<int64_t> num_snapshots(0);
+  std::thread snapshotter([&]() {
+    while (!done.load(std::memory_order_relaxed)) {
+      benchmark::DoNotOptimize(test_view.view->GetData());
+      num_snapshots.fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    Record({{test_view.measure, 1.0}}, {{kTagKey, tag_values[i]}});
+    if (++i == tag_values.size()) i = 0;
+  }
+  done = true;
+  snapshotter.join();
+  state.SetItemsProcessed(state.iterations());
+  state.counters["snapshots"] = num_snapshots.load();
+}
+BENCHMARK(BM_RecordWhileSnapshotting)
+    ->RangeMultiplier(kRowsMultiplier)
+    ->Range(1, kMaxRows)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace stats
+}  // namespace opencensus
+BENCHMARK_MAIN();
@@ -19,6 +19,7 @@
 #include "absl/base/macros.h"
 #include "absl/memory/memory.h"
 #include "absl/time/time.h"
+#include "opencensus/common/internal/clock.h"
 #include "opencensus/stats/distribution.h"
 #include "opencensus/stats/internal/view_data_impl.h"
 
@@ -41,7 +42,8 @@ const ViewData View::GetData() {
   if (!IsValid()) {
     std::cerr << "View::GetData() called on invalid view.\n";
     ABSL_ASSERT(0);
-    return ViewData(absl::make_unique<ViewDataImpl>(absl::Now(), descriptor_));
+    return ViewData(
+        absl::make_unique<ViewDataImpl>(common::Clock::Now(), descriptor_));
   }
   return ViewData((absl::make_unique<ViewDataImpl>(handle_->GetData())));
 }
@@ -155,6 +155,46 @@ ViewDataImpl::ViewDataImpl(const ViewDataImpl& other)
   }
 }
 
+size_t ViewDataImpl::num_rows() const {
+  switch (type_) {
+    case Type::kDouble:
+      return double_data_.size();
+    case Type::kInt64:
+      return int_data_.size();
+    case Type::kDistribution:
+      return distribution_data_.size();
+    case Type::kStatsObject:
+      return interval_data_.size();
+  }
+  return 0;
+}
+
+int64_t ViewDataImpl::row_data_bytes() const {
+  // A node holds the key, the value, the cached hash and the next pointer;
+  // the bucket array holds another pointer per row at full load.
+  constexpr int64_t kNodeBytes =
+      sizeof(std::vector<std::string>) + sizeof(size_t) + 2 * sizeof(void*);
+  switch (type_) {
+    case Type::kDouble:
+      return kNodeBytes + sizeof(double);
+    case Type::kInt64:
+      return kNodeBytes + sizeof(int64_t);
+    case Type::kDistribution:
+      return kNodeBytes + sizeof(Distribution) +
+             aggregation_.bucket_boundaries().num_buckets() * sizeof(uint64_t);
+    case Type::kStatsObject: {
+      // See the IntervalStatsObject constructor calls in Add().
+      const int64_t num_stats =
+          aggregation_.type() == Aggregation::Type::kDistribution
+              ? aggregation_.bucket_boundaries().num_buckets() + 5
+              : 1;
+      return kNodeBytes + sizeof(IntervalStatsObject) +
+             num_stats * (4 + 1) * sizeof(double);
+    }
+  }
+  return 0;
+}
+
 void ViewDataImpl::Add(double value, const std::vector<std::string>& tag_values,
                        absl::Time now) {
   end_time_ = std::max(end_time_, now);
@@ -15,6 +15,8 @@
 #ifndef OPENCENSUS_STATS_INTERNAL_VIEW_DATA_IMPL_H_
 #define OPENCENSUS_STATS_INTERNAL_VIEW_DATA_IMPL_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -97,6 +99,13 @@ class ViewDataImpl {
     return interval_data_;
   }
 
+  // The number of rows, i.e. distinct combinations of tag values.
+  size_t num_rows() const;
+
+  // The estimated bytes of the data for one row, including the map node but
+  // excluding the tag values.
+  int64_t row_data_bytes() const;
+
   absl::Time start_time() const { return start_time_; }
   absl::Time end_time() const { return end_time_; }
 
@@ -0,0 +1,46 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_STATS_INTERNAL_VIEW_NOOP_H_
+#define OPENCENSUS_STATS_INTERNAL_VIEW_NOOP_H_
+
+// Inline no-op definitions of the View API, used instead of view.cc in builds
+// with --define opencensus_noop=true. Views collect nothing and are never
+// valid. Included by view.h; don't include directly.
+
+#include "absl/memory/memory.h"
+#include "absl/time/clock.h"
+#include "opencensus/stats/internal/view_data_impl.h"
+#include "opencensus/stats/view.h"
+#include "opencensus/stats/view_data.h"
+#include "opencensus/stats/view_descriptor.h"
+
+namespace opencensus {
+namespace stats {
+
+inline View::View(const ViewDescriptor& descriptor)
+    : descriptor_(descriptor), handle_(nullptr) {}
+
+inline View::~View() {}
+
+inline bool View::IsValid() const { return false; }
+
+inline const ViewData View::GetData() {
+  return ViewData(absl::make_unique<ViewDataImpl>(absl::Now(), descriptor_));
+}
+
+}  // namespace stats
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_STATS_INTERNAL_VIEW_NOOP_H_
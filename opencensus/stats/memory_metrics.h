@@ -0,0 +1,85 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_STATS_MEMORY_METRICS_H_
+#define OPENCENSUS_STATS_MEMORY_METRICS_H_
+
+#include <vector>
+
+#include "opencensus/common/internal/memory_account.h"
+#include "opencensus/stats/measure.h"
+#include "opencensus/stats/view_descriptor.h"
+
+namespace opencensus {
+namespace stats {
+
+// MemoryMetrics exports the estimated memory used by the library's own data
+// structures as views, to show which view, tag or span store accounts for the
+// library's share of RSS without taking a heap profile.
+//
+// Each data structure keeps its estimate up to date as data is added and
+// removed, so reading the estimates is cheap. Update() records the changes
+// since its last call; once enabled, the StatsExporter calls it before every
+// export.
+//
+// The views' tags are:
+//   "component": what owns the memory: "stats/view",
+//                "stats/measure_registry", "trace/running_span_store",
+//                "trace/local_span_store" or "trace/span_exporter_queue".
+//   "name":      which instance, i.e. the view name for "stats/view" and empty
+//                for the others.
+//   "kind":      (bytes only) "key" for the strings identifying entries, such
+//                as tag values, and "data" for everything else.
+//
+// Usage, at initialization:
+//   opencensus::stats::MemoryMetrics::Enable();
+//
+// This class is thread-safe.
+class MemoryMetrics final {
+ public:
+  using Usage = common::MemoryAccount::Usage;
+
+  // Registers BytesView() and EntriesView() for export and starts updating
+  // them.
+  static void Enable();
+
+  // Stops updating the views. They remain registered.
+  static void Disable();
+
+  // Records the changes in memory usage since the last call. Does nothing
+  // unless enabled.
+  static void Update();
+
+  // Returns the current estimates, read directly instead of through the
+  // views. Works whether or not MemoryMetrics is enabled.
+  static std::vector<Usage> GetUsage();
+
+  // The measure for estimated bytes.
+  static MeasureDouble BytesMeasure();
+  // The measure for the number of entries: view rows, measures, or spans.
+  static MeasureDouble EntriesMeasure();
+
+  // The estimated bytes by component, name and kind.
+  static const ViewDescriptor& BytesView();
+  // The number of entries by component and name.
+  static const ViewDescriptor& EntriesView();
+
+ private:
+  MemoryMetrics() = delete;
+};
+
+}  // namespace stats
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_STATS_MEMORY_METRICS_H_
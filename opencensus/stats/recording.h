@@ -41,4 +41,8 @@ void Record(
 }  // namespace stats
 }  // namespace opencensus
 
+#ifdef OPENCENSUS_NOOP
+#include "opencensus/stats/internal/recording_noop.h"
+#endif
+
 #endif  // OPENCENSUS_STATS_RECORDING_H_
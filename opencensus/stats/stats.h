@@ -23,6 +23,7 @@
 #include "opencensus/stats/measure.h"             // IWYU pragma: export
 #include "opencensus/stats/measure_descriptor.h"  // IWYU pragma: export
 #include "opencensus/stats/measure_registry.h"    // IWYU pragma: export
+#include "opencensus/stats/memory_metrics.h"      // IWYU pragma: export
 #include "opencensus/stats/recording.h"           // IWYU pragma: export
 #include "opencensus/stats/stats_exporter.h"      // IWYU pragma: export
 #include "opencensus/stats/view.h"                // IWYU pragma: export
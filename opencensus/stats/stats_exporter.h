@@ -19,6 +19,8 @@
 #include <functional>
 #include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "opencensus/stats/view.h"
@@ -37,10 +39,18 @@ class StatsExporter final {
   // Removes the view with 'name' from the registry, if one is registered.
   static void RemoveView(absl::string_view name);
 
+  // Returns a snapshot of the current data of every registered view, for
+  // callers that pull data rather than wait for exports, such as debug pages.
+  static std::vector<std::pair<ViewDescriptor, ViewData>> GetViewData();
+
   // StatsExporter::Handler is the interface for exporters that export recorded
   // data for registered views. The exporter should provide a static Register()
   // method that takes any arguments needed by the exporter (e.g. a URL to
   // export to) and calls StatsExporter::RegisterHandler itself.
+  //
+  // ExportViewData() runs on the library's shared background executor (see
+  // opencensus/common/internal/executor.h). While it blocks, other background
+  // work waits unless the executor has spare threads.
   class Handler {
    public:
     virtual ~Handler() = default;
@@ -62,4 +72,8 @@ class StatsExporter final {
 }  // namespace stats
 }  // namespace opencensus
 
+#ifdef OPENCENSUS_NOOP
+#include "opencensus/stats/internal/stats_exporter_noop.h"
+#endif
+
 #endif  // OPENCENSUS_STATS_STATS_EXPORTER_H_
@@ -55,4 +55,8 @@ class View {
 }  // namespace stats
 }  // namespace opencensus
 
+#ifdef OPENCENSUS_NOOP
+#include "opencensus/stats/internal/view_noop.h"
+#endif
+
 #endif  // OPENCENSUS_STATS_VIEW_H_
@@ -0,0 +1,70 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_EXPORTER_FLIGHT_RECORDER_H_
+#define OPENCENSUS_TRACE_EXPORTER_FLIGHT_RECORDER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "opencensus/trace/exporter/span_data.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+// FlightRecorder keeps the most recently ended recording Spans in a fixed-size
+// ring inside a memory-mapped file. The data is in the page cache as soon as a
+// Span ends, so it survives the process crashing or being killed, and can be
+// read back with ReadFile() (or the flight_recorder_dump tool) afterwards.
+//
+// Each Span is written into a fixed-size slot in a compact binary encoding.
+// Spans that don't fit are truncated: trailing attributes and annotations are
+// dropped and added to the dropped counts, and a string that only partly fits
+// is cut short. ReadFile() marks a truncated Span with a final annotation,
+// "Truncated by the flight recorder.", at its end time. Message events and
+// links are not recorded. Every slot carries a sequence number and a checksum,
+// so slots that were only partly written when the process died are skipped
+// when reading.
+//
+// Writing a Span doesn't allocate or make system calls, so the recorder is
+// cheap enough to leave on in production.
+//
+// This class is thread-safe.
+class FlightRecorder final {
+ public:
+  // Starts recording into the file at 'path', which is created or overwritten
+  // and sized to 'size_bytes'. Any previous recording is stopped first.
+  // Returns false if the file can't be set up, or is too small to hold a
+  // single Span.
+  //
+  // Since this overwrites 'path', dump the file left by a crashed process
+  // before restarting it, or include something unique such as the pid in the
+  // path.
+  static bool Start(absl::string_view path, size_t size_bytes);
+
+  // Stops recording and unmaps the file. The file is left in place.
+  static void Stop();
+
+  // Reads back the Spans in a flight recorder file, oldest first. Returns an
+  // empty vector if the file can't be read or isn't a flight recorder file.
+  static std::vector<SpanData> ReadFile(absl::string_view path);
+};
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_EXPORTER_FLIGHT_RECORDER_H_
@@ -20,8 +20,10 @@
 #include <unordered_map>
 #include <vector>
 
+#include "absl/time/time.h"
 #include "opencensus/trace/exporter/span_data.h"
 #include "opencensus/trace/status_code.h"
+#include "opencensus/trace/trace_id.h"
 
 namespace opencensus {
 namespace trace {
@@ -30,7 +32,17 @@ namespace exporter {
 // LocalSpanStore allows users to access in-process information about Spans that
 // have completed (called End()) and were recording events.
 //
-// The LocalSpanStore has a bounded size and evicts Spans when needed.
+// For each span name, the LocalSpanStore keeps a bounded random sample of the
+// successful Spans in each latency bucket, and of the failed Spans with each
+// status code, so that rare slow or failed Spans remain available. Samples are
+// kept for a bounded number of span names: when a new name would go over the
+// limit, the samples of the name that least recently ended a Span are dropped.
+//
+// The LocalSpanStore also keeps every ended Span of the traces that most
+// recently ended a Span, indexed by trace ID, so that a whole trace can be put
+// back together and analyzed: which Spans were on its critical path, and how
+// much time each Span spent doing its own work rather than waiting on its
+// children.
 //
 // This class is thread-safe.
 class LocalSpanStore {
@@ -49,6 +61,8 @@ class LocalSpanStore {
     k100s_plus,
   };
 
+  // The number of sampled spans available per latency bucket and per error
+  // code.
   struct PerSpanNameSummary {
     std::unordered_map<LatencyBucketBoundary, int, std::hash<int>>
         number_of_latency_sampled_spans;
@@ -81,6 +95,38 @@ class LocalSpanStore {
     bool all_errors;
   };
 
+  // A Span of an analyzed trace.
+  struct AnalyzedSpan {
+    std::shared_ptr<const SpanData> span;
+    // The index in TraceAnalysis::spans of the parent, or -1 if the Span is a
+    // root or its parent is not in the store.
+    int parent_index;
+    // The duration of the Span minus the time covered by its children.
+    absl::Duration self_time;
+    // The part of the trace's critical path spent in this Span itself. Zero
+    // if the Span is not on the critical path.
+    absl::Duration critical_path_time;
+  };
+
+  // The Spans of a trace, arranged as a tree.
+  struct TraceAnalysis {
+    // Parents come before their children, and siblings are ordered by start
+    // time.
+    std::vector<AnalyzedSpan> spans;
+    // The indices in spans of the Spans on the critical path, ordered by start
+    // time. These are the Spans that determined when the root that ended last
+    // could end: shortening any other Span would not have made it end sooner.
+    std::vector<int> critical_path;
+  };
+
+  // Totals for the Spans with the same name, over all the stored traces.
+  struct SpanNameProfile {
+    int num_spans = 0;
+    absl::Duration total_time;
+    absl::Duration self_time;
+    absl::Duration critical_path_time;
+  };
+
   // --- Methods ---
 
   LocalSpanStore() = delete;
@@ -88,15 +134,29 @@ class LocalSpanStore {
   // Returns a summary of the data available in the LocalSpanStore.
   static Summary GetSummary();
 
-  // Returns SpanData for the sampled spans that match the latency filter.
-  static std::vector<SpanData> GetLatencySampledSpans(
+  // Returns SpanData for the sampled spans that match the latency filter. The
+  // SpanData is shared with the store and with other callers, not copied.
+  static std::vector<std::shared_ptr<const SpanData>> GetLatencySampledSpans(
       const LatencyFilter& filter);
 
   // Returns SpanData for the sampled spans that match the error filter.
-  static std::vector<SpanData> GetErrorSampledSpans(const ErrorFilter& filter);
+  static std::vector<std::shared_ptr<const SpanData>> GetErrorSampledSpans(
+      const ErrorFilter& filter);
 
   // Returns SpanData for all spans in the local span store.
-  static std::vector<SpanData> GetSpans();
+  static std::vector<std::shared_ptr<const SpanData>> GetSpans();
+
+  // Returns the IDs of the traces kept for analysis, the one that most
+  // recently ended a Span first.
+  static std::vector<TraceId> GetTraceIds();
+
+  // Returns the stored Spans of the trace as a tree, with self times and the
+  // critical path. Returns an empty analysis if the trace is not stored.
+  static TraceAnalysis AnalyzeTrace(const TraceId& trace_id);
+
+  // Analyzes all the stored traces and returns the totals by span name.
+  static std::unordered_map<std::string, SpanNameProfile>
+  GetSpanNameProfiles();
 };
 
 }  // namespace exporter
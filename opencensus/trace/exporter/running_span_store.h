@@ -15,10 +15,12 @@
 #ifndef OPENCENSUS_TRACE_EXPORTER_RUNNING_SPAN_STORE_H_
 #define OPENCENSUS_TRACE_EXPORTER_RUNNING_SPAN_STORE_H_
 
+#include <cstddef>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "absl/time/time.h"
 #include "opencensus/trace/exporter/span_data.h"
 
 namespace opencensus {
@@ -31,6 +33,15 @@ namespace exporter {
 //
 // Running spans are spans that haven't called End() and are recording events.
 //
+// Tracking running spans is off by default, since it adds a global lock and a
+// map update to the start and end of every recording span. Enable() it while
+// the data is needed, e.g. while a debug page is open.
+//
+// Spans that are never ended, e.g. because the object that owns them leaked,
+// would otherwise be kept alive by the store forever. SetOptions() can cap the
+// number of tracked spans and the memory they hold, report spans that have
+// been running for too long, and optionally end them.
+//
 // This class is thread-safe.
 class RunningSpanStore {
  public:
@@ -40,6 +51,12 @@ class RunningSpanStore {
 
   struct Summary {
     std::unordered_map<std::string, PerSpanNameSummary> per_span_name_summary;
+    // The number of spans that weren't tracked, or stopped being tracked,
+    // because the store was full.
+    int num_untracked_spans = 0;
+    // The approximate number of bytes held by the tracked spans, as of the
+    // last scan.
+    size_t approximate_bytes = 0;
   };
 
   // Filters all the spans based on exact match of span name. If span_name is
@@ -50,10 +67,58 @@ class RunningSpanStore {
     int max_spans_to_return;
   };
 
+  struct Options {
+    // The maximum number of spans to track. Spans that start while the store
+    // is full are not tracked. 0 means no limit.
+    int max_spans = 0;
+    // The approximate maximum number of bytes held by tracked spans,
+    // including their attributes and events. When it's exceeded, the
+    // longest-running spans stop being tracked. Since span sizes are only
+    // measured by the background scan, this can be overshot between scans.
+    // 0 means no limit.
+    size_t max_bytes = 0;
+    // Spans that have been running for longer than this are reported by
+    // GetStuckSpans(). Zero disables stuck span detection.
+    absl::Duration stuck_span_threshold = absl::ZeroDuration();
+    // If true, stuck spans are ended with DEADLINE_EXCEEDED status and
+    // exported like any other span, so that their memory can be reclaimed.
+    // Calling End() on them later has no effect.
+    bool end_stuck_spans = false;
+    // How often the background scan runs, on the shared executor. It only
+    // runs if max_bytes or stuck_span_threshold is set.
+    absl::Duration scan_interval = absl::Seconds(10);
+  };
+
+  // Spans that were found running for longer than the stuck span threshold by
+  // the most recent scan.
+  struct StuckSpans {
+    std::unordered_map<std::string, int> num_stuck_spans_by_name;
+    // One example per span name.
+    std::vector<SpanData> samples;
+  };
+
   // --- Methods ---
 
   RunningSpanStore() = delete;
 
+  // Starts tracking running spans. Only spans that start after this call are
+  // tracked, so the store reports a partial view until the spans that were
+  // already running have ended.
+  static void Enable();
+
+  // Stops tracking running spans and drops all currently tracked spans.
+  static void Disable();
+
+  // Returns true if running spans are being tracked.
+  static bool IsEnabled();
+
+  // Sets limits and stuck span detection. Starts the background scan if
+  // needed.
+  static void SetOptions(const Options& options);
+
+  // Returns the stuck spans found by the most recent scan.
+  static StuckSpans GetStuckSpans();
+
   // Returns a summary of the data available in the RunningSpanStore.
   static Summary GetSummary();
 
@@ -0,0 +1,128 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_EXPORTER_SPAN_BATCH_ENCODER_H_
+#define OPENCENSUS_TRACE_EXPORTER_SPAN_BATCH_ENCODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/span_data.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+// SpanBatchEncoder encodes batches of SpanData in the protobuf wire format of
+// opencensus.proto.agent.trace.v1.ExportTraceServiceRequest, whose spans
+// (field 2) are opencensus.proto.trace.v1.Span messages. It writes directly
+// into a buffer that is reused across batches, so a steady-state exporter
+// doesn't allocate per span, and it doesn't depend on libprotobuf.
+//
+// The OpenCensus protos have no way to share strings between spans. With
+// Options::deduplicate_strings, span names and attribute keys are instead
+// written once per batch into a string table (repeated string, field 15 of the
+// request), and referenced by index (field 3 of TruncatableString, and of
+// attribute map entries). Only receivers that understand this extension can
+// decode such batches; other protobuf decoders will see empty names and keys.
+//
+// Typical use in a SpanExporter::Handler:
+//
+//   void Export(const std::vector<SpanData>& spans) override {
+//     Send(encoder_.Encode(spans));
+//   }
+//
+// This class is thread-compatible.
+class SpanBatchEncoder final {
+ public:
+  struct Options {
+    bool deduplicate_strings = false;
+  };
+
+  // Field numbers of the extension.
+  static constexpr uint32_t kStringTableField = 15;
+  static constexpr uint32_t kStringIndexField = 3;
+
+  SpanBatchEncoder() : SpanBatchEncoder(Options()) {}
+  explicit SpanBatchEncoder(const Options& options) : options_(options) {}
+
+  // Encodes a batch. The result is valid until the next call to a non-const
+  // method.
+  absl::string_view Encode(const std::vector<SpanData>& spans);
+
+  // Appends one span to the current batch, for encoding a batch incrementally.
+  // When deduplicating strings, 'span' must outlive the Finish() call.
+  void Add(const SpanData& span);
+
+  // Finishes the current batch and returns it. The result is valid until the
+  // next call to a non-const method. The next Add() starts a new batch.
+  absl::string_view Finish();
+
+  // The number of spans in the current batch.
+  size_t num_spans() const { return num_spans_; }
+
+  // The number of bytes in the current batch so far.
+  size_t size() const { return buffer_.size() + string_table_.size(); }
+
+ private:
+  // Writes a tag and reserves space for the length of a nested message.
+  // Returns a position to pass to EndMessage().
+  size_t BeginMessage(uint32_t field);
+  // Writes the length of the nested message started at 'start'.
+  void EndMessage(size_t start);
+
+  void PutVarint(uint64_t value);
+  void PutTag(uint32_t field, uint32_t wire_type);
+  void PutVarintField(uint32_t field, uint64_t value);
+  void PutBytesField(uint32_t field, absl::string_view value);
+  void PutTimestamp(uint32_t field, absl::Time time);
+  // Writes a TruncatableString, as a string table reference if 'dedup' and
+  // deduplication is enabled.
+  void PutTruncatableString(uint32_t field, absl::string_view value,
+                            bool dedup);
+  void PutAttributeValue(uint32_t field, const AttributeValue& value);
+  void PutAttributes(uint32_t field,
+                     const std::unordered_map<std::string, AttributeValue>&
+                         attributes,
+                     int dropped_attributes_count);
+  void PutSpan(const SpanData& span);
+
+  // Returns the index of 'value' in the string table, adding it if needed.
+  uint32_t StringIndex(absl::string_view value);
+
+  struct StringViewHash {
+    size_t operator()(absl::string_view s) const;
+  };
+
+  const Options options_;
+  std::string buffer_;
+  size_t num_spans_ = 0;
+  // The encoded string table, appended to buffer_ by Finish().
+  std::string string_table_;
+  // Points into the SpanData of the current batch.
+  std::unordered_map<absl::string_view, uint32_t, StringViewHash>
+      string_indices_;
+};
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_EXPORTER_SPAN_BATCH_ENCODER_H_
@@ -15,6 +15,7 @@
 #ifndef OPENCENSUS_TRACE_EXPORTER_SPAN_DATA_H_
 #define OPENCENSUS_TRACE_EXPORTER_SPAN_DATA_H_
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -39,7 +40,8 @@ namespace exporter {
 // other than using SpanData with exporting interfaces.
 //
 // SpanData can represent either a running span, or a span that has ended.
-// SpanData is immutable.
+// SpanData is immutable once it reaches a SpanExporter::Handler; only
+// SpanExporter::Processors edit it, through the mutable_*() accessors.
 //
 // SpanData tries to match the Stackdriver v2 model:
 // https://cloud.google.com/trace/docs/reference/v2/rpc/google.devtools.cloudtrace.v2
@@ -72,20 +74,54 @@ class SpanData final {
     const std::vector<TimeEvent<T>>& events() const { return events_; }
     int dropped_events_count() const { return dropped_events_count_; }
 
+    std::vector<TimeEvent<T>>* mutable_events() { return &events_; }
+    void set_dropped_events_count(int count) { dropped_events_count_ = count; }
+
    private:
     std::vector<TimeEvent<T>> events_;
     int dropped_events_count_;
   };
 
-  // The constructor is visible for test purposes. Users are expected to get
+  // Totals over all the message events recorded on a span, including the ones
+  // that were dropped from message_events(), so that they stay accurate for
+  // long streams.
+  struct MessageEventSummary {
+    uint64_t num_sent = 0;
+    uint64_t num_received = 0;
+    uint64_t sent_compressed_bytes = 0;
+    uint64_t sent_uncompressed_bytes = 0;
+    uint64_t received_compressed_bytes = 0;
+    uint64_t received_uncompressed_bytes = 0;
+    // The times of the first and last message events. Only meaningful if there
+    // were any.
+    absl::Time first_event_time;
+    absl::Time last_event_time;
+
+    // Adds an event to the totals.
+    void Add(absl::Time timestamp, const MessageEvent& event);
+  };
+
+  // The constructors are visible for test purposes. Users are expected to get
   // SpanData from a Span object.
+  //
+  // This one computes the message event summary from message_events.
   SpanData(absl::string_view name, SpanContext context, SpanId parent_span_id,
            TimeEvents<Annotation>&& annotations,
            TimeEvents<MessageEvent>&& message_events, std::vector<Link>&& links,
            int num_links_dropped,
            std::unordered_map<std::string, AttributeValue>&& attributes,
            int num_attributes_dropped, bool has_ended, absl::Time start_time,
-           absl::Time end_time, Status status, bool has_remote_parent);
+           absl::Time end_time, Status status, bool has_remote_parent,
+           uint64_t thread_id = 0);
+  SpanData(absl::string_view name, SpanContext context, SpanId parent_span_id,
+           TimeEvents<Annotation>&& annotations,
+           TimeEvents<MessageEvent>&& message_events,
+           const MessageEventSummary& message_event_summary,
+           std::vector<Link>&& links, int num_links_dropped,
+           std::unordered_map<std::string, AttributeValue>&& attributes,
+           int num_attributes_dropped, bool has_ended, absl::Time start_time,
+           absl::Time end_time, Status status, bool has_remote_parent,
+           uint64_t thread_id, int num_strings_truncated);
 
   // --- Accessors ---
 
@@ -107,6 +143,9 @@ class SpanData final {
   // was sent.
   const TimeEvents<MessageEvent>& message_events() const;
 
+  // Totals over all message events, including the dropped ones.
+  const MessageEventSummary& message_event_summary() const;
+
   // Links to spans in other traces.
   const std::vector<Link>& links() const;
 
@@ -135,16 +174,33 @@ class SpanData final {
   // True if the parent is on a different process.
   bool has_remote_parent() const;
 
+  // The ID of the thread that started the span, or 0 if unknown. On Linux,
+  // this is the kernel thread ID.
+  uint64_t thread_id() const;
+
+  // The number of strings (attribute values, annotation descriptions, and the
+  // status message) that were truncated to fit in the span's byte budget; see
+  // TraceParams::max_span_bytes.
+  int num_strings_truncated() const;
+
   // Returns a human-readable string for debugging. Do not rely on its format or
   // try to parse it.
   std::string DebugString() const;
 
+  // --- Mutators, for SpanExporter::Processor ---
+
+  TimeEvents<Annotation>* mutable_annotations();
+  TimeEvents<MessageEvent>* mutable_message_events();
+  std::unordered_map<std::string, AttributeValue>* mutable_attributes();
+  void set_num_attributes_dropped(int num_attributes_dropped);
+
  private:
   std::string name_;
   SpanContext context_;
   SpanId parent_span_id_;
   TimeEvents<Annotation> annotations_;
   TimeEvents<MessageEvent> message_events_;
+  MessageEventSummary message_event_summary_;
   std::vector<Link> links_;
   std::unordered_map<std::string, AttributeValue> attributes_;
   int num_links_dropped_;
@@ -154,6 +210,8 @@ class SpanData final {
   Status status_;
   bool has_remote_parent_;
   bool has_ended_;
+  uint64_t thread_id_;
+  int num_strings_truncated_;
 };
 
 }  // namespace exporter
@@ -33,18 +33,41 @@ class SpanExporter final {
   // sampled spans in their own format. The exporter should provide a static
   // Register() method that takes any arguments needed by the exporter (e.g. a
   // URL to export to) and calls SpanExporter::RegisterHandler itself.
+  //
+  // Export() runs on the library's shared background executor (see
+  // opencensus/common/internal/executor.h). While it blocks, other background
+  // work waits unless the executor has spare threads.
   class Handler {
    public:
     virtual ~Handler() = default;
     virtual void Export(const std::vector<SpanData>& spans) = 0;
   };
 
+  // Processors edit or drop spans before they reach any Handler, e.g. to strip
+  // large attributes or drop health-check spans, so that the work is done once
+  // per batch rather than in every exporter. Processors run on the background
+  // executor, in registration order. See span_processors.h for common ones.
+  class Processor {
+   public:
+    virtual ~Processor() = default;
+    // Edits 'span' in place. Returns false to drop the span.
+    virtual bool Process(SpanData* span) = 0;
+  };
+
   // This should only be called by Handler's Register() method.
   static void RegisterHandler(std::unique_ptr<Handler> handler);
+
+  // Appends a processor to the chain. This is intended to be done at
+  // initialization, before any spans are exported.
+  static void RegisterProcessor(std::unique_ptr<Processor> processor);
 };
 
 }  // namespace exporter
 }  // namespace trace
 }  // namespace opencensus
 
+#ifdef OPENCENSUS_NOOP
+#include "opencensus/trace/internal/span_exporter_noop.h"
+#endif
+
 #endif  // OPENCENSUS_TRACE_EXPORTER_SPAN_EXPORTER_H_
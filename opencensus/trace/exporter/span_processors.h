@@ -0,0 +1,85 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_EXPORTER_SPAN_PROCESSORS_H_
+#define OPENCENSUS_TRACE_EXPORTER_SPAN_PROCESSORS_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/span_exporter.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+// Common SpanExporter::Processors. For example, to drop health checks and
+// keep attribute values short:
+//
+//   SpanExporter::RegisterProcessor(absl::make_unique<DropSpansProcessor>(
+//       std::vector<std::string>{"/healthz"}));
+//   SpanExporter::RegisterProcessor(
+//       absl::make_unique<TruncateAttributesProcessor>(256));
+
+// Drops spans with any of the given names.
+class DropSpansProcessor final : public SpanExporter::Processor {
+ public:
+  explicit DropSpansProcessor(const std::vector<std::string>& names);
+  bool Process(SpanData* span) override;
+
+ private:
+  // Sorted, so that span names can be looked up without a copy.
+  const std::vector<std::string> names_;
+};
+
+// Removes the attributes with any of the given keys, counting them as
+// dropped.
+class DropAttributesProcessor final : public SpanExporter::Processor {
+ public:
+  explicit DropAttributesProcessor(const std::vector<std::string>& keys);
+  bool Process(SpanData* span) override;
+
+ private:
+  const std::vector<std::string> keys_;
+};
+
+// Truncates string attribute values to at most max_length bytes, without
+// splitting a UTF-8 character.
+class TruncateAttributesProcessor final : public SpanExporter::Processor {
+ public:
+  explicit TruncateAttributesProcessor(size_t max_length);
+  bool Process(SpanData* span) override;
+
+ private:
+  const size_t max_length_;
+};
+
+// Keeps only the most recent max_annotations annotations of each span, counting
+// the rest as dropped.
+class CapAnnotationsProcessor final : public SpanExporter::Processor {
+ public:
+  explicit CapAnnotationsProcessor(size_t max_annotations);
+  bool Process(SpanData* span) override;
+
+ private:
+  const size_t max_annotations_;
+};
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_EXPORTER_SPAN_PROCESSORS_H_
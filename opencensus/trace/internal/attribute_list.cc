@@ -14,9 +14,11 @@
 
 #include "opencensus/trace/internal/attribute_list.h"
 
+#include <string>
 #include <utility>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 
 namespace opencensus {
 namespace trace {
@@ -29,27 +31,11 @@ uint32_t AttributeList::num_attributes_added() const {
   return total_recorded_attributes_;
 }
 
-void AttributeList::AddAttribute(absl::string_view key,
+bool AttributeList::AddAttribute(absl::string_view key,
                                  exporter::AttributeValue&& value) {
-  // Blank span has 0 max attributes.
-  if (max_attributes_ == 0) {
-    return;
-  }
-
-  std::string key_string(key);
-  auto it = attributes_.find(key_string);
-  if (it != attributes_.end()) {
-    it->second = std::move(value);
-    return;
-  }
-
-  if (attributes_.size() >= max_attributes_) {
-    // TODO: This should be changed to a LRU mechanism.  Just remove
-    // first element for now.
-    attributes_.erase(attributes_.begin());
-  }
-  attributes_.insert({key_string, std::move(value)});
-  total_recorded_attributes_++;
+  return AddAttribute(key, [&value](const Entry*) {
+    return absl::optional<exporter::AttributeValue>(std::move(value));
+  });
 }
 
 }  // namespace trace
@@ -18,8 +18,10 @@
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "opencensus/trace/exporter/attribute_value.h"
 
 namespace opencensus {
@@ -30,6 +32,8 @@ namespace trace {
 // string key. AttributeList is thread-compatible.
 class AttributeList final {
  public:
+  using Entry = std::pair<const std::string, exporter::AttributeValue>;
+
   explicit AttributeList(uint32_t max_attributes = 0)
       : total_recorded_attributes_(0), max_attributes_(max_attributes) {}
 
@@ -41,8 +45,17 @@ class AttributeList final {
 
   // Adds an AttributeValue to the list or updates an existing AttributeValue.
   // If max_attributes_ is exceeded, it will evict one of the previous
-  // AttributeValues.
-  void AddAttribute(absl::string_view key, exporter::AttributeValue&& value);
+  // AttributeValues. Returns false if the attribute was dropped instead.
+  bool AddAttribute(absl::string_view key, exporter::AttributeValue&& value);
+
+  // As AddAttribute(), but the value is made by make_value(replaced), where
+  // replaced is the attribute that the value will replace or evict, or
+  // nullptr. This lets the caller size the value, e.g. to fit the span's byte
+  // budget, without a second lookup. make_value returns absl::nullopt to drop
+  // the attribute instead; an existing key then keeps its old value, and only
+  // a new key counts as dropped.
+  template <typename MakeValue>
+  bool AddAttribute(absl::string_view key, MakeValue make_value);
 
   // Returns an unordered map of all the attributes that are currently contained
   // within the list.
@@ -57,6 +70,40 @@ class AttributeList final {
   std::unordered_map<std::string, exporter::AttributeValue> attributes_;
 };
 
+template <typename MakeValue>
+bool AttributeList::AddAttribute(absl::string_view key, MakeValue make_value) {
+  // Blank span has 0 max attributes.
+  if (max_attributes_ == 0) {
+    return false;
+  }
+
+  std::string key_string(key);
+  auto it = attributes_.find(key_string);
+  if (it != attributes_.end()) {
+    absl::optional<exporter::AttributeValue> value = make_value(&*it);
+    if (!value.has_value()) {
+      return false;
+    }
+    it->second = std::move(*value);
+    return true;
+  }
+
+  total_recorded_attributes_++;
+  // TODO: This should be changed to a LRU mechanism.  Just evict the first
+  // element for now.
+  const bool evict = attributes_.size() >= max_attributes_;
+  absl::optional<exporter::AttributeValue> value =
+      make_value(evict ? &*attributes_.begin() : nullptr);
+  if (!value.has_value()) {
+    return false;
+  }
+  if (evict) {
+    attributes_.erase(attributes_.begin());
+  }
+  attributes_.emplace(std::move(key_string), std::move(*value));
+  return true;
+}
+
 }  // namespace trace
 }  // namespace opencensus
 
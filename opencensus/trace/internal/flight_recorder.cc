@@ -0,0 +1,39 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/exporter/flight_recorder.h"
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/internal/flight_recorder_impl.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+bool FlightRecorder::Start(absl::string_view path, size_t size_bytes) {
+  return FlightRecorderImpl::Get()->Start(path, size_bytes);
+}
+
+void FlightRecorder::Stop() { FlightRecorderImpl::Get()->Stop(); }
+
+std::vector<SpanData> FlightRecorder::ReadFile(absl::string_view path) {
+  return FlightRecorderImpl::ReadFile(path);
+}
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
@@ -0,0 +1,36 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Prints the Spans in a FlightRecorder file, oldest first.
+//
+// Usage: flight_recorder_dump <file>
+
+#include <iostream>
+
+#include "opencensus/trace/exporter/flight_recorder.h"
+#include "opencensus/trace/exporter/span_data.h"
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <file>\n";
+    return 1;
+  }
+  const auto spans =
+      opencensus::trace::exporter::FlightRecorder::ReadFile(argv[1]);
+  for (const auto& span : spans) {
+    std::cout << span.DebugString() << "\n";
+  }
+  std::cerr << spans.size() << " spans.\n";
+  return 0;
+}
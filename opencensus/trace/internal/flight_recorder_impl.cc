@@ -0,0 +1,567 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/internal/flight_recorder_impl.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/base/internal/endian.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "opencensus/trace/exporter/annotation.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/link.h"
+#include "opencensus/trace/exporter/message_event.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/status.h"
+#include "opencensus/trace/internal/span_impl.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_id.h"
+#include "opencensus/trace/trace_options.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+namespace {
+
+constexpr char kMagic[8] = {'O', 'C', 'F', 'L', 'T', 'R', 'E', 'C'};
+constexpr uint32_t kVersion = 2;
+
+// Header field offsets.
+constexpr size_t kVersionOffset = 8;
+constexpr size_t kSlotSizeOffset = 12;
+constexpr size_t kNumSlotsOffset = 16;
+constexpr size_t kNextSeqOffset = 24;
+
+// Slot header field offsets.
+constexpr size_t kChecksumOffset = 0;
+constexpr size_t kLengthOffset = 4;
+constexpr size_t kSeqOffset = 8;
+
+// The sequence number of a slot that is being written.
+constexpr uint64_t kWriting = UINT64_MAX;
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "slot sequence numbers are mapped as atomics");
+
+// Returns the sequence number of a slot, which writers update atomically.
+std::atomic<uint64_t>* SlotSeq(uint8_t* slot) {
+  return reinterpret_cast<std::atomic<uint64_t>*>(slot + kSeqOffset);
+}
+const std::atomic<uint64_t>* SlotSeq(const uint8_t* slot) {
+  return reinterpret_cast<const std::atomic<uint64_t>*>(slot + kSeqOffset);
+}
+
+// Offset of the flags byte in the payload, and its bits.
+constexpr size_t kFlagsOffset = TraceId::kSize + 2 * SpanId::kSize + 1;
+constexpr uint8_t kRemoteParentFlag = 1;
+constexpr uint8_t kTruncatedFlag = 2;
+
+// Size of the fixed-size fields at the start of the payload.
+constexpr size_t kFixedPayloadSize = TraceId::kSize + 2 * SpanId::kSize +
+                                     TraceOptions::kSize + 3 + 2 * 8 + 2 * 4;
+
+// FNV-1a. Only needs to detect torn writes, not adversarial changes.
+uint32_t Checksum(const uint8_t* data, size_t size,
+                  uint32_t hash = 2166136261u) {
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Returns the checksum of a slot with the given sequence number. The sequence
+// number field itself holds kWriting while the checksum is computed.
+uint32_t SlotChecksum(const uint8_t* slot, uint64_t seq, uint32_t length) {
+  uint8_t seq_bytes[8];
+  absl::little_endian::Store64(seq_bytes, seq);
+  const uint32_t hash = Checksum(slot + kLengthOffset, 4,
+                                 Checksum(seq_bytes, sizeof(seq_bytes)));
+  return Checksum(slot + FlightRecorderImpl::kSlotHeaderSize, length,
+                  hash);
+}
+
+// Appends fields to a fixed-size buffer. Once a field doesn't fit, the buffer
+// is marked truncated and all further writes are ignored.
+class SlotWriter {
+ public:
+  SlotWriter(uint8_t* buf, size_t size) : buf_(buf), pos_(0), size_(size) {}
+
+  size_t pos() const { return pos_; }
+  bool truncated() const { return truncated_; }
+
+  // Discards everything written after 'pos'.
+  void Rollback(size_t pos) { pos_ = pos; }
+
+  void PutU8(uint8_t v) {
+    if (Reserve(1)) buf_[pos_++] = v;
+  }
+  void PutU16(uint16_t v) {
+    if (!Reserve(2)) return;
+    absl::little_endian::Store16(buf_ + pos_, v);
+    pos_ += 2;
+  }
+  void PutU32(uint32_t v) {
+    if (!Reserve(4)) return;
+    absl::little_endian::Store32(buf_ + pos_, v);
+    pos_ += 4;
+  }
+  void PutI64(int64_t v) {
+    if (!Reserve(8)) return;
+    absl::little_endian::Store64(buf_ + pos_, v);
+    pos_ += 8;
+  }
+  void PutTime(absl::Time t) { PutI64(absl::ToUnixNanos(t)); }
+
+  // Writes a length-prefixed string. If only part of it fits, writes that part
+  // and marks the buffer truncated.
+  void PutString(absl::string_view s) {
+    if (!Reserve(2)) return;
+    size_t len = std::min<size_t>(s.size(), UINT16_MAX);
+    if (len > size_ - pos_ - 2) {
+      len = size_ - pos_ - 2;
+      truncated_ = true;
+    }
+    absl::little_endian::Store16(buf_ + pos_, len);
+    memcpy(buf_ + pos_ + 2, s.data(), len);
+    pos_ += 2 + len;
+  }
+
+  // Reserve space for a count, to be filled in with SetU16() or SetU32().
+  size_t ReserveU16() {
+    const size_t at = pos_;
+    PutU16(0);
+    return at;
+  }
+  size_t ReserveU32() {
+    const size_t at = pos_;
+    PutU32(0);
+    return at;
+  }
+  // Do nothing if the reservation at 'at' failed or was rolled back.
+  void SetU16(size_t at, uint16_t v) {
+    if (at + 2 <= pos_) absl::little_endian::Store16(buf_ + at, v);
+  }
+  void SetU32(size_t at, uint32_t v) {
+    if (at + 4 <= pos_) absl::little_endian::Store32(buf_ + at, v);
+  }
+
+ private:
+  bool Reserve(size_t n) {
+    if (truncated_ || size_ - pos_ < n) {
+      truncated_ = true;
+      return false;
+    }
+    return true;
+  }
+
+  uint8_t* const buf_;
+  size_t pos_;
+  const size_t size_;
+  bool truncated_ = false;
+};
+
+// Reads fields written by SlotWriter. Once a read runs past the end, ok()
+// returns false and all further reads return zero values.
+class SlotReader {
+ public:
+  SlotReader(const uint8_t* buf, size_t size)
+      : buf_(buf), pos_(0), size_(size) {}
+
+  bool ok() const { return ok_; }
+
+  const uint8_t* Bytes(size_t n) {
+    if (!ok_ || size_ - pos_ < n) {
+      ok_ = false;
+      return nullptr;
+    }
+    const uint8_t* p = buf_ + pos_;
+    pos_ += n;
+    return p;
+  }
+  uint8_t GetU8() {
+    const uint8_t* p = Bytes(1);
+    return p ? *p : 0;
+  }
+  uint16_t GetU16() {
+    const uint8_t* p = Bytes(2);
+    return p ? absl::little_endian::Load16(p) : 0;
+  }
+  uint32_t GetU32() {
+    const uint8_t* p = Bytes(4);
+    return p ? absl::little_endian::Load32(p) : 0;
+  }
+  int64_t GetI64() {
+    const uint8_t* p = Bytes(8);
+    return p ? absl::little_endian::Load64(p) : 0;
+  }
+  absl::Time GetTime() { return absl::FromUnixNanos(GetI64()); }
+  std::string GetString() {
+    const uint16_t len = GetU16();
+    const uint8_t* p = Bytes(len);
+    return p ? std::string(reinterpret_cast<const char*>(p), len) : "";
+  }
+
+ private:
+  const uint8_t* const buf_;
+  size_t pos_;
+  const size_t size_;
+  bool ok_ = true;
+};
+
+void PutAttributeValue(const AttributeValue& value, SlotWriter* w) {
+  w->PutU8(static_cast<uint8_t>(value.type()));
+  switch (value.type()) {
+    case AttributeValue::Type::kString:
+      w->PutString(value.string_value());
+      break;
+    case AttributeValue::Type::kBool:
+      w->PutU8(value.bool_value());
+      break;
+    case AttributeValue::Type::kInt:
+      w->PutI64(value.int_value());
+      break;
+  }
+}
+
+// Returns false if the value was cut off.
+bool GetAttributeValue(SlotReader* r,
+                       std::unordered_map<std::string, AttributeValue>* out) {
+  std::string key = r->GetString();
+  const auto type = static_cast<AttributeValue::Type>(r->GetU8());
+  switch (type) {
+    case AttributeValue::Type::kString: {
+      std::string value = r->GetString();
+      if (!r->ok()) return false;
+      out->emplace(std::move(key), AttributeValue(AttributeValueRef(value)));
+      return true;
+    }
+    case AttributeValue::Type::kBool: {
+      const bool value = r->GetU8();
+      if (!r->ok()) return false;
+      out->emplace(std::move(key), AttributeValue(AttributeValueRef(value)));
+      return true;
+    }
+    case AttributeValue::Type::kInt: {
+      const int64_t value = r->GetI64();
+      if (!r->ok()) return false;
+      out->emplace(std::move(key), AttributeValue(AttributeValueRef(value)));
+      return true;
+    }
+  }
+  return false;
+}
+
+// Decodes a payload written by FlightRecorderImpl::Encode(), which must be at
+// least kFixedPayloadSize bytes. Truncated spans are decoded up to the last
+// complete field.
+SpanData Decode(const uint8_t* payload, size_t size) {
+  SlotReader r(payload, size);
+  const uint8_t* ids =
+      r.Bytes(TraceId::kSize + 2 * SpanId::kSize + TraceOptions::kSize);
+  const TraceId trace_id(ids);
+  const SpanId span_id(ids + TraceId::kSize);
+  const SpanId parent_span_id(ids + TraceId::kSize + SpanId::kSize);
+  const TraceOptions trace_options(ids + TraceId::kSize + 2 * SpanId::kSize);
+  const uint8_t flags = r.GetU8();
+  const auto code = static_cast<StatusCode>(r.GetU8());
+  r.GetU8();  // Padding.
+  const absl::Time start_time = r.GetTime();
+  const absl::Time end_time = r.GetTime();
+  const uint32_t num_attributes_dropped = r.GetU32();
+  const uint32_t num_annotations_dropped = r.GetU32();
+  const std::string name = r.GetString();
+  const std::string message = r.GetString();
+
+  std::unordered_map<std::string, AttributeValue> attributes;
+  const uint16_t num_attributes = r.GetU16();
+  for (int i = 0; i < num_attributes && r.ok(); ++i) {
+    GetAttributeValue(&r, &attributes);
+  }
+  std::vector<SpanData::TimeEvent<Annotation>> annotations;
+  const uint16_t num_annotations = r.GetU16();
+  for (int i = 0; i < num_annotations && r.ok(); ++i) {
+    const absl::Time time = r.GetTime();
+    Annotation annotation(r.GetString());
+    if (r.ok()) annotations.emplace_back(time, std::move(annotation));
+  }
+  if (flags & kTruncatedFlag) {
+    annotations.emplace_back(end_time,
+                             Annotation("Truncated by the flight recorder."));
+  }
+
+  return SpanData(
+      name, SpanContext(trace_id, span_id, trace_options), parent_span_id,
+      SpanData::TimeEvents<Annotation>(std::move(annotations),
+                                       num_annotations_dropped),
+      SpanData::TimeEvents<MessageEvent>({}, 0), /*links=*/{},
+      /*num_links_dropped=*/0, std::move(attributes), num_attributes_dropped,
+      /*has_ended=*/true, start_time, end_time, Status(code, message),
+      flags & kRemoteParentFlag);
+}
+
+}  // namespace
+
+FlightRecorderImpl* FlightRecorderImpl::Get() {
+  static FlightRecorderImpl* global_flight_recorder = new FlightRecorderImpl;
+  return global_flight_recorder;
+}
+
+bool FlightRecorderImpl::Start(absl::string_view path, size_t size_bytes) {
+  absl::MutexLock l(&mu_);
+  UnmapLocked();
+  if (size_bytes < kHeaderSize + kSlotSize) {
+    std::cerr << "FlightRecorder: " << size_bytes
+              << " bytes is too small for a flight recorder file.\n";
+    return false;
+  }
+  const uint64_t num_slots = (size_bytes - kHeaderSize) / kSlotSize;
+  const size_t mapped_size = kHeaderSize + num_slots * kSlotSize;
+  const std::string path_str(path);
+  const int fd = open(path_str.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    std::cerr << "FlightRecorder: can't open " << path_str << ": "
+              << strerror(errno) << "\n";
+    return false;
+  }
+  // ftruncate() zero-fills, so all slots start out empty.
+  if (ftruncate(fd, mapped_size) != 0) {
+    std::cerr << "FlightRecorder: can't resize " << path_str << ": "
+              << strerror(errno) << "\n";
+    close(fd);
+    return false;
+  }
+  void* base =
+      mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);  // The mapping keeps the file open.
+  if (base == MAP_FAILED) {
+    std::cerr << "FlightRecorder: can't map " << path_str << ": "
+              << strerror(errno) << "\n";
+    return false;
+  }
+  Ring* ring = new Ring;
+  ring->base = static_cast<uint8_t*>(base);
+  ring->mapped_size = mapped_size;
+  ring->num_slots = num_slots;
+  memcpy(ring->base, kMagic, sizeof(kMagic));
+  absl::little_endian::Store32(ring->base + kVersionOffset, kVersion);
+  absl::little_endian::Store32(ring->base + kSlotSizeOffset, kSlotSize);
+  absl::little_endian::Store64(ring->base + kNumSlotsOffset, num_slots);
+  ring->next_seq = new (ring->base + kNextSeqOffset) std::atomic<uint64_t>(1);
+  for (uint64_t i = 0; i < num_slots; ++i) {
+    new (ring->base + kHeaderSize + i * kSlotSize + kSeqOffset)
+        std::atomic<uint64_t>(0);
+  }
+  ring_.store(ring, std::memory_order_release);
+  return true;
+}
+
+void FlightRecorderImpl::Stop() {
+  absl::MutexLock l(&mu_);
+  UnmapLocked();
+}
+
+void FlightRecorderImpl::UnmapLocked() {
+  // Both sides of the handshake with AddSpan() are sequentially consistent:
+  // either a writer sees the null ring, or we see its registration.
+  Ring* ring = ring_.exchange(nullptr);
+  if (ring == nullptr) return;
+  while (num_writers_.load() != 0) {
+    std::this_thread::yield();
+  }
+  munmap(ring->base, ring->mapped_size);
+  delete ring;
+}
+
+void FlightRecorderImpl::AddSpan(const SpanImpl& span) {
+  num_writers_.fetch_add(1);
+  const Ring* ring = ring_.load();
+  if (ring != nullptr) Write(*ring, span);
+  num_writers_.fetch_sub(1, std::memory_order_release);
+}
+
+// static
+void FlightRecorderImpl::Write(const Ring& ring, const SpanImpl& span) {
+  const uint64_t seq = ring.next_seq->fetch_add(1, std::memory_order_relaxed);
+  uint8_t* slot =
+      ring.base + kHeaderSize + ((seq - 1) % ring.num_slots) * kSlotSize;
+  std::atomic<uint64_t>* slot_seq = SlotSeq(slot);
+  // If a writer that lapped the ring still holds the slot, drop this span
+  // rather than wait for it. If we die before publishing, the slot stays
+  // kWriting and is skipped.
+  uint64_t old_seq = slot_seq->load(std::memory_order_relaxed);
+  if (old_seq == kWriting ||
+      !slot_seq->compare_exchange_strong(old_seq, kWriting,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed)) {
+    return;
+  }
+  // Orders the kWriting store before the payload stores, for readers.
+  std::atomic_thread_fence(std::memory_order_release);
+  const size_t length =
+      Encode(span, slot + kSlotHeaderSize, kSlotSize - kSlotHeaderSize);
+  absl::little_endian::Store32(slot + kLengthOffset, length);
+  absl::little_endian::Store32(slot + kChecksumOffset,
+                               SlotChecksum(slot, seq, length));
+  slot_seq->store(seq, std::memory_order_release);
+}
+
+// static
+size_t FlightRecorderImpl::Encode(const SpanImpl& span, uint8_t* buf,
+                                  size_t size) {
+  absl::MutexLock l(&span.mu_);
+  SlotWriter w(buf, size);
+  uint8_t ids[TraceId::kSize + 2 * SpanId::kSize + TraceOptions::kSize];
+  span.context_.trace_id().CopyTo(ids);
+  span.context_.span_id().CopyTo(ids + TraceId::kSize);
+  span.parent_span_id_.CopyTo(ids + TraceId::kSize + SpanId::kSize);
+  span.context_.trace_options().CopyTo(ids + TraceId::kSize +
+                                       2 * SpanId::kSize);
+  for (uint8_t b : ids) w.PutU8(b);
+  w.PutU8(span.remote_parent_ ? kRemoteParentFlag : 0);
+  w.PutU8(span.status_.CanonicalCode());
+  w.PutU8(0);  // Padding.
+  w.PutTime(span.start_time_);
+  w.PutTime(span.end_time_);
+  const size_t num_attributes_dropped_at = w.ReserveU32();
+  const size_t num_annotations_dropped_at = w.ReserveU32();
+  w.PutString(span.name_);
+  w.PutString(span.status_.error_message());
+
+  // Only whole attributes and annotations are kept, so the counts match what
+  // was written.
+  const size_t num_attributes_at = w.ReserveU16();
+  uint16_t num_attributes = 0;
+  for (const auto& attribute : span.attributes_.attributes()) {
+    const size_t start = w.pos();
+    w.PutString(attribute.first);
+    PutAttributeValue(attribute.second, &w);
+    if (w.truncated()) {
+      w.Rollback(start);
+      break;
+    }
+    ++num_attributes;
+  }
+  const size_t num_annotations_at = w.ReserveU16();
+  uint16_t num_annotations = 0;
+  for (const auto& annotation : span.annotations_.events()) {
+    const size_t start = w.pos();
+    w.PutTime(annotation.time);
+    w.PutString(annotation.event.description());
+    if (w.truncated()) {
+      w.Rollback(start);
+      break;
+    }
+    ++num_annotations;
+  }
+  w.SetU16(num_attributes_at, num_attributes);
+  w.SetU16(num_annotations_at, num_annotations);
+  // What didn't fit counts as dropped.
+  w.SetU32(num_attributes_dropped_at,
+           span.attributes_.num_attributes_dropped() +
+               (span.attributes_.attributes().size() - num_attributes));
+  w.SetU32(num_annotations_dropped_at,
+           span.annotations_.num_events_dropped() +
+               (span.annotations_.events().size() - num_annotations));
+  if (w.truncated()) buf[kFlagsOffset] |= kTruncatedFlag;
+  return w.pos();
+}
+
+// static
+std::vector<SpanData> FlightRecorderImpl::ReadFile(absl::string_view path) {
+  // Mapped rather than read, so that the slots' sequence numbers can be
+  // checked around each copy if the file is still being written.
+  const std::string path_str(path);
+  const int fd = open(path_str.c_str(), O_RDONLY);
+  if (fd < 0) return {};
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kHeaderSize) {
+    close(fd);
+    return {};
+  }
+  const size_t size = st.st_size;
+  void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) return {};
+  const uint8_t* data = static_cast<const uint8_t*>(mapped);
+  const uint32_t slot_size =
+      absl::little_endian::Load32(data + kSlotSizeOffset);
+  const uint64_t num_slots =
+      absl::little_endian::Load64(data + kNumSlotsOffset);
+  if (memcmp(data, kMagic, sizeof(kMagic)) != 0 ||
+      absl::little_endian::Load32(data + kVersionOffset) != kVersion ||
+      slot_size <= kSlotHeaderSize || slot_size % 8 != 0 ||
+      (size - kHeaderSize) / slot_size < num_slots) {
+    munmap(mapped, size);
+    return {};
+  }
+
+  std::vector<std::pair<uint64_t, std::string>> slots;
+  for (uint64_t i = 0; i < num_slots; ++i) {
+    const uint8_t* slot = data + kHeaderSize + i * slot_size;
+    const uint64_t seq = SlotSeq(slot)->load(std::memory_order_acquire);
+    if (seq == 0 || seq == kWriting) continue;  // Empty or being written.
+    std::string copy(reinterpret_cast<const char*>(slot), slot_size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (SlotSeq(slot)->load(std::memory_order_relaxed) != seq) {
+      continue;  // Rewritten while we copied it.
+    }
+    const uint8_t* copied = reinterpret_cast<const uint8_t*>(copy.data());
+    const uint32_t length =
+        absl::little_endian::Load32(copied + kLengthOffset);
+    if (length < kFixedPayloadSize || length > slot_size - kSlotHeaderSize ||
+        absl::little_endian::Load32(copied + kChecksumOffset) !=
+            SlotChecksum(copied, seq, length)) {
+      continue;  // Torn.
+    }
+    slots.emplace_back(seq, std::move(copy));
+  }
+  munmap(mapped, size);
+  std::sort(slots.begin(), slots.end());
+
+  std::vector<SpanData> spans;
+  spans.reserve(slots.size());
+  for (const auto& seq_slot : slots) {
+    const uint8_t* slot =
+        reinterpret_cast<const uint8_t*>(seq_slot.second.data());
+    spans.push_back(
+        Decode(slot + kSlotHeaderSize,
+               absl::little_endian::Load32(slot + kLengthOffset)));
+  }
+  return spans;
+}
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
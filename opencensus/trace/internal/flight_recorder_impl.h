@@ -0,0 +1,109 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_INTERNAL_FLIGHT_RECORDER_IMPL_H_
+#define OPENCENSUS_TRACE_INTERNAL_FLIGHT_RECORDER_IMPL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/internal/span_impl.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+// FlightRecorderImpl implements the FlightRecorder API.
+//
+// File layout (all integers little-endian):
+//   Header, kHeaderSize bytes:
+//     magic "OCFLTREC", u32 version, u32 slot size, u64 number of slots,
+//     u64 next sequence number (updated atomically by writers).
+//   Slots, kSlotSize bytes each:
+//     u32 checksum of the sequence number, the length and the payload,
+//     u32 payload length, u64 sequence number (0 if empty), payload.
+//
+// A slot's sequence number doubles as a seqlock. A writer claims a sequence
+// number, which determines its slot, and swaps the slot's sequence number for
+// kWriting, so that writers that lap the ring can't interleave in one slot. It
+// then writes the payload, the length and the checksum, and publishes the slot
+// by storing the sequence number with release ordering. ReadFile() skips slots
+// that are being written, that changed while it copied them, or whose checksum
+// doesn't match, such as a slot left half-written by a crash.
+//
+// This class is thread-safe and a singleton.
+class FlightRecorderImpl {
+ public:
+  static constexpr size_t kHeaderSize = 64;
+  static constexpr size_t kSlotSize = 1024;
+  static constexpr size_t kSlotHeaderSize = 16;
+
+  // Returns the global instance of FlightRecorderImpl.
+  static FlightRecorderImpl* Get();
+
+  bool Start(absl::string_view path, size_t size_bytes) LOCKS_EXCLUDED(mu_);
+  void Stop() LOCKS_EXCLUDED(mu_);
+
+  // Returns true if spans are being recorded. Checked without locking, so that
+  // Span::End() is nearly free when the recorder is off.
+  bool enabled() const {
+    return ring_.load(std::memory_order_acquire) != nullptr;
+  }
+
+  // Appends an ended span to the ring. Only Span::End should call this.
+  void AddSpan(const SpanImpl& span);
+
+  static std::vector<SpanData> ReadFile(absl::string_view path);
+
+ private:
+  // The mapped file.
+  struct Ring {
+    uint8_t* base;
+    size_t mapped_size;
+    uint64_t num_slots;
+    // Points into the mapped header.
+    std::atomic<uint64_t>* next_seq;
+  };
+
+  FlightRecorderImpl() = default;
+
+  void UnmapLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Writes the span into the next slot of the ring.
+  static void Write(const Ring& ring, const SpanImpl& span);
+
+  // Encodes the span into buf, truncating it to fit. Returns the number of
+  // bytes written.
+  static size_t Encode(const SpanImpl& span, uint8_t* buf, size_t size);
+
+  // Serializes Start() and Stop().
+  absl::Mutex mu_;
+  // The current ring, or null if stopped. Writers don't take mu_: they
+  // register in num_writers_ before loading ring_, and Stop() clears ring_
+  // and waits for num_writers_ to drain before unmapping.
+  std::atomic<Ring*> ring_{nullptr};
+  std::atomic<int> num_writers_{0};
+};
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_INTERNAL_FLIGHT_RECORDER_IMPL_H_
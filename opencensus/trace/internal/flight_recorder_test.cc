@@ -0,0 +1,202 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/exporter/flight_recorder.h"
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/internal/flight_recorder_impl.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+namespace {
+
+std::string TestPath(absl::string_view name) {
+  const char* dir = getenv("TEST_TMPDIR");
+  return absl::StrCat(dir != nullptr ? dir : "/tmp", "/", name, ".", getpid());
+}
+
+size_t SizeForSlots(int num_slots) {
+  return FlightRecorderImpl::kHeaderSize +
+         num_slots * FlightRecorderImpl::kSlotSize;
+}
+
+TEST(FlightRecorderTest, RecordsEndedSpans) {
+  const std::string path = TestPath("records_ended_spans");
+  ASSERT_TRUE(FlightRecorder::Start(path, SizeForSlots(16)));
+  AlwaysSampler sampler;
+  auto parent = Span::StartSpan("Parent", nullptr, {&sampler});
+  auto child = Span::StartSpan("Child", &parent);
+  child.AddAttribute("key", "value");
+  child.AddAttribute("count", 42);
+  child.AddAnnotation("Annotation");
+  child.SetStatus(StatusCode::NOT_FOUND, "missing");
+  child.End();
+  parent.End();
+  FlightRecorder::Stop();
+
+  const std::vector<SpanData> spans = FlightRecorder::ReadFile(path);
+  ASSERT_EQ(2, spans.size());
+  EXPECT_EQ("Child", spans[0].name());
+  EXPECT_EQ(child.context(), spans[0].context());
+  EXPECT_EQ(parent.context().span_id(), spans[0].parent_span_id());
+  EXPECT_TRUE(spans[0].has_ended());
+  EXPECT_LE(spans[0].start_time(), spans[0].end_time());
+  EXPECT_EQ(StatusCode::NOT_FOUND, spans[0].status().CanonicalCode());
+  EXPECT_EQ("missing", spans[0].status().error_message());
+  ASSERT_EQ(2, spans[0].attributes().size());
+  EXPECT_EQ("value", spans[0].attributes().at("key").string_value());
+  EXPECT_EQ(42, spans[0].attributes().at("count").int_value());
+  ASSERT_EQ(1, spans[0].annotations().events().size());
+  EXPECT_EQ("Annotation",
+            spans[0].annotations().events()[0].event().description());
+  EXPECT_EQ("Parent", spans[1].name());
+  EXPECT_EQ(parent.context(), spans[1].context());
+  unlink(path.c_str());
+}
+
+TEST(FlightRecorderTest, KeepsMostRecentSpans) {
+  const std::string path = TestPath("keeps_most_recent_spans");
+  ASSERT_TRUE(FlightRecorder::Start(path, SizeForSlots(4)));
+  AlwaysSampler sampler;
+  for (int i = 0; i < 10; ++i) {
+    Span::StartSpan(absl::StrCat("Span", i), nullptr, {&sampler}).End();
+  }
+  FlightRecorder::Stop();
+
+  const std::vector<SpanData> spans = FlightRecorder::ReadFile(path);
+  ASSERT_EQ(4, spans.size());
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(absl::StrCat("Span", i + 6), spans[i].name());
+  }
+  unlink(path.c_str());
+}
+
+TEST(FlightRecorderTest, TruncatesLargeSpans) {
+  const std::string path = TestPath("truncates_large_spans");
+  ASSERT_TRUE(FlightRecorder::Start(path, SizeForSlots(4)));
+  AlwaysSampler sampler;
+  auto span = Span::StartSpan("Large", nullptr, {&sampler});
+  const std::string value(100, 'x');
+  for (int i = 0; i < 20; ++i) {
+    span.AddAttribute(absl::StrCat("key", i), value);
+  }
+  span.End();
+  FlightRecorder::Stop();
+
+  const std::vector<SpanData> spans = FlightRecorder::ReadFile(path);
+  ASSERT_EQ(1, spans.size());
+  EXPECT_EQ("Large", spans[0].name());
+  EXPECT_LT(0, spans[0].attributes().size());
+  EXPECT_GT(20, spans[0].attributes().size());
+  for (const auto& attribute : spans[0].attributes()) {
+    EXPECT_EQ(value, attribute.second.string_value());
+  }
+  // The attributes that didn't fit are counted as dropped.
+  EXPECT_EQ(20, spans[0].attributes().size() +
+                    spans[0].num_attributes_dropped());
+  // And the truncation is marked.
+  const auto& annotations = spans[0].annotations().events();
+  ASSERT_EQ(1, annotations.size());
+  EXPECT_EQ("Truncated by the flight recorder.",
+            annotations[0].event().description());
+  EXPECT_EQ(spans[0].end_time(), annotations[0].timestamp());
+  unlink(path.c_str());
+}
+
+TEST(FlightRecorderTest, ConcurrentWritersDontTearSlots) {
+  const std::string path = TestPath("concurrent_writers");
+  ASSERT_TRUE(FlightRecorder::Start(path, SizeForSlots(4)));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([t]() {
+      AlwaysSampler sampler;
+      const std::string name = absl::StrCat("Thread", t);
+      for (int i = 0; i < 1000; ++i) {
+        auto span = Span::StartSpan(name, nullptr, {&sampler});
+        span.AddAttribute("thread", name);
+        span.End();
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  FlightRecorder::Stop();
+
+  const std::vector<SpanData> spans = FlightRecorder::ReadFile(path);
+  EXPECT_LT(0, spans.size());
+  EXPECT_GE(4, spans.size());
+  for (const auto& span : spans) {
+    ASSERT_EQ(1, span.attributes().size());
+    EXPECT_EQ(span.name(), span.attributes().at("thread").string_value());
+  }
+  unlink(path.c_str());
+}
+
+TEST(FlightRecorderTest, SkipsTornSlots) {
+  const std::string path = TestPath("skips_torn_slots");
+  ASSERT_TRUE(FlightRecorder::Start(path, SizeForSlots(4)));
+  AlwaysSampler sampler;
+  Span::StartSpan("Torn", nullptr, {&sampler}).End();
+  Span::StartSpan("Intact", nullptr, {&sampler}).End();
+  FlightRecorder::Stop();
+
+  // Flip a payload byte in the first slot, as if the process died mid-write.
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    const size_t offset =
+        FlightRecorderImpl::kHeaderSize + FlightRecorderImpl::kSlotHeaderSize;
+    file.seekg(offset);
+    const char byte = file.get();
+    file.seekp(offset);
+    file.put(~byte);
+  }
+  const std::vector<SpanData> spans = FlightRecorder::ReadFile(path);
+  ASSERT_EQ(1, spans.size());
+  EXPECT_EQ("Intact", spans[0].name());
+  unlink(path.c_str());
+}
+
+TEST(FlightRecorderTest, StopsRecording) {
+  const std::string path = TestPath("stops_recording");
+  ASSERT_TRUE(FlightRecorder::Start(path, SizeForSlots(4)));
+  FlightRecorder::Stop();
+  AlwaysSampler sampler;
+  Span::StartSpan("NotRecorded", nullptr, {&sampler}).End();
+  EXPECT_TRUE(FlightRecorder::ReadFile(path).empty());
+  unlink(path.c_str());
+}
+
+TEST(FlightRecorderTest, RejectsBadFiles) {
+  EXPECT_FALSE(FlightRecorder::Start(TestPath("too_small"), 16));
+  EXPECT_TRUE(FlightRecorder::ReadFile(TestPath("does_not_exist")).empty());
+}
+
+}  // namespace
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
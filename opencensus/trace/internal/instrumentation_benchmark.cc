@@ -0,0 +1,90 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the cost of typical request instrumentation against the same work
+// without it. In builds with --define opencensus_noop=true both benchmarks
+// should take the same time, since the instrumentation compiles out:
+//
+//   bazel run -c opt //opencensus/trace:instrumentation_benchmark
+//   bazel run -c opt --define opencensus_noop=true
+//       //opencensus/trace:instrumentation_benchmark
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "opencensus/stats/stats.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+#include "opencensus/trace/status_code.h"
+
+namespace opencensus {
+namespace trace {
+namespace {
+
+#ifdef OPENCENSUS_NOOP
+constexpr char kLabel[] = "noop";
+#else
+constexpr char kLabel[] = "instrumented";
+#endif
+
+constexpr char kLatencyMeasureName[] = "example.com/request_latency";
+
+stats::MeasureDouble LatencyMeasure() {
+  static const stats::MeasureDouble measure =
+      stats::MeasureRegistry::RegisterDouble(kLatencyMeasureName, "ms",
+                                             "Request latency.");
+  return measure;
+}
+
+// The work being instrumented.
+uint64_t DoWork(uint64_t x) {
+  benchmark::DoNotOptimize(x *= 0x9e3779b97f4a7c15);
+  return x;
+}
+
+void BM_Uninstrumented(benchmark::State& state) {
+  uint64_t x = 1;
+  while (state.KeepRunning()) {
+    x = DoWork(x);
+  }
+  state.SetLabel(kLabel);
+}
+BENCHMARK(BM_Uninstrumented);
+
+void BM_Instrumented(benchmark::State& state) {
+  static AlwaysSampler sampler;
+  const stats::MeasureDouble measure = LatencyMeasure();
+  stats::View view(stats::ViewDescriptor()
+                       .set_name("example.com/request_latency_sum")
+                       .set_measure(kLatencyMeasureName)
+                       .set_aggregation(stats::Aggregation::Sum())
+                       .add_column("method"));
+  uint64_t x = 1;
+  while (state.KeepRunning()) {
+    auto span = Span::StartSpan("Request", /*parent=*/nullptr, {&sampler});
+    span.AddAttribute("method", "Get");
+    x = DoWork(x);
+    span.AddAnnotation("Done.");
+    span.SetStatus(StatusCode::OK);
+    span.End();
+    stats::Record({{measure, 1.5}}, {{"method", "Get"}});
+  }
+  state.SetLabel(kLabel);
+}
+BENCHMARK(BM_Instrumented);
+
+}  // namespace
+}  // namespace trace
+}  // namespace opencensus
+BENCHMARK_MAIN();
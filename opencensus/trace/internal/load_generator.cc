@@ -0,0 +1,584 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Simulates an RPC server to measure the end-to-end cost of instrumentation.
+//
+// Runs the same synthetic load twice, first with instrumentation disabled and
+// then with it enabled, and reports throughput, the per-request latency and
+// CPU overhead, allocations per request, and RSS over time. Each request spins
+// for --work_us, inside a chain of --depth spans (the root has no parent, like
+// a server span) with --attributes attributes each, and records
+// --measurements stats measurements tagged with one of --cardinality values.
+// Sampled spans and exported views go to handlers that discard them.
+//
+// Usage: load_generator [--name=value]...
+//
+// Flags (defaults in parentheses):
+//   --workers               worker threads (4)
+//   --qps                   target requests per second across all workers, or
+//                           0 to run every worker flat out (0)
+//   --duration_s            seconds to run each phase (10)
+//   --report_interval_s     seconds between progress lines (1)
+//   --work_us               synthetic work per request (50)
+//   --depth                 spans per request (3)
+//   --attributes            attributes per span (4)
+//   --measurements          Record() calls per request (2)
+//   --cardinality           distinct values of the request tag (100)
+//   --sampling_probability  probability of sampling a request (1e-4)
+//
+// Latency quantiles are accurate to within 1%. The overhead reported at a
+// quantile is the difference between the two phases' quantiles, not a
+// quantile of the per-request differences. Allocations are only counted on
+// the worker threads; the allocations of the export threads show up in the
+// CPU and RSS numbers instead.
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "opencensus/stats/stats.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/span_exporter.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+
+// Counts allocations on the current thread. A plain thread_local, so that
+// counting doesn't add contention of its own.
+namespace {
+thread_local uint64_t thread_allocations = 0;
+}  // namespace
+
+void* operator new(size_t size) {
+  ++thread_allocations;
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  int64_t workers = 4;
+  double qps = 0;
+  double duration_s = 10;
+  double report_interval_s = 1;
+  int64_t work_us = 50;
+  int64_t depth = 3;
+  int64_t attributes = 4;
+  int64_t measurements = 2;
+  int64_t cardinality = 100;
+  double sampling_probability = 1e-4;
+};
+
+bool ParseFlags(int argc, char** argv, Options* options) {
+  const std::vector<std::pair<absl::string_view,
+                              std::function<bool(absl::string_view)>>>
+      flags = {
+          {"workers",
+           [&](absl::string_view v) {
+             return absl::SimpleAtoi(v, &options->workers) &&
+                    options->workers > 0;
+           }},
+          {"qps",
+           [&](absl::string_view v) {
+             return absl::SimpleAtod(v, &options->qps) && options->qps >= 0;
+           }},
+          {"duration_s",
+           [&](absl::string_view v) {
+             return absl::SimpleAtod(v, &options->duration_s) &&
+                    options->duration_s > 0;
+           }},
+          {"report_interval_s",
+           [&](absl::string_view v) {
+             return absl::SimpleAtod(v, &options->report_interval_s) &&
+                    options->report_interval_s > 0;
+           }},
+          {"work_us",
+           [&](absl::string_view v) {
+             return absl::SimpleAtoi(v, &options->work_us) &&
+                    options->work_us >= 0;
+           }},
+          {"depth",
+           [&](absl::string_view v) {
+             return absl::SimpleAtoi(v, &options->depth) && options->depth > 0;
+           }},
+          {"attributes",
+           [&](absl::string_view v) {
+             return absl::SimpleAtoi(v, &options->attributes) &&
+                    options->attributes >= 0;
+           }},
+          {"measurements",
+           [&](absl::string_view v) {
+             return absl::SimpleAtoi(v, &options->measurements) &&
+                    options->measurements >= 0;
+           }},
+          {"cardinality",
+           [&](absl::string_view v) {
+             return absl::SimpleAtoi(v, &options->cardinality) &&
+                    options->cardinality > 0;
+           }},
+          {"sampling_probability",
+           [&](absl::string_view v) {
+             return absl::SimpleAtod(v, &options->sampling_probability) &&
+                    options->sampling_probability >= 0 &&
+                    options->sampling_probability <= 1;
+           }},
+      };
+  for (int i = 1; i < argc; ++i) {
+    absl::string_view arg = argv[i];
+    const size_t equals = arg.find('=');
+    bool ok = arg.substr(0, 2) == "--" && equals != absl::string_view::npos;
+    if (ok) {
+      const absl::string_view name = arg.substr(2, equals - 2);
+      ok = false;
+      for (const auto& flag : flags) {
+        if (flag.first == name) {
+          ok = flag.second(arg.substr(equals + 1));
+          break;
+        }
+      }
+    }
+    if (!ok) {
+      std::cerr << "Bad flag: " << arg << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+// A latency histogram with buckets less than 1% wide, so that quantiles can be
+// compared between phases without keeping every sample.
+class LatencyHistogram {
+ public:
+  void Add(uint64_t nanos) {
+    ++counts_[BucketFor(nanos)];
+    ++count_;
+  }
+
+  void Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < counts_.size(); ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+  }
+
+  uint64_t count() const { return count_; }
+
+  // Returns the upper bound of the bucket holding the q-th quantile.
+  uint64_t Quantile(double q) const {
+    const uint64_t rank = q * count_;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+      seen += counts_[i];
+      if (seen > rank) return UpperBound(i);
+    }
+    return 0;
+  }
+
+ private:
+  // Values below kSubBuckets get a bucket each; above that, each power of two
+  // is split into kSubBuckets buckets.
+  static constexpr int kSubBucketBits = 7;
+  static constexpr uint64_t kSubBuckets = 1 << kSubBucketBits;
+
+  static size_t BucketFor(uint64_t value) {
+    if (value < kSubBuckets) return value;
+    const int log = 63 - __builtin_clzll(value);
+    const uint64_t sub = (value >> (log - kSubBucketBits)) & (kSubBuckets - 1);
+    return (log - kSubBucketBits + 1) * kSubBuckets + sub;
+  }
+
+  static uint64_t UpperBound(size_t bucket) {
+    if (bucket < kSubBuckets) return bucket;
+    const int log = bucket / kSubBuckets + kSubBucketBits - 1;
+    const uint64_t sub = bucket % kSubBuckets;
+    return ((kSubBuckets + sub + 1) << (log - kSubBucketBits)) - 1;
+  }
+
+  std::array<uint64_t, (64 - kSubBucketBits + 1) * kSubBuckets> counts_{};
+  uint64_t count_ = 0;
+};
+
+int64_t RssBytes() {
+  std::ifstream statm("/proc/self/statm");
+  int64_t size = 0;
+  int64_t resident = 0;
+  statm >> size >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+double CpuSeconds() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+}
+
+double Mib(int64_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+class NullSpanHandler
+    : public ::opencensus::trace::exporter::SpanExporter::Handler {
+ public:
+  explicit NullSpanHandler(std::atomic<int64_t>* num_spans)
+      : num_spans_(num_spans) {}
+
+  void Export(const std::vector<::opencensus::trace::exporter::SpanData>& spans)
+      override {
+    num_spans_->fetch_add(spans.size(), std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<int64_t>* const num_spans_;
+};
+
+class NullStatsHandler : public ::opencensus::stats::StatsExporter::Handler {
+ public:
+  explicit NullStatsHandler(std::atomic<int64_t>* num_rows)
+      : num_rows_(num_rows) {}
+
+  void ExportViewData(
+      const ::opencensus::stats::ViewDescriptor& /*descriptor*/,
+      const ::opencensus::stats::ViewData& data) override {
+    int64_t rows = 0;
+    switch (data.type()) {
+      case ::opencensus::stats::ViewData::Type::kDouble:
+        rows = data.double_data().size();
+        break;
+      case ::opencensus::stats::ViewData::Type::kInt64:
+        rows = data.int_data().size();
+        break;
+      case ::opencensus::stats::ViewData::Type::kDistribution:
+        rows = data.distribution_data().size();
+        break;
+    }
+    num_rows_->fetch_add(rows, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<int64_t>* const num_rows_;
+};
+
+constexpr char kMethodKey[] = "method";
+constexpr char kRequestKey[] = "request_key";
+constexpr int kNumMethods = 8;
+
+// Everything the workers share, set up once before the first phase.
+struct Server {
+  explicit Server(const Options& options)
+      : options(options),
+        sampler(options.sampling_probability),
+        latency(::opencensus::stats::MeasureRegistry::RegisterDouble(
+            "load_generator/latency", "ms", "Request latency.")),
+        response_bytes(::opencensus::stats::MeasureRegistry::RegisterInt(
+            "load_generator/response_bytes", "By", "Response size.")) {
+    for (int i = 0; i < options.depth; ++i) {
+      span_names.push_back(absl::StrCat("Service.Method/", i));
+    }
+    for (int i = 0; i < options.attributes; ++i) {
+      attribute_keys.push_back(absl::StrCat("attribute", i));
+    }
+    for (int i = 0; i < kNumMethods; ++i) {
+      methods.push_back(absl::StrCat("Method", i));
+    }
+    for (int i = 0; i < options.cardinality; ++i) {
+      request_keys.push_back(absl::StrCat("key", i));
+    }
+    ::opencensus::stats::StatsExporter::AddView(
+        ::opencensus::stats::ViewDescriptor()
+            .set_name("load_generator/latency")
+            .set_measure("load_generator/latency")
+            .set_aggregation(::opencensus::stats::Aggregation::Distribution(
+                ::opencensus::stats::BucketBoundaries::Exponential(20, 0.01,
+                                                                   2)))
+            .add_column(kMethodKey)
+            .add_column(kRequestKey));
+    ::opencensus::stats::StatsExporter::AddView(
+        ::opencensus::stats::ViewDescriptor()
+            .set_name("load_generator/response_bytes")
+            .set_measure("load_generator/response_bytes")
+            .set_aggregation(::opencensus::stats::Aggregation::Sum())
+            .add_column(kMethodKey)
+            .add_column(kRequestKey));
+    ::opencensus::trace::exporter::SpanExporter::RegisterHandler(
+        absl::make_unique<NullSpanHandler>(&num_spans_exported));
+    ::opencensus::stats::StatsExporter::RegisterHandler(
+        absl::make_unique<NullStatsHandler>(&num_rows_exported));
+  }
+
+  const Options options;
+  // Mutable because StartSpanOptions takes a non-const Sampler.
+  mutable ::opencensus::trace::ProbabilitySampler sampler;
+  const ::opencensus::stats::MeasureDouble latency;
+  const ::opencensus::stats::MeasureInt response_bytes;
+  std::vector<std::string> span_names;
+  std::vector<std::string> attribute_keys;
+  std::vector<std::string> methods;
+  std::vector<std::string> request_keys;
+  std::atomic<int64_t> num_spans_exported{0};
+  std::atomic<int64_t> num_rows_exported{0};
+};
+
+void Spin(Clock::duration duration) {
+  const Clock::time_point end = Clock::now() + duration;
+  while (Clock::now() < end) {
+  }
+}
+
+struct Worker {
+  LatencyHistogram latency;
+  uint64_t num_requests = 0;
+  uint64_t num_allocations = 0;
+  std::minstd_rand rng;
+};
+
+void AddAttributes(const Server& server, ::opencensus::trace::Span* span) {
+  for (size_t i = 0; i < server.attribute_keys.size(); ++i) {
+    if (i % 2 == 0) {
+      span->AddAttribute(server.attribute_keys[i], "some string value");
+    } else {
+      span->AddAttribute(server.attribute_keys[i], static_cast<int64_t>(i));
+    }
+  }
+}
+
+// Starts the spans below parent, down to --depth, and does the work in the
+// innermost one.
+void HandleInSpan(const Server& server, int level,
+                  ::opencensus::trace::Span* parent) {
+  if (level == server.options.depth) {
+    Spin(std::chrono::microseconds(server.options.work_us));
+    return;
+  }
+  auto span =
+      ::opencensus::trace::Span::StartSpan(server.span_names[level], parent);
+  AddAttributes(server, &span);
+  HandleInSpan(server, level + 1, &span);
+  span.End();
+}
+
+void HandleRequest(const Server& server, bool instrumented, Worker* worker) {
+  if (!instrumented) {
+    Spin(std::chrono::microseconds(server.options.work_us));
+    return;
+  }
+  const uint32_t r = worker->rng();
+  const std::string& method = server.methods[r % kNumMethods];
+  const std::string& request_key =
+      server.request_keys[(r / kNumMethods) % server.request_keys.size()];
+  auto span = ::opencensus::trace::Span::StartSpan(
+      server.span_names[0], /*parent=*/nullptr,
+      {&server.sampler});
+  AddAttributes(server, &span);
+  HandleInSpan(server, 1, &span);
+  for (int i = 0; i < server.options.measurements; ++i) {
+    if (i % 2 == 0) {
+      ::opencensus::stats::Record({{server.latency, 0.05}},
+                                  {{kMethodKey, method},
+                                   {kRequestKey, request_key}});
+    } else {
+      ::opencensus::stats::Record({{server.response_bytes, 1024}},
+                                  {{kMethodKey, method},
+                                   {kRequestKey, request_key}});
+    }
+  }
+  span.End();
+}
+
+void RunWorker(const Server& server, bool instrumented,
+               const std::atomic<bool>* done, std::atomic<uint64_t>* progress,
+               Worker* worker) {
+  const Clock::duration interval =
+      server.options.qps > 0
+          ? std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(server.options.workers /
+                                              server.options.qps))
+          : Clock::duration::zero();
+  Clock::time_point next = Clock::now();
+  while (!done->load(std::memory_order_relaxed)) {
+    if (interval > Clock::duration::zero()) {
+      next += interval;
+      std::this_thread::sleep_until(next);
+    }
+    const uint64_t allocations = thread_allocations;
+    const Clock::time_point start = Clock::now();
+    HandleRequest(server, instrumented, worker);
+    const Clock::time_point end = Clock::now();
+    worker->num_allocations += thread_allocations - allocations;
+    worker->latency.Add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+            .count());
+    ++worker->num_requests;
+    progress->fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+struct PhaseResult {
+  LatencyHistogram latency;
+  uint64_t num_requests = 0;
+  uint64_t num_allocations = 0;
+  double wall_seconds = 0;
+  double cpu_seconds = 0;
+  int64_t start_rss = 0;
+  int64_t end_rss = 0;
+
+  double qps() const { return num_requests / wall_seconds; }
+  double cpu_us_per_request() const {
+    return 1e6 * cpu_seconds / num_requests;
+  }
+};
+
+PhaseResult RunPhase(const Server& server, bool instrumented) {
+  const char* name = instrumented ? "instrumented" : "disabled";
+  std::vector<Worker> workers(server.options.workers);
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i].rng.seed(i + 1);
+  }
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> progress(0);
+
+  PhaseResult result;
+  result.start_rss = RssBytes();
+  const double start_cpu = CpuSeconds();
+  const Clock::time_point start = Clock::now();
+  std::vector<std::thread> threads;
+  for (auto& worker : workers) {
+    threads.emplace_back(RunWorker, std::cref(server), instrumented, &done,
+                         &progress, &worker);
+  }
+
+  const auto report_interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(server.options.report_interval_s));
+  const Clock::time_point end =
+      start + std::chrono::duration_cast<Clock::duration>(
+                  std::chrono::duration<double>(server.options.duration_s));
+  Clock::time_point last_report = start;
+  uint64_t last_progress = 0;
+  while (Clock::now() < end) {
+    const Clock::time_point next_report =
+        std::min(end, last_report + report_interval);
+    std::this_thread::sleep_until(next_report);
+    const Clock::time_point now = Clock::now();
+    const uint64_t requests = progress.load(std::memory_order_relaxed);
+    const double seconds = std::chrono::duration<double>(now - start).count();
+    const double qps =
+        (requests - last_progress) /
+        std::chrono::duration<double>(now - last_report).count();
+    std::printf("%-12s t=%6.1fs  qps=%10.0f  rss=%8.2f MiB\n", name, seconds,
+                qps, Mib(RssBytes()));
+    std::fflush(stdout);
+    last_report = now;
+    last_progress = requests;
+  }
+
+  done = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  result.wall_seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  result.cpu_seconds = CpuSeconds() - start_cpu;
+  result.end_rss = RssBytes();
+  for (const auto& worker : workers) {
+    result.latency.Merge(worker.latency);
+    result.num_requests += worker.num_requests;
+    result.num_allocations += worker.num_allocations;
+  }
+  return result;
+}
+
+void PrintQuantile(const char* label, double q, const PhaseResult& disabled,
+                   const PhaseResult& instrumented) {
+  const double base = disabled.latency.Quantile(q) * 1e-3;
+  const double with = instrumented.latency.Quantile(q) * 1e-3;
+  std::printf("  %s latency: %10.2f us -> %10.2f us  (overhead %+.2f us)\n",
+              label, base, with, with - base);
+}
+
+void PrintReport(const Server& server, const PhaseResult& disabled,
+                 const PhaseResult& instrumented) {
+  const Options& o = server.options;
+  std::printf(
+      "\nworkers=%lld qps=%.0f work_us=%lld depth=%lld attributes=%lld "
+      "measurements=%lld cardinality=%lld sampling_probability=%g\n",
+      static_cast<long long>(o.workers), o.qps,
+      static_cast<long long>(o.work_us), static_cast<long long>(o.depth),
+      static_cast<long long>(o.attributes),
+      static_cast<long long>(o.measurements),
+      static_cast<long long>(o.cardinality), o.sampling_probability);
+  std::printf("                     disabled -> instrumented\n");
+  std::printf("  throughput:    %10.0f qps -> %10.0f qps\n", disabled.qps(),
+              instrumented.qps());
+  PrintQuantile("p50", 0.5, disabled, instrumented);
+  PrintQuantile("p99", 0.99, disabled, instrumented);
+  std::printf(
+      "  CPU/request:   %10.2f us -> %10.2f us  (overhead %+.1f%%, %.2f "
+      "cores at %.0f qps)\n",
+      disabled.cpu_us_per_request(), instrumented.cpu_us_per_request(),
+      100 * (instrumented.cpu_us_per_request() /
+                 disabled.cpu_us_per_request() -
+             1),
+      instrumented.cpu_seconds / instrumented.wall_seconds,
+      instrumented.qps());
+  std::printf("  allocations/request: %.2f -> %.2f\n",
+              static_cast<double>(disabled.num_allocations) /
+                  disabled.num_requests,
+              static_cast<double>(instrumented.num_allocations) /
+                  instrumented.num_requests);
+  std::printf("  RSS: %.2f MiB -> %.2f MiB (%+.2f MiB while instrumented)\n",
+              Mib(disabled.start_rss), Mib(instrumented.end_rss),
+              Mib(instrumented.end_rss - instrumented.start_rss));
+  std::printf("  exported: %lld spans, %lld view rows\n",
+              static_cast<long long>(server.num_spans_exported.load()),
+              static_cast<long long>(server.num_rows_exported.load()));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseFlags(argc, argv, &options)) {
+    std::cerr << "Usage: " << argv[0] << " [--name=value]...\n";
+    return 1;
+  }
+  Server server(options);
+  const PhaseResult disabled = RunPhase(server, /*instrumented=*/false);
+  const PhaseResult instrumented = RunPhase(server, /*instrumented=*/true);
+  PrintReport(server, disabled, instrumented);
+  return 0;
+}
@@ -14,10 +14,14 @@
 
 #include "opencensus/trace/exporter/local_span_store.h"
 
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "opencensus/trace/exporter/span_data.h"
 #include "opencensus/trace/internal/local_span_store_impl.h"
+#include "opencensus/trace/trace_id.h"
 
 namespace opencensus {
 namespace trace {
@@ -27,20 +31,36 @@ LocalSpanStore::Summary LocalSpanStore::GetSummary() {
   return LocalSpanStoreImpl::Get()->GetSummary();
 }
 
-std::vector<SpanData> LocalSpanStore::GetLatencySampledSpans(
+std::vector<std::shared_ptr<const SpanData>>
+LocalSpanStore::GetLatencySampledSpans(
     const LocalSpanStore::LatencyFilter& filter) {
   return LocalSpanStoreImpl::Get()->GetLatencySampledSpans(filter);
 }
 
-std::vector<SpanData> LocalSpanStore::GetErrorSampledSpans(
+std::vector<std::shared_ptr<const SpanData>>
+LocalSpanStore::GetErrorSampledSpans(
     const LocalSpanStore::ErrorFilter& filter) {
   return LocalSpanStoreImpl::Get()->GetErrorSampledSpans(filter);
 }
 
-std::vector<SpanData> LocalSpanStore::GetSpans() {
+std::vector<std::shared_ptr<const SpanData>> LocalSpanStore::GetSpans() {
   return LocalSpanStoreImpl::Get()->GetSpans();
 }
 
+std::vector<TraceId> LocalSpanStore::GetTraceIds() {
+  return LocalSpanStoreImpl::Get()->GetTraceIds();
+}
+
+LocalSpanStore::TraceAnalysis LocalSpanStore::AnalyzeTrace(
+    const TraceId& trace_id) {
+  return LocalSpanStoreImpl::Get()->AnalyzeTrace(trace_id);
+}
+
+std::unordered_map<std::string, LocalSpanStore::SpanNameProfile>
+LocalSpanStore::GetSpanNameProfiles() {
+  return LocalSpanStoreImpl::Get()->GetSpanNameProfiles();
+}
+
 }  // namespace exporter
 }  // namespace trace
 }  // namespace opencensus
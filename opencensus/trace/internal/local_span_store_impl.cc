@@ -14,48 +14,52 @@
 
 #include "opencensus/trace/internal/local_span_store_impl.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <list>
 #include <memory>
-#include <queue>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "absl/base/internal/endian.h"
+#include "absl/base/macros.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "opencensus/common/internal/random.h"
 #include "opencensus/trace/exporter/span_data.h"
 #include "opencensus/trace/exporter/status.h"
 #include "opencensus/trace/internal/span_impl.h"
+#include "opencensus/trace/internal/trace_analysis.h"
 #include "opencensus/trace/span.h"
 #include "opencensus/trace/span_context.h"
 #include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_id.h"
 
 namespace opencensus {
 namespace trace {
 namespace exporter {
 
 namespace {
-constexpr int kMaxSpans = 128;
 
 using ErrorFilter = LocalSpanStore::ErrorFilter;
 using LatencyBucketBoundary = LocalSpanStore::LatencyBucketBoundary;
 using LatencyFilter = LocalSpanStore::LatencyFilter;
 using PerSpanNameSummary = LocalSpanStore::PerSpanNameSummary;
+using SpanNameProfile = LocalSpanStore::SpanNameProfile;
 using Summary = LocalSpanStore::Summary;
+using TraceAnalysis = LocalSpanStore::TraceAnalysis;
 
-// Returns a reference to the requested PerSpanNameSummary. If necessary, adds
-// it first.
-PerSpanNameSummary& GetPerSpanNameSummary(absl::string_view span_name,
-                                          LocalSpanStore::Summary* summary) {
-  const std::string name = std::string(span_name);
-  return summary->per_span_name_summary
-      .insert({name, LocalSpanStore::PerSpanNameSummary()})
-      .first->second;
-}
+// The lower bound of each LatencyBucketBoundary. The upper bound is the next
+// bucket's lower bound.
+constexpr absl::Duration kLatencyBucketLowerBounds[] = {
+    absl::ZeroDuration(),    absl::Microseconds(10), absl::Microseconds(100),
+    absl::Milliseconds(1),   absl::Milliseconds(10), absl::Milliseconds(100),
+    absl::Seconds(1),        absl::Seconds(10),      absl::Seconds(100),
+};
 
 // Returns the LatencyBucketBoundary corresponding to the given latency.
 LatencyBucketBoundary GetLatencyBucketBoundary(absl::Duration latency) {
@@ -75,86 +79,264 @@ LatencyBucketBoundary GetLatencyBucketBoundary(absl::Duration latency) {
   return LatencyBucketBoundary::k100s_plus;
 }
 
-// Increment the counter corresponding to the given key. Sets it to 1 if the key
-// wasn't present before.
-template <typename Key, typename Hash>
-void MapIncrement(const Key& key, std::unordered_map<Key, int, Hash>* map) {
-  auto iter_inserted = map->insert({key, 1});
-  if (!iter_inserted.second) {
-    // Was not inserted: needs to be incremented instead.
-    ++iter_inserted.first->second;
-  }
+// Returns true if the bucket can hold spans with latency in [lower, upper).
+bool BucketOverlaps(int bucket, absl::Duration lower, absl::Duration upper) {
+  const absl::Duration bucket_lower = kLatencyBucketLowerBounds[bucket];
+  const absl::Duration bucket_upper =
+      bucket + 1 < ABSL_ARRAYSIZE(kLatencyBucketLowerBounds)
+          ? kLatencyBucketLowerBounds[bucket + 1]
+          : absl::InfiniteDuration();
+  return bucket_lower < upper && lower < bucket_upper;
 }
 
 }  // namespace
 
+std::shared_ptr<const SpanData> LocalSpanStoreImpl::SampledSpan::data()
+    const {
+  absl::MutexLock l(&mu_);
+  if (data_ == nullptr) {
+    data_ = std::make_shared<const SpanData>(span_->ToSpanData());
+    span_.reset();
+  }
+  return data_;
+}
+
+void LocalSpanStoreImpl::Reservoir::Add(
+    const std::shared_ptr<const SampledSpan>& span, size_t capacity) {
+  ++num_offered_;
+  if (samples_.size() < capacity) {
+    samples_.push_back(span);
+    return;
+  }
+  // Keep the new span with probability capacity / num_offered_, replacing a
+  // uniformly chosen sample.
+  const uint64_t slot =
+      ::opencensus::common::Random::GetRandom()->GenerateRandom64() %
+      num_offered_;
+  if (slot < capacity) {
+    samples_[slot] = span;
+  }
+}
+
+// static
+std::vector<std::shared_ptr<const SpanData>> LocalSpanStoreImpl::ToSpanData(
+    const std::vector<std::shared_ptr<const SampledSpan>>& samples) {
+  std::vector<std::shared_ptr<const SpanData>> out;
+  out.reserve(samples.size());
+  for (const auto& sample : samples) {
+    out.emplace_back(sample->data());
+  }
+  return out;
+}
+
+template <typename Fn>
+void LocalSpanStoreImpl::ForEachSpanName(absl::string_view span_name,
+                                         Fn fn) const {
+  if (span_name.empty()) {
+    for (const auto& name_samples : samples_) {
+      fn(name_samples.second);
+    }
+    return;
+  }
+  auto it = samples_.find(std::string(span_name));
+  if (it != samples_.end()) {
+    fn(it->second);
+  }
+}
+
 LocalSpanStoreImpl* LocalSpanStoreImpl::Get() {
-  static LocalSpanStoreImpl* global_running_span_store = new LocalSpanStoreImpl;
-  return global_running_span_store;
+  static LocalSpanStoreImpl* global_local_span_store = new LocalSpanStoreImpl;
+  return global_local_span_store;
 }
 
 void LocalSpanStoreImpl::AddSpan(const std::shared_ptr<SpanImpl>& span) {
+  const absl::Duration latency = span->latency();
+  const StatusCode code = span->status_code();
+  const TraceId trace_id = span->context().trace_id();
+  auto sampled = std::make_shared<const SampledSpan>(
+      span, latency, span->MemoryUsage() + sizeof(SampledSpan),
+      &memory_account_);
   absl::MutexLock l(&mu_);
-  if (spans_.size() >= kMaxSpans) {
-    spans_.pop_back();  // Make room.
+  PerSpanNameSamples& samples = GetSamplesLocked(span->name_constref());
+  if (code == StatusCode::OK) {
+    samples.latency[GetLatencyBucketBoundary(latency)].Add(
+        sampled, kMaxLatencySamplesPerBucket);
+  } else if (code < kNumStatusCodes) {
+    samples.errors[code].Add(sampled, kMaxErrorSamplesPerBucket);
+  }
+
+  auto it = traces_.find(trace_id);
+  if (it != traces_.end()) {
+    trace_order_.splice(trace_order_.end(), trace_order_, it->second.order);
+  } else {
+    if (trace_order_.size() >= kMaxTraces) {
+      traces_.erase(trace_order_.front());
+      trace_order_.pop_front();
+    }
+    it = traces_.emplace(trace_id, StoredTrace()).first;
+    it->second.order = trace_order_.insert(trace_order_.end(), trace_id);
+  }
+  auto& spans = it->second.spans;
+  if (spans.size() < kMaxSpansPerTrace) {
+    spans.push_back(std::move(sampled));
   }
-  spans_.emplace_front(span->ToSpanData());
+}
+
+LocalSpanStoreImpl::PerSpanNameSamples& LocalSpanStoreImpl::GetSamplesLocked(
+    const std::string& span_name) {
+  auto it = samples_.find(span_name);
+  if (it != samples_.end()) {
+    span_name_order_.splice(span_name_order_.end(), span_name_order_,
+                            it->second.order);
+    return it->second;
+  }
+  if (samples_.size() >= kMaxSpanNames) {
+    auto evicted = samples_.find(*span_name_order_.front());
+    memory_account_.Add(
+        0, -common::MemoryAccount::StringBytes(evicted->first),
+        -kSpanNameBytes);
+    span_name_order_.pop_front();
+    samples_.erase(evicted);
+  }
+  it = samples_.emplace(span_name, PerSpanNameSamples()).first;
+  it->second.order =
+      span_name_order_.insert(span_name_order_.end(), &it->first);
+  memory_account_.Add(0, common::MemoryAccount::StringBytes(span_name),
+                      kSpanNameBytes);
+  return it->second;
 }
 
 Summary LocalSpanStoreImpl::GetSummary() const {
   Summary summary;
   absl::MutexLock l(&mu_);
-  for (const auto& span : spans_) {
-    PerSpanNameSummary& curr = GetPerSpanNameSummary(span.name(), &summary);
-    const absl::Duration latency = span.end_time() - span.start_time();
-    MapIncrement(GetLatencyBucketBoundary(latency),
-                 &curr.number_of_latency_sampled_spans);
-    MapIncrement(span.status().CanonicalCode(),
-                 &curr.number_of_error_sampled_spans);
+  for (const auto& name_samples : samples_) {
+    PerSpanNameSummary& curr =
+        summary.per_span_name_summary[name_samples.first];
+    const PerSpanNameSamples& samples = name_samples.second;
+    for (int i = 0; i < kNumLatencyBuckets; ++i) {
+      if (!samples.latency[i].samples().empty()) {
+        curr.number_of_latency_sampled_spans[static_cast<
+            LatencyBucketBoundary>(i)] = samples.latency[i].samples().size();
+      }
+    }
+    for (int i = 0; i < kNumStatusCodes; ++i) {
+      if (!samples.errors[i].samples().empty()) {
+        curr.number_of_error_sampled_spans[static_cast<StatusCode>(i)] =
+            samples.errors[i].samples().size();
+      }
+    }
   }
   return summary;
 }
 
-std::vector<SpanData> LocalSpanStoreImpl::GetLatencySampledSpans(
-    const LatencyFilter& filter) const {
-  std::vector<SpanData> out;
-  absl::MutexLock l(&mu_);
-  for (const auto& span : spans_) {
-    uint64_t latency_ns =
-        (span.end_time() - span.start_time()) / absl::Nanoseconds(1);
-    if ((filter.span_name.empty() || (span.name() == filter.span_name)) &&
-        latency_ns >= filter.lower_latency_ns &&
-        latency_ns < filter.upper_latency_ns) {
-      out.emplace_back(span);
-    }
-    if (out.size() >= filter.max_spans_to_return) break;
+std::vector<std::shared_ptr<const SpanData>>
+LocalSpanStoreImpl::GetLatencySampledSpans(const LatencyFilter& filter) const {
+  const absl::Duration lower = absl::Nanoseconds(filter.lower_latency_ns);
+  const absl::Duration upper = absl::Nanoseconds(filter.upper_latency_ns);
+  const size_t max_spans = std::max(filter.max_spans_to_return, 0);
+  std::vector<std::shared_ptr<const SampledSpan>> matches;
+  {
+    absl::MutexLock l(&mu_);
+    ForEachSpanName(filter.span_name, [&](const PerSpanNameSamples& samples) {
+      for (int i = 0; i < kNumLatencyBuckets; ++i) {
+        if (!BucketOverlaps(i, lower, upper)) continue;
+        for (const auto& sample : samples.latency[i].samples()) {
+          if (matches.size() >= max_spans) return;
+          if (sample->latency() >= lower && sample->latency() < upper) {
+            matches.push_back(sample);
+          }
+        }
+      }
+    });
   }
-  return out;
+  return ToSpanData(matches);
 }
 
-std::vector<SpanData> LocalSpanStoreImpl::GetErrorSampledSpans(
-    const ErrorFilter& filter) const {
-  std::vector<SpanData> out;
-  absl::MutexLock l(&mu_);
-  for (const auto& span : spans_) {
-    if ((filter.span_name.empty() || (span.name() == filter.span_name)) &&
-        filter.canonical_code == span.status().CanonicalCode()) {
-      out.emplace_back(span);
-    }
-    if (out.size() >= filter.max_spans_to_return) break;
+std::vector<std::shared_ptr<const SpanData>>
+LocalSpanStoreImpl::GetErrorSampledSpans(const ErrorFilter& filter) const {
+  const size_t max_spans = std::max(filter.max_spans_to_return, 0);
+  std::vector<std::shared_ptr<const SampledSpan>> matches;
+  {
+    absl::MutexLock l(&mu_);
+    ForEachSpanName(filter.span_name, [&](const PerSpanNameSamples& samples) {
+      for (int i = 0; i < kNumStatusCodes; ++i) {
+        if (!filter.all_errors && i != filter.canonical_code) continue;
+        for (const auto& sample : samples.errors[i].samples()) {
+          if (matches.size() >= max_spans) return;
+          matches.push_back(sample);
+        }
+      }
+    });
   }
-  return out;
+  return ToSpanData(matches);
+}
+
+std::vector<std::shared_ptr<const SpanData>> LocalSpanStoreImpl::GetSpans()
+    const {
+  std::vector<std::shared_ptr<const SampledSpan>> all;
+  {
+    absl::MutexLock l(&mu_);
+    ForEachSpanName("", [&all](const PerSpanNameSamples& samples) {
+      for (const auto& reservoir : samples.latency) {
+        all.insert(all.end(), reservoir.samples().begin(),
+                   reservoir.samples().end());
+      }
+      for (const auto& reservoir : samples.errors) {
+        all.insert(all.end(), reservoir.samples().begin(),
+                   reservoir.samples().end());
+      }
+    });
+  }
+  return ToSpanData(all);
 }
 
-std::vector<SpanData> LocalSpanStoreImpl::GetSpans() const {
+std::vector<TraceId> LocalSpanStoreImpl::GetTraceIds() const {
   absl::MutexLock l(&mu_);
-  std::vector<SpanData> out(spans_.begin(), spans_.end());
-  return out;
+  return std::vector<TraceId>(trace_order_.rbegin(), trace_order_.rend());
+}
+
+std::vector<std::shared_ptr<const SpanData>> LocalSpanStoreImpl::GetTraceSpans(
+    const TraceId& trace_id) const {
+  std::vector<std::shared_ptr<const SampledSpan>> spans;
+  {
+    absl::MutexLock l(&mu_);
+    auto it = traces_.find(trace_id);
+    if (it != traces_.end()) spans = it->second.spans;
+  }
+  return ToSpanData(spans);
+}
+
+TraceAnalysis LocalSpanStoreImpl::AnalyzeTrace(const TraceId& trace_id) const {
+  return ::opencensus::trace::exporter::AnalyzeTrace(GetTraceSpans(trace_id));
+}
+
+std::unordered_map<std::string, SpanNameProfile>
+LocalSpanStoreImpl::GetSpanNameProfiles() const {
+  std::unordered_map<std::string, SpanNameProfile> profiles;
+  for (const TraceId& trace_id : GetTraceIds()) {
+    for (const auto& analyzed : AnalyzeTrace(trace_id).spans) {
+      const SpanData& span = *analyzed.span;
+      SpanNameProfile& profile = profiles[std::string(span.name())];
+      ++profile.num_spans;
+      profile.total_time += span.end_time() - span.start_time();
+      profile.self_time += analyzed.self_time;
+      profile.critical_path_time += analyzed.critical_path_time;
+    }
+  }
+  return profiles;
 }
 
 void LocalSpanStoreImpl::ClearForTesting() {
   absl::MutexLock l(&mu_);
-  spans_.clear();
+  for (const auto& name_samples : samples_) {
+    memory_account_.Add(
+        0, -common::MemoryAccount::StringBytes(name_samples.first),
+        -kSpanNameBytes);
+  }
+  samples_.clear();
+  span_name_order_.clear();
+  traces_.clear();
+  trace_order_.clear();
 }
 
 }  // namespace exporter
@@ -17,8 +17,9 @@
 
 #include "opencensus/trace/exporter/local_span_store.h"
 
+#include <array>
 #include <cstdint>
-#include <deque>
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -30,12 +31,15 @@
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "opencensus/common/internal/memory_account.h"
 #include "opencensus/trace/exporter/span_data.h"
 #include "opencensus/trace/exporter/status.h"
 #include "opencensus/trace/internal/span_impl.h"
 #include "opencensus/trace/span.h"
 #include "opencensus/trace/span_context.h"
 #include "opencensus/trace/span_id.h"
+#include "opencensus/trace/status_code.h"
+#include "opencensus/trace/trace_id.h"
 
 namespace opencensus {
 namespace trace {
@@ -43,38 +47,188 @@ namespace exporter {
 
 // LocalSpanStoreImpl implements the LocalSpanStore API.
 //
+// For every span name, ended spans are sampled into bounded reservoirs: one
+// per LatencyBucketBoundary for successful spans, and one per StatusCode for
+// failed spans. Reservoir sampling keeps a uniform sample of all the spans that
+// fell into a bucket, so rare outliers are not crowded out by common spans.
+//
+// Spans are indexed by name, and the reservoir sizes double as per-bucket
+// counters, so GetSummary() is O(names * buckets) and filtered queries only
+// visit the buckets that can match. At most kMaxSpanNames names are kept; the
+// name that least recently ended a span is evicted to make room for a new one.
+//
+// Span::End() only makes the sampling decision and keeps a reference to the
+// SpanImpl. A sampled span is converted to SpanData the first time it is
+// queried, outside of the store's lock, and the result is shared by all later
+// queries.
+//
+// Separately from the samples, every ended span of the kMaxTraces traces that
+// most recently ended a span is kept in an index by trace ID, up to
+// kMaxSpansPerTrace spans per trace, for trace analysis. A span kept by both
+// shares its SampledSpan, so it is converted at most once.
+//
 // This class is thread-safe and a singleton.
 class LocalSpanStoreImpl {
  public:
+  // The maximum number of spans kept per span name and latency bucket.
+  static constexpr int kMaxLatencySamplesPerBucket = 16;
+  // The maximum number of spans kept per span name and error code.
+  static constexpr int kMaxErrorSamplesPerBucket = 8;
+  // The maximum number of span names sampled.
+  static constexpr int kMaxSpanNames = 128;
+  // The number of traces kept for analysis.
+  static constexpr int kMaxTraces = 32;
+  // The maximum number of spans kept per trace. Later spans are dropped.
+  static constexpr int kMaxSpansPerTrace = 256;
+
   // Returns the global instance of LocalSpanStoreImpl.
   static LocalSpanStoreImpl* Get();
 
-  // Adds a new running Span. Only Span::End should call this.
+  // Offers an ended Span to the store. Only Span::End should call this.
   void AddSpan(const std::shared_ptr<SpanImpl>& span) LOCKS_EXCLUDED(mu_);
 
   // Returns a summary of the data available in the LocalSpanStore.
   LocalSpanStore::Summary GetSummary() const LOCKS_EXCLUDED(mu_);
 
-  // Returns the running spans that match the filter.
-  std::vector<SpanData> GetLatencySampledSpans(
+  // Returns the sampled successful spans that match the filter.
+  std::vector<std::shared_ptr<const SpanData>> GetLatencySampledSpans(
       const LocalSpanStore::LatencyFilter& filter) const LOCKS_EXCLUDED(mu_);
 
-  std::vector<SpanData> GetErrorSampledSpans(
+  // Returns the sampled failed spans that match the filter.
+  std::vector<std::shared_ptr<const SpanData>> GetErrorSampledSpans(
       const LocalSpanStore::ErrorFilter& filter) const LOCKS_EXCLUDED(mu_);
 
-  std::vector<SpanData> GetSpans() const LOCKS_EXCLUDED(mu_);
+  // Returns all sampled spans.
+  std::vector<std::shared_ptr<const SpanData>> GetSpans() const
+      LOCKS_EXCLUDED(mu_);
+
+  // Returns the IDs of the traces kept for analysis, most recent first.
+  std::vector<TraceId> GetTraceIds() const LOCKS_EXCLUDED(mu_);
+
+  // Analyzes the stored spans of a trace.
+  LocalSpanStore::TraceAnalysis AnalyzeTrace(const TraceId& trace_id) const
+      LOCKS_EXCLUDED(mu_);
+
+  // Analyzes all the stored traces and returns the totals by span name.
+  std::unordered_map<std::string, LocalSpanStore::SpanNameProfile>
+  GetSpanNameProfiles() const LOCKS_EXCLUDED(mu_);
 
  private:
   friend class LocalSpanStoreImplTestPeer;
 
+  static constexpr int kNumLatencyBuckets =
+      LocalSpanStore::LatencyBucketBoundary::k100s_plus + 1;
+  static constexpr int kNumStatusCodes = StatusCode::DATA_LOSS + 1;
+
+  // A span kept by the store. Its SpanData is built on first use, and the
+  // SpanImpl is released once that's done. Counts its estimated size in
+  // account for as long as it lives. Thread-safe.
+  class SampledSpan {
+   public:
+    SampledSpan(std::shared_ptr<SpanImpl> span, absl::Duration latency,
+                int64_t bytes, common::MemoryAccount* account)
+        : latency_(latency),
+          bytes_(bytes),
+          account_(account),
+          span_(std::move(span)) {
+      account_->Add(1, 0, bytes_);
+    }
+    ~SampledSpan() { account_->Add(-1, 0, -bytes_); }
+
+    absl::Duration latency() const { return latency_; }
+
+    // Returns the SpanData, converting the span if this is the first call.
+    std::shared_ptr<const SpanData> data() const LOCKS_EXCLUDED(mu_);
+
+   private:
+    const absl::Duration latency_;
+    const int64_t bytes_;
+    common::MemoryAccount* const account_;
+    mutable absl::Mutex mu_;
+    mutable std::shared_ptr<SpanImpl> span_ GUARDED_BY(mu_);
+    mutable std::shared_ptr<const SpanData> data_ GUARDED_BY(mu_);
+  };
+
+  // A fixed-capacity uniform sample of the spans offered to it (Algorithm R).
+  // Thread-compatible.
+  class Reservoir {
+   public:
+    void Add(const std::shared_ptr<const SampledSpan>& span, size_t capacity);
+
+    const std::vector<std::shared_ptr<const SampledSpan>>& samples() const {
+      return samples_;
+    }
+
+   private:
+    // The number of spans offered to this reservoir, including ones that
+    // were not kept.
+    uint64_t num_offered_ = 0;
+    std::vector<std::shared_ptr<const SampledSpan>> samples_;
+  };
+
+  struct PerSpanNameSamples {
+    std::array<Reservoir, kNumLatencyBuckets> latency;
+    // Indexed by StatusCode. The entry for OK is unused.
+    std::array<Reservoir, kNumStatusCodes> errors;
+    // The name's position in span_name_order_.
+    std::list<const std::string*>::iterator order;
+  };
+
+  struct StoredTrace {
+    std::vector<std::shared_ptr<const SampledSpan>> spans;
+    // The trace's position in trace_order_.
+    std::list<TraceId>::iterator order;
+  };
+
+  struct TraceIdHash {
+    size_t operator()(const TraceId& trace_id) const {
+      uint8_t buf[TraceId::kSize];
+      trace_id.CopyTo(buf);
+      // Trace IDs are random, so folding them is hash enough.
+      return absl::little_endian::Load64(buf) ^
+             absl::little_endian::Load64(buf + 8);
+    }
+  };
+
   // Private so only Get() can call it.
   LocalSpanStoreImpl() {}
 
+  // Calls fn on the samples for span_name, or on all samples if span_name is
+  // empty.
+  template <typename Fn>
+  void ForEachSpanName(absl::string_view span_name, Fn fn) const
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns SpanData for the samples. Called without holding mu_, so that
+  // conversions don't block Span::End().
+  static std::vector<std::shared_ptr<const SpanData>> ToSpanData(
+      const std::vector<std::shared_ptr<const SampledSpan>>& samples);
+
+  // Returns the samples for a span name, adding it, and evicting the least
+  // recently used name if there are too many, if it's new.
+  PerSpanNameSamples& GetSamplesLocked(const std::string& span_name)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns the bytes accounted for each span name, on top of its string.
+  static constexpr int64_t kSpanNameBytes =
+      sizeof(PerSpanNameSamples) + 3 * sizeof(void*);
+
   // Clears all currently active spans from the store.
   void ClearForTesting() LOCKS_EXCLUDED(mu_);
 
+  // Returns the stored spans of a trace.
+  std::vector<std::shared_ptr<const SpanData>> GetTraceSpans(
+      const TraceId& trace_id) const LOCKS_EXCLUDED(mu_);
+
+  // Declared first so that it outlives the SampledSpans.
+  common::MemoryAccount memory_account_{"trace/local_span_store"};
   mutable absl::Mutex mu_;
-  std::deque<SpanData> spans_ GUARDED_BY(mu_);
+  std::unordered_map<std::string, PerSpanNameSamples> samples_ GUARDED_BY(mu_);
+  // The keys of samples_, least recently used first.
+  std::list<const std::string*> span_name_order_ GUARDED_BY(mu_);
+  std::unordered_map<TraceId, StoredTrace, TraceIdHash> traces_ GUARDED_BY(mu_);
+  // The keys of traces_, least recently ended first.
+  std::list<TraceId> trace_order_ GUARDED_BY(mu_);
 };
 
 }  // namespace exporter
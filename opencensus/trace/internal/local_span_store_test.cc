@@ -14,10 +14,19 @@
 
 #include "opencensus/trace/exporter/local_span_store.h"
 
+#include <memory>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "gtest/gtest.h"
 #include "opencensus/trace/internal/local_span_store_impl.h"
+#include "opencensus/trace/internal/running_span_store_impl.h"
+#include "opencensus/trace/internal/span_impl.h"
 #include "opencensus/trace/sampler.h"
 #include "opencensus/trace/span.h"
+#include "opencensus/trace/trace_id.h"
 
 namespace opencensus {
 namespace trace {
@@ -25,10 +34,12 @@ namespace trace {
 class SpanTestPeer {
  public:
   static void End(absl::Duration latency, Span* span) {
-    // Set latency.
-    span->span_impl_for_test()->EndWithLatencyForTesting(latency);
-    // Then call Span::End to get into stores.
-    span->End();
+    // End with the given latency, then get into the stores as Span::End()
+    // would; Span::End() itself does nothing once the span has ended.
+    const std::shared_ptr<SpanImpl> impl = span->span_impl_for_test();
+    impl->EndWithLatencyForTesting(latency);
+    exporter::RunningSpanStoreImpl::Get()->RemoveSpan(impl);
+    exporter::LocalSpanStoreImpl::Get()->AddSpan(impl);
   }
 };
 
@@ -59,6 +70,219 @@ TEST(LocalSpanStoreTest, GetSummary) {
           [LocalSpanStore::LatencyBucketBoundary::k10us_to_100us]);
 }
 
+TEST(LocalSpanStoreTest, RareLatencyOutliersAreKept) {
+  exporter::LocalSpanStoreImplTestPeer::ClearForTesting();
+  // Many fast spans followed by a single slow one.
+  for (int i = 0; i < 1000; ++i) {
+    auto span = Span::StartSpan("Outlier", /*parent=*/nullptr,
+                                {nullptr, /*record_events=*/true});
+    SpanTestPeer::End(absl::Microseconds(1), &span);
+  }
+  auto slow_span = Span::StartSpan("Outlier", /*parent=*/nullptr,
+                                   {nullptr, /*record_events=*/true});
+  SpanTestPeer::End(absl::Seconds(2), &slow_span);
+
+  auto summary = LocalSpanStore::GetSummary();
+  auto& latency = summary.per_span_name_summary["Outlier"]
+                      .number_of_latency_sampled_spans;
+  EXPECT_EQ(LocalSpanStoreImpl::kMaxLatencySamplesPerBucket,
+            latency[LocalSpanStore::LatencyBucketBoundary::k0_to_10us]);
+  EXPECT_EQ(1, latency[LocalSpanStore::LatencyBucketBoundary::k1s_to_10s]);
+
+  const auto slow = LocalSpanStore::GetLatencySampledSpans(
+      {"Outlier", 10, /*lower_latency_ns=*/1000000000,
+       /*upper_latency_ns=*/10000000000});
+  ASSERT_EQ(1, slow.size());
+  EXPECT_EQ(absl::Seconds(2), slow[0]->end_time() - slow[0]->start_time());
+
+  const auto fast =
+      LocalSpanStore::GetLatencySampledSpans({"Outlier", 100, 0, 10000});
+  EXPECT_EQ(LocalSpanStoreImpl::kMaxLatencySamplesPerBucket, fast.size());
+  EXPECT_EQ(5, LocalSpanStore::GetLatencySampledSpans({"", 5, 0, 10000}).size())
+      << "Hit max_spans_to_return.";
+}
+
+TEST(LocalSpanStoreTest, ErrorSampledSpans) {
+  exporter::LocalSpanStoreImplTestPeer::ClearForTesting();
+  for (int i = 0; i < 100; ++i) {
+    auto span = Span::StartSpan("Errors", /*parent=*/nullptr,
+                                {nullptr, /*record_events=*/true});
+    span.SetStatus(StatusCode::UNAVAILABLE);
+    SpanTestPeer::End(absl::Milliseconds(1), &span);
+  }
+  auto span = Span::StartSpan("Errors", /*parent=*/nullptr,
+                              {nullptr, /*record_events=*/true});
+  span.SetStatus(StatusCode::DATA_LOSS, "lost");
+  SpanTestPeer::End(absl::Milliseconds(1), &span);
+
+  auto summary = LocalSpanStore::GetSummary();
+  auto& errors =
+      summary.per_span_name_summary["Errors"].number_of_error_sampled_spans;
+  EXPECT_EQ(LocalSpanStoreImpl::kMaxErrorSamplesPerBucket,
+            errors[StatusCode::UNAVAILABLE]);
+  EXPECT_EQ(1, errors[StatusCode::DATA_LOSS]);
+  EXPECT_EQ(0, summary.per_span_name_summary["Errors"]
+                   .number_of_latency_sampled_spans.size())
+      << "Failed spans are not latency-sampled.";
+
+  const auto data_loss = LocalSpanStore::GetErrorSampledSpans(
+      {"Errors", 10, StatusCode::DATA_LOSS, /*all_errors=*/false});
+  ASSERT_EQ(1, data_loss.size());
+  EXPECT_EQ("lost", data_loss[0]->status().error_message());
+  EXPECT_EQ(LocalSpanStoreImpl::kMaxErrorSamplesPerBucket + 1,
+            LocalSpanStore::GetErrorSampledSpans(
+                {"", 100, StatusCode::OK, /*all_errors=*/true})
+                .size());
+}
+
+TEST(LocalSpanStoreTest, QueriesShareSpanData) {
+  exporter::LocalSpanStoreImplTestPeer::ClearForTesting();
+  for (const char* name : {"A", "B"}) {
+    auto span = Span::StartSpan(name, /*parent=*/nullptr,
+                                {nullptr, /*record_events=*/true});
+    SpanTestPeer::End(absl::Microseconds(50), &span);
+  }
+  const auto first =
+      LocalSpanStore::GetLatencySampledSpans({"A", 10, 0, 100000});
+  const auto second = LocalSpanStore::GetSpans();
+  ASSERT_EQ(1, first.size());
+  ASSERT_EQ(2, second.size());
+  EXPECT_EQ("A", first[0]->name());
+  EXPECT_TRUE(first[0] == second[0] || first[0] == second[1])
+      << "Repeated queries should return the same SpanData.";
+}
+
+TEST(LocalSpanStoreTest, AnalyzeTrace) {
+  exporter::LocalSpanStoreImplTestPeer::ClearForTesting();
+  auto root = Span::StartSpan("Root", /*parent=*/nullptr,
+                              {nullptr, /*record_events=*/true});
+  auto child = Span::StartSpan("Child", &root,
+                               {nullptr, /*record_events=*/true});
+  child.End();
+  // A separate trace, which must not show up in the first one.
+  auto other = Span::StartSpan("Other", /*parent=*/nullptr,
+                               {nullptr, /*record_events=*/true});
+  other.End();
+  root.End();
+
+  const auto trace_ids = LocalSpanStore::GetTraceIds();
+  ASSERT_EQ(2, trace_ids.size());
+  EXPECT_EQ(root.context().trace_id(), trace_ids[0])
+      << "The trace that most recently ended a span comes first.";
+  EXPECT_EQ(other.context().trace_id(), trace_ids[1]);
+
+  const auto analysis = LocalSpanStore::AnalyzeTrace(root.context().trace_id());
+  ASSERT_EQ(2, analysis.spans.size());
+  EXPECT_EQ("Root", analysis.spans[0].span->name());
+  EXPECT_EQ(-1, analysis.spans[0].parent_index);
+  EXPECT_EQ("Child", analysis.spans[1].span->name());
+  EXPECT_EQ(0, analysis.spans[1].parent_index);
+  const absl::Duration root_duration =
+      analysis.spans[0].span->end_time() - analysis.spans[0].span->start_time();
+  EXPECT_EQ(root_duration, analysis.spans[0].critical_path_time +
+                               analysis.spans[1].critical_path_time);
+
+  EXPECT_TRUE(LocalSpanStore::AnalyzeTrace(TraceId()).spans.empty());
+}
+
+TEST(LocalSpanStoreTest, GetSpanNameProfiles) {
+  exporter::LocalSpanStoreImplTestPeer::ClearForTesting();
+  for (int i = 0; i < 3; ++i) {
+    auto root = Span::StartSpan("Root", /*parent=*/nullptr,
+                                {nullptr, /*record_events=*/true});
+    auto child = Span::StartSpan("Child", &root,
+                                 {nullptr, /*record_events=*/true});
+    child.End();
+    root.End();
+  }
+  auto profiles = LocalSpanStore::GetSpanNameProfiles();
+  ASSERT_EQ(2, profiles.size());
+  EXPECT_EQ(3, profiles["Root"].num_spans);
+  EXPECT_EQ(3, profiles["Child"].num_spans);
+  EXPECT_GE(profiles["Root"].total_time, profiles["Root"].self_time);
+}
+
+TEST(LocalSpanStoreTest, EvictsLeastRecentlyUsedSpanNames) {
+  exporter::LocalSpanStoreImplTestPeer::ClearForTesting();
+  auto end_span = [](absl::string_view name) {
+    Span::StartSpan(name, /*parent=*/nullptr,
+                    {nullptr, /*record_events=*/true})
+        .End();
+  };
+  for (int i = 0; i < LocalSpanStoreImpl::kMaxSpanNames; ++i) {
+    end_span(absl::StrCat("Name", i));
+  }
+  end_span("Name0");  // Now the most recently used.
+  end_span("New");
+
+  auto summary = LocalSpanStore::GetSummary();
+  EXPECT_EQ(LocalSpanStoreImpl::kMaxSpanNames,
+            summary.per_span_name_summary.size());
+  EXPECT_EQ(1, summary.per_span_name_summary.count("Name0"));
+  EXPECT_EQ(0, summary.per_span_name_summary.count("Name1"));
+  EXPECT_EQ(1, summary.per_span_name_summary.count("New"));
+
+  // High name cardinality doesn't grow the store.
+  for (int i = 0; i < 10 * LocalSpanStoreImpl::kMaxSpanNames; ++i) {
+    end_span(absl::StrCat("Unique", i));
+  }
+  EXPECT_EQ(LocalSpanStoreImpl::kMaxSpanNames,
+            LocalSpanStore::GetSummary().per_span_name_summary.size());
+}
+
+TEST(LocalSpanStoreTest, KeepsMostRecentTraces) {
+  exporter::LocalSpanStoreImplTestPeer::ClearForTesting();
+  std::vector<TraceId> trace_ids;
+  for (int i = 0; i < LocalSpanStoreImpl::kMaxTraces + 1; ++i) {
+    auto span = Span::StartSpan("Span", /*parent=*/nullptr,
+                                {nullptr, /*record_events=*/true});
+    span.End();
+    trace_ids.push_back(span.context().trace_id());
+  }
+  const auto stored = LocalSpanStore::GetTraceIds();
+  ASSERT_EQ(LocalSpanStoreImpl::kMaxTraces, stored.size());
+  EXPECT_EQ(trace_ids.back(), stored.front());
+  EXPECT_EQ(trace_ids[1], stored.back());
+  EXPECT_TRUE(LocalSpanStore::AnalyzeTrace(trace_ids[0]).spans.empty());
+
+  auto root = Span::StartSpan("Root", /*parent=*/nullptr,
+                              {nullptr, /*record_events=*/true});
+  for (int i = 0; i < LocalSpanStoreImpl::kMaxSpansPerTrace + 1; ++i) {
+    Span::StartSpan("Child", &root, {nullptr, /*record_events=*/true}).End();
+  }
+  root.End();
+  EXPECT_EQ(LocalSpanStoreImpl::kMaxSpansPerTrace,
+            LocalSpanStore::AnalyzeTrace(root.context().trace_id())
+                .spans.size());
+}
+
+TEST(LocalSpanStoreTest, EvictsTraceThatLeastRecentlyEndedASpan) {
+  exporter::LocalSpanStoreImplTestPeer::ClearForTesting();
+  auto root = Span::StartSpan("Root", /*parent=*/nullptr,
+                              {nullptr, /*record_events=*/true});
+  Span::StartSpan("Child", &root, {nullptr, /*record_events=*/true}).End();
+  std::vector<TraceId> trace_ids;
+  for (int i = 0; i < LocalSpanStoreImpl::kMaxTraces; ++i) {
+    if (i == LocalSpanStoreImpl::kMaxTraces - 1) {
+      // The long-running trace ends another span, so it's no longer the
+      // least recently ended.
+      root.End();
+    }
+    auto span = Span::StartSpan("Span", /*parent=*/nullptr,
+                                {nullptr, /*record_events=*/true});
+    span.End();
+    trace_ids.push_back(span.context().trace_id());
+  }
+  const auto stored = LocalSpanStore::GetTraceIds();
+  ASSERT_EQ(LocalSpanStoreImpl::kMaxTraces, stored.size());
+  EXPECT_EQ(trace_ids.back(), stored[0]);
+  EXPECT_EQ(root.context().trace_id(), stored[1]);
+  EXPECT_EQ(2,
+            LocalSpanStore::AnalyzeTrace(root.context().trace_id())
+                .spans.size());
+  EXPECT_TRUE(LocalSpanStore::AnalyzeTrace(trace_ids[0]).spans.empty());
+}
+
 }  // namespace
 }  // namespace exporter
 }  // namespace trace
@@ -23,6 +23,22 @@ namespace opencensus {
 namespace trace {
 namespace exporter {
 
+void RunningSpanStore::Enable() { RunningSpanStoreImpl::Get()->Enable(); }
+
+void RunningSpanStore::Disable() { RunningSpanStoreImpl::Get()->Disable(); }
+
+bool RunningSpanStore::IsEnabled() {
+  return RunningSpanStoreImpl::Get()->enabled();
+}
+
+void RunningSpanStore::SetOptions(const Options& options) {
+  RunningSpanStoreImpl::Get()->SetOptions(options);
+}
+
+RunningSpanStore::StuckSpans RunningSpanStore::GetStuckSpans() {
+  return RunningSpanStoreImpl::Get()->GetStuckSpans();
+}
+
 RunningSpanStore::Summary RunningSpanStore::GetSummary() {
   return RunningSpanStoreImpl::Get()->GetSummary();
 }
@@ -14,6 +14,8 @@
 
 #include "opencensus/trace/internal/running_span_store_impl.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -24,11 +26,22 @@
 #include "absl/base/internal/endian.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/strings/string_view.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "opencensus/common/internal/clock.h"
+#include "opencensus/common/internal/executor.h"
 #include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/status.h"
+#include "opencensus/trace/internal/flight_recorder_impl.h"
+#include "opencensus/trace/internal/local_span_store_impl.h"
+#include "opencensus/trace/internal/span_exporter_impl.h"
+#include "opencensus/trace/internal/span_end_hook.h"
 #include "opencensus/trace/internal/span_impl.h"
 #include "opencensus/trace/span_context.h"
 #include "opencensus/trace/span_id.h"
+#include "opencensus/trace/status_code.h"
 
 namespace opencensus {
 namespace trace {
@@ -48,18 +61,75 @@ RunningSpanStoreImpl* RunningSpanStoreImpl::Get() {
   return global_running_span_store;
 }
 
+void RunningSpanStoreImpl::Enable() {
+  common::Executor::TaskId old_scan;
+  {
+    absl::MutexLock l(&mu_);
+    enabled_.store(true, std::memory_order_release);
+    old_scan = RescheduleScan();
+  }
+  common::Executor::Get()->Cancel(old_scan);
+}
+
+void RunningSpanStoreImpl::Disable() {
+  common::Executor::TaskId old_scan;
+  {
+    absl::MutexLock l(&mu_);
+    enabled_.store(false, std::memory_order_release);
+    spans_.clear();
+    tracked_bytes_ = 0;
+    UpdateMemoryAccount();
+    old_scan = RescheduleScan();
+  }
+  common::Executor::Get()->Cancel(old_scan);
+}
+
+void RunningSpanStoreImpl::SetOptions(
+    const RunningSpanStore::Options& options) {
+  common::Executor::TaskId old_scan;
+  {
+    absl::MutexLock l(&mu_);
+    options_ = options;
+    old_scan = RescheduleScan();
+  }
+  common::Executor::Get()->Cancel(old_scan);
+}
+
+RunningSpanStore::StuckSpans RunningSpanStoreImpl::GetStuckSpans() const {
+  absl::MutexLock l(&mu_);
+  return stuck_spans_;
+}
+
 void RunningSpanStoreImpl::AddSpan(const std::shared_ptr<SpanImpl>& span) {
+  if (!enabled()) return;
+  // A new span has no events yet.
+  const size_t bytes = sizeof(SpanImpl) + span->name_constref().capacity();
   absl::MutexLock l(&mu_);
-  spans_.insert({GetKey(span.get()), span});
+  // Re-check: Disable() may have run since the unlocked check.
+  if (!enabled_.load(std::memory_order_relaxed)) return;
+  if ((options_.max_spans > 0 &&
+       spans_.size() >= static_cast<size_t>(options_.max_spans)) ||
+      (options_.max_bytes > 0 && tracked_bytes_ >= options_.max_bytes)) {
+    ++num_untracked_spans_;
+    return;
+  }
+  if (spans_.insert({GetKey(span.get()), {span, bytes}}).second) {
+    tracked_bytes_ += bytes;
+    UpdateMemoryAccount();
+  }
 }
 
 bool RunningSpanStoreImpl::RemoveSpan(const std::shared_ptr<SpanImpl>& span) {
+  // If the store is disabled, Disable() already dropped this span.
+  if (!enabled()) return false;
   absl::MutexLock l(&mu_);
   auto iter = spans_.find(GetKey(span.get()));
   if (iter == spans_.end()) {
     return false;  // Not tracked.
   }
+  tracked_bytes_ -= iter->second.bytes;
   spans_.erase(iter);
+  UpdateMemoryAccount();
   return true;
 }
 
@@ -67,7 +137,7 @@ RunningSpanStore::Summary RunningSpanStoreImpl::GetSummary() const {
   RunningSpanStore::Summary summary;
   absl::MutexLock l(&mu_);
   for (const auto& addr_span : spans_) {
-    const std::string& name = addr_span.second->name_constref();
+    const std::string& name = addr_span.second.span->name_constref();
     auto it = summary.per_span_name_summary.find(name);
     if (it != summary.per_span_name_summary.end()) {
       it->second.num_running_spans++;
@@ -75,25 +145,163 @@ RunningSpanStore::Summary RunningSpanStoreImpl::GetSummary() const {
       summary.per_span_name_summary[name] = {1};
     }
   }
+  summary.num_untracked_spans = num_untracked_spans_;
+  summary.approximate_bytes = tracked_bytes_;
   return summary;
 }
 
 std::vector<SpanData> RunningSpanStoreImpl::GetRunningSpans(
     const RunningSpanStore::Filter& filter) const {
-  std::vector<SpanData> running_spans;
-  absl::MutexLock l(&mu_);
-  for (const auto& it : spans_) {
-    if (running_spans.size() >= filter.max_spans_to_return) break;
-    if (filter.span_name.empty() || (it.second->name() == filter.span_name)) {
-      running_spans.emplace_back(it.second->ToSpanData());
+  // Copying out the span data takes each span's lock and can be slow for large
+  // spans, so only collect references under mu_.
+  std::vector<std::shared_ptr<SpanImpl>> spans;
+  {
+    absl::MutexLock l(&mu_);
+    for (const auto& it : spans_) {
+      if (spans.size() >= filter.max_spans_to_return) break;
+      if (filter.span_name.empty() ||
+          it.second.span->name() == filter.span_name) {
+        spans.push_back(it.second.span);
+      }
     }
   }
+  std::vector<SpanData> running_spans;
+  running_spans.reserve(spans.size());
+  for (const auto& span : spans) {
+    running_spans.emplace_back(span->ToSpanData());
+  }
   return running_spans;
 }
 
+common::Executor::TaskId RunningSpanStoreImpl::RescheduleScan() {
+  const common::Executor::TaskId old_scan = scan_task_;
+  scan_task_ = common::Executor::kInvalidTask;
+  ++scan_generation_;
+  if (enabled_.load(std::memory_order_relaxed) &&
+      (options_.max_bytes > 0 ||
+       options_.stuck_span_threshold > absl::ZeroDuration())) {
+    ScheduleScan();
+  }
+  return old_scan;
+}
+
+void RunningSpanStoreImpl::ScheduleScan() {
+  const uint64_t generation = scan_generation_;
+  scan_task_ = common::Executor::Get()->Schedule(
+      [this, generation]() {
+        Scan();
+        absl::MutexLock l(&mu_);
+        if (generation == scan_generation_) ScheduleScan();
+      },
+      absl::Now() + options_.scan_interval);
+}
+
+void RunningSpanStoreImpl::Scan() {
+  RunningSpanStore::Options options;
+  std::vector<std::shared_ptr<SpanImpl>> spans;
+  {
+    absl::MutexLock l(&mu_);
+    options = options_;
+    spans.reserve(spans_.size());
+    for (const auto& it : spans_) {
+      spans.push_back(it.second.span);
+    }
+  }
+  // Oldest first, which is the eviction order.
+  std::sort(spans.begin(), spans.end(),
+            [](const std::shared_ptr<SpanImpl>& a,
+               const std::shared_ptr<SpanImpl>& b) {
+              return a->start_time_ < b->start_time_;
+            });
+  std::vector<size_t> bytes(spans.size());
+  for (size_t i = 0; i < spans.size(); ++i) {
+    bytes[i] = spans[i]->MemoryUsage();
+  }
+
+  RunningSpanStore::StuckSpans stuck_spans;
+  std::vector<std::shared_ptr<SpanImpl>> samples;
+  std::vector<std::shared_ptr<SpanImpl>> spans_to_end;
+  if (options.stuck_span_threshold > absl::ZeroDuration()) {
+    const absl::Time stuck_start_time =
+        common::Clock::Now() - options.stuck_span_threshold;
+    for (const auto& span : spans) {
+      if (span->start_time_ >= stuck_start_time) break;
+      if (++stuck_spans.num_stuck_spans_by_name[span->name_constref()] == 1) {
+        samples.push_back(span);
+      }
+      if (options.end_stuck_spans) spans_to_end.push_back(span);
+    }
+  }
+
+  {
+    absl::MutexLock l(&mu_);
+    // Spans may have ended or started since the snapshot; only update the
+    // ones that are still tracked.
+    for (size_t i = 0; i < spans.size(); ++i) {
+      auto it = spans_.find(GetKey(spans[i].get()));
+      if (it == spans_.end()) continue;
+      tracked_bytes_ = tracked_bytes_ - it->second.bytes + bytes[i];
+      it->second.bytes = bytes[i];
+    }
+    for (const auto& span : spans_to_end) {
+      auto it = spans_.find(GetKey(span.get()));
+      if (it == spans_.end()) continue;
+      tracked_bytes_ -= it->second.bytes;
+      spans_.erase(it);
+    }
+    for (size_t i = 0; i < spans.size() && options.max_bytes > 0 &&
+                       tracked_bytes_ > options.max_bytes;
+         ++i) {
+      auto it = spans_.find(GetKey(spans[i].get()));
+      if (it == spans_.end()) continue;
+      tracked_bytes_ -= it->second.bytes;
+      spans_.erase(it);
+      ++num_untracked_spans_;
+    }
+    UpdateMemoryAccount();
+  }
+
+  // Same as Span::End(), minus removing the span from this store.
+  for (const auto& span : spans_to_end) {
+    if (!span->ForceEnd(Status(
+            StatusCode::DEADLINE_EXCEEDED,
+            absl::StrCat("Span was still running after ",
+                         absl::FormatDuration(options.stuck_span_threshold),
+                         " and was ended by the RunningSpanStore.")))) {
+      continue;  // The owner ended it first.
+    }
+    SpanEndHook::Run(*span);
+    LocalSpanStoreImpl::Get()->AddSpan(span);
+    SpanExporterImpl::Get()->AddSpan(span);
+    if (FlightRecorderImpl::Get()->enabled()) {
+      FlightRecorderImpl::Get()->AddSpan(*span);
+    }
+  }
+
+  stuck_spans.samples.reserve(samples.size());
+  for (const auto& span : samples) {
+    stuck_spans.samples.push_back(span->ToSpanData());
+  }
+  absl::MutexLock l(&mu_);
+  stuck_spans_ = std::move(stuck_spans);
+}
+
 void RunningSpanStoreImpl::ClearForTesting() {
   absl::MutexLock l(&mu_);
   spans_.clear();
+  tracked_bytes_ = 0;
+  num_untracked_spans_ = 0;
+  stuck_spans_ = RunningSpanStore::StuckSpans();
+  UpdateMemoryAccount();
+}
+
+void RunningSpanStoreImpl::UpdateMemoryAccount() {
+  // Each map node holds the key, an Entry and a next pointer; the estimate
+  // leaves out the bucket array.
+  constexpr size_t kNodeBytes = sizeof(uintptr_t) + sizeof(Entry) +
+                                sizeof(void*);
+  memory_account_.Set(spans_.size(), 0,
+                      tracked_bytes_ + spans_.size() * kNodeBytes);
 }
 
 }  // namespace exporter
@@ -15,13 +15,17 @@
 #ifndef OPENCENSUS_TRACE_INTERNAL_RUNNING_SPAN_STORE_IMPL_H_
 #define OPENCENSUS_TRACE_INTERNAL_RUNNING_SPAN_STORE_IMPL_H_
 
+#include <atomic>
 #include <cstdint>
+#include <cstddef>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
+#include "opencensus/common/internal/executor.h"
+#include "opencensus/common/internal/memory_account.h"
 #include "opencensus/trace/exporter/running_span_store.h"
 #include "opencensus/trace/internal/span_impl.h"
 
@@ -31,17 +35,37 @@ namespace exporter {
 
 // RunningSpanStoreImpl implements the store for the RunningSpanStore API.
 //
+// Limits on memory and stuck span detection are enforced by Scan(), which
+// runs periodically on the shared executor while the store is enabled and the
+// options call for it. Disable() and SetOptions() cancel the scheduled scan,
+// waiting for it if it is running.
+//
 // This class is thread-safe and a singleton.
 class RunningSpanStoreImpl {
  public:
   // Returns the global instance of RunningSpanStoreImpl.
   static RunningSpanStoreImpl* Get();
 
-  // Adds a new running Span.
+  // Starts tracking spans added after this call.
+  void Enable() LOCKS_EXCLUDED(mu_);
+
+  // Stops tracking spans and clears the store.
+  void Disable() LOCKS_EXCLUDED(mu_);
+
+  // Returns true if spans are being tracked. This is checked without taking
+  // mu_, so that AddSpan() and RemoveSpan() are nearly free when disabled.
+  bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+  void SetOptions(const RunningSpanStore::Options& options)
+      LOCKS_EXCLUDED(mu_);
+
+  RunningSpanStore::StuckSpans GetStuckSpans() const LOCKS_EXCLUDED(mu_);
+
+  // Adds a new running Span. Does nothing if the store is disabled or full.
   void AddSpan(const std::shared_ptr<SpanImpl>& span) LOCKS_EXCLUDED(mu_);
 
   // Removes a Span that's no longer running. Returns true on success, false if
-  // that Span was not being tracked.
+  // that Span was not being tracked or the store is disabled.
   bool RemoveSpan(const std::shared_ptr<SpanImpl>& span) LOCKS_EXCLUDED(mu_);
 
   // Returns a summary of the data available in the RunningSpanStore.
@@ -54,16 +78,51 @@ class RunningSpanStoreImpl {
  private:
   friend class RunningSpanStoreImplTestPeer;
 
+  struct Entry {
+    std::shared_ptr<SpanImpl> span;
+    // The approximate memory usage of the span, as of the last scan.
+    size_t bytes;
+  };
+
   RunningSpanStoreImpl() {}
 
+  // Replaces the scheduled scan, if any, with one that matches the current
+  // state and options. Returns the replaced task, which the caller must cancel
+  // after releasing mu_, since a running scan takes mu_.
+  common::Executor::TaskId RescheduleScan() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Schedules Scan() to run scan_interval from now, and again after that
+  // until scan_generation_ changes.
+  void ScheduleScan() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Measures the tracked spans, finds (and optionally ends) stuck spans, and
+  // stops tracking the longest-running spans if over the memory limit. Spans
+  // are measured and ended without holding mu_.
+  void Scan() LOCKS_EXCLUDED(mu_);
+
   // Clears all currently active spans from the store.
   void ClearForTesting() LOCKS_EXCLUDED(mu_);
 
+  // Updates memory_account_ after spans_ or tracked_bytes_ changed.
+  void UpdateMemoryAccount() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   mutable absl::Mutex mu_;
 
+  // Only written while holding mu_, so that a span can't be added after
+  // Disable() has cleared the store.
+  std::atomic<bool> enabled_{false};
+
   // The key is the memory address of the underlying SpanImpl object.
-  std::unordered_map<uintptr_t, std::shared_ptr<SpanImpl>> spans_
-      GUARDED_BY(mu_);
+  std::unordered_map<uintptr_t, Entry> spans_ GUARDED_BY(mu_);
+  size_t tracked_bytes_ GUARDED_BY(mu_) = 0;
+  int num_untracked_spans_ GUARDED_BY(mu_) = 0;
+  RunningSpanStore::Options options_ GUARDED_BY(mu_);
+  RunningSpanStore::StuckSpans stuck_spans_ GUARDED_BY(mu_);
+  common::Executor::TaskId scan_task_ GUARDED_BY(mu_) =
+      common::Executor::kInvalidTask;
+  // Incremented to stop the scheduled scan from rescheduling itself.
+  uint64_t scan_generation_ GUARDED_BY(mu_) = 0;
+  common::MemoryAccount memory_account_{"trace/running_span_store"};
 };
 
 }  // namespace exporter
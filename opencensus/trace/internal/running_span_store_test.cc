@@ -21,6 +21,8 @@
 
 #include "absl/base/attributes.h"
 #include "absl/memory/memory.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "gtest/gtest.h"
 #include "opencensus/trace/exporter/attribute_value.h"
 #include "opencensus/trace/exporter/span_data.h"
@@ -31,6 +33,7 @@
 #include "opencensus/trace/span.h"
 #include "opencensus/trace/span_context.h"
 #include "opencensus/trace/span_id.h"
+#include "opencensus/trace/status_code.h"
 #include "opencensus/trace/trace_config.h"
 #include "opencensus/trace/trace_options.h"
 #include "opencensus/trace/trace_params.h"
@@ -51,6 +54,8 @@ class RunningSpanStoreImplTestPeer {
   static void ClearForTesting() {
     RunningSpanStoreImpl::Get()->ClearForTesting();
   }
+
+  static void Scan() { RunningSpanStoreImpl::Get()->Scan(); }
 };
 
 namespace {
@@ -63,6 +68,7 @@ TEST(RunningSpanStoreTest, ForceSamplingViaStartSpanOptions) {
   // Child Span with forced sampling.
   SpanContext parent_ctx{TraceId(trace_id), SpanId(span_id)};
   AlwaysSampler sampler;
+  RunningSpanStore::Enable();
   RunningSpanStoreImplTestPeer::ClearForTesting();
   auto span = Span::StartSpanWithRemoteParent("Span", parent_ctx, {&sampler});
   EXPECT_TRUE(span.IsSampled());
@@ -76,7 +82,7 @@ TEST(RunningSpanStoreTest, ForceSamplingViaStartSpanOptions) {
 TEST(RunningSpanStoreTest, ForceSamplingOffViaTraceConfig) {
   // No sampling requested, but trace_params forces it.
   TraceConfig::SetCurrentTraceParams(
-      TraceParams{32, 32, 128, 128, ProbabilitySampler(0.0)});
+      TraceParams{32, 32, 128, 128, ProbabilitySampler(0.0), 0, 0});
   for (int i = 0; i < 1000; ++i) {
     auto span = Span::StartSpan("SpanName");
     EXPECT_FALSE(span.IsSampled());
@@ -87,6 +93,7 @@ TEST(RunningSpanStoreTest, ForceSamplingOffViaTraceConfig) {
 TEST(RunningSpanStoreTest, GetSummaryAndGetRunningSpans) {
   AlwaysSampler sampler;
   StartSpanOptions opts = {&sampler};
+  RunningSpanStore::Enable();
   RunningSpanStoreImplTestPeer::ClearForTesting();
   auto span1 = Span::StartSpan("Group1", nullptr, opts);
   EXPECT_TRUE(span1.IsSampled());
@@ -111,6 +118,173 @@ TEST(RunningSpanStoreTest, GetSummaryAndGetRunningSpans) {
   EXPECT_EQ(1, summary.per_span_name_summary["Group2"].num_running_spans);
 }
 
+TEST(RunningSpanStoreTest, DisabledStoreTracksNothing) {
+  AlwaysSampler sampler;
+  StartSpanOptions opts = {&sampler};
+  RunningSpanStore::Enable();
+  RunningSpanStoreImplTestPeer::ClearForTesting();
+  auto span1 = Span::StartSpan("Span1", nullptr, opts);
+  EXPECT_EQ(1, RunningSpanStore::GetRunningSpans({"", 10}).size());
+
+  RunningSpanStore::Disable();
+  EXPECT_FALSE(RunningSpanStore::IsEnabled());
+  EXPECT_EQ(0, RunningSpanStore::GetRunningSpans({"", 10}).size());
+  auto span2 = Span::StartSpan("Span2", nullptr, opts);
+  EXPECT_EQ(0, RunningSpanStore::GetRunningSpans({"", 10}).size());
+
+  // Only spans started after re-enabling are tracked.
+  RunningSpanStore::Enable();
+  EXPECT_TRUE(RunningSpanStore::IsEnabled());
+  auto span3 = Span::StartSpan("Span3", nullptr, opts);
+  EXPECT_EQ(0, RunningSpanStore::GetRunningSpans({"Span1", 10}).size());
+  EXPECT_EQ(0, RunningSpanStore::GetRunningSpans({"Span2", 10}).size());
+  EXPECT_EQ(1, RunningSpanStore::GetRunningSpans({"Span3", 10}).size());
+  span1.End();
+  span2.End();
+  span3.End();
+  EXPECT_EQ(0, RunningSpanStore::GetRunningSpans({"", 10}).size());
+}
+
+// Options that keep the background scan from running during the test.
+RunningSpanStore::Options TestOptions() {
+  RunningSpanStore::Options options;
+  options.scan_interval = absl::Hours(1);
+  return options;
+}
+
+TEST(RunningSpanStoreTest, MaxSpans) {
+  AlwaysSampler sampler;
+  StartSpanOptions opts = {&sampler};
+  RunningSpanStore::Enable();
+  RunningSpanStoreImplTestPeer::ClearForTesting();
+  auto options = TestOptions();
+  options.max_spans = 2;
+  RunningSpanStore::SetOptions(options);
+  auto span1 = Span::StartSpan("Span", nullptr, opts);
+  auto span2 = Span::StartSpan("Span", nullptr, opts);
+  auto span3 = Span::StartSpan("Span", nullptr, opts);
+  auto summary = RunningSpanStore::GetSummary();
+  EXPECT_EQ(2, summary.per_span_name_summary["Span"].num_running_spans);
+  EXPECT_EQ(1, summary.num_untracked_spans);
+  EXPECT_LT(0, summary.approximate_bytes);
+
+  // Ending a span makes room for another.
+  span1.End();
+  auto span4 = Span::StartSpan("Span", nullptr, opts);
+  EXPECT_EQ(2, RunningSpanStore::GetRunningSpans({"", 10}).size());
+  span2.End();
+  span3.End();
+  span4.End();
+  EXPECT_EQ(0, RunningSpanStore::GetSummary().approximate_bytes);
+  RunningSpanStore::SetOptions(TestOptions());
+}
+
+TEST(RunningSpanStoreTest, MaxBytesEvictsLongestRunningSpans) {
+  AlwaysSampler sampler;
+  StartSpanOptions opts = {&sampler};
+  RunningSpanStore::Enable();
+  RunningSpanStoreImplTestPeer::ClearForTesting();
+  auto span1 = Span::StartSpan("Old", nullptr, opts);
+  absl::SleepFor(absl::Milliseconds(1));
+  auto span2 = Span::StartSpan("New", nullptr, opts);
+  for (int i = 0; i < 10; ++i) {
+    span1.AddAnnotation(std::string(1000, 'a'));
+  }
+  RunningSpanStoreImplTestPeer::Scan();
+  const size_t bytes = RunningSpanStore::GetSummary().approximate_bytes;
+  EXPECT_LT(10000, bytes);
+
+  // Room for one small span only.
+  auto options = TestOptions();
+  options.max_bytes = bytes - 10000;
+  RunningSpanStore::SetOptions(options);
+  RunningSpanStoreImplTestPeer::Scan();
+  auto summary = RunningSpanStore::GetSummary();
+  EXPECT_EQ(0, summary.per_span_name_summary.count("Old"));
+  EXPECT_EQ(1, summary.per_span_name_summary["New"].num_running_spans);
+  EXPECT_EQ(1, summary.num_untracked_spans);
+  span1.End();
+  span2.End();
+  RunningSpanStore::SetOptions(TestOptions());
+}
+
+TEST(RunningSpanStoreTest, ReportsStuckSpans) {
+  AlwaysSampler sampler;
+  StartSpanOptions opts = {&sampler};
+  RunningSpanStore::Enable();
+  RunningSpanStoreImplTestPeer::ClearForTesting();
+  auto options = TestOptions();
+  options.stuck_span_threshold = absl::Milliseconds(1);
+  RunningSpanStore::SetOptions(options);
+  auto span1 = Span::StartSpan("Stuck", nullptr, opts);
+  auto span2 = Span::StartSpan("Stuck", nullptr, opts);
+  absl::SleepFor(absl::Milliseconds(2));
+  auto span3 = Span::StartSpan("NotStuck", nullptr, opts);
+  RunningSpanStoreImplTestPeer::Scan();
+
+  auto stuck = RunningSpanStore::GetStuckSpans();
+  EXPECT_EQ(1, stuck.num_stuck_spans_by_name.size());
+  EXPECT_EQ(2, stuck.num_stuck_spans_by_name["Stuck"]);
+  ASSERT_EQ(1, stuck.samples.size());
+  EXPECT_EQ("Stuck", stuck.samples[0].name());
+  EXPECT_FALSE(stuck.samples[0].has_ended());
+  // Stuck spans are still tracked.
+  EXPECT_EQ(3, RunningSpanStore::GetRunningSpans({"", 10}).size());
+  span1.End();
+  span2.End();
+  span3.End();
+  RunningSpanStore::SetOptions(TestOptions());
+}
+
+TEST(RunningSpanStoreTest, EndsStuckSpans) {
+  AlwaysSampler sampler;
+  StartSpanOptions opts = {&sampler};
+  RunningSpanStore::Enable();
+  RunningSpanStoreImplTestPeer::ClearForTesting();
+  auto options = TestOptions();
+  options.stuck_span_threshold = absl::Milliseconds(1);
+  options.end_stuck_spans = true;
+  RunningSpanStore::SetOptions(options);
+  auto span = Span::StartSpan("Stuck", nullptr, opts);
+  absl::SleepFor(absl::Milliseconds(2));
+  RunningSpanStoreImplTestPeer::Scan();
+
+  auto stuck = RunningSpanStore::GetStuckSpans();
+  ASSERT_EQ(1, stuck.samples.size());
+  EXPECT_TRUE(stuck.samples[0].has_ended());
+  EXPECT_EQ(StatusCode::DEADLINE_EXCEEDED,
+            stuck.samples[0].status().CanonicalCode());
+  EXPECT_EQ(0, RunningSpanStore::GetRunningSpans({"", 10}).size());
+  // Ending it again has no effect.
+  span.End();
+  EXPECT_EQ(0, RunningSpanStore::GetRunningSpans({"", 10}).size());
+  RunningSpanStore::SetOptions(TestOptions());
+}
+
+TEST(RunningSpanStoreTest, SetOptionsStopsBackgroundScan) {
+  AlwaysSampler sampler;
+  StartSpanOptions opts = {&sampler};
+  RunningSpanStore::Enable();
+  RunningSpanStoreImplTestPeer::ClearForTesting();
+  RunningSpanStore::Options options;
+  options.stuck_span_threshold = absl::Milliseconds(1);
+  options.scan_interval = absl::Milliseconds(1);
+  RunningSpanStore::SetOptions(options);
+  auto span = Span::StartSpan("Stuck", nullptr, opts);
+  const absl::Time deadline = absl::Now() + absl::Seconds(10);
+  while (RunningSpanStore::GetStuckSpans().samples.empty() &&
+         absl::Now() < deadline) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  ASSERT_EQ(1, RunningSpanStore::GetStuckSpans().samples.size());
+
+  // Without a threshold, another scan would clear the stuck spans.
+  RunningSpanStore::SetOptions(TestOptions());
+  absl::SleepFor(absl::Milliseconds(20));
+  EXPECT_EQ(1, RunningSpanStore::GetStuckSpans().samples.size());
+  span.End();
+}
+
 }  // namespace
 }  // namespace exporter
 }  // namespace trace
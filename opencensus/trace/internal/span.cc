@@ -17,16 +17,20 @@
 #include <string>
 #include <utility>
 
+#include "absl/base/internal/endian.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "opencensus/common/internal/probes.h"
 #include "opencensus/common/internal/random.h"
 #include "opencensus/trace/exporter/annotation.h"
 #include "opencensus/trace/exporter/attribute_value.h"
 #include "opencensus/trace/exporter/link.h"
 #include "opencensus/trace/exporter/message_event.h"
 #include "opencensus/trace/exporter/running_span_store.h"
-#include "opencensus/trace/exporter/status.h"
+#include "opencensus/trace/internal/flight_recorder_impl.h"
 #include "opencensus/trace/internal/local_span_store_impl.h"
 #include "opencensus/trace/internal/running_span_store_impl.h"
+#include "opencensus/trace/internal/span_end_hook.h"
 #include "opencensus/trace/internal/span_exporter_impl.h"
 #include "opencensus/trace/internal/span_impl.h"
 #include "opencensus/trace/internal/trace_config_impl.h"
@@ -59,6 +63,27 @@ TraceId GenerateRandomTraceId() {
   return TraceId(trace_id_buf);
 }
 
+#ifdef OPENCENSUS_USDT_PROBES
+// Probe arguments. See probes.h.
+uint64_t SpanIdArg(const SpanId& span_id) {
+  uint8_t buf[SpanId::kSize];
+  span_id.CopyTo(buf);
+  return absl::big_endian::Load64(buf);
+}
+
+uint64_t TraceIdHighArg(const TraceId& trace_id) {
+  uint8_t buf[TraceId::kSize];
+  trace_id.CopyTo(buf);
+  return absl::big_endian::Load64(buf);
+}
+
+uint64_t TraceIdLowArg(const TraceId& trace_id) {
+  uint8_t buf[TraceId::kSize];
+  trace_id.CopyTo(buf);
+  return absl::big_endian::Load64(buf + 8);
+}
+#endif  // OPENCENSUS_USDT_PROBES
+
 }  // namespace
 
 class SpanGenerator {
@@ -95,9 +120,11 @@ class SpanGenerator {
     SpanImpl* impl = nullptr;
     if (trace_options.IsSampled() || options.record_events) {
       // Only Spans that are recording are backed by a SpanImpl.
-      impl =
-          new SpanImpl(context, TraceConfigImpl::Get()->current_trace_params(),
-                       name, parent_span_id, has_remote_parent);
+      impl = new SpanImpl(
+          context, TraceConfigImpl::Get()->current_trace_params(), name,
+          parent_span_id, has_remote_parent,
+          options.record_cpu_usage ||
+              TraceConfigImpl::Get()->RecordsCpuUsage(name));
     }
     // Add links.
     for (const auto& parent_link : options.parent_links) {
@@ -108,6 +135,12 @@ class SpanGenerator {
       }
       parent_link->AddChildLink(context);
     }
+    if (OPENCENSUS_PROBE_ENABLED(span_start)) {
+      OPENCENSUS_PROBE(span_start, TraceIdHighArg(trace_id),
+                       TraceIdLowArg(trace_id), SpanIdArg(span_id),
+                       SpanIdArg(parent_span_id), name.data(), name.size(),
+                       trace_options.IsSampled());
+    }
     return Span(context, impl);
   }
 };
@@ -132,9 +165,11 @@ Span Span::StartSpanWithRemoteParent(absl::string_view name,
                                  /*has_remote_parent=*/true, options);
 }
 
-Span::Span(const SpanContext& context, SpanImpl* impl)
-    : context_(context), span_impl_(impl) {
-  if (IsRecording()) {
+Span::Span(const SpanContext& context, SpanImpl* impl) : context_(context) {
+  // Constructing a shared_ptr from a null pointer would still allocate a
+  // control block.
+  if (impl != nullptr) {
+    span_impl_.reset(impl);
     exporter::RunningSpanStoreImpl::Get()->AddSpan(span_impl_);
   }
 }
@@ -196,16 +231,30 @@ void Span::AddChildLink(const SpanContext& child_ctx,
 
 void Span::SetStatus(StatusCode canonical_code, absl::string_view message) {
   if (IsRecording()) {
-    span_impl_->SetStatus(exporter::Status(canonical_code, message));
+    span_impl_->SetStatus(canonical_code, message);
   }
 }
 
 void Span::End() {
   if (IsRecording()) {
-    span_impl_->End();
+    // Already ended, either by an earlier End() or by the RunningSpanStore,
+    // which also exported it.
+    if (!span_impl_->End()) return;
+    SpanEndHook::Run(*span_impl_);
+    if (OPENCENSUS_PROBE_ENABLED(span_end)) {
+      OPENCENSUS_PROBE(span_end, TraceIdHighArg(context_.trace_id()),
+                       TraceIdLowArg(context_.trace_id()),
+                       SpanIdArg(context_.span_id()),
+                       span_impl_->name_constref().data(),
+                       span_impl_->name_constref().size(),
+                       absl::ToInt64Nanoseconds(span_impl_->latency()));
+    }
     exporter::RunningSpanStoreImpl::Get()->RemoveSpan(span_impl_);
     exporter::LocalSpanStoreImpl::Get()->AddSpan(span_impl_);
     exporter::SpanExporterImpl::Get()->AddSpan(span_impl_);
+    if (exporter::FlightRecorderImpl::Get()->enabled()) {
+      exporter::FlightRecorderImpl::Get()->AddSpan(*span_impl_);
+    }
   }
 }
 
@@ -0,0 +1,99 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Allocation budgets for the tracing hot paths. A failure here means a change
+// added heap allocations to a path that is expected to have none (or few);
+// either remove them or, if they are unavoidable, raise the budget with a
+// comment saying why.
+
+#include <cstdint>
+
+#include "gtest/gtest.h"
+#include "opencensus/common/internal/allocation_counter.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+#include "opencensus/trace/span_context.h"
+
+namespace opencensus {
+namespace trace {
+namespace {
+
+using ::opencensus::common::AllocationCounter;
+
+// Sampled spans allocate their SpanImpl, its event containers, and the copy
+// handed to the local span store. This only catches large regressions.
+constexpr int64_t kSampledSpanBudget = 16;
+
+class SpanAllocationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // The first span initializes the random generator, TraceConfig and the
+    // span stores.
+    auto span = Span::StartSpan("Warmup", /*parent=*/nullptr, {&always_});
+    span.End();
+  }
+
+  AlwaysSampler always_;
+  NeverSampler never_;
+};
+
+TEST_F(SpanAllocationTest, UnsampledStartAndEnd) {
+  AllocationCounter counter;
+  auto span = Span::StartSpan("Span", /*parent=*/nullptr, {&never_});
+  span.End();
+  EXPECT_EQ(0, counter.count());
+}
+
+TEST_F(SpanAllocationTest, UnsampledChild) {
+  auto parent = Span::StartSpan("Parent", /*parent=*/nullptr, {&never_});
+  AllocationCounter counter;
+  auto span = Span::StartSpan("Child", &parent);
+  span.End();
+  EXPECT_EQ(0, counter.count());
+  parent.End();
+}
+
+TEST_F(SpanAllocationTest, UnsampledEvents) {
+  auto span = Span::StartSpan("Span", /*parent=*/nullptr, {&never_});
+  AllocationCounter counter;
+  span.AddAttribute("key", "a value that is too long to be inlined");
+  span.AddAttributes({{"key1", 1}, {"key2", true}});
+  span.AddAnnotation("Annotation.", {{"key", "value"}});
+  span.AddSentMessageEvent(1, 2, 3);
+  span.AddReceivedMessageEvent(1, 2, 3);
+  span.SetStatus(StatusCode::CANCELLED, "cancelled");
+  EXPECT_EQ(0, counter.count());
+  span.End();
+}
+
+TEST_F(SpanAllocationTest, Context) {
+  auto span = Span::StartSpan("Span", /*parent=*/nullptr, {&always_});
+  AllocationCounter counter;
+  const SpanContext context = span.context();
+  EXPECT_TRUE(context.IsValid());
+  EXPECT_EQ(0, counter.count());
+  span.End();
+}
+
+TEST_F(SpanAllocationTest, SampledStartAndEnd) {
+  AllocationCounter counter;
+  auto span = Span::StartSpan("Span", /*parent=*/nullptr, {&always_});
+  span.End();
+  EXPECT_GT(counter.count(), 0);  // Make sure allocations are counted.
+  EXPECT_LE(counter.count(), kSampledSpanBudget);
+}
+
+}  // namespace
+}  // namespace trace
+}  // namespace opencensus
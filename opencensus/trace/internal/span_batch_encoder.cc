@@ -0,0 +1,393 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/exporter/span_batch_encoder.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "opencensus/trace/exporter/annotation.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/link.h"
+#include "opencensus/trace/exporter/message_event.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_id.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+namespace {
+
+// Protobuf wire types.
+constexpr uint32_t kVarint = 0;
+constexpr uint32_t kLengthDelimited = 2;
+
+// Field numbers, from opencensus/proto/agent/trace/v1/trace_service.proto and
+// opencensus/proto/trace/v1/trace.proto.
+constexpr uint32_t kRequestSpans = 2;
+
+constexpr uint32_t kSpanTraceId = 1;
+constexpr uint32_t kSpanSpanId = 2;
+constexpr uint32_t kSpanParentSpanId = 3;
+constexpr uint32_t kSpanName = 4;
+constexpr uint32_t kSpanStartTime = 5;
+constexpr uint32_t kSpanEndTime = 6;
+constexpr uint32_t kSpanAttributes = 7;
+constexpr uint32_t kSpanTimeEvents = 9;
+constexpr uint32_t kSpanLinks = 10;
+constexpr uint32_t kSpanStatus = 11;
+constexpr uint32_t kSpanSameProcessAsParentSpan = 12;
+
+constexpr uint32_t kTruncatableStringValue = 1;
+
+constexpr uint32_t kTimestampSeconds = 1;
+constexpr uint32_t kTimestampNanos = 2;
+
+constexpr uint32_t kAttributesAttributeMap = 1;
+constexpr uint32_t kAttributesDroppedAttributesCount = 2;
+constexpr uint32_t kMapEntryKey = 1;
+constexpr uint32_t kMapEntryValue = 2;
+
+constexpr uint32_t kAttributeValueStringValue = 1;
+constexpr uint32_t kAttributeValueIntValue = 2;
+constexpr uint32_t kAttributeValueBoolValue = 3;
+
+constexpr uint32_t kTimeEventsTimeEvent = 1;
+constexpr uint32_t kTimeEventsDroppedAnnotationsCount = 2;
+constexpr uint32_t kTimeEventsDroppedMessageEventsCount = 3;
+constexpr uint32_t kTimeEventTime = 1;
+constexpr uint32_t kTimeEventAnnotation = 2;
+constexpr uint32_t kTimeEventMessageEvent = 3;
+constexpr uint32_t kAnnotationDescription = 1;
+constexpr uint32_t kAnnotationAttributes = 2;
+constexpr uint32_t kMessageEventType = 1;
+constexpr uint32_t kMessageEventId = 2;
+constexpr uint32_t kMessageEventUncompressedSize = 3;
+constexpr uint32_t kMessageEventCompressedSize = 4;
+
+constexpr uint32_t kLinksLink = 1;
+constexpr uint32_t kLinksDroppedLinksCount = 2;
+constexpr uint32_t kLinkTraceId = 1;
+constexpr uint32_t kLinkSpanId = 2;
+constexpr uint32_t kLinkType = 3;
+constexpr uint32_t kLinkAttributes = 4;
+
+constexpr uint32_t kStatusCode = 1;
+constexpr uint32_t kStatusMessage = 2;
+
+constexpr uint32_t kBoolValueValue = 1;
+
+// Link.Type values.
+constexpr uint32_t kChildLinkedSpan = 1;
+constexpr uint32_t kParentLinkedSpan = 2;
+
+int VarintSize(uint64_t value) {
+  int size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+// Writes a varint at 'out', which must have room for it.
+void WriteVarint(uint64_t value, char* out) {
+  while (value >= 0x80) {
+    *out++ = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  *out = static_cast<char>(value);
+}
+
+}  // namespace
+
+size_t SpanBatchEncoder::StringViewHash::operator()(
+    absl::string_view s) const {
+  // FNV-1a.
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : s) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+absl::string_view SpanBatchEncoder::Encode(const std::vector<SpanData>& spans) {
+  for (const auto& span : spans) {
+    Add(span);
+  }
+  return Finish();
+}
+
+void SpanBatchEncoder::Add(const SpanData& span) {
+  if (num_spans_ == 0) {
+    // Start a new batch. clear() keeps the buffers' capacity.
+    buffer_.clear();
+    string_table_.clear();
+    string_indices_.clear();
+  }
+  const size_t start = BeginMessage(kRequestSpans);
+  PutSpan(span);
+  EndMessage(start);
+  ++num_spans_;
+}
+
+absl::string_view SpanBatchEncoder::Finish() {
+  if (num_spans_ == 0) {
+    buffer_.clear();
+    string_table_.clear();
+    string_indices_.clear();
+  }
+  // Fields may appear in any order, so the table can follow the spans.
+  buffer_.append(string_table_);
+  string_table_.clear();
+  string_indices_.clear();
+  num_spans_ = 0;
+  return buffer_;
+}
+
+size_t SpanBatchEncoder::BeginMessage(uint32_t field) {
+  PutTag(field, kLengthDelimited);
+  const size_t start = buffer_.size();
+  // Most messages are shorter than 128 bytes and need a single byte for their
+  // length. EndMessage() makes room if not.
+  buffer_.push_back(0);
+  return start;
+}
+
+void SpanBatchEncoder::EndMessage(size_t start) {
+  const size_t length = buffer_.size() - start - 1;
+  const int length_size = VarintSize(length);
+  if (length_size > 1) {
+    buffer_.insert(start + 1, length_size - 1, '\0');
+  }
+  WriteVarint(length, &buffer_[start]);
+}
+
+void SpanBatchEncoder::PutVarint(uint64_t value) {
+  char buf[10];
+  WriteVarint(value, buf);
+  buffer_.append(buf, VarintSize(value));
+}
+
+void SpanBatchEncoder::PutTag(uint32_t field, uint32_t wire_type) {
+  PutVarint((field << 3) | wire_type);
+}
+
+void SpanBatchEncoder::PutVarintField(uint32_t field, uint64_t value) {
+  PutTag(field, kVarint);
+  PutVarint(value);
+}
+
+void SpanBatchEncoder::PutBytesField(uint32_t field, absl::string_view value) {
+  PutTag(field, kLengthDelimited);
+  PutVarint(value.size());
+  buffer_.append(value.data(), value.size());
+}
+
+void SpanBatchEncoder::PutTimestamp(uint32_t field, absl::Time time) {
+  const int64_t nanos = absl::ToUnixNanos(time);
+  int64_t seconds = nanos / 1000000000;
+  int64_t subsecond_nanos = nanos % 1000000000;
+  if (subsecond_nanos < 0) {
+    // Timestamp.nanos must be non-negative.
+    --seconds;
+    subsecond_nanos += 1000000000;
+  }
+  const size_t start = BeginMessage(field);
+  if (seconds != 0) PutVarintField(kTimestampSeconds, seconds);
+  if (subsecond_nanos != 0) PutVarintField(kTimestampNanos, subsecond_nanos);
+  EndMessage(start);
+}
+
+void SpanBatchEncoder::PutTruncatableString(uint32_t field,
+                                            absl::string_view value,
+                                            bool dedup) {
+  const size_t start = BeginMessage(field);
+  if (dedup && options_.deduplicate_strings) {
+    PutVarintField(kStringIndexField, StringIndex(value));
+  } else {
+    PutBytesField(kTruncatableStringValue, value);
+  }
+  EndMessage(start);
+}
+
+void SpanBatchEncoder::PutAttributeValue(uint32_t field,
+                                         const AttributeValue& value) {
+  const size_t start = BeginMessage(field);
+  switch (value.type()) {
+    case AttributeValue::Type::kString:
+      PutTruncatableString(kAttributeValueStringValue, value.string_value(),
+                           /*dedup=*/false);
+      break;
+    case AttributeValue::Type::kInt:
+      PutVarintField(kAttributeValueIntValue, value.int_value());
+      break;
+    case AttributeValue::Type::kBool:
+      PutVarintField(kAttributeValueBoolValue, value.bool_value());
+      break;
+  }
+  EndMessage(start);
+}
+
+void SpanBatchEncoder::PutAttributes(
+    uint32_t field,
+    const std::unordered_map<std::string, AttributeValue>& attributes,
+    int dropped_attributes_count) {
+  if (attributes.empty() && dropped_attributes_count == 0) return;
+  const size_t start = BeginMessage(field);
+  for (const auto& attribute : attributes) {
+    const size_t entry_start = BeginMessage(kAttributesAttributeMap);
+    if (options_.deduplicate_strings) {
+      PutVarintField(kStringIndexField, StringIndex(attribute.first));
+    } else {
+      PutBytesField(kMapEntryKey, attribute.first);
+    }
+    PutAttributeValue(kMapEntryValue, attribute.second);
+    EndMessage(entry_start);
+  }
+  if (dropped_attributes_count != 0) {
+    PutVarintField(kAttributesDroppedAttributesCount,
+                   dropped_attributes_count);
+  }
+  EndMessage(start);
+}
+
+void SpanBatchEncoder::PutSpan(const SpanData& span) {
+  uint8_t id[TraceId::kSize];
+  span.context().trace_id().CopyTo(id);
+  PutBytesField(kSpanTraceId,
+                absl::string_view(reinterpret_cast<char*>(id), TraceId::kSize));
+  span.context().span_id().CopyTo(id);
+  PutBytesField(kSpanSpanId,
+                absl::string_view(reinterpret_cast<char*>(id), SpanId::kSize));
+  if (span.parent_span_id().IsValid()) {
+    span.parent_span_id().CopyTo(id);
+    PutBytesField(kSpanParentSpanId, absl::string_view(
+                                         reinterpret_cast<char*>(id),
+                                         SpanId::kSize));
+  }
+  PutTruncatableString(kSpanName, span.name(), /*dedup=*/true);
+  PutTimestamp(kSpanStartTime, span.start_time());
+  if (span.has_ended()) PutTimestamp(kSpanEndTime, span.end_time());
+  PutAttributes(kSpanAttributes, span.attributes(),
+                span.num_attributes_dropped());
+
+  const auto& annotations = span.annotations();
+  const auto& message_events = span.message_events();
+  if (!annotations.events().empty() || !message_events.events().empty() ||
+      annotations.dropped_events_count() != 0 ||
+      message_events.dropped_events_count() != 0) {
+    const size_t start = BeginMessage(kSpanTimeEvents);
+    for (const auto& annotation : annotations.events()) {
+      const size_t event_start = BeginMessage(kTimeEventsTimeEvent);
+      PutTimestamp(kTimeEventTime, annotation.timestamp());
+      const size_t annotation_start = BeginMessage(kTimeEventAnnotation);
+      PutTruncatableString(kAnnotationDescription,
+                           annotation.event().description(), /*dedup=*/false);
+      PutAttributes(kAnnotationAttributes, annotation.event().attributes(), 0);
+      EndMessage(annotation_start);
+      EndMessage(event_start);
+    }
+    for (const auto& message_event : message_events.events()) {
+      const size_t event_start = BeginMessage(kTimeEventsTimeEvent);
+      PutTimestamp(kTimeEventTime, message_event.timestamp());
+      const size_t message_event_start = BeginMessage(kTimeEventMessageEvent);
+      // MessageEvent::Type values match the proto enum.
+      PutVarintField(kMessageEventType,
+                     static_cast<uint32_t>(message_event.event().type()));
+      PutVarintField(kMessageEventId, message_event.event().id());
+      PutVarintField(kMessageEventUncompressedSize,
+                     message_event.event().uncompressed_size());
+      PutVarintField(kMessageEventCompressedSize,
+                     message_event.event().compressed_size());
+      EndMessage(message_event_start);
+      EndMessage(event_start);
+    }
+    if (annotations.dropped_events_count() != 0) {
+      PutVarintField(kTimeEventsDroppedAnnotationsCount,
+                     annotations.dropped_events_count());
+    }
+    if (message_events.dropped_events_count() != 0) {
+      PutVarintField(kTimeEventsDroppedMessageEventsCount,
+                     message_events.dropped_events_count());
+    }
+    EndMessage(start);
+  }
+
+  if (!span.links().empty() || span.num_links_dropped() != 0) {
+    const size_t start = BeginMessage(kSpanLinks);
+    for (const auto& link : span.links()) {
+      const size_t link_start = BeginMessage(kLinksLink);
+      link.trace_id().CopyTo(id);
+      PutBytesField(kLinkTraceId, absl::string_view(
+                                      reinterpret_cast<char*>(id),
+                                      TraceId::kSize));
+      link.span_id().CopyTo(id);
+      PutBytesField(kLinkSpanId, absl::string_view(
+                                     reinterpret_cast<char*>(id),
+                                     SpanId::kSize));
+      PutVarintField(kLinkType,
+                     link.type() == Link::Type::kChildLinkedSpan
+                         ? kChildLinkedSpan
+                         : kParentLinkedSpan);
+      PutAttributes(kLinkAttributes, link.attributes(), 0);
+      EndMessage(link_start);
+    }
+    if (span.num_links_dropped() != 0) {
+      PutVarintField(kLinksDroppedLinksCount, span.num_links_dropped());
+    }
+    EndMessage(start);
+  }
+
+  const Status status = span.status();
+  if (!status.ok()) {
+    const size_t start = BeginMessage(kSpanStatus);
+    PutVarintField(kStatusCode, static_cast<uint32_t>(status.CanonicalCode()));
+    if (!status.error_message().empty()) {
+      PutBytesField(kStatusMessage, status.error_message());
+    }
+    EndMessage(start);
+  }
+
+  const size_t start = BeginMessage(kSpanSameProcessAsParentSpan);
+  if (!span.has_remote_parent()) PutVarintField(kBoolValueValue, 1);
+  EndMessage(start);
+}
+
+uint32_t SpanBatchEncoder::StringIndex(absl::string_view value) {
+  auto it = string_indices_.find(value);
+  if (it != string_indices_.end()) return it->second;
+  const uint32_t index = string_indices_.size();
+  string_indices_.emplace(value, index);
+  // Written directly in table form: a tag, length, and bytes per entry.
+  char buf[10];
+  WriteVarint((kStringTableField << 3) | kLengthDelimited, buf);
+  string_table_.append(buf,
+                       VarintSize((kStringTableField << 3) | kLengthDelimited));
+  WriteVarint(value.size(), buf);
+  string_table_.append(buf, VarintSize(value.size()));
+  string_table_.append(value.data(), value.size());
+  return index;
+}
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
@@ -0,0 +1,102 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "opencensus/trace/attribute_value_ref.h"
+#include "opencensus/trace/exporter/annotation.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/link.h"
+#include "opencensus/trace/exporter/message_event.h"
+#include "opencensus/trace/exporter/span_batch_encoder.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/status.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_id.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+namespace {
+
+constexpr uint8_t trace_id[] = {1, 2,  3,  4,  5,  6,  7,  8,
+                                9, 10, 11, 12, 13, 14, 15, 16};
+constexpr uint8_t span_id[] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+AttributeValue Value(AttributeValueRef ref) { return AttributeValue(ref); }
+
+// Returns num_spans ended spans that look like RPC spans: a handful of names,
+// a few attributes, an annotation, and message events each.
+std::vector<SpanData> MakeSpans(int num_spans) {
+  const absl::Time start = absl::Now();
+  std::vector<SpanData> spans;
+  spans.reserve(num_spans);
+  for (int i = 0; i < num_spans; ++i) {
+    std::vector<SpanData::TimeEvent<Annotation>> annotations;
+    annotations.emplace_back(
+        start, Annotation("Looked up user.", {{"user_id", Value(i)}}));
+    std::vector<SpanData::TimeEvent<MessageEvent>> message_events;
+    message_events.emplace_back(
+        start, MessageEvent(MessageEvent::Type::SENT, 1, 120, 260));
+    message_events.emplace_back(
+        start, MessageEvent(MessageEvent::Type::RECEIVED, 1, 1800, 4000));
+    spans.emplace_back(
+        absl::StrCat("Service.Method", i % 8),
+        SpanContext(TraceId(trace_id), SpanId(span_id)), SpanId(span_id),
+        SpanData::TimeEvents<Annotation>(std::move(annotations), 0),
+        SpanData::TimeEvents<MessageEvent>(std::move(message_events), 0),
+        std::vector<Link>(), 0,
+        std::unordered_map<std::string, AttributeValue>{
+            {"http.method", Value("GET")},
+            {"http.path", Value("/some/path")},
+            {"http.status_code", Value(200)},
+            {"cache_hit", Value(i % 2 == 0)}},
+        0, /*has_ended=*/true, start, start + absl::Microseconds(i),
+        Status(), /*has_remote_parent=*/false);
+  }
+  return spans;
+}
+
+void BM_EncodeBatch(benchmark::State& state) {
+  const int batch_size = state.range(0);
+  const bool deduplicate_strings = state.range(1);
+  const std::vector<SpanData> spans = MakeSpans(batch_size);
+  SpanBatchEncoder encoder({deduplicate_strings});
+  size_t bytes = 0;
+  while (state.KeepRunning()) {
+    bytes = encoder.Encode(spans).size();
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_EncodeBatch)
+    ->ArgPair(64, 0)
+    ->ArgPair(64, 1)
+    ->ArgPair(1024, 0)
+    ->ArgPair(1024, 1);
+
+}  // namespace
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
+BENCHMARK_MAIN();
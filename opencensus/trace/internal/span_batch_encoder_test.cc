@@ -0,0 +1,267 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/exporter/span_batch_encoder.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "opencensus/trace/attribute_value_ref.h"
+#include "opencensus/trace/exporter/annotation.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/link.h"
+#include "opencensus/trace/exporter/message_event.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/status.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/status_code.h"
+#include "opencensus/trace/trace_id.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+namespace {
+
+constexpr uint8_t trace_id[] = {1, 2,  3,  4,  5,  6,  7,  8,
+                                9, 10, 11, 12, 13, 14, 15, 16};
+constexpr uint8_t span_id[] = {1, 0, 0, 0, 0, 0, 0, 1};
+constexpr uint8_t parent_span_id[] = {2, 0, 0, 0, 0, 0, 0, 2};
+
+// A decoded protobuf field: a varint, or the bytes of a length-delimited
+// field.
+struct Field {
+  uint32_t number;
+  uint64_t varint;
+  std::string bytes;
+};
+
+uint64_t ReadVarint(absl::string_view* data) {
+  uint64_t value = 0;
+  for (int shift = 0; !data->empty(); shift += 7) {
+    const uint8_t byte = (*data)[0];
+    data->remove_prefix(1);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) break;
+  }
+  return value;
+}
+
+// Decodes a message with only varint and length-delimited fields.
+std::vector<Field> Parse(absl::string_view data) {
+  std::vector<Field> fields;
+  while (!data.empty()) {
+    const uint64_t tag = ReadVarint(&data);
+    Field field{static_cast<uint32_t>(tag >> 3), 0, ""};
+    if ((tag & 7) == 0) {
+      field.varint = ReadVarint(&data);
+    } else {
+      EXPECT_EQ(2, tag & 7);
+      const uint64_t length = ReadVarint(&data);
+      EXPECT_LE(length, data.size());
+      field.bytes = std::string(data.substr(0, length));
+      data.remove_prefix(length);
+    }
+    fields.push_back(field);
+  }
+  return fields;
+}
+
+// Returns the fields with the given number.
+std::vector<Field> Get(const std::vector<Field>& fields, uint32_t number) {
+  std::vector<Field> out;
+  for (const auto& field : fields) {
+    if (field.number == number) out.push_back(field);
+  }
+  return out;
+}
+
+// Returns the only field with the given number.
+Field GetOne(const std::vector<Field>& fields, uint32_t number) {
+  auto out = Get(fields, number);
+  EXPECT_EQ(1, out.size()) << "field " << number;
+  return out.empty() ? Field{number, 0, ""} : out[0];
+}
+
+SpanData MakeSpan(absl::string_view name,
+                  std::unordered_map<std::string, AttributeValue> attributes) {
+  const absl::Time start = absl::FromUnixNanos(1500000000123456789);
+  std::vector<SpanData::TimeEvent<Annotation>> annotations;
+  annotations.emplace_back(start, Annotation("Annotation"));
+  std::vector<SpanData::TimeEvent<MessageEvent>> message_events;
+  message_events.emplace_back(
+      start, MessageEvent(MessageEvent::Type::RECEIVED, 7, 100, 200));
+  std::vector<Link> links;
+  links.emplace_back(SpanContext(TraceId(trace_id), SpanId(parent_span_id)),
+                     Link::Type::kParentLinkedSpan);
+  return SpanData(
+      name, SpanContext(TraceId(trace_id), SpanId(span_id)),
+      SpanId(parent_span_id),
+      SpanData::TimeEvents<Annotation>(std::move(annotations), 1),
+      SpanData::TimeEvents<MessageEvent>(std::move(message_events), 0),
+      std::move(links), 0, std::move(attributes), 2, /*has_ended=*/true, start,
+      start + absl::Milliseconds(5),
+      Status(StatusCode::NOT_FOUND, "not found"), /*has_remote_parent=*/true);
+}
+
+AttributeValue StringValue(absl::string_view value) {
+  return AttributeValue(AttributeValueRef(value));
+}
+
+TEST(SpanBatchEncoderTest, EncodesSpan) {
+  std::vector<SpanData> spans;
+  spans.push_back(MakeSpan("Span", {{"key", StringValue("value")},
+                                    {"int", AttributeValue(
+                                                AttributeValueRef(42))}}));
+  SpanBatchEncoder encoder;
+  const auto request = Parse(encoder.Encode(spans));
+  ASSERT_EQ(1, request.size());
+  const auto span = Parse(GetOne(request, 2).bytes);
+
+  EXPECT_EQ(std::string(reinterpret_cast<const char*>(trace_id), 16),
+            GetOne(span, 1).bytes);
+  EXPECT_EQ(std::string(reinterpret_cast<const char*>(span_id), 8),
+            GetOne(span, 2).bytes);
+  EXPECT_EQ(std::string(reinterpret_cast<const char*>(parent_span_id), 8),
+            GetOne(span, 3).bytes);
+  EXPECT_EQ("Span", GetOne(Parse(GetOne(span, 4).bytes), 1).bytes);
+
+  const auto start_time = Parse(GetOne(span, 5).bytes);
+  EXPECT_EQ(1500000000, GetOne(start_time, 1).varint);
+  EXPECT_EQ(123456789, GetOne(start_time, 2).varint);
+  const auto end_time = Parse(GetOne(span, 6).bytes);
+  EXPECT_EQ(128456789, GetOne(end_time, 2).varint);
+
+  const auto attributes = Parse(GetOne(span, 7).bytes);
+  EXPECT_EQ(2, GetOne(attributes, 2).varint);
+  std::unordered_map<std::string, std::vector<Field>> attribute_map;
+  for (const auto& entry : Get(attributes, 1)) {
+    const auto entry_fields = Parse(entry.bytes);
+    attribute_map[GetOne(entry_fields, 1).bytes] =
+        Parse(GetOne(entry_fields, 2).bytes);
+  }
+  ASSERT_EQ(2, attribute_map.size());
+  EXPECT_EQ("value",
+            GetOne(Parse(GetOne(attribute_map["key"], 1).bytes), 1).bytes);
+  EXPECT_EQ(42, GetOne(attribute_map["int"], 2).varint);
+
+  const auto time_events = Parse(GetOne(span, 9).bytes);
+  const auto events = Get(time_events, 1);
+  ASSERT_EQ(2, events.size());
+  const auto annotation = Parse(GetOne(Parse(events[0].bytes), 2).bytes);
+  EXPECT_EQ("Annotation", GetOne(Parse(GetOne(annotation, 1).bytes), 1).bytes);
+  const auto message_event = Parse(GetOne(Parse(events[1].bytes), 3).bytes);
+  EXPECT_EQ(2, GetOne(message_event, 1).varint);  // RECEIVED
+  EXPECT_EQ(7, GetOne(message_event, 2).varint);
+  EXPECT_EQ(200, GetOne(message_event, 3).varint);
+  EXPECT_EQ(100, GetOne(message_event, 4).varint);
+  EXPECT_EQ(1, GetOne(time_events, 2).varint);
+
+  const auto link = Parse(GetOne(Parse(GetOne(span, 10).bytes), 1).bytes);
+  EXPECT_EQ(std::string(reinterpret_cast<const char*>(parent_span_id), 8),
+            GetOne(link, 2).bytes);
+  EXPECT_EQ(2, GetOne(link, 3).varint);  // PARENT_LINKED_SPAN
+
+  const auto status = Parse(GetOne(span, 11).bytes);
+  EXPECT_EQ(5, GetOne(status, 1).varint);  // NOT_FOUND
+  EXPECT_EQ("not found", GetOne(status, 2).bytes);
+
+  // Remote parent, so same_process_as_parent_span is false.
+  EXPECT_TRUE(Parse(GetOne(span, 12).bytes).empty());
+}
+
+TEST(SpanBatchEncoderTest, LongMessages) {
+  const std::string value(20000, 'x');
+  std::vector<SpanData> spans;
+  spans.push_back(MakeSpan("Span", {{"key", StringValue(value)}}));
+  SpanBatchEncoder encoder;
+  const auto request = Parse(encoder.Encode(spans));
+  const auto span = Parse(GetOne(request, 2).bytes);
+  const auto entry = Parse(GetOne(Parse(GetOne(span, 7).bytes), 1).bytes);
+  EXPECT_EQ(value,
+            GetOne(Parse(GetOne(Parse(GetOne(entry, 2).bytes), 1).bytes), 1)
+                .bytes);
+  EXPECT_EQ("Span", GetOne(Parse(GetOne(span, 4).bytes), 1).bytes);
+}
+
+TEST(SpanBatchEncoderTest, DeduplicatesStrings) {
+  std::vector<SpanData> spans;
+  for (int i = 0; i < 3; ++i) {
+    spans.push_back(MakeSpan("SpanName", {{"key", StringValue("value")}}));
+  }
+  SpanBatchEncoder plain_encoder;
+  const size_t plain_size = plain_encoder.Encode(spans).size();
+  SpanBatchEncoder encoder({/*deduplicate_strings=*/true});
+  const absl::string_view batch = encoder.Encode(spans);
+  EXPECT_LT(batch.size(), plain_size);
+
+  const auto request = Parse(batch);
+  const auto table = Get(request, SpanBatchEncoder::kStringTableField);
+  ASSERT_EQ(2, table.size());
+  EXPECT_EQ("SpanName", table[0].bytes);
+  EXPECT_EQ("key", table[1].bytes);
+  const auto encoded_spans = Get(request, 2);
+  ASSERT_EQ(3, encoded_spans.size());
+  for (const auto& encoded_span : encoded_spans) {
+    const auto span = Parse(encoded_span.bytes);
+    const auto name = Parse(GetOne(span, 4).bytes);
+    EXPECT_EQ(0, GetOne(name, SpanBatchEncoder::kStringIndexField).varint);
+    const auto entry = Parse(GetOne(Parse(GetOne(span, 7).bytes), 1).bytes);
+    EXPECT_EQ(1, GetOne(entry, SpanBatchEncoder::kStringIndexField).varint);
+    // String values aren't deduplicated.
+    EXPECT_EQ("value",
+              GetOne(Parse(GetOne(Parse(GetOne(entry, 2).bytes), 1).bytes), 1)
+                  .bytes);
+  }
+}
+
+TEST(SpanBatchEncoderTest, BatchesAreIndependent) {
+  std::vector<SpanData> batch1;
+  batch1.push_back(MakeSpan("First", {{"key1", StringValue("value")}}));
+  batch1.push_back(MakeSpan("Second", {}));
+  std::vector<SpanData> batch2;
+  batch2.push_back(MakeSpan("Second", {{"key2", StringValue("value")}}));
+
+  SpanBatchEncoder encoder({/*deduplicate_strings=*/true});
+  encoder.Encode(batch1);
+  const std::string reused(encoder.Encode(batch2));
+  SpanBatchEncoder fresh_encoder({/*deduplicate_strings=*/true});
+  EXPECT_EQ(fresh_encoder.Encode(batch2), reused);
+}
+
+TEST(SpanBatchEncoderTest, Incremental) {
+  std::vector<SpanData> spans;
+  spans.push_back(MakeSpan("First", {}));
+  spans.push_back(MakeSpan("Second", {}));
+  SpanBatchEncoder encoder;
+  for (const auto& span : spans) {
+    encoder.Add(span);
+  }
+  EXPECT_EQ(2, encoder.num_spans());
+  EXPECT_LT(0, encoder.size());
+  const std::string incremental(encoder.Finish());
+  EXPECT_EQ(0, encoder.num_spans());
+  EXPECT_EQ(encoder.Encode(spans), incremental);
+  EXPECT_TRUE(encoder.Encode({}).empty());
+}
+
+}  // namespace
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
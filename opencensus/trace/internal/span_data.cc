@@ -25,6 +25,36 @@ namespace exporter {
 
 using absl::StrAppend;
 
+namespace {
+
+SpanData::MessageEventSummary Summarize(
+    const SpanData::TimeEvents<MessageEvent>& message_events) {
+  SpanData::MessageEventSummary summary;
+  for (const auto& event : message_events.events()) {
+    summary.Add(event.timestamp(), event.event());
+  }
+  return summary;
+}
+
+}  // namespace
+
+void SpanData::MessageEventSummary::Add(absl::Time timestamp,
+                                        const MessageEvent& event) {
+  if (num_sent + num_received == 0) {
+    first_event_time = timestamp;
+  }
+  last_event_time = timestamp;
+  if (event.type() == MessageEvent::Type::SENT) {
+    ++num_sent;
+    sent_compressed_bytes += event.compressed_size();
+    sent_uncompressed_bytes += event.uncompressed_size();
+  } else {
+    ++num_received;
+    received_compressed_bytes += event.compressed_size();
+    received_uncompressed_bytes += event.uncompressed_size();
+  }
+}
+
 SpanData::SpanData(absl::string_view name, SpanContext context,
                    SpanId parent_span_id, TimeEvents<Annotation>&& annotations,
                    TimeEvents<MessageEvent>&& message_events,
@@ -32,12 +62,32 @@ SpanData::SpanData(absl::string_view name, SpanContext context,
                    std::unordered_map<std::string, AttributeValue>&& attributes,
                    int num_attributes_dropped, bool has_ended,
                    absl::Time start_time, absl::Time end_time, Status status,
-                   bool has_remote_parent)
+                   bool has_remote_parent, uint64_t thread_id)
+    // Summarize() only reads message_events; it's moved from by the delegated
+    // constructor's member initializers, which run afterwards.
+    : SpanData(name, context, parent_span_id, std::move(annotations),
+               std::move(message_events), Summarize(message_events),
+               std::move(links), num_links_dropped, std::move(attributes),
+               num_attributes_dropped, has_ended, start_time, end_time,
+               std::move(status), has_remote_parent, thread_id,
+               /*num_strings_truncated=*/0) {}
+
+SpanData::SpanData(absl::string_view name, SpanContext context,
+                   SpanId parent_span_id, TimeEvents<Annotation>&& annotations,
+                   TimeEvents<MessageEvent>&& message_events,
+                   const MessageEventSummary& message_event_summary,
+                   std::vector<Link>&& links, int num_links_dropped,
+                   std::unordered_map<std::string, AttributeValue>&& attributes,
+                   int num_attributes_dropped, bool has_ended,
+                   absl::Time start_time, absl::Time end_time, Status status,
+                   bool has_remote_parent, uint64_t thread_id,
+                   int num_strings_truncated)
     : name_(name),
       context_(context),
       parent_span_id_(parent_span_id),
       annotations_(std::move(annotations)),
       message_events_(std::move(message_events)),
+      message_event_summary_(message_event_summary),
       links_(std::move(links)),
       attributes_(std::move(attributes)),
       num_links_dropped_(num_links_dropped),
@@ -46,7 +96,9 @@ SpanData::SpanData(absl::string_view name, SpanContext context,
       end_time_(end_time),
       status_(std::move(status)),
       has_remote_parent_(has_remote_parent),
-      has_ended_(has_ended) {}
+      has_ended_(has_ended),
+      thread_id_(thread_id),
+      num_strings_truncated_(num_strings_truncated) {}
 
 absl::string_view SpanData::name() const { return name_; }
 
@@ -62,6 +114,10 @@ const SpanData::TimeEvents<MessageEvent>& SpanData::message_events() const {
   return message_events_;
 }
 
+const SpanData::MessageEventSummary& SpanData::message_event_summary() const {
+  return message_event_summary_;
+}
+
 const std::vector<Link>& SpanData::links() const { return links_; }
 
 int SpanData::num_links_dropped() const { return num_links_dropped_; }
@@ -83,6 +139,27 @@ Status SpanData::status() const { return status_; }
 
 bool SpanData::has_remote_parent() const { return has_remote_parent_; }
 
+uint64_t SpanData::thread_id() const { return thread_id_; }
+
+int SpanData::num_strings_truncated() const { return num_strings_truncated_; }
+
+SpanData::TimeEvents<Annotation>* SpanData::mutable_annotations() {
+  return &annotations_;
+}
+
+SpanData::TimeEvents<MessageEvent>* SpanData::mutable_message_events() {
+  return &message_events_;
+}
+
+std::unordered_map<std::string, AttributeValue>*
+SpanData::mutable_attributes() {
+  return &attributes_;
+}
+
+void SpanData::set_num_attributes_dropped(int num_attributes_dropped) {
+  num_attributes_dropped_ = num_attributes_dropped;
+}
+
 std::string SpanData::DebugString() const {
   std::string debug_str;
   StrAppend(&debug_str, "Name: ", name(), "\n");
@@ -124,6 +201,13 @@ std::string SpanData::DebugString() const {
   for (const auto& message : message_events().events()) {
     StrAppend(&debug_str, "\t", message.event().DebugString(), "\n");
   }
+  const MessageEventSummary& summary = message_event_summary();
+  StrAppend(&debug_str, "\tsent: ", summary.num_sent, " messages, ",
+            summary.sent_uncompressed_bytes, " bytes (",
+            summary.sent_compressed_bytes, " compressed)\n");
+  StrAppend(&debug_str, "\treceived: ", summary.num_received, " messages, ",
+            summary.received_uncompressed_bytes, " bytes (",
+            summary.received_compressed_bytes, " compressed)\n");
 
   // Export Links
   StrAppend(&debug_str, "Links:\n");
@@ -143,6 +227,10 @@ std::string SpanData::DebugString() const {
 
   // The status of the span. Unset if the span hasn't ended.
   StrAppend(&debug_str, "status: ", status().ToString(), "\n");
+
+  // The number of strings truncated to fit the span's byte budget.
+  StrAppend(&debug_str, "num truncated strings: ", num_strings_truncated(),
+            "\n");
   return debug_str;
 }
 
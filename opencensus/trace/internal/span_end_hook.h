@@ -0,0 +1,73 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_INTERNAL_SPAN_END_HOOK_H_
+#define OPENCENSUS_TRACE_INTERNAL_SPAN_END_HOOK_H_
+
+#include <atomic>
+
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "opencensus/trace/internal/span_impl.h"
+#include "opencensus/trace/status_code.h"
+
+namespace opencensus {
+namespace trace {
+
+// SpanEndHook lets a library that tracing can't depend on, such as
+// SpanMetrics, observe every recording span as it ends, before and regardless
+// of sampling for export. When no callback is set, Run() costs one atomic load.
+//
+// This class is thread-safe.
+class SpanEndHook final {
+ public:
+  struct EndedSpan {
+    absl::string_view name;
+    StatusCode status;
+    absl::Duration latency;
+    // Only set if the span recorded its CPU usage.
+    bool has_cpu_time;
+    absl::Duration cpu_time;
+  };
+  using Callback = void (*)(const EndedSpan& span);
+
+  // Sets the callback, replacing any previous one. nullptr disables the hook.
+  static void Set(Callback callback) {
+    callback_.store(callback, std::memory_order_release);
+  }
+
+  // Calls the callback, if any, for 'span', which has ended.
+  static void Run(const SpanImpl& span) {
+    const Callback callback = callback_.load(std::memory_order_acquire);
+    if (callback != nullptr) {
+      EndedSpan ended;
+      {
+        absl::MutexLock l(&span.mu_);
+        ended = {span.name(), span.status_.CanonicalCode(),
+                 span.end_time_ - span.start_time_, span.has_cpu_time_,
+                 span.cpu_time_};
+      }
+      callback(ended);
+    }
+  }
+
+ private:
+  static std::atomic<Callback> callback_;
+};
+
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_INTERNAL_SPAN_END_HOOK_H_
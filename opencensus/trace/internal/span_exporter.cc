@@ -27,6 +27,10 @@ void SpanExporter::RegisterHandler(std::unique_ptr<Handler> handler) {
   SpanExporterImpl::Get()->RegisterHandler(std::move(handler));
 }
 
+void SpanExporter::RegisterProcessor(std::unique_ptr<Processor> processor) {
+  SpanExporterImpl::Get()->RegisterProcessor(std::move(processor));
+}
+
 }  // namespace exporter
 }  // namespace trace
 }  // namespace opencensus
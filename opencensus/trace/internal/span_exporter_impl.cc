@@ -14,9 +14,14 @@
 
 #include "opencensus/trace/internal/span_exporter_impl.h"
 
+#include <cstdint>
 #include <utility>
 
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "opencensus/common/internal/executor.h"
+#include "opencensus/common/internal/probes.h"
 #include "opencensus/trace/exporter/span_data.h"
 #include "opencensus/trace/exporter/span_exporter.h"
 
@@ -32,72 +37,95 @@ SpanExporterImpl* SpanExporterImpl::Get() {
   return global_span_exporter_impl;
 }
 
-// Create detached worker thread
 SpanExporterImpl::SpanExporterImpl(uint32_t buffer_size,
                                    absl::Duration interval)
-    : buffer_size_(buffer_size), interval_(interval), size_(0) {}
+    : buffer_size_(buffer_size), interval_(interval) {}
 
 void SpanExporterImpl::RegisterHandler(
     std::unique_ptr<SpanExporter::Handler> handler) {
-  absl::MutexLock l(&handler_mu_);
-  handlers_.emplace_back(std::move(handler));
-  if (!thread_started_) {
-    StartExportThread();
+  {
+    absl::MutexLock l(&handler_mu_);
+    handlers_.emplace_back(std::move(handler));
+  }
+  absl::MutexLock l(&span_mu_);
+  if (!export_scheduled_) {
+    common::Executor::Get()->SchedulePeriodic([this]() { ExportBatch(); },
+                                              interval_);
+    export_scheduled_ = true;
   }
 }
 
+void SpanExporterImpl::RegisterProcessor(
+    std::unique_ptr<SpanExporter::Processor> processor) {
+  absl::MutexLock l(&handler_mu_);
+  processors_.emplace_back(std::move(processor));
+}
+
 void SpanExporterImpl::AddSpan(
     const std::shared_ptr<opencensus::trace::SpanImpl>& span_impl) {
-  absl::MutexLock l(&span_mu_);
-  spans_.emplace_back(span_impl);
-  size_.fetch_add(1, std::memory_order_acq_rel);
+  // Measured outside the lock; the span has ended, so it no longer changes.
+  const int64_t bytes = span_impl->MemoryUsage() + sizeof(span_impl);
+  bool export_now;
+  {
+    absl::MutexLock l(&span_mu_);
+    spans_.emplace_back(span_impl);
+    queued_bytes_ += bytes;
+    memory_account_.Add(1, 0, bytes);
+    export_now = export_scheduled_ && spans_.size() == buffer_size_;
+  }
+  if (export_now) {
+    const absl::Time now = absl::Now();
+    common::Executor::Get()->Schedule([this]() { ExportBatch(); }, now, now);
+  }
 }
 
-void SpanExporterImpl::StartExportThread() {
-  t_ = std::thread(&SpanExporterImpl::RunWorkerLoop, this);
-  thread_started_ = true;
+void SpanExporterImpl::ExportBatch() {
+  absl::MutexLock export_lock(&export_mu_);
+  {
+    absl::MutexLock l(&span_mu_);
+    if (spans_.empty()) return;
+    std::swap(export_spans_, spans_);
+    memory_account_.Add(-static_cast<int64_t>(export_spans_.size()), 0,
+                        -queued_bytes_);
+    queued_bytes_ = 0;
+  }
+  for (const auto& span : export_spans_) {
+    export_span_data_.emplace_back(span->ToSpanData());
+  }
+  Export(&export_span_data_);
+  export_spans_.clear();
+  export_span_data_.clear();
 }
 
-void SpanExporterImpl::RunWorkerLoop() {
-  std::vector<opencensus::trace::exporter::SpanData> span_data_;
-  std::vector<std::shared_ptr<opencensus::trace::SpanImpl>> spans_copy_;
-  // Thread loops forever.
-  // TODO: Add in shutdown mechanism.
-  absl::Time next_forced_export_time = absl::Now() + interval_;
-  while (true) {
-    {
-      absl::MutexLock l(&span_mu_);
-      // Wait until batch is full or interval time has been exceeded.
-      span_mu_.AwaitWithDeadline(
-          absl::Condition(
-              +[](SpanExporterImpl* ptr) {
-                return (ptr->size_.load(std::memory_order_acquire) >=
-                        ptr->buffer_size_);
-              },
-              this),
-          next_forced_export_time);
-      next_forced_export_time = absl::Now() + interval_;
-      if (spans_.empty()) {
-        continue;
+void SpanExporterImpl::Export(std::vector<SpanData>* span_data) {
+  absl::MutexLock lock(&handler_mu_);
+  OPENCENSUS_PROBE(span_export_start, span_data->size());
+  if (!processors_.empty()) {
+    // Run the chain over each span, compacting the kept spans in place.
+    auto kept = span_data->begin();
+    for (auto it = span_data->begin(); it != span_data->end(); ++it) {
+      bool keep = true;
+      for (const auto& processor : processors_) {
+        if (!processor->Process(&*it)) {
+          keep = false;
+          break;
+        }
       }
-      std::swap(spans_copy_, spans_);
-      size_.store(0, std::memory_order_release);
+      if (!keep) continue;
+      if (kept != it) *kept = std::move(*it);
+      ++kept;
     }
-    for (const auto& span : spans_copy_) {
-      span_data_.emplace_back(span->ToSpanData());
+    span_data->erase(kept, span_data->end());
+    if (span_data->empty()) {
+      OPENCENSUS_PROBE(span_export_done, 0);
+      return;
     }
-    Export(span_data_);
-    spans_copy_.clear();
-    span_data_.clear();
   }
-}
-
-void SpanExporterImpl::Export(const std::vector<SpanData>& span_data) {
   // Call each registered handler.
-  absl::MutexLock lock(&handler_mu_);
   for (const auto& handler : handlers_) {
-    handler->Export(span_data);
+    handler->Export(*span_data);
   }
+  OPENCENSUS_PROBE(span_export_done, span_data->size());
 }
 
 }  // namespace exporter
@@ -15,16 +15,16 @@
 #ifndef OPENCENSUS_TRACE_INTERNAL_SPAN_EXPORTER_IMPL_H_
 #define OPENCENSUS_TRACE_INTERNAL_SPAN_EXPORTER_IMPL_H_
 
-#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
-#include <thread>  // NOLINT
 #include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "opencensus/common/internal/memory_account.h"
 #include "opencensus/trace/exporter/span_data.h"
 #include "opencensus/trace/exporter/span_exporter.h"
 #include "opencensus/trace/internal/span_impl.h"
@@ -53,6 +53,8 @@ class SpanExporterImpl {
   // Registers a handler with the exporter. This is intended to be done at
   // initialization.
   void RegisterHandler(std::unique_ptr<SpanExporter::Handler> handler);
+  // Appends a processor to the chain run before the handlers.
+  void RegisterProcessor(std::unique_ptr<SpanExporter::Processor> processor);
 
   static constexpr uint32_t kDefaultBufferSize = 64;
   static constexpr uint32_t kIntervalWaitTimeInMillis = 5000;
@@ -65,27 +67,37 @@ class SpanExporterImpl {
   SpanExporterImpl& operator=(SpanExporterImpl&&) = delete;
   friend class Span;
 
-  void StartExportThread() EXCLUSIVE_LOCKS_REQUIRED(handler_mu_);
-  void RunWorkerLoop();
-  // Calls all registered handlers and exports the spans contained in span_data.
-  void Export(const std::vector<SpanData>& span_data);
+  // Exports the queued spans. Runs on the shared executor, every interval_
+  // and whenever the queue reaches buffer_size_.
+  void ExportBatch() LOCKS_EXCLUDED(export_mu_, span_mu_);
+  // Runs the processors over span_data, then calls all registered handlers
+  // with the spans that remain.
+  void Export(std::vector<SpanData>* span_data);
   void ExportForTesting();
 
   static SpanExporterImpl* span_exporter_;
   const uint32_t buffer_size_;
   const absl::Duration interval_;
-  // This is intentionally not guarded by span_mu_. You cannot lock the waiting
-  // mutex within an AwaitWithTimeout, so we need to store the size in another
-  // variable.
-  std::atomic<size_t> size_;
+  // Held while exporting, so that batches are exported one at a time and in
+  // order.
+  mutable absl::Mutex export_mu_ ACQUIRED_BEFORE(span_mu_, handler_mu_);
   mutable absl::Mutex span_mu_;
   mutable absl::Mutex handler_mu_;
   std::vector<std::shared_ptr<opencensus::trace::SpanImpl>> spans_
       GUARDED_BY(span_mu_);
+  // Set once exports are scheduled, i.e. once a handler is registered.
+  bool export_scheduled_ GUARDED_BY(span_mu_) = false;
+  // Reused by ExportBatch().
+  std::vector<std::shared_ptr<opencensus::trace::SpanImpl>> export_spans_
+      GUARDED_BY(export_mu_);
+  std::vector<SpanData> export_span_data_ GUARDED_BY(export_mu_);
+  // The estimated memory usage of spans_, as counted in memory_account_.
+  int64_t queued_bytes_ GUARDED_BY(span_mu_) = 0;
+  common::MemoryAccount memory_account_{"trace/span_exporter_queue"};
   std::vector<std::unique_ptr<SpanExporter::Handler>> handlers_
       GUARDED_BY(handler_mu_);
-  bool thread_started_ GUARDED_BY(handler_mu_) = false;
-  std::thread t_;
+  std::vector<std::unique_ptr<SpanExporter::Processor>> processors_
+      GUARDED_BY(handler_mu_);
 };
 
 }  // namespace exporter
@@ -0,0 +1,41 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_INTERNAL_SPAN_EXPORTER_NOOP_H_
+#define OPENCENSUS_TRACE_INTERNAL_SPAN_EXPORTER_NOOP_H_
+
+// Inline no-op definitions of the SpanExporter API, used instead of
+// span_exporter.cc in builds with --define opencensus_noop=true. Handlers and
+// processors are destroyed immediately. Included by span_exporter.h; don't
+// include directly.
+
+#include <memory>
+
+#include "opencensus/trace/exporter/span_exporter.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+inline void SpanExporter::RegisterHandler(
+    std::unique_ptr<Handler> /*handler*/) {}
+
+inline void SpanExporter::RegisterProcessor(
+    std::unique_ptr<Processor> /*processor*/) {}
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_INTERNAL_SPAN_EXPORTER_NOOP_H_
@@ -14,11 +14,16 @@
 
 #include "opencensus/trace/exporter/span_exporter.h"
 
+#include <atomic>
+#include <string>
+#include <vector>
+
 #include "absl/memory/memory.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "gtest/gtest.h"
 #include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/span_processors.h"
 #include "opencensus/trace/sampler.h"
 #include "opencensus/trace/span.h"
 
@@ -49,6 +54,9 @@ class Counter {
   int value_ GUARDED_BY(mu_) = 0;
 };
 
+// Spans that should have been dropped or edited by the processors.
+std::atomic<int> num_unprocessed_spans(0);
+
 class MyExporter : public exporter::SpanExporter::Handler {
  public:
   static void Register() {
@@ -57,6 +65,11 @@ class MyExporter : public exporter::SpanExporter::Handler {
 
   void Export(const std::vector<exporter::SpanData>& spans) override {
     Counter::Get()->Increment(spans.size());
+    for (const auto& span : spans) {
+      if (span.name() == "DroppedSpan" || span.attributes().count("secret")) {
+        ++num_unprocessed_spans;
+      }
+    }
   }
 };
 
@@ -65,6 +78,12 @@ class SpanExporterTest : public ::testing::Test {
   static void SetUpTestCase() {
     // Only register once.
     MyExporter::Register();
+    exporter::SpanExporter::RegisterProcessor(
+        absl::make_unique<exporter::DropSpansProcessor>(
+            std::vector<std::string>{"DroppedSpan"}));
+    exporter::SpanExporter::RegisterProcessor(
+        absl::make_unique<exporter::DropAttributesProcessor>(
+            std::vector<std::string>{"secret"}));
   }
 };
 
@@ -88,6 +107,25 @@ TEST_F(SpanExporterTest, BasicExportTest) {
   EXPECT_EQ(3, Counter::Get()->value());
 }
 
+TEST_F(SpanExporterTest, ProcessorsRunBeforeHandlers) {
+  ::opencensus::trace::AlwaysSampler sampler;
+  ::opencensus::trace::StartSpanOptions opts = {&sampler};
+  const int initial = Counter::Get()->value();
+  auto dropped = ::opencensus::trace::Span::StartSpan("DroppedSpan", nullptr,
+                                                      opts);
+  auto kept = ::opencensus::trace::Span::StartSpan("KeptSpan", nullptr, opts);
+  kept.AddAttribute("secret", "hunter2");
+  dropped.End();
+  kept.End();
+
+  for (int i = 0; i < 10; ++i) {
+    if (Counter::Get()->value() >= initial + 1) break;
+    absl::SleepFor(absl::Seconds(1));
+  }
+  EXPECT_EQ(initial + 1, Counter::Get()->value());
+  EXPECT_EQ(0, num_unprocessed_spans);
+}
+
 }  // namespace
 }  // namespace trace
 }  // namespace opencensus
@@ -14,12 +14,27 @@
 
 #include "opencensus/trace/internal/span_impl.h"
 
+#include <time.h>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <deque>
+#include <limits>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
-#include "absl/time/clock.h"
+#include "absl/types/optional.h"
+#include "opencensus/common/internal/clock.h"
+#include "opencensus/common/internal/utf8.h"
 #include "opencensus/trace/attribute_value_ref.h"
 #include "opencensus/trace/exporter/attribute_value.h"
 #include "opencensus/trace/exporter/message_event.h"
@@ -41,68 +56,215 @@ std::vector<T> CopyTraceEvents(const std::deque<T>& events) {
 
 template <typename T>
 std::vector<exporter::SpanData::TimeEvent<T>> CopyEventWithTime(
-    const std::deque<EventWithTime<T>>& events) {
+    const TraceEvents<EventWithTime<T>>& events) {
   std::vector<exporter::SpanData::TimeEvent<T>> time_events;
-  time_events.reserve(events.size());
-  for (const auto& event : events) {
+  time_events.reserve(events.initial_events().size() +
+                      events.events().size());
+  for (const auto& event : events.initial_events()) {
+    auto tmp_event = event.event;
+    time_events.emplace_back(event.time, std::move(tmp_event));
+  }
+  for (const auto& event : events.events()) {
     auto tmp_event = event.event;
     time_events.emplace_back(event.time, std::move(tmp_event));
   }
   return time_events;
 }
 
+// Returns the longest prefix of 'str' that fits in *budget, without splitting
+// a UTF-8 sequence, and deducts its size from *budget. Counts truncations in
+// *num_truncated.
+absl::string_view Truncate(absl::string_view str, size_t* budget,
+                           int* num_truncated) {
+  const absl::string_view prefix = common::Utf8Prefix(str, *budget);
+  *budget -= prefix.size();
+  if (prefix.size() < str.size()) ++*num_truncated;
+  return prefix;
+}
+
+// Truncates string values to fit in *budget; other values are copied as they
+// are.
+exporter::AttributeValue CopyValue(AttributeValueRef value, size_t* budget,
+                                   int* num_truncated) {
+  if (budget != nullptr && value.type() == AttributeValueRef::Type::kString) {
+    return exporter::AttributeValue(AttributeValueRef(
+        Truncate(value.string_value(), budget, num_truncated)));
+  }
+  return exporter::AttributeValue(value);
+}
+
 // Deep-copies an initializer_list of absl::string_view keys and
 // AttributeValueRefs (cheap, used in the API) to an unordered_map that owns all
 // of the data in it. If the same key appears multiple times, the last value
-// wins.
+// wins. If budget is not null, string values are truncated to fit in it.
 std::unordered_map<std::string, exporter::AttributeValue> CopyAttributes(
-    AttributesRef attributes) {
+    AttributesRef attributes, size_t* budget = nullptr,
+    int* num_truncated = nullptr) {
   std::unordered_map<std::string, exporter::AttributeValue> out;
   for (const auto& pair : attributes) {
-    auto iter_inserted = out.insert(
-        {std::string(pair.first), exporter::AttributeValue(pair.second)});
+    auto iter_inserted =
+        out.insert({std::string(pair.first),
+                    CopyValue(pair.second, budget, num_truncated)});
     if (!iter_inserted.second) {
       // Already exists, update.
-      iter_inserted.first->second = exporter::AttributeValue(pair.second);
+      iter_inserted.first->second =
+          CopyValue(pair.second, budget, num_truncated);
     }
   }
   return out;
 }
+
+// Returns how much of a budget of max_bytes is left once 'used' bytes are
+// held. A budget of 0 is unlimited.
+size_t BytesLeft(size_t used, uint32_t max_bytes) {
+  if (max_bytes == 0) return std::numeric_limits<size_t>::max();
+  return used < max_bytes ? max_bytes - used : 0;
+}
+
+// The approximate bytes held by each kind of span content, for the byte
+// budget. These count string sizes rather than capacities, so that they can be
+// computed before anything is copied.
+using AttributeEntry = AttributeList::Entry;
+
+size_t AttributeBytes(absl::string_view key,
+                      const exporter::AttributeValue& value) {
+  size_t bytes = sizeof(AttributeEntry) + key.size();
+  if (value.type() == exporter::AttributeValue::Type::kString) {
+    bytes += value.string_value().size();
+  }
+  return bytes;
+}
+
+size_t AttributesBytes(
+    const std::unordered_map<std::string, exporter::AttributeValue>&
+        attributes) {
+  size_t bytes = 0;
+  for (const auto& attribute : attributes) {
+    bytes += AttributeBytes(attribute.first, attribute.second);
+  }
+  return bytes;
+}
+
+// The bytes needed by the attributes before their string values.
+size_t AttributeKeysBytes(AttributesRef attributes) {
+  size_t bytes = 0;
+  for (const auto& attribute : attributes) {
+    bytes += sizeof(AttributeEntry) + attribute.first.size();
+  }
+  return bytes;
+}
+
+size_t AnnotationBytes(const EventWithTime<exporter::Annotation>& annotation) {
+  return sizeof(annotation) + annotation.event.description().size() +
+         AttributesBytes(annotation.event.attributes());
+}
+
+size_t LinkBytes(const exporter::Link& link) {
+  return sizeof(link) + AttributesBytes(link.attributes());
+}
+
+constexpr size_t kMessageEventBytes =
+    sizeof(EventWithTime<exporter::MessageEvent>);
+
+// Returns an ID for the calling thread: the kernel thread ID on Linux, so that
+// it matches other tools, and a process-unique number elsewhere.
+uint64_t CurrentThreadId() {
+#ifdef __linux__
+  static thread_local const uint64_t thread_id = syscall(SYS_gettid);
+#else
+  static std::atomic<uint64_t> next_thread_id(1);
+  static thread_local const uint64_t thread_id = next_thread_id++;
+#endif
+  return thread_id;
+}
 }  // namespace
 
 // SpanImpl::SpanImpl() : has_ended_(false), remote_parent_(false) {}
 
 SpanImpl::SpanImpl(const SpanContext& context, const TraceParams& trace_params,
                    absl::string_view name, const SpanId& parent_span_id,
-                   bool remote_parent)
-    : start_time_(absl::Now()),
+                   bool remote_parent, bool record_cpu_usage)
+    : start_time_(common::Clock::Now()),
       name_(name),
       parent_span_id_(parent_span_id),
       context_(context),
       annotations_(trace_params.max_annotations),
-      message_events_(trace_params.max_message_events),
+      message_events_(trace_params.max_message_events,
+                      trace_params.max_initial_message_events),
       links_(trace_params.max_links),
       attributes_(trace_params.max_attributes),
+      max_bytes_(trace_params.max_span_bytes),
       has_ended_(false),
-      remote_parent_(remote_parent) {}
+      remote_parent_(remote_parent),
+      start_thread_id_(CurrentThreadId()),
+      start_cpu_usage_(record_cpu_usage ? new CpuUsage(CurrentCpuUsage())
+                                        : nullptr) {}
 
 void SpanImpl::AddAttributes(AttributesRef attributes) {
   absl::MutexLock l(&mu_);
   if (!has_ended_) {
     for (const auto& attr : attributes) {
-      attributes_.AddAttribute(attr.first,
-                               exporter::AttributeValue(attr.second));
+      AddAttributeLocked(attr.first, attr.second);
     }
   }
 }
 
+void SpanImpl::AddAttributeLocked(absl::string_view key,
+                                  AttributeValueRef value) {
+  // The lambda runs under mu_ but can't be annotated as such, so it works on
+  // copies of the guarded state.
+  const size_t used = bytes_;
+  size_t freed = 0;
+  size_t bytes = 0;
+  int num_truncated = 0;
+  const bool added = attributes_.AddAttribute(
+      key,
+      [&](const AttributeEntry* replaced)
+          -> absl::optional<exporter::AttributeValue> {
+        if (replaced != nullptr) {
+          freed = AttributeBytes(replaced->first, replaced->second);
+        }
+        size_t budget = BytesLeft(used - freed, max_bytes_);
+        const size_t key_bytes = sizeof(AttributeEntry) + key.size();
+        if (key_bytes > budget) return absl::nullopt;
+        budget -= key_bytes;
+        exporter::AttributeValue copy =
+            CopyValue(value, &budget, &num_truncated);
+        bytes = AttributeBytes(key, copy);
+        return copy;
+      });
+  num_strings_truncated_ += num_truncated;
+  if (added) UpdateBytes(freed, bytes);
+}
+
+size_t SpanImpl::AvailableBytes(size_t freed) const {
+  return BytesLeft(bytes_ - freed, max_bytes_);
+}
+
 void SpanImpl::AddAnnotation(absl::string_view description,
                              AttributesRef attributes) {
   absl::MutexLock l(&mu_);
-  if (!has_ended_) {
-    annotations_.AddEvent(EventWithTime<exporter::Annotation>(
-        absl::Now(),
-        exporter::Annotation(description, CopyAttributes(attributes))));
+  if (has_ended_) return;
+  const EventWithTime<exporter::Annotation>* evicted =
+      annotations_.next_evicted();
+  const size_t freed = evicted == nullptr ? 0 : AnnotationBytes(*evicted);
+  size_t budget = AvailableBytes(freed);
+  const size_t fixed_bytes = sizeof(EventWithTime<exporter::Annotation>) +
+                             AttributeKeysBytes(attributes);
+  if (fixed_bytes > budget) {
+    annotations_.AddDroppedEvent();
+    return;
+  }
+  budget -= fixed_bytes;
+  description = Truncate(description, &budget, &num_strings_truncated_);
+  EventWithTime<exporter::Annotation> annotation(
+      common::Clock::Now(),
+      exporter::Annotation(
+          description,
+          CopyAttributes(attributes, &budget, &num_strings_truncated_)));
+  const size_t bytes = AnnotationBytes(annotation);
+  if (annotations_.AddEvent(std::move(annotation))) {
+    UpdateBytes(freed, bytes);
   }
 }
 
@@ -112,40 +274,131 @@ void SpanImpl::AddMessageEvent(exporter::MessageEvent::Type type,
                                uint32_t uncompressed_message_size) {
   absl::MutexLock l(&mu_);
   if (!has_ended_) {
-    message_events_.AddEvent(EventWithTime<exporter::MessageEvent>(
-        absl::Now(),
+    EventWithTime<exporter::MessageEvent> event(
+        common::Clock::Now(),
         exporter::MessageEvent(type, message_id, compressed_message_size,
-                               uncompressed_message_size)));
+                               uncompressed_message_size));
+    message_event_summary_.Add(event.time, event.event);
+    const size_t freed =
+        message_events_.next_evicted() == nullptr ? 0 : kMessageEventBytes;
+    if (kMessageEventBytes > AvailableBytes(freed)) {
+      message_events_.AddDroppedEvent();
+    } else if (message_events_.AddEvent(std::move(event))) {
+      UpdateBytes(freed, kMessageEventBytes);
+    }
   }
 }
 
 void SpanImpl::AddLink(const SpanContext& context, exporter::Link::Type type,
                        AttributesRef attributes) {
   absl::MutexLock l(&mu_);
-  if (!has_ended_) {
-    links_.AddEvent(exporter::Link(context, type, CopyAttributes(attributes)));
+  if (has_ended_) return;
+  const exporter::Link* evicted = links_.next_evicted();
+  const size_t freed = evicted == nullptr ? 0 : LinkBytes(*evicted);
+  size_t budget = AvailableBytes(freed);
+  const size_t fixed_bytes =
+      sizeof(exporter::Link) + AttributeKeysBytes(attributes);
+  if (fixed_bytes > budget) {
+    links_.AddDroppedEvent();
+    return;
+  }
+  budget -= fixed_bytes;
+  exporter::Link link(
+      context, type,
+      CopyAttributes(attributes, &budget, &num_strings_truncated_));
+  const size_t bytes = LinkBytes(link);
+  if (links_.AddEvent(std::move(link))) {
+    UpdateBytes(freed, bytes);
   }
 }
 
-void SpanImpl::SetStatus(exporter::Status&& status) {
+void SpanImpl::SetStatus(StatusCode canonical_code,
+                         absl::string_view message) {
   absl::MutexLock l(&mu_);
-  if (!has_ended_) {
-    status_ = std::move(status);
-  }
+  if (has_ended_) return;
+  const size_t freed = status_.error_message().size();
+  size_t budget = AvailableBytes(freed);
+  message = Truncate(message, &budget, &num_strings_truncated_);
+  status_ = exporter::Status(canonical_code, message);
+  UpdateBytes(freed, message.size());
 }
 
-void SpanImpl::End() { EndWithTime(absl::Now()); }
+bool SpanImpl::End() { return EndWithTime(common::Clock::Now()); }
+
+// static
+SpanImpl::CpuUsage SpanImpl::CurrentCpuUsage() {
+  CpuUsage usage{absl::ZeroDuration(), 0, 0};
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+    usage.cpu_time = absl::DurationFromTimespec(ts);
+  }
+#ifdef __linux__
+  rusage ru;
+  if (getrusage(RUSAGE_THREAD, &ru) == 0) {
+    usage.voluntary_context_switches = ru.ru_nvcsw;
+    usage.involuntary_context_switches = ru.ru_nivcsw;
+  }
+#endif
+  return usage;
+}
 
 void SpanImpl::EndWithLatencyForTesting(absl::Duration latency) {
   EndWithTime(start_time_ + latency);
 }
 
-void SpanImpl::EndWithTime(absl::Time end_time) {
+bool SpanImpl::EndWithTime(absl::Time end_time) {
+  // Only the starting thread's usage covers the span.
+  const bool record_cpu_usage =
+      start_cpu_usage_ != nullptr && CurrentThreadId() == start_thread_id_;
+  CpuUsage end_usage{absl::ZeroDuration(), 0, 0};
+  if (record_cpu_usage) end_usage = CurrentCpuUsage();
   absl::MutexLock l(&mu_);
-  if (!has_ended_) {
-    has_ended_ = true;
-    end_time_ = end_time;
+  if (has_ended_) return false;
+  has_ended_ = true;
+  end_time_ = end_time;
+  if (record_cpu_usage) {
+    cpu_time_ = end_usage.cpu_time - start_cpu_usage_->cpu_time;
+    has_cpu_time_ = true;
+    AddAttributeLocked("thread.cpu_time_ns",
+                       AttributeValueRef(absl::ToInt64Nanoseconds(cpu_time_)));
+#ifdef __linux__
+    AddAttributeLocked(
+        "thread.voluntary_context_switches",
+        AttributeValueRef(end_usage.voluntary_context_switches -
+                          start_cpu_usage_->voluntary_context_switches));
+    AddAttributeLocked(
+        "thread.involuntary_context_switches",
+        AttributeValueRef(end_usage.involuntary_context_switches -
+                          start_cpu_usage_->involuntary_context_switches));
+#endif
   }
+  return true;
+}
+
+absl::Duration SpanImpl::latency() const {
+  absl::MutexLock l(&mu_);
+  return end_time_ - start_time_;
+}
+
+StatusCode SpanImpl::status_code() const {
+  absl::MutexLock l(&mu_);
+  return status_.CanonicalCode();
+}
+
+bool SpanImpl::ForceEnd(exporter::Status&& status) {
+  absl::MutexLock l(&mu_);
+  if (has_ended_) return false;
+  has_ended_ = true;
+  force_ended_ = true;
+  end_time_ = common::Clock::Now();
+  UpdateBytes(status_.error_message().size(), status.error_message().size());
+  status_ = std::move(status);
+  return true;
+}
+
+size_t SpanImpl::MemoryUsage() const {
+  absl::MutexLock l(&mu_);
+  return sizeof(SpanImpl) + name_.size() + bytes_;
 }
 
 exporter::SpanData SpanImpl::ToSpanData() const {
@@ -156,14 +409,15 @@ exporter::SpanData SpanImpl::ToSpanData() const {
   return exporter::SpanData(
       name_, context_, parent_span_id_,
       exporter::SpanData::TimeEvents<exporter::Annotation>(
-          CopyEventWithTime(annotations_.events()),
-          annotations_.num_events_dropped()),
+          CopyEventWithTime(annotations_), annotations_.num_events_dropped()),
       exporter::SpanData::TimeEvents<exporter::MessageEvent>(
-          CopyEventWithTime(message_events_.events()),
+          CopyEventWithTime(message_events_),
           message_events_.num_events_dropped()),
-      CopyTraceEvents(links_.events()), links_.num_events_dropped(),
+      message_event_summary_, CopyTraceEvents(links_.events()),
+      links_.num_events_dropped(),
       std::move(attributes), attributes_.num_attributes_dropped(), has_ended_,
-      start_time_, end_time_, status_, remote_parent_);
+      start_time_, end_time_, status_, remote_parent_, start_thread_id_,
+      num_strings_truncated_);
 }
 
 }  // namespace trace
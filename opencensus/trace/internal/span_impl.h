@@ -15,6 +15,9 @@
 #ifndef OPENCENSUS_TRACE_INTERNAL_SPAN_IMPL_H_
 #define OPENCENSUS_TRACE_INTERNAL_SPAN_IMPL_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -22,6 +25,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "opencensus/trace/attribute_value_ref.h"
 #include "opencensus/trace/exporter/annotation.h"
 #include "opencensus/trace/exporter/attribute_value.h"
 #include "opencensus/trace/exporter/link.h"
@@ -34,6 +38,7 @@
 #include "opencensus/trace/span.h"
 #include "opencensus/trace/span_context.h"
 #include "opencensus/trace/span_id.h"
+#include "opencensus/trace/status_code.h"
 #include "opencensus/trace/trace_config.h"
 #include "opencensus/trace/trace_params.h"
 
@@ -41,11 +46,14 @@ namespace opencensus {
 namespace trace {
 
 namespace exporter {
+class FlightRecorderImpl;
 class LocalSpanStoreImpl;
 class RunningSpanStoreImpl;
 class SpanExporterImpl;
 }  // namespace exporter
 
+class Span;
+class SpanEndHook;
 class SpanTestPeer;
 
 // SpanImpl is the underlying representation of a Span. Span has a shared_ptr
@@ -66,10 +74,11 @@ class SpanImpl final {
   // SpanContext sets the TraceId, SpanId, and TraceOptions for the span.
   // TraceParams sets the maximum number of attributes, annotations, network
   // events, and links. The name allows for a user provided description of the
-  // span.
+  // span. If record_cpu_usage is true, the CPU usage of the calling thread is
+  // measured until End().
   SpanImpl(const SpanContext& context, const TraceParams& trace_params,
            absl::string_view name, const SpanId& parent_span_id,
-           bool remote_parent);
+           bool remote_parent, bool record_cpu_usage = false);
 
   void AddAttributes(AttributesRef attributes) LOCKS_EXCLUDED(mu_);
 
@@ -83,10 +92,14 @@ class SpanImpl final {
   void AddLink(const SpanContext& context, exporter::Link::Type type,
                AttributesRef attributes) LOCKS_EXCLUDED(mu_);
 
-  void SetStatus(exporter::Status&& status) LOCKS_EXCLUDED(mu_);
+  void SetStatus(StatusCode canonical_code, absl::string_view message)
+      LOCKS_EXCLUDED(mu_);
 
-  // Marks the end of the Span and sets its end_time_.
-  void End() LOCKS_EXCLUDED(mu_);
+  // Marks the end of the Span and sets its end_time_. If CPU usage is being
+  // recorded and this is the starting thread, adds it as attributes. Returns
+  // true only for the call that ended the span: false if it had already ended,
+  // including when the RunningSpanStore ended and exported it with ForceEnd().
+  bool End() LOCKS_EXCLUDED(mu_);
 
   absl::string_view name() const { return name_; }
 
@@ -99,17 +112,59 @@ class SpanImpl final {
   SpanId parent_span_id() const { return parent_span_id_; }
 
  private:
+  friend class ::opencensus::trace::exporter::FlightRecorderImpl;
   friend class ::opencensus::trace::exporter::RunningSpanStoreImpl;
   friend class ::opencensus::trace::exporter::LocalSpanStoreImpl;
   friend class ::opencensus::trace::exporter::SpanExporterImpl;
+  friend class ::opencensus::trace::Span;
+  friend class ::opencensus::trace::SpanEndHook;
   friend class ::opencensus::trace::SpanTestPeer;
 
+  // Resource usage of a thread.
+  struct CpuUsage {
+    absl::Duration cpu_time;
+    int64_t voluntary_context_switches;
+    int64_t involuntary_context_switches;
+  };
+
+  // Returns the usage of the calling thread so far.
+  static CpuUsage CurrentCpuUsage();
+
   void EndWithLatencyForTesting(absl::Duration latency) LOCKS_EXCLUDED(mu_);
-  void EndWithTime(absl::Time end_time) LOCKS_EXCLUDED(mu_);
+  // As End(), with the given end time.
+  bool EndWithTime(absl::Time end_time) LOCKS_EXCLUDED(mu_);
 
   // Makes a deep copy of span contents and returns copied data in SpanData.
   exporter::SpanData ToSpanData() const LOCKS_EXCLUDED(mu_);
 
+  // Returns end_time_ - start_time_. Only meaningful after End().
+  absl::Duration latency() const LOCKS_EXCLUDED(mu_);
+
+  // Returns the canonical code of status_.
+  StatusCode status_code() const LOCKS_EXCLUDED(mu_);
+
+  // Ends a span on behalf of an owner that never ended it, and sets its
+  // status. Returns false if the span had already ended.
+  bool ForceEnd(exporter::Status&& status) LOCKS_EXCLUDED(mu_);
+
+  // Returns the approximate number of bytes held by the span, including its
+  // attributes, events, and links. O(1): it uses the running total kept for
+  // the byte budget.
+  size_t MemoryUsage() const LOCKS_EXCLUDED(mu_);
+
+  // Adds or replaces an attribute, within the byte budget.
+  void AddAttributeLocked(absl::string_view key, AttributeValueRef value)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns how many bytes can be added once 'freed' bytes are released by
+  // the addition, e.g. because it evicts an older event.
+  size_t AvailableBytes(size_t freed) const EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Records that 'added' bytes replaced 'freed' bytes.
+  void UpdateBytes(size_t freed, size_t added) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    bytes_ = bytes_ - freed + added;
+  }
+
   mutable absl::Mutex mu_;
   // The start time of the span.
   const absl::Time start_time_;
@@ -129,14 +184,36 @@ class SpanImpl final {
   // Queue of recorded network events.
   TraceEvents<EventWithTime<exporter::MessageEvent>> message_events_
       GUARDED_BY(mu_);
+  // Totals over all network events, including the ones dropped from
+  // message_events_.
+  exporter::SpanData::MessageEventSummary message_event_summary_
+      GUARDED_BY(mu_);
   // Queue of recorded links to parent and child spans.
   TraceEvents<exporter::Link> links_ GUARDED_BY(mu_);
   // Set of recorded attributes.
   AttributeList attributes_ GUARDED_BY(mu_);
+  // The byte budget for the span's contents, from
+  // TraceParams::max_span_bytes. 0 means no limit.
+  const uint32_t max_bytes_;
+  // The approximate number of bytes held by the attributes, annotations,
+  // message events, links, and status message. Kept whether or not there is
+  // a budget, for MemoryUsage().
+  size_t bytes_ GUARDED_BY(mu_) = 0;
+  // The number of strings truncated to fit in the budget.
+  int num_strings_truncated_ GUARDED_BY(mu_) = 0;
   // Marks if the span has ended.
   bool has_ended_ GUARDED_BY(mu_);
+  // Marks if the span was ended by ForceEnd() rather than by its owner.
+  bool force_ended_ GUARDED_BY(mu_) = false;
   // True if the parent Span is in a different process.
   const bool remote_parent_;
+  // The thread that started the span.
+  const uint64_t start_thread_id_;
+  // The starting thread's usage at start, if recording CPU usage.
+  const std::unique_ptr<const CpuUsage> start_cpu_usage_;
+  // The usage between start and End(), if it was recorded.
+  absl::Duration cpu_time_ GUARDED_BY(mu_);
+  bool has_cpu_time_ GUARDED_BY(mu_) = false;
 };
 
 }  // namespace trace
@@ -0,0 +1,106 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "opencensus/common/internal/memory_account.h"
+#include "opencensus/trace/exporter/running_span_store.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/span_exporter.h"
+#include "opencensus/trace/internal/span_exporter_impl.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+
+namespace opencensus {
+namespace trace {
+namespace {
+
+using ::opencensus::common::MemoryAccount;
+
+MemoryAccount::Usage GetUsage(absl::string_view component) {
+  for (const auto& usage : MemoryAccount::GetAll()) {
+    if (usage.component == component) return usage;
+  }
+  return MemoryAccount::Usage();
+}
+
+std::atomic<int> num_exported(0);
+
+class CountingHandler : public exporter::SpanExporter::Handler {
+ public:
+  void Export(const std::vector<exporter::SpanData>& spans) override {
+    num_exported += spans.size();
+  }
+};
+
+// Runs as a single test, since handlers can't be unregistered and the stores
+// are global.
+TEST(SpanMemoryTest, StoresAccountForSpans) {
+  exporter::RunningSpanStore::Enable();
+  AlwaysSampler sampler;
+
+  auto running = Span::StartSpan("Running", nullptr, {&sampler});
+  const auto running_usage = GetUsage("trace/running_span_store");
+  EXPECT_EQ(1, running_usage.entries);
+  EXPECT_LT(static_cast<int64_t>(sizeof(exporter::SpanData)),
+            running_usage.bytes());
+
+  running.AddAnnotation(std::string(1000, 'x'));
+  running.End();
+  EXPECT_EQ(0, GetUsage("trace/running_span_store").entries);
+  EXPECT_EQ(0, GetUsage("trace/running_span_store").bytes());
+
+  // With no handler, ended spans wait in the exporter's queue.
+  const auto queue_usage = GetUsage("trace/span_exporter_queue");
+  EXPECT_EQ(1, queue_usage.entries);
+  EXPECT_LT(1000, queue_usage.data_bytes);
+
+  // The local store keeps the span and its name.
+  const auto local_usage = GetUsage("trace/local_span_store");
+  EXPECT_EQ(1, local_usage.entries);
+  EXPECT_LT(0, local_usage.key_bytes);
+  EXPECT_LT(1000, local_usage.data_bytes);
+  auto other = Span::StartSpan("Running", nullptr, {&sampler});
+  other.End();
+  EXPECT_EQ(2, GetUsage("trace/local_span_store").entries);
+  EXPECT_EQ(local_usage.key_bytes,
+            GetUsage("trace/local_span_store").key_bytes);
+
+  // Fill the export buffer so the worker exports right away, and check that
+  // the queue's account is emptied.
+  exporter::SpanExporter::RegisterHandler(absl::make_unique<CountingHandler>());
+  const int num_spans = exporter::SpanExporterImpl::kDefaultBufferSize;
+  for (int i = 2; i < num_spans; ++i) {
+    Span::StartSpan("Exported", nullptr, {&sampler}).End();
+  }
+  const absl::Time deadline = absl::Now() + absl::Seconds(10);
+  while (num_exported < num_spans && absl::Now() < deadline) {
+    absl::SleepFor(absl::Milliseconds(10));
+  }
+  ASSERT_EQ(num_spans, num_exported);
+  EXPECT_EQ(0, GetUsage("trace/span_exporter_queue").entries);
+  EXPECT_EQ(0, GetUsage("trace/span_exporter_queue").bytes());
+}
+
+}  // namespace
+}  // namespace trace
+}  // namespace opencensus
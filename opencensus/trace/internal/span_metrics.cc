@@ -0,0 +1,141 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/span_metrics.h"
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "opencensus/stats/stats.h"
+#include "opencensus/trace/internal/span_end_hook.h"
+#include "opencensus/trace/status_code.h"
+
+namespace opencensus {
+namespace trace {
+
+namespace {
+
+constexpr char kLatencyMeasureName[] = "opencensus.io/trace/span_latency";
+constexpr char kCpuTimeMeasureName[] = "opencensus.io/trace/span_cpu_time";
+constexpr char kSpanNameKey[] = "span_name";
+constexpr char kStatusKey[] = "status";
+
+// Latency buckets in milliseconds, also used for CPU time.
+stats::BucketBoundaries LatencyBuckets() {
+  return stats::BucketBoundaries::Explicit(
+      {0,   0.01, 0.05, 0.1,  0.3,  0.6,  0.8,   1,     2,     3,    4,
+       5,   6,    8,    10,   13,   16,   20,    25,    30,    40,   50,
+       65,  80,   100,  130,  160,  200,  250,   300,   400,   500,  650,
+       800, 1000, 2000, 5000, 10000, 20000, 50000, 100000});
+}
+
+void RecordSpan(const SpanEndHook::EndedSpan& span) {
+  const double latency_ms = absl::ToDoubleMilliseconds(span.latency);
+  const absl::string_view status = StatusCodeToString(span.status);
+  if (span.has_cpu_time) {
+    stats::Record({{SpanMetrics::LatencyMeasure(), latency_ms},
+                   {SpanMetrics::CpuTimeMeasure(),
+                    absl::ToDoubleMilliseconds(span.cpu_time)}},
+                  {{kSpanNameKey, span.name}, {kStatusKey, status}});
+  } else {
+    stats::Record({{SpanMetrics::LatencyMeasure(), latency_ms}},
+                  {{kSpanNameKey, span.name}, {kStatusKey, status}});
+  }
+}
+
+}  // namespace
+
+// static
+void SpanMetrics::Enable() {
+  LatencyMeasure();
+  CpuTimeMeasure();
+  stats::StatsExporter::AddView(LatencyView());
+  stats::StatsExporter::AddView(CountView());
+  stats::StatsExporter::AddView(CpuTimeView());
+  SpanEndHook::Set(&RecordSpan);
+}
+
+// static
+void SpanMetrics::Disable() { SpanEndHook::Set(nullptr); }
+
+// static
+stats::MeasureDouble SpanMetrics::LatencyMeasure() {
+  static const stats::MeasureDouble measure =
+      stats::MeasureRegistry::RegisterDouble(
+          kLatencyMeasureName, "ms", "Latency of ended spans.");
+  return measure;
+}
+
+// static
+stats::MeasureDouble SpanMetrics::CpuTimeMeasure() {
+  static const stats::MeasureDouble measure =
+      stats::MeasureRegistry::RegisterDouble(
+          kCpuTimeMeasureName, "ms",
+          "CPU time of ended spans that record CPU usage.");
+  return measure;
+}
+
+// static
+const stats::ViewDescriptor& SpanMetrics::LatencyView() {
+  static const stats::ViewDescriptor* descriptor =
+      new stats::ViewDescriptor(
+          stats::ViewDescriptor()
+              .set_name("opencensus.io/trace/span_latency_distribution")
+              .set_measure(kLatencyMeasureName)
+              .set_aggregation(
+                  stats::Aggregation::Distribution(LatencyBuckets()))
+              .set_aggregation_window(stats::AggregationWindow::Cumulative())
+              .add_column(kSpanNameKey)
+              .add_column(kStatusKey)
+              .set_description(
+                  "Distribution of span latency in milliseconds, by span name "
+                  "and status."));
+  return *descriptor;
+}
+
+// static
+const stats::ViewDescriptor& SpanMetrics::CountView() {
+  static const stats::ViewDescriptor* descriptor =
+      new stats::ViewDescriptor(
+          stats::ViewDescriptor()
+              .set_name("opencensus.io/trace/span_count")
+              .set_measure(kLatencyMeasureName)
+              .set_aggregation(stats::Aggregation::Count())
+              .set_aggregation_window(stats::AggregationWindow::Cumulative())
+              .add_column(kSpanNameKey)
+              .add_column(kStatusKey)
+              .set_description(
+                  "Number of ended spans, by span name and status."));
+  return *descriptor;
+}
+
+// static
+const stats::ViewDescriptor& SpanMetrics::CpuTimeView() {
+  static const stats::ViewDescriptor* descriptor =
+      new stats::ViewDescriptor(
+          stats::ViewDescriptor()
+              .set_name("opencensus.io/trace/span_cpu_time_distribution")
+              .set_measure(kCpuTimeMeasureName)
+              .set_aggregation(
+                  stats::Aggregation::Distribution(LatencyBuckets()))
+              .set_aggregation_window(stats::AggregationWindow::Cumulative())
+              .add_column(kSpanNameKey)
+              .add_column(kStatusKey)
+              .set_description(
+                  "Distribution of span CPU time in milliseconds, by span "
+                  "name and status, for spans that record CPU usage."));
+  return *descriptor;
+}
+
+}  // namespace trace
+}  // namespace opencensus
@@ -0,0 +1,85 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/span_metrics.h"
+
+#include "gtest/gtest.h"
+#include "opencensus/stats/stats.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+#include "opencensus/trace/status_code.h"
+
+namespace opencensus {
+namespace trace {
+namespace {
+
+TEST(SpanMetricsTest, RecordsEveryRecordingSpan) {
+  SpanMetrics::Enable();
+  stats::View latency_view(SpanMetrics::LatencyView());
+  stats::View count_view(SpanMetrics::CountView());
+  ASSERT_TRUE(latency_view.IsValid());
+  ASSERT_TRUE(count_view.IsValid());
+
+  AlwaysSampler always;
+  NeverSampler never;
+  for (int i = 0; i < 3; ++i) {
+    auto span = Span::StartSpan("Sampled", nullptr, {&always});
+    span.End();
+  }
+  // Recorded but not sampled for export.
+  auto unsampled = Span::StartSpan("Unsampled", nullptr,
+                                   {&never, /*record_events=*/true});
+  unsampled.SetStatus(StatusCode::NOT_FOUND, "missing");
+  unsampled.End();
+  // Ending a span again doesn't record it again.
+  unsampled.End();
+  // Not recorded at all.
+  auto blank = Span::StartSpan("Blank", nullptr, {&never});
+  blank.End();
+
+  const auto counts = count_view.GetData().int_data();
+  EXPECT_EQ(2, counts.size());
+  EXPECT_EQ(3, counts.at({"Sampled", "OK"}));
+  EXPECT_EQ(1, counts.at({"Unsampled", "NOT_FOUND"}));
+  const auto latencies = latency_view.GetData().distribution_data();
+  EXPECT_EQ(3, latencies.at({"Sampled", "OK"}).count());
+  EXPECT_LE(0, latencies.at({"Sampled", "OK"}).mean());
+
+  SpanMetrics::Disable();
+  auto after = Span::StartSpan("Sampled", nullptr, {&always});
+  after.End();
+  EXPECT_EQ(3, count_view.GetData().int_data().at({"Sampled", "OK"}));
+}
+
+TEST(SpanMetricsTest, RecordsCpuTime) {
+  SpanMetrics::Enable();
+  stats::View cpu_time_view(SpanMetrics::CpuTimeView());
+  ASSERT_TRUE(cpu_time_view.IsValid());
+
+  AlwaysSampler always;
+  auto measured = Span::StartSpan(
+      "Measured", nullptr, {&always, false, {}, /*record_cpu_usage=*/true});
+  measured.End();
+  auto unmeasured = Span::StartSpan("Unmeasured", nullptr, {&always});
+  unmeasured.End();
+  SpanMetrics::Disable();
+
+  const auto data = cpu_time_view.GetData().distribution_data();
+  ASSERT_EQ(1, data.size());
+  EXPECT_EQ(1, data.at({"Measured", "OK"}).count());
+}
+
+}  // namespace
+}  // namespace trace
+}  // namespace opencensus
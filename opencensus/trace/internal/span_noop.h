@@ -0,0 +1,83 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_INTERNAL_SPAN_NOOP_H_
+#define OPENCENSUS_TRACE_INTERNAL_SPAN_NOOP_H_
+
+// Inline no-op definitions of the Span API, used instead of span.cc in builds
+// with --define opencensus_noop=true. Every Span is blank, so instrumentation
+// compiles down to nothing. Included by span.h; don't include directly.
+
+#include "absl/strings/string_view.h"
+#include "opencensus/trace/span.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/status_code.h"
+
+namespace opencensus {
+namespace trace {
+
+inline Span::Span(const SpanContext& context, SpanImpl* /*impl*/)
+    : context_(context) {}
+
+inline Span Span::BlankSpan() { return Span(); }
+
+inline Span Span::StartSpan(absl::string_view /*name*/,
+                            const Span* /*parent*/,
+                            const StartSpanOptions& /*options*/) {
+  return Span();
+}
+
+inline Span Span::StartSpanWithRemoteParent(
+    absl::string_view /*name*/, const SpanContext& /*parent_ctx*/,
+    const StartSpanOptions& /*options*/) {
+  return Span();
+}
+
+inline void Span::AddAttribute(absl::string_view /*key*/,
+                               AttributeValueRef /*attribute*/) {}
+
+inline void Span::AddAttributes(AttributesRef /*attributes*/) {}
+
+inline void Span::AddAnnotation(absl::string_view /*description*/,
+                                AttributesRef /*attributes*/) {}
+
+inline void Span::AddSentMessageEvent(
+    uint32_t /*message_id*/, uint32_t /*compressed_message_size*/,
+    uint32_t /*uncompressed_message_size*/) {}
+
+inline void Span::AddReceivedMessageEvent(
+    uint32_t /*message_id*/, uint32_t /*compressed_message_size*/,
+    uint32_t /*uncompressed_message_size*/) {}
+
+inline void Span::AddParentLink(const SpanContext& /*parent_ctx*/,
+                                AttributesRef /*attributes*/) {}
+
+inline void Span::AddChildLink(const SpanContext& /*child_ctx*/,
+                               AttributesRef /*attributes*/) {}
+
+inline void Span::SetStatus(StatusCode /*canonical_code*/,
+                            absl::string_view /*message*/) {}
+
+inline void Span::End() {}
+
+inline const SpanContext& Span::context() const { return context_; }
+
+inline bool Span::IsSampled() const { return false; }
+
+inline bool Span::IsRecording() const { return false; }
+
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_INTERNAL_SPAN_NOOP_H_
@@ -0,0 +1,104 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/exporter/span_processors.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "opencensus/common/internal/utf8.h"
+#include "opencensus/trace/attribute_value_ref.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/span_data.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+namespace {
+
+std::vector<std::string> SortedUnique(std::vector<std::string> strings) {
+  std::sort(strings.begin(), strings.end());
+  strings.erase(std::unique(strings.begin(), strings.end()), strings.end());
+  return strings;
+}
+
+}  // namespace
+
+DropSpansProcessor::DropSpansProcessor(const std::vector<std::string>& names)
+    : names_(SortedUnique(names)) {}
+
+bool DropSpansProcessor::Process(SpanData* span) {
+  // Searched by string_view, so that no string is built per span.
+  const absl::string_view name = span->name();
+  const auto it =
+      std::lower_bound(names_.begin(), names_.end(), name,
+                       [](const std::string& a, absl::string_view b) {
+                         return absl::string_view(a) < b;
+                       });
+  return it == names_.end() || absl::string_view(*it) != name;
+}
+
+DropAttributesProcessor::DropAttributesProcessor(
+    const std::vector<std::string>& keys)
+    : keys_(keys) {}
+
+bool DropAttributesProcessor::Process(SpanData* span) {
+  auto* attributes = span->mutable_attributes();
+  int num_dropped = 0;
+  for (const auto& key : keys_) {
+    num_dropped += attributes->erase(key);
+  }
+  if (num_dropped > 0) {
+    span->set_num_attributes_dropped(span->num_attributes_dropped() +
+                                     num_dropped);
+  }
+  return true;
+}
+
+TruncateAttributesProcessor::TruncateAttributesProcessor(size_t max_length)
+    : max_length_(max_length) {}
+
+bool TruncateAttributesProcessor::Process(SpanData* span) {
+  for (auto& attribute : *span->mutable_attributes()) {
+    AttributeValue& value = attribute.second;
+    if (value.type() != AttributeValue::Type::kString ||
+        value.string_value().size() <= max_length_) {
+      continue;
+    }
+    value = AttributeValue(AttributeValueRef(
+        common::Utf8Prefix(value.string_value(), max_length_)));
+  }
+  return true;
+}
+
+CapAnnotationsProcessor::CapAnnotationsProcessor(size_t max_annotations)
+    : max_annotations_(max_annotations) {}
+
+bool CapAnnotationsProcessor::Process(SpanData* span) {
+  auto* annotations = span->mutable_annotations();
+  auto* events = annotations->mutable_events();
+  if (events->size() <= max_annotations_) return true;
+  const size_t num_dropped = events->size() - max_annotations_;
+  events->erase(events->begin(), events->begin() + num_dropped);
+  annotations->set_dropped_events_count(annotations->dropped_events_count() +
+                                        num_dropped);
+  return true;
+}
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
@@ -0,0 +1,121 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/exporter/span_processors.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "opencensus/trace/attribute_value_ref.h"
+#include "opencensus/trace/exporter/annotation.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/link.h"
+#include "opencensus/trace/exporter/message_event.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/status.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_id.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+namespace {
+
+constexpr uint8_t trace_id[] = {1, 2,  3,  4,  5,  6,  7,  8,
+                                9, 10, 11, 12, 13, 14, 15, 16};
+constexpr uint8_t span_id[] = {1, 0, 0, 0, 0, 0, 0, 1};
+
+AttributeValue Value(AttributeValueRef ref) { return AttributeValue(ref); }
+
+SpanData MakeSpan(absl::string_view name,
+                  std::unordered_map<std::string, AttributeValue> attributes,
+                  int num_annotations) {
+  const absl::Time start = absl::FromUnixSeconds(1500000000);
+  std::vector<SpanData::TimeEvent<Annotation>> annotations;
+  for (int i = 0; i < num_annotations; ++i) {
+    annotations.emplace_back(start + absl::Seconds(i),
+                             Annotation(std::to_string(i)));
+  }
+  return SpanData(
+      name, SpanContext(TraceId(trace_id), SpanId(span_id)), SpanId(),
+      SpanData::TimeEvents<Annotation>(std::move(annotations), 1),
+      SpanData::TimeEvents<MessageEvent>({}, 0), std::vector<Link>(), 0,
+      std::move(attributes), 2, /*has_ended=*/true, start,
+      start + absl::Seconds(10), Status(), /*has_remote_parent=*/false);
+}
+
+TEST(SpanProcessorsTest, DropSpans) {
+  DropSpansProcessor processor({"/healthz", "/varz"});
+  SpanData healthz = MakeSpan("/healthz", {}, 0);
+  SpanData rpc = MakeSpan("Service.Method", {}, 0);
+  EXPECT_FALSE(processor.Process(&healthz));
+  EXPECT_TRUE(processor.Process(&rpc));
+}
+
+TEST(SpanProcessorsTest, DropAttributes) {
+  DropAttributesProcessor processor({"password", "token", "absent"});
+  SpanData span = MakeSpan("Span",
+                           {{"password", Value("hunter2")},
+                            {"token", Value(12345)},
+                            {"user", Value("alice")}},
+                           0);
+  EXPECT_TRUE(processor.Process(&span));
+  ASSERT_EQ(1, span.attributes().size());
+  EXPECT_EQ("alice", span.attributes().at("user").string_value());
+  EXPECT_EQ(4, span.num_attributes_dropped());
+}
+
+TEST(SpanProcessorsTest, TruncateAttributes) {
+  TruncateAttributesProcessor processor(4);
+  SpanData span = MakeSpan("Span",
+                           {{"short", Value("abcd")},
+                            {"long", Value("abcdef")},
+                            // "a" followed by two 2-byte characters.
+                            {"utf8", Value("a\xC3\xA9\xC3\xA9")},
+                            {"int", Value(123456789)}},
+                           0);
+  EXPECT_TRUE(processor.Process(&span));
+  EXPECT_EQ("abcd", span.attributes().at("short").string_value());
+  EXPECT_EQ("abcd", span.attributes().at("long").string_value());
+  EXPECT_EQ("a\xC3\xA9", span.attributes().at("utf8").string_value());
+  EXPECT_EQ(123456789, span.attributes().at("int").int_value());
+  EXPECT_EQ(2, span.num_attributes_dropped());
+}
+
+TEST(SpanProcessorsTest, CapAnnotations) {
+  CapAnnotationsProcessor processor(2);
+  SpanData span = MakeSpan("Span", {}, 5);
+  EXPECT_TRUE(processor.Process(&span));
+  const auto& events = span.annotations().events();
+  ASSERT_EQ(2, events.size());
+  EXPECT_EQ("3", events[0].event().description());
+  EXPECT_EQ("4", events[1].event().description());
+  EXPECT_EQ(4, span.annotations().dropped_events_count());
+
+  SpanData small = MakeSpan("Span", {}, 1);
+  EXPECT_TRUE(processor.Process(&small));
+  EXPECT_EQ(1, small.annotations().events().size());
+  EXPECT_EQ(1, small.annotations().dropped_events_count());
+}
+
+}  // namespace
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
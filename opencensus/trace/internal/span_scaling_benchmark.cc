@@ -0,0 +1,316 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks for how tracing scales: with threads, with sampling, with the
+// amount of data on a span, with a registered exporter, and with the local
+// and running span stores being queried while spans churn. See
+// span_benchmark.cc for single-threaded costs of the individual Span methods.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "opencensus/trace/exporter/local_span_store.h"
+#include "opencensus/trace/exporter/running_span_store.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/span_exporter.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+
+namespace opencensus {
+namespace trace {
+namespace {
+
+// How the spans in a benchmark are sampled, passed as an Arg.
+enum SamplingMode {
+  kNeverSampled = 0,
+  kNeverSampledRecordEvents = 1,  // Not exported, but still recorded.
+  kAlwaysSampled = 2,
+};
+
+StartSpanOptions OptionsFor(int mode) {
+  static AlwaysSampler always_sampler;
+  static NeverSampler never_sampler;
+  switch (mode) {
+    case kNeverSampled:
+      return {&never_sampler};
+    case kNeverSampledRecordEvents:
+      return {&never_sampler, /*record_events=*/true};
+    default:
+      return {&always_sampler};
+  }
+}
+
+const char* LabelFor(int mode) {
+  switch (mode) {
+    case kNeverSampled:
+      return "unsampled";
+    case kNeverSampledRecordEvents:
+      return "unsampled_recording";
+    default:
+      return "sampled";
+  }
+}
+
+void BM_StartEndSpanThreads(benchmark::State& state) {
+  const StartSpanOptions options = OptionsFor(state.range(0));
+  while (state.KeepRunning()) {
+    auto span = Span::StartSpan("SpanName", /*parent=*/nullptr, options);
+    span.End();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(LabelFor(state.range(0)));
+}
+BENCHMARK(BM_StartEndSpanThreads)
+    ->Arg(kNeverSampled)
+    ->Arg(kNeverSampledRecordEvents)
+    ->Arg(kAlwaysSampled)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+// A root span with a child per iteration, so that the child's sampling
+// decision is inherited from the parent instead of made by a Sampler.
+void BM_StartEndChildSpanThreads(benchmark::State& state) {
+  const StartSpanOptions options = OptionsFor(state.range(0));
+  auto root = Span::StartSpan("Root", /*parent=*/nullptr, options);
+  while (state.KeepRunning()) {
+    auto span = Span::StartSpan("SpanName", &root);
+    span.End();
+  }
+  root.End();
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(LabelFor(state.range(0)));
+}
+BENCHMARK(BM_StartEndChildSpanThreads)
+    ->Arg(kNeverSampled)
+    ->Arg(kAlwaysSampled)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+// A span that looks like a server RPC: range(0) attributes, range(1)
+// annotations, and a sent and a received message event.
+void BM_StartEndRealisticSpan(benchmark::State& state) {
+  const int num_attributes = state.range(0);
+  const int num_annotations = state.range(1);
+  const StartSpanOptions options = OptionsFor(kAlwaysSampled);
+  std::vector<std::string> keys;
+  for (int i = 0; i < num_attributes; ++i) {
+    keys.push_back(absl::StrCat("attribute", i));
+  }
+  while (state.KeepRunning()) {
+    auto span = Span::StartSpan("Service.Method", /*parent=*/nullptr, options);
+    for (int i = 0; i < num_attributes; ++i) {
+      if (i % 2 == 0) {
+        span.AddAttribute(keys[i], "some string value");
+      } else {
+        span.AddAttribute(keys[i], i);
+      }
+    }
+    span.AddReceivedMessageEvent(1, 1800, 4000);
+    for (int i = 0; i < num_annotations; ++i) {
+      span.AddAnnotation("Did something.", {{"count", i}});
+    }
+    span.AddSentMessageEvent(1, 120, 260);
+    span.End();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StartEndRealisticSpan)
+    ->ArgPair(0, 0)
+    ->ArgPair(4, 1)
+    ->ArgPair(8, 4)
+    ->ArgPair(32, 16)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+// Starts and ends spans on background threads until destroyed. Each thread
+// keeps kOpenSpans spans running, ending the oldest whenever it starts a new
+// one, so RunningSpanStore always has spans to report.
+class SpanChurn {
+ public:
+  static constexpr int kOpenSpans = 16;
+
+  explicit SpanChurn(int num_threads) {
+    for (int i = 0; i < num_threads; ++i) {
+      threads_.emplace_back([this, i]() { Run(i); });
+    }
+  }
+
+  ~SpanChurn() {
+    done_ = true;
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  int64_t num_spans() const { return num_spans_.load(); }
+
+ private:
+  void Run(int thread) {
+    static AlwaysSampler sampler;
+    const std::string names[] = {absl::StrCat("Churn", thread % 4),
+                                 absl::StrCat("Churn", thread % 4, ".Child")};
+    // Span isn't assignable, so the slots hold pointers.
+    std::vector<std::unique_ptr<Span>> spans;
+    for (int i = 0; i < kOpenSpans; ++i) {
+      spans.push_back(absl::make_unique<Span>(
+          Span::StartSpan(names[0], /*parent=*/nullptr, {&sampler})));
+    }
+    for (int i = 0; !done_.load(std::memory_order_relaxed); ++i) {
+      std::unique_ptr<Span>& slot = spans[i % kOpenSpans];
+      auto child = Span::StartSpan(names[1], slot.get());
+      child.AddAttribute("key", i);
+      child.End();
+      slot->End();
+      slot = absl::make_unique<Span>(
+          Span::StartSpan(names[0], /*parent=*/nullptr, {&sampler}));
+      num_spans_.fetch_add(2, std::memory_order_relaxed);
+    }
+    for (auto& span : spans) {
+      span->End();
+    }
+  }
+
+  std::atomic<bool> done_{false};
+  std::atomic<int64_t> num_spans_{0};
+  std::vector<std::thread> threads_;
+};
+
+constexpr int SpanChurn::kOpenSpans;
+
+// Queries race with range(0) churning threads. The "churned" counter shows how
+// far span throughput drops while the store is being read.
+void BM_LocalSpanStoreGetSummaryWithChurn(benchmark::State& state) {
+  SpanChurn churn(state.range(0));
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(exporter::LocalSpanStore::GetSummary());
+  }
+  state.counters["churned"] =
+      benchmark::Counter(churn.num_spans(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_LocalSpanStoreGetSummaryWithChurn)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16)
+    ->UseRealTime();
+
+void BM_LocalSpanStoreGetSpansWithChurn(benchmark::State& state) {
+  SpanChurn churn(state.range(0));
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(exporter::LocalSpanStore::GetSpans());
+  }
+  state.counters["churned"] =
+      benchmark::Counter(churn.num_spans(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_LocalSpanStoreGetSpansWithChurn)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16)
+    ->UseRealTime();
+
+void BM_RunningSpanStoreGetSummaryWithChurn(benchmark::State& state) {
+  exporter::RunningSpanStore::Enable();
+  {
+    SpanChurn churn(state.range(0));
+    while (state.KeepRunning()) {
+      benchmark::DoNotOptimize(exporter::RunningSpanStore::GetSummary());
+    }
+    state.counters["churned"] =
+        benchmark::Counter(churn.num_spans(), benchmark::Counter::kIsRate);
+  }
+  exporter::RunningSpanStore::Disable();
+}
+BENCHMARK(BM_RunningSpanStoreGetSummaryWithChurn)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16)
+    ->UseRealTime();
+
+void BM_RunningSpanStoreGetRunningSpansWithChurn(benchmark::State& state) {
+  exporter::RunningSpanStore::Enable();
+  {
+    SpanChurn churn(state.range(0));
+    while (state.KeepRunning()) {
+      benchmark::DoNotOptimize(exporter::RunningSpanStore::GetRunningSpans(
+          {"Churn0", /*max_spans_to_return=*/100}));
+    }
+    state.counters["churned"] =
+        benchmark::Counter(churn.num_spans(), benchmark::Counter::kIsRate);
+  }
+  exporter::RunningSpanStore::Disable();
+}
+BENCHMARK(BM_RunningSpanStoreGetRunningSpansWithChurn)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16)
+    ->UseRealTime();
+
+// Span churn alone, with RunningSpanStore enabled and no one querying it, as
+// the baseline for the "churned" counters above.
+void BM_ChurnWithRunningSpanStore(benchmark::State& state) {
+  if (state.thread_index() == 0) exporter::RunningSpanStore::Enable();
+  const StartSpanOptions options = OptionsFor(kAlwaysSampled);
+  while (state.KeepRunning()) {
+    auto span = Span::StartSpan("SpanName", /*parent=*/nullptr, options);
+    span.End();
+  }
+  if (state.thread_index() == 0) exporter::RunningSpanStore::Disable();
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ChurnWithRunningSpanStore)->ThreadRange(1, 16)->UseRealTime();
+
+class NoopHandler : public exporter::SpanExporter::Handler {
+ public:
+  void Export(const std::vector<exporter::SpanData>& spans) override {
+    benchmark::DoNotOptimize(spans.data());
+  }
+};
+
+// Handlers can't be unregistered, so this has to run last: with a handler,
+// every sampled span is also buffered and converted to SpanData by the export
+// thread, which competes with the benchmark threads for the buffer's lock.
+void BM_StartEndSpanWithExportHandler(benchmark::State& state) {
+  static bool registered = [] {
+    exporter::SpanExporter::RegisterHandler(absl::make_unique<NoopHandler>());
+    return true;
+  }();
+  benchmark::DoNotOptimize(registered);
+  const StartSpanOptions options = OptionsFor(state.range(0));
+  while (state.KeepRunning()) {
+    auto span = Span::StartSpan("SpanName", /*parent=*/nullptr, options);
+    span.AddAttribute("key", "value");
+    span.End();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(LabelFor(state.range(0)));
+}
+BENCHMARK(BM_StartEndSpanWithExportHandler)
+    ->Arg(kNeverSampled)
+    ->Arg(kAlwaysSampled)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace trace
+}  // namespace opencensus
+BENCHMARK_MAIN();
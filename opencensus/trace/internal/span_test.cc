@@ -15,13 +15,26 @@
 #include "opencensus/trace/span.h"
 
 #include <cstdint>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "gtest/gtest.h"
 #include "opencensus/trace/attribute_value_ref.h"
+#include "opencensus/trace/exporter/annotation.h"
 #include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/message_event.h"
 #include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/status.h"
+#include "opencensus/trace/internal/event_with_time.h"
 #include "opencensus/trace/internal/span_impl.h"
+#include "opencensus/trace/span_context.h"
 #include "opencensus/trace/span_id.h"
+#include "opencensus/trace/status_code.h"
+#include "opencensus/trace/trace_config.h"
 #include "opencensus/trace/trace_id.h"
 #include "opencensus/trace/trace_options.h"
 
@@ -41,6 +54,10 @@ class SpanTestPeer {
   static exporter::SpanData ToSpanData(Span* span) {
     return span->span_impl_for_test()->ToSpanData();
   }
+
+  static size_t MemoryUsage(Span* span) {
+    return span->span_impl_for_test()->MemoryUsage();
+  }
 };
 
 namespace {
@@ -278,7 +295,7 @@ TEST(SpanTest, ChildInheritsTraceOption) {
 TEST(SpanTest, ForceSamplingOnViaTraceConfig) {
   // No sampling requested, but trace_params forces it.
   TraceConfig::SetCurrentTraceParams(
-      TraceParams{32, 32, 128, 128, ProbabilitySampler(1.0)});
+      TraceParams{32, 32, 128, 128, ProbabilitySampler(1.0), 0, 0});
   for (int i = 0; i < 1000; ++i) {
     auto span = Span::StartSpan("SpanName");
     EXPECT_TRUE(span.IsSampled());
@@ -289,7 +306,7 @@ TEST(SpanTest, ForceSamplingOnViaTraceConfig) {
 TEST(SpanTest, ForceSamplingOffViaTraceConfig) {
   // No sampling requested, but trace_params forces it.
   TraceConfig::SetCurrentTraceParams(
-      TraceParams{32, 32, 128, 128, ProbabilitySampler(0.0)});
+      TraceParams{32, 32, 128, 128, ProbabilitySampler(0.0), 0, 0});
   for (int i = 0; i < 1000; ++i) {
     auto span = Span::StartSpan("SpanName");
     EXPECT_FALSE(span.IsSampled());
@@ -297,6 +314,140 @@ TEST(SpanTest, ForceSamplingOffViaTraceConfig) {
   }
 }
 
+TEST(SpanTest, MessageEventSummaryCountsDroppedEvents) {
+  // Keep the first 2 and the last 3 message events.
+  TraceConfig::SetCurrentTraceParams(
+      TraceParams{32, 32, 3, 128, ProbabilitySampler(1e-4), 2, 0});
+  auto span =
+      Span::StartSpan("SpanName", /*parent=*/nullptr, {nullptr, kRecordEvents});
+  for (uint32_t i = 0; i < 1000; ++i) {
+    if (i % 2 == 0) {
+      span.AddSentMessageEvent(i, 10, 20);
+    } else {
+      span.AddReceivedMessageEvent(i, 1, 2);
+    }
+  }
+  span.End();
+  TraceConfig::SetCurrentTraceParams(
+      TraceParams{32, 32, 128, 128, ProbabilitySampler(1e-4), 0, 0});
+  const exporter::SpanData data = SpanTestPeer::ToSpanData(&span);
+
+  const auto& events = data.message_events().events();
+  ASSERT_EQ(5, events.size());
+  const uint32_t expected_ids[] = {0, 1, 997, 998, 999};
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(expected_ids[i], events[i].event().id());
+  }
+  EXPECT_EQ(995, data.message_events().dropped_events_count());
+
+  const auto& summary = data.message_event_summary();
+  EXPECT_EQ(500, summary.num_sent);
+  EXPECT_EQ(500, summary.num_received);
+  EXPECT_EQ(5000, summary.sent_compressed_bytes);
+  EXPECT_EQ(10000, summary.sent_uncompressed_bytes);
+  EXPECT_EQ(500, summary.received_compressed_bytes);
+  EXPECT_EQ(1000, summary.received_uncompressed_bytes);
+  EXPECT_EQ(events[0].timestamp(), summary.first_event_time);
+  EXPECT_EQ(events[4].timestamp(), summary.last_event_time);
+}
+
+TEST(SpanTest, SpanDataSummarizesGivenMessageEvents) {
+  const absl::Time start = absl::FromUnixSeconds(1000);
+  std::vector<exporter::SpanData::TimeEvent<exporter::MessageEvent>> events;
+  events.emplace_back(start, exporter::MessageEvent(
+                                 exporter::MessageEvent::Type::SENT, 1, 3, 4));
+  events.emplace_back(
+      start + absl::Seconds(1),
+      exporter::MessageEvent(exporter::MessageEvent::Type::RECEIVED, 2, 5, 6));
+  const exporter::SpanData data(
+      "Span", SpanContext(), SpanId(),
+      exporter::SpanData::TimeEvents<exporter::Annotation>({}, 0),
+      exporter::SpanData::TimeEvents<exporter::MessageEvent>(std::move(events),
+                                                             0),
+      {}, 0, {}, 0, /*has_ended=*/true, start, start + absl::Seconds(1),
+      exporter::Status(), /*has_remote_parent=*/false);
+  const auto& summary = data.message_event_summary();
+  EXPECT_EQ(1, summary.num_sent);
+  EXPECT_EQ(1, summary.num_received);
+  EXPECT_EQ(3, summary.sent_compressed_bytes);
+  EXPECT_EQ(6, summary.received_uncompressed_bytes);
+  EXPECT_EQ(start, summary.first_event_time);
+  EXPECT_EQ(start + absl::Seconds(1), summary.last_event_time);
+}
+
+TEST(SpanTest, ByteBudgetTruncatesStrings) {
+  TraceConfig::SetCurrentTraceParams(
+      TraceParams{32, 32, 128, 128, ProbabilitySampler(1e-4), 0, 1000});
+  auto span =
+      Span::StartSpan("SpanName", /*parent=*/nullptr, {nullptr, kRecordEvents});
+  std::string value;
+  for (int i = 0; i < 1000; ++i) value.append("\xc3\xa9");  // U+00E9
+  span.AddAttribute("key", value);
+  // The attribute used up the budget.
+  span.AddAnnotation("Annotation");
+  span.AddAttribute("other_key", 1);
+  span.SetStatus(StatusCode::CANCELLED, "message");
+  span.End();
+  TraceConfig::SetCurrentTraceParams(
+      TraceParams{32, 32, 128, 128, ProbabilitySampler(1e-4), 0, 0});
+  const exporter::SpanData data = SpanTestPeer::ToSpanData(&span);
+
+  ASSERT_EQ(1, data.attributes().size());
+  const std::string& truncated = data.attributes().at("key").string_value();
+  EXPECT_LT(0, truncated.size());
+  EXPECT_GT(1000, truncated.size());
+  EXPECT_EQ(0, truncated.size() % 2) << "Split a UTF-8 sequence.";
+  EXPECT_EQ(value.substr(0, truncated.size()), truncated);
+  EXPECT_EQ(1, data.num_attributes_dropped());
+  EXPECT_TRUE(data.annotations().events().empty());
+  EXPECT_EQ(1, data.annotations().dropped_events_count());
+  EXPECT_EQ(StatusCode::CANCELLED, data.status().CanonicalCode());
+  // At most what the UTF-8 backoff left over.
+  EXPECT_GT(2, data.status().error_message().size());
+  EXPECT_EQ(2, data.num_strings_truncated());
+}
+
+TEST(SpanTest, ByteBudgetCreditsEvictedEvents) {
+  // Room for exactly 2 message events.
+  TraceConfig::SetCurrentTraceParams(TraceParams{
+      32, 32, 2, 128, ProbabilitySampler(1e-4), 0,
+      2 * sizeof(EventWithTime<exporter::MessageEvent>)});
+  auto span =
+      Span::StartSpan("SpanName", /*parent=*/nullptr, {nullptr, kRecordEvents});
+  for (uint32_t i = 0; i < 10; ++i) {
+    span.AddSentMessageEvent(i, 1, 2);
+  }
+  span.End();
+  TraceConfig::SetCurrentTraceParams(
+      TraceParams{32, 32, 128, 128, ProbabilitySampler(1e-4), 0, 0});
+  const exporter::SpanData data = SpanTestPeer::ToSpanData(&span);
+
+  // Each event evicted the oldest one, freeing its bytes for the next.
+  const auto& events = data.message_events().events();
+  ASSERT_EQ(2, events.size());
+  EXPECT_EQ(8, events[0].event().id());
+  EXPECT_EQ(9, events[1].event().id());
+  EXPECT_EQ(8, data.message_events().dropped_events_count());
+  EXPECT_EQ(10, data.message_event_summary().num_sent);
+  EXPECT_EQ(0, data.num_strings_truncated());
+}
+
+TEST(SpanTest, MemoryUsageIsTrackedWithoutByteBudget) {
+  auto span =
+      Span::StartSpan("SpanName", /*parent=*/nullptr, {nullptr, kRecordEvents});
+  const size_t empty = SpanTestPeer::MemoryUsage(&span);
+  const std::string value(1000, 'x');
+  span.AddAttribute("key", value);
+  EXPECT_LE(empty + value.size(), SpanTestPeer::MemoryUsage(&span));
+  // Replacing the attribute gives its bytes back.
+  span.AddAttribute("key", 1);
+  const size_t with_attribute = SpanTestPeer::MemoryUsage(&span);
+  EXPECT_GT(empty + value.size(), with_attribute);
+  span.AddAnnotation(value);
+  EXPECT_LE(with_attribute + value.size(), SpanTestPeer::MemoryUsage(&span));
+  span.End();
+}
+
 TEST(SpanTest, CheckSpanData) {
   AlwaysSampler sampler;
   auto current_span = Span::StartSpan("test_span", nullptr, {&sampler});
@@ -324,6 +475,58 @@ TEST(SpanTest, CheckSpanData) {
   EXPECT_EQ(333, attributes.at("test3").int_value());
 }
 
+// Spins for about 'duration' of CPU time.
+void BurnCpu(absl::Duration duration) {
+  const absl::Time deadline = absl::Now() + duration;
+  volatile uint64_t x = 0;
+  while (absl::Now() < deadline) {
+    for (int i = 0; i < 1000; ++i) x = x + i;
+  }
+}
+
+TEST(SpanTest, RecordCpuUsage) {
+  AlwaysSampler sampler;
+  auto span = Span::StartSpan("MySpan", nullptr,
+                              {&sampler, false, {}, /*record_cpu_usage=*/true});
+  BurnCpu(absl::Milliseconds(20));
+  span.End();
+
+  const exporter::SpanData data = SpanTestPeer::ToSpanData(&span);
+  ASSERT_EQ(1, data.attributes().count("thread.cpu_time_ns"));
+  EXPECT_LT(absl::ToInt64Nanoseconds(absl::Milliseconds(5)),
+            data.attributes().at("thread.cpu_time_ns").int_value());
+#ifdef __linux__
+  EXPECT_LE(0, data.attributes()
+                   .at("thread.voluntary_context_switches")
+                   .int_value());
+  EXPECT_LE(0, data.attributes()
+                   .at("thread.involuntary_context_switches")
+                   .int_value());
+#endif
+}
+
+TEST(SpanTest, RecordCpuUsageByName) {
+  AlwaysSampler sampler;
+  TraceConfig::SetCpuUsageSpanNames({"Measured"});
+  auto measured = Span::StartSpan("Measured", nullptr, {&sampler});
+  auto unmeasured = Span::StartSpan("Unmeasured", nullptr, {&sampler});
+  TraceConfig::SetCpuUsageSpanNames({});
+  measured.End();
+  unmeasured.End();
+  EXPECT_EQ(1, SpanTestPeer::ToSpanData(&measured).attributes().count(
+                   "thread.cpu_time_ns"));
+  EXPECT_TRUE(SpanTestPeer::ToSpanData(&unmeasured).attributes().empty());
+}
+
+TEST(SpanTest, NoCpuUsageWhenEndedOnAnotherThread) {
+  AlwaysSampler sampler;
+  auto span = Span::StartSpan("MySpan", nullptr,
+                              {&sampler, false, {}, /*record_cpu_usage=*/true});
+  std::thread t([&span]() { span.End(); });
+  t.join();
+  EXPECT_TRUE(SpanTestPeer::ToSpanData(&span).attributes().empty());
+}
+
 TEST(SpanTest, BlankSpan) {
   auto parent = Span::StartSpan("parent");
   auto span = Span::BlankSpan();
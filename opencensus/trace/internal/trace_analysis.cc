@@ -0,0 +1,197 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/internal/trace_analysis.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/base/internal/endian.h"
+#include "absl/time/time.h"
+#include "opencensus/trace/exporter/local_span_store.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/span_id.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+namespace {
+
+using AnalyzedSpan = LocalSpanStore::AnalyzedSpan;
+using TraceAnalysis = LocalSpanStore::TraceAnalysis;
+
+uint64_t SpanIdKey(const SpanId& span_id) {
+  uint8_t buf[SpanId::kSize];
+  span_id.CopyTo(buf);
+  return absl::little_endian::Load64(buf);
+}
+
+class Analyzer {
+ public:
+  explicit Analyzer(const std::vector<std::shared_ptr<const SpanData>>& spans);
+
+  TraceAnalysis Run();
+
+ private:
+  // Appends spans_[i] and its subtree to the result, parents first.
+  void AddSubtree(int i, int parent_index);
+
+  // Computes self_time for every span in the result.
+  void ComputeSelfTimes();
+
+  // Walks the critical path backwards through spans_[i], starting at time end,
+  // and adds the spans on it to the result.
+  void WalkCriticalPath(int i, absl::Time end);
+
+  const std::vector<std::shared_ptr<const SpanData>>& spans_;
+  // The children of each span, by index in spans_, ordered by start time.
+  std::vector<std::vector<int>> children_;
+  std::vector<int> roots_;
+  // The result index of each span in spans_, or -1 if it isn't in the result.
+  std::vector<int> result_index_;
+  TraceAnalysis result_;
+};
+
+Analyzer::Analyzer(const std::vector<std::shared_ptr<const SpanData>>& spans)
+    : spans_(spans), children_(spans.size()),
+      result_index_(spans.size(), -1) {
+  std::unordered_map<uint64_t, int> index_by_span_id;
+  for (int i = 0; i < spans_.size(); ++i) {
+    index_by_span_id.emplace(SpanIdKey(spans_[i]->context().span_id()), i);
+  }
+  for (int i = 0; i < spans_.size(); ++i) {
+    const SpanId& parent = spans_[i]->parent_span_id();
+    auto it = parent.IsValid() ? index_by_span_id.find(SpanIdKey(parent))
+                               : index_by_span_id.end();
+    if (it == index_by_span_id.end() || it->second == i) {
+      roots_.push_back(i);
+    } else {
+      children_[it->second].push_back(i);
+    }
+  }
+  const auto by_start = [this](int a, int b) {
+    return spans_[a]->start_time() < spans_[b]->start_time();
+  };
+  std::sort(roots_.begin(), roots_.end(), by_start);
+  for (auto& children : children_) {
+    std::sort(children.begin(), children.end(), by_start);
+  }
+}
+
+TraceAnalysis Analyzer::Run() {
+  result_.spans.reserve(spans_.size());
+  for (int root : roots_) {
+    AddSubtree(root, -1);
+  }
+  // Spans in a parent cycle aren't reachable from any root. They can only
+  // come from bad span IDs, so leave them out.
+  ComputeSelfTimes();
+  if (!roots_.empty()) {
+    int last = roots_[0];
+    for (int root : roots_) {
+      if (spans_[root]->end_time() > spans_[last]->end_time()) last = root;
+    }
+    WalkCriticalPath(last, spans_[last]->end_time());
+    std::sort(result_.critical_path.begin(), result_.critical_path.end(),
+              [this](int a, int b) {
+                return result_.spans[a].span->start_time() <
+                       result_.spans[b].span->start_time();
+              });
+  }
+  return std::move(result_);
+}
+
+void Analyzer::AddSubtree(int i, int parent_index) {
+  // Iterative, since traces can be deep.
+  std::vector<std::pair<int, int>> stack = {{i, parent_index}};
+  while (!stack.empty()) {
+    const int span = stack.back().first;
+    const int parent = stack.back().second;
+    stack.pop_back();
+    result_index_[span] = result_.spans.size();
+    result_.spans.push_back(
+        {spans_[span], parent, absl::ZeroDuration(), absl::ZeroDuration()});
+    const auto& children = children_[span];
+    for (auto it = children.rbegin(); it != children.rend(); ++it) {
+      stack.emplace_back(*it, result_index_[span]);
+    }
+  }
+}
+
+void Analyzer::ComputeSelfTimes() {
+  for (int i = 0; i < spans_.size(); ++i) {
+    if (result_index_[i] < 0) continue;
+    const SpanData& span = *spans_[i];
+    // Children are ordered by start time, so their union is a single sweep.
+    absl::Duration covered;
+    absl::Time covered_until = span.start_time();
+    for (int child : children_[i]) {
+      const absl::Time start =
+          std::max(spans_[child]->start_time(), covered_until);
+      const absl::Time end = std::min(spans_[child]->end_time(),
+                                      span.end_time());
+      if (end > start) {
+        covered += end - start;
+        covered_until = end;
+      }
+    }
+    result_.spans[result_index_[i]].self_time =
+        std::max(span.end_time() - span.start_time() - covered,
+                 absl::ZeroDuration());
+  }
+}
+
+void Analyzer::WalkCriticalPath(int i, absl::Time end) {
+  const int index = result_index_[i];
+  result_.critical_path.push_back(index);
+  const absl::Time start = spans_[i]->start_time();
+  std::vector<int> children = children_[i];
+  std::sort(children.begin(), children.end(), [this](int a, int b) {
+    return spans_[a]->end_time() > spans_[b]->end_time();
+  });
+  absl::Time t = end;
+  for (int child : children) {
+    if (t <= start) break;
+    const SpanData& child_span = *spans_[child];
+    // Skip children that ran alongside the path rather than on it.
+    if (child_span.start_time() >= t || child_span.end_time() <= start) {
+      continue;
+    }
+    const absl::Time child_end = std::min(child_span.end_time(), t);
+    result_.spans[index].critical_path_time += t - child_end;
+    // Recursion depth is bounded by the number of spans in the trace, which
+    // the store caps.
+    WalkCriticalPath(child, child_end);
+    t = std::max(child_span.start_time(), start);
+  }
+  if (t > start) {
+    result_.spans[index].critical_path_time += t - start;
+  }
+}
+
+}  // namespace
+
+LocalSpanStore::TraceAnalysis AnalyzeTrace(
+    const std::vector<std::shared_ptr<const SpanData>>& spans) {
+  return Analyzer(spans).Run();
+}
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
@@ -0,0 +1,48 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_INTERNAL_TRACE_ANALYSIS_H_
+#define OPENCENSUS_TRACE_INTERNAL_TRACE_ANALYSIS_H_
+
+#include <memory>
+#include <vector>
+
+#include "opencensus/trace/exporter/local_span_store.h"
+#include "opencensus/trace/exporter/span_data.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+// Arranges the ended spans of one trace into a tree by parent span ID, and
+// computes each span's self time and the trace's critical path.
+//
+// A span whose parent is not among the spans is treated as a root. Children
+// are clipped to their parent's interval, so clock skew between processes can't
+// produce negative times.
+//
+// The critical path is found by walking backwards from the end of the root
+// that ended last: at each point in time, a span is taken to be waiting on the
+// child that ended last before that point, so the path descends into that
+// child and then continues from the child's start time. Time not covered by
+// such a child is credited to the span itself, so the critical_path_time of
+// the spans on the path adds up to the root's duration.
+LocalSpanStore::TraceAnalysis AnalyzeTrace(
+    const std::vector<std::shared_ptr<const SpanData>>& spans);
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_INTERNAL_TRACE_ANALYSIS_H_
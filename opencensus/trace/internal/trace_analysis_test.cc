@@ -0,0 +1,140 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/internal/trace_analysis.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "opencensus/trace/exporter/annotation.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/link.h"
+#include "opencensus/trace/exporter/local_span_store.h"
+#include "opencensus/trace/exporter/message_event.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/status.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_id.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+namespace {
+
+constexpr uint8_t trace_id[] = {1, 2,  3,  4,  5,  6,  7,  8,
+                                9, 10, 11, 12, 13, 14, 15, 16};
+
+SpanId MakeSpanId(uint8_t id) {
+  const uint8_t buf[] = {0, 0, 0, 0, 0, 0, 0, id};
+  return SpanId(buf);
+}
+
+// Returns an ended span that runs from start_ms to end_ms. A parent of 0
+// means no parent.
+std::shared_ptr<const SpanData> MakeSpan(absl::string_view name, uint8_t id,
+                                         uint8_t parent, int start_ms,
+                                         int end_ms) {
+  const absl::Time base = absl::FromUnixSeconds(1500000000);
+  return std::make_shared<const SpanData>(
+      name, SpanContext(TraceId(trace_id), MakeSpanId(id)),
+      parent == 0 ? SpanId() : MakeSpanId(parent),
+      SpanData::TimeEvents<Annotation>({}, 0),
+      SpanData::TimeEvents<MessageEvent>({}, 0), std::vector<Link>(), 0,
+      std::unordered_map<std::string, AttributeValue>(), 0,
+      /*has_ended=*/true, base + absl::Milliseconds(start_ms),
+      base + absl::Milliseconds(end_ms), Status(),
+      /*has_remote_parent=*/false);
+}
+
+TEST(TraceAnalysisTest, BuildsTree) {
+  // Out of order, with a span whose parent is missing.
+  const auto analysis = AnalyzeTrace({
+      MakeSpan("C", 4, 3, 30, 50),
+      MakeSpan("Orphan", 6, 99, 5, 15),
+      MakeSpan("B", 3, 1, 20, 90),
+      MakeSpan("Root", 1, 0, 0, 100),
+      MakeSpan("A", 2, 1, 10, 40),
+  });
+  ASSERT_EQ(5, analysis.spans.size());
+  const char* names[] = {"Root", "A", "B", "C", "Orphan"};
+  const int parents[] = {-1, 0, 0, 2, -1};
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(names[i], analysis.spans[i].span->name());
+    EXPECT_EQ(parents[i], analysis.spans[i].parent_index) << names[i];
+  }
+}
+
+TEST(TraceAnalysisTest, SelfTimeAndCriticalPath) {
+  // Root [0, 100]
+  //   A [10, 40]
+  //   B [20, 90]
+  //     C [30, 50]
+  //     D [60, 95], which outlives its parent.
+  // Orphan [5, 15]
+  const auto analysis = AnalyzeTrace({
+      MakeSpan("Root", 1, 0, 0, 100),
+      MakeSpan("A", 2, 1, 10, 40),
+      MakeSpan("B", 3, 1, 20, 90),
+      MakeSpan("C", 4, 3, 30, 50),
+      MakeSpan("D", 5, 3, 60, 95),
+      MakeSpan("Orphan", 6, 99, 5, 15),
+  });
+  ASSERT_EQ(6, analysis.spans.size());
+  const char* names[] = {"Root", "A", "B", "C", "D", "Orphan"};
+  const int self_ms[] = {20, 30, 20, 20, 35, 10};
+  const int critical_ms[] = {20, 10, 20, 20, 30, 0};
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_EQ(names[i], analysis.spans[i].span->name());
+    EXPECT_EQ(absl::Milliseconds(self_ms[i]), analysis.spans[i].self_time)
+        << names[i];
+    EXPECT_EQ(absl::Milliseconds(critical_ms[i]),
+              analysis.spans[i].critical_path_time)
+        << names[i];
+  }
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4}), analysis.critical_path);
+}
+
+TEST(TraceAnalysisTest, ParallelChildrenOffThePath) {
+  // Two children run in parallel. Only the one that ends last is waited on.
+  const auto analysis = AnalyzeTrace({
+      MakeSpan("Root", 1, 0, 0, 50),
+      MakeSpan("Fast", 2, 1, 12, 20),
+      MakeSpan("Slow", 3, 1, 10, 40),
+  });
+  ASSERT_EQ(3, analysis.spans.size());
+  EXPECT_EQ(absl::Milliseconds(20), analysis.spans[0].self_time);
+  EXPECT_EQ(absl::Milliseconds(20), analysis.spans[0].critical_path_time);
+  ASSERT_EQ("Slow", analysis.spans[1].span->name());
+  EXPECT_EQ(absl::Milliseconds(30), analysis.spans[1].critical_path_time);
+  EXPECT_EQ(absl::ZeroDuration(), analysis.spans[2].critical_path_time);
+  EXPECT_EQ(std::vector<int>({0, 1}), analysis.critical_path);
+}
+
+TEST(TraceAnalysisTest, Empty) {
+  const auto analysis = AnalyzeTrace({});
+  EXPECT_TRUE(analysis.spans.empty());
+  EXPECT_TRUE(analysis.critical_path.empty());
+}
+
+}  // namespace
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
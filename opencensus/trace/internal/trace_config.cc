@@ -13,6 +13,10 @@
 // limitations under the License.
 
 #include "opencensus/trace/trace_config.h"
+
+#include <string>
+#include <vector>
+
 #include "opencensus/trace/internal/trace_config_impl.h"
 #include "opencensus/trace/trace_params.h"
 
@@ -23,5 +27,9 @@ void TraceConfig::SetCurrentTraceParams(const TraceParams& params) {
   TraceConfigImpl::Get()->SetCurrentTraceParams(params);
 }
 
+void TraceConfig::SetCpuUsageSpanNames(const std::vector<std::string>& names) {
+  TraceConfigImpl::Get()->SetCpuUsageSpanNames(names);
+}
+
 }  // namespace trace
 }  // namespace opencensus
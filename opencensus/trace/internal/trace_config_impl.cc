@@ -15,6 +15,11 @@
 #include "opencensus/trace/internal/trace_config_impl.h"
 
 #include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 
 #include "opencensus/trace/sampler.h"
 #include "opencensus/trace/trace_params.h"
@@ -27,12 +32,18 @@ constexpr uint32_t kMaxAttributes = 32;
 constexpr uint32_t kMaxAnnotations = 32;
 constexpr uint32_t kMaxMessageEvents = 128;
 constexpr uint32_t kMaxLinks = 128;
+constexpr uint32_t kMaxInitialMessageEvents = 0;
+constexpr uint32_t kMaxSpanBytes = 0;
 constexpr double kDefaultSamplingProbability = 1e-4;
 
 TraceParams MakeDefaultTraceParams() {
-  return TraceParams{kMaxAttributes, kMaxAnnotations, kMaxMessageEvents,
+  return TraceParams{kMaxAttributes,
+                     kMaxAnnotations,
+                     kMaxMessageEvents,
                      kMaxLinks,
-                     ProbabilitySampler{kDefaultSamplingProbability}};
+                     ProbabilitySampler{kDefaultSamplingProbability},
+                     kMaxInitialMessageEvents,
+                     kMaxSpanBytes};
 }
 }  // namespace
 
@@ -42,5 +53,19 @@ TraceConfigImpl* TraceConfigImpl::Get() {
   return global_trace_params;
 }
 
+void TraceConfigImpl::SetCpuUsageSpanNames(
+    const std::vector<std::string>& names) {
+  absl::MutexLock l(&mu_);
+  cpu_usage_span_names_.clear();
+  cpu_usage_span_names_.insert(names.begin(), names.end());
+  has_cpu_usage_span_names_.store(!names.empty(), std::memory_order_release);
+}
+
+bool TraceConfigImpl::RecordsCpuUsageSlow(absl::string_view name) const {
+  const std::string key(name);
+  absl::MutexLock l(&mu_);
+  return cpu_usage_span_names_.count(key) > 0;
+}
+
 }  // namespace trace
 }  // namespace opencensus
@@ -15,7 +15,15 @@
 #ifndef OPENCENSUS_TRACE_INTERNAL_TRACE_CONFIG_IMPL_H_
 #define OPENCENSUS_TRACE_INTERNAL_TRACE_CONFIG_IMPL_H_
 
+#include <atomic>
 #include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 
 #include "opencensus/trace/internal/trace_params_impl.h"
 #include "opencensus/trace/trace_config.h"
@@ -39,10 +47,28 @@ class TraceConfigImpl {
     return current_trace_params_.Get();
   }
 
+  void SetCpuUsageSpanNames(const std::vector<std::string>& names)
+      LOCKS_EXCLUDED(mu_);
+
+  // Returns true if spans named 'name' should record CPU usage. Cheap when no
+  // names are set.
+  bool RecordsCpuUsage(absl::string_view name) const LOCKS_EXCLUDED(mu_) {
+    if (!has_cpu_usage_span_names_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    return RecordsCpuUsageSlow(name);
+  }
+
  private:
   TraceConfigImpl(const TraceParams& params) : current_trace_params_(params) {}
 
+  bool RecordsCpuUsageSlow(absl::string_view name) const LOCKS_EXCLUDED(mu_);
+
   TraceParamsImpl current_trace_params_;
+
+  mutable absl::Mutex mu_;
+  std::unordered_set<std::string> cpu_usage_span_names_ GUARDED_BY(mu_);
+  std::atomic<bool> has_cpu_usage_span_names_{false};
 };
 
 }  // namespace trace
@@ -36,7 +36,7 @@ TEST(TraceConfigTest, MultiThreaded) {
       n = (n + 1) % (denom + 1);
       TraceConfig::SetCurrentTraceParams(
           {128, 128, 64, 64,
-           ProbabilitySampler(n / static_cast<double>(denom))});
+           ProbabilitySampler(n / static_cast<double>(denom)), 0, 0});
     }
   };
 
@@ -18,18 +18,24 @@
 #include <cstdint>
 #include <deque>
 #include <utility>
+#include <vector>
 
 namespace opencensus {
 namespace trace {
 
 // A fixed size FIFO queue of events of type T.  T must have a valid copy
 // constructor. TraceEvents is thread-compatible.
+//
+// Optionally, the first max_initial_events events are kept aside and never
+// evicted, so that both ends of a long series of events are available.
 template <typename T>
 class TraceEvents final {
  public:
   TraceEvents() : total_recorded_events_(0), max_events_(0) {}
-  explicit TraceEvents(uint32_t max_events)
-      : total_recorded_events_(0), max_events_(max_events) {}
+  explicit TraceEvents(uint32_t max_events, uint32_t max_initial_events = 0)
+      : total_recorded_events_(0),
+        max_events_(max_events),
+        max_initial_events_(max_initial_events) {}
 
   // Returns the number of the dropped events.
   uint32_t num_events_dropped() const;
@@ -38,55 +44,92 @@ class TraceEvents final {
   uint32_t num_events_recorded() const;
 
   // Adds an event to the event queue. If max_events_ is exceeded, an event
-  // will be evicted in a FIFO manner.
-  void AddEvent(const T& event);
-  void AddEvent(T&& event);
+  // will be evicted in a FIFO manner. Returns false if the event was dropped
+  // instead.
+  bool AddEvent(const T& event);
+  bool AddEvent(T&& event);
+
+  // Counts an event that was dropped before it was added, e.g. because it
+  // didn't fit in the span's byte budget.
+  void AddDroppedEvent() { total_recorded_events_++; }
+
+  // Returns the event that the next AddEvent() will evict, or nullptr.
+  const T* next_evicted() const;
+
+  // Returns the first events, which are never evicted. Empty unless
+  // max_initial_events was set.
+  const std::vector<T>& initial_events() const;
 
-  // Returns a vector of populate with all the events currently in the queue.
+  // Returns a vector of populate with all the events currently in the queue,
+  // after the initial events.
   const std::deque<T>& events() const;
 
  private:
+  template <typename U>
+  bool Add(U&& event);
+
   uint32_t total_recorded_events_;
   uint32_t max_events_;
+  uint32_t max_initial_events_ = 0;
+  std::vector<T> initial_events_;
   std::deque<T> events_;
 };
 
 template <typename T>
 inline uint32_t TraceEvents<T>::num_events_dropped() const {
-  return total_recorded_events_ - events_.size();
+  return total_recorded_events_ - initial_events_.size() - events_.size();
 }
 
 template <typename T>
 inline uint32_t TraceEvents<T>::num_events_recorded() const {
-  return num_events_recorded;
+  return total_recorded_events_;
 }
 
 template <typename T>
-inline void TraceEvents<T>::AddEvent(const T& event) {
-  // Blank span has 0 max events.
-  if (max_events_ == 0) {
-    return;
-  }
+inline bool TraceEvents<T>::AddEvent(const T& event) {
+  return Add(event);
+}
 
-  if (events_.size() >= max_events_) {
-    events_.pop_front();
+template <typename T>
+inline bool TraceEvents<T>::AddEvent(T&& event) {
+  return Add(std::move(event));
+}
+
+template <typename T>
+inline const T* TraceEvents<T>::next_evicted() const {
+  if (initial_events_.size() < max_initial_events_ || max_events_ == 0 ||
+      events_.size() < max_events_) {
+    return nullptr;
   }
-  events_.emplace_back(event);
-  total_recorded_events_++;
+  return &events_.front();
 }
 
 template <typename T>
-inline void TraceEvents<T>::AddEvent(T&& event) {
+template <typename U>
+inline bool TraceEvents<T>::Add(U&& event) {
   // Blank span has 0 max events.
-  if (max_events_ == 0) {
-    return;
+  if (max_events_ == 0 && max_initial_events_ == 0) {
+    return false;
   }
 
+  total_recorded_events_++;
+  if (initial_events_.size() < max_initial_events_) {
+    initial_events_.emplace_back(std::forward<U>(event));
+    return true;
+  }
+  if (max_events_ == 0) {
+    return false;
+  }
   if (events_.size() >= max_events_) {
     events_.pop_front();
   }
-  events_.emplace_back(std::move(event));
-  total_recorded_events_++;
+  events_.emplace_back(std::forward<U>(event));
+  return true;
+}
+
+template <typename T>
+inline const std::vector<T>& TraceEvents<T>::initial_events() const {
+  return initial_events_;
 }
 
 template <typename T>
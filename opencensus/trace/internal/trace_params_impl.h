@@ -44,6 +44,9 @@ class TraceParamsImpl final {
     max_links_.store(p.max_links, std::memory_order_release);
     probability_threshold_.store(p.sampler.threshold_,
                                  std::memory_order_release);
+    max_initial_message_events_.store(p.max_initial_message_events,
+                                      std::memory_order_release);
+    max_span_bytes_.store(p.max_span_bytes, std::memory_order_release);
   }
 
   TraceParams Get() const {
@@ -52,7 +55,10 @@ class TraceParamsImpl final {
                        max_message_events_.load(std::memory_order_acquire),
                        max_links_.load(std::memory_order_acquire),
                        ProbabilitySampler(probability_threshold_.load(
-                           std::memory_order_acquire))};
+                           std::memory_order_acquire)),
+                       max_initial_message_events_.load(
+                           std::memory_order_acquire),
+                       max_span_bytes_.load(std::memory_order_acquire)};
   }
 
  private:
@@ -61,6 +67,8 @@ class TraceParamsImpl final {
   std::atomic<uint32_t> max_message_events_;
   std::atomic<uint32_t> max_links_;
   std::atomic<uint64_t> probability_threshold_;
+  std::atomic<uint32_t> max_initial_message_events_;
+  std::atomic<uint32_t> max_span_bytes_;
 };
 
 }  // namespace trace
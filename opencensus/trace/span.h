@@ -52,10 +52,12 @@ struct StartSpanOptions {
   StartSpanOptions(
       Sampler* sampler = nullptr,  // Default Sampler.
       bool record_events = false,  // Only record events if the Span is sampled.
-      const std::vector<Span*>& parent_links = {})
+      const std::vector<Span*>& parent_links = {},
+      bool record_cpu_usage = false)
       : sampler(sampler),
         record_events(record_events),
-        parent_links(parent_links) {}
+        parent_links(parent_links),
+        record_cpu_usage(record_cpu_usage) {}
 
   // The Sampler to use. It must remain valid for the duration of the
   // StartSpan() call. If nullptr, use the default Sampler from TraceConfig.
@@ -72,9 +74,21 @@ struct StartSpanOptions {
   // Pointers to Spans in *other Traces* that are parents of this Span. They
   // must remain valid for the duration of the StartSpan() call.
   const std::vector<Span*> parent_links;
+
+  // If the Span is recording, measures the CPU time and context switches of
+  // the starting thread until End(), and adds them as the attributes
+  // "thread.cpu_time_ns", "thread.voluntary_context_switches", and
+  // "thread.involuntary_context_switches" (context switches are only counted
+  // on Linux). Nothing is recorded if End() is called on a different thread.
+  // This costs a few system calls per Span; see also
+  // TraceConfig::SetCpuUsageSpanNames().
+  const bool record_cpu_usage;
 };
 
 // Span represents a trace span. It has a SpanContext. Span is thread-safe.
+//
+// In builds with --define opencensus_noop=true, every Span is a blank Span and
+// all methods are inline no-ops (see internal/span_noop.h).
 class Span final {
  public:
   // Constructs a no-op Span with an invalid context. Attempts to add
@@ -114,7 +128,9 @@ class Span final {
                      AttributesRef attributes = {});
 
   // Adds a MessageEvent to the Span. If the max number of MessageEvents is
-  // exceeded, a MessageEvent will be evicted in a FIFO manner.
+  // exceeded, a MessageEvent will be evicted in a FIFO manner, except for the
+  // first TraceParams::max_initial_message_events. Every MessageEvent counts
+  // towards the totals in SpanData::message_event_summary().
   void AddSentMessageEvent(uint32_t message_id,
                            uint32_t compressed_message_size,
                            uint32_t uncompressed_message_size);
@@ -174,4 +190,8 @@ class Span final {
 }  // namespace trace
 }  // namespace opencensus
 
+#ifdef OPENCENSUS_NOOP
+#include "opencensus/trace/internal/span_noop.h"
+#endif
+
 #endif  // OPENCENSUS_TRACE_SPAN_H_
@@ -0,0 +1,69 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_SPAN_METRICS_H_
+#define OPENCENSUS_TRACE_SPAN_METRICS_H_
+
+#include "opencensus/stats/measure.h"
+#include "opencensus/stats/view_descriptor.h"
+
+namespace opencensus {
+namespace trace {
+
+// SpanMetrics records the latency of every recording span when it ends, as a
+// stats measurement tagged with the span name and status code. Unlike the
+// LocalSpanStore, which keeps a small sample, and exporters, which only see
+// sampled spans, the views cover every span, giving exact per-operation
+// latency and error rates.
+//
+// Spans that record CPU usage (see StartSpanOptions::record_cpu_usage) also
+// record their CPU time against a second measure.
+//
+// The measures are in milliseconds. Their tags are:
+//   "span_name": the name of the span.
+//   "status":    the span's canonical status code, e.g. "OK" or "NOT_FOUND".
+//
+// Usage, at initialization:
+//   opencensus::trace::SpanMetrics::Enable();
+//
+// This class is thread-safe.
+class SpanMetrics final {
+ public:
+  // Starts recording span latencies, and registers LatencyView(),
+  // CountView(), and CpuTimeView() for export.
+  static void Enable();
+
+  // Stops recording span latencies. Views remain registered.
+  static void Disable();
+
+  // The measure that span latencies are recorded against.
+  static stats::MeasureDouble LatencyMeasure();
+  // The measure that span CPU times are recorded against.
+  static stats::MeasureDouble CpuTimeMeasure();
+
+  // A cumulative distribution of span latency by span name and status.
+  static const stats::ViewDescriptor& LatencyView();
+  // A cumulative count of ended spans by span name and status.
+  static const stats::ViewDescriptor& CountView();
+  // A cumulative distribution of span CPU time by span name and status.
+  static const stats::ViewDescriptor& CpuTimeView();
+
+ private:
+  SpanMetrics() = delete;
+};
+
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_SPAN_METRICS_H_
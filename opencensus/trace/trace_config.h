@@ -15,6 +15,9 @@
 #ifndef OPENCENSUS_TRACE_TRACE_CONFIG_H_
 #define OPENCENSUS_TRACE_TRACE_CONFIG_H_
 
+#include <string>
+#include <vector>
+
 #include "opencensus/trace/trace_params.h"
 
 namespace opencensus {
@@ -27,6 +30,10 @@ class TraceConfig {
   // Sets the currently active TraceParams. Doing this is not atomic: individual
   // parts of the active TraceParams are updated separately.
   static void SetCurrentTraceParams(const TraceParams& params);
+
+  // Records CPU usage for spans with any of these names, as if
+  // StartSpanOptions::record_cpu_usage were set. Replaces the previous names.
+  static void SetCpuUsageSpanNames(const std::vector<std::string>& names);
 };
 
 }  // namespace trace
@@ -23,16 +23,29 @@ namespace opencensus {
 namespace trace {
 
 // TraceParams holds the limits for attributes, annotations, message_events,
-// links, and a ProbabilitySampler. For performance, only ProbabilitySampler is
-// supported as the globally active sampler.
+// links, and span size, and a ProbabilitySampler. For performance, only
+// ProbabilitySampler is supported as the globally active sampler.
 //
 // The currently active TraceParams is set in TraceConfig.
 struct TraceParams final {
   uint32_t max_attributes;
   uint32_t max_annotations;
+  // The most recent message events that are kept for each span.
   uint32_t max_message_events;
   uint32_t max_links;
   ProbabilitySampler sampler;
+  // If nonzero, the first max_initial_message_events message events of each
+  // span are also kept, so that a long stream keeps its beginning as well as
+  // its end. Totals over all message events are kept either way; see
+  // SpanData::message_event_summary().
+  uint32_t max_initial_message_events;
+  // If nonzero, the approximate maximum number of bytes held by the
+  // attributes, annotations, message events, links, and status message of
+  // each span, including their strings. It's checked before anything is
+  // copied into the span: strings are truncated to fit what's left of the
+  // budget (see SpanData::num_strings_truncated()), and anything that still
+  // doesn't fit is dropped.
+  uint32_t max_span_bytes;
 };
 
 }  // namespace trace
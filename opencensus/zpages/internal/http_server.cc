@@ -0,0 +1,343 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/zpages/internal/http_server.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace opencensus {
+namespace zpages {
+
+namespace {
+
+// Requests are small; anything larger is rejected.
+constexpr size_t kMaxRequestBytes = 8 << 10;
+
+absl::string_view StatusText(int status) {
+  switch (status) {
+    case 200:
+      return "OK";
+    case 400:
+      return "Bad Request";
+    case 404:
+      return "Not Found";
+    case 405:
+      return "Method Not Allowed";
+  }
+  return "Error";
+}
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Decodes %XX escapes and, in query strings, '+' as space. Invalid escapes are
+// kept as they are.
+std::string UrlDecode(absl::string_view in, bool plus_is_space) {
+  std::string out;
+  out.reserve(in.size());
+  for (size_t i = 0; i < in.size(); ++i) {
+    if (in[i] == '%' && i + 2 < in.size() && HexValue(in[i + 1]) >= 0 &&
+        HexValue(in[i + 2]) >= 0) {
+      out.push_back(
+          static_cast<char>(HexValue(in[i + 1]) * 16 + HexValue(in[i + 2])));
+      i += 2;
+    } else if (in[i] == '+' && plus_is_space) {
+      out.push_back(' ');
+    } else {
+      out.push_back(in[i]);
+    }
+  }
+  return out;
+}
+
+void SetTimeout(int fd, int option, absl::Duration timeout) {
+  const timeval tv = absl::ToTimeval(timeout);
+  setsockopt(fd, SOL_SOCKET, option, &tv, sizeof(tv));
+}
+
+}  // namespace
+
+absl::string_view HttpServer::Request::param(const std::string& name) const {
+  const auto it = params.find(name);
+  if (it == params.end()) return "";
+  return it->second;
+}
+
+void HttpServer::Response::Append(absl::string_view data) {
+  if (!ok_) return;
+  while (size_ + data.size() > kBufferSize) {
+    const size_t n = kBufferSize - size_;
+    memcpy(buffer_ + size_, data.data(), n);
+    size_ = kBufferSize;
+    data.remove_prefix(n);
+    Flush();
+    if (!ok()) return;
+  }
+  memcpy(buffer_ + size_, data.data(), data.size());
+  size_ += data.size();
+}
+
+void HttpServer::Response::WriteEscaped(absl::string_view text) {
+  size_t start = 0;
+  for (size_t i = 0; i < text.size(); ++i) {
+    absl::string_view replacement;
+    switch (text[i]) {
+      case '&':
+        replacement = "&amp;";
+        break;
+      case '<':
+        replacement = "&lt;";
+        break;
+      case '>':
+        replacement = "&gt;";
+        break;
+      case '"':
+        replacement = "&quot;";
+        break;
+      case '\'':
+        replacement = "&#39;";
+        break;
+      default:
+        continue;
+    }
+    Append(text.substr(start, i - start));
+    Append(replacement);
+    start = i + 1;
+  }
+  Append(text.substr(start));
+}
+
+void HttpServer::Response::Flush() {
+  if (!ok_ || (size_ == 0 && headers_sent_)) return;
+  std::string headers;
+  iovec iov[4];
+  int iovcnt = 0;
+  if (!headers_sent_) {
+    headers = absl::StrCat("HTTP/1.1 ", status_, " ", StatusText(status_),
+                           "\r\nContent-Type: ", content_type_,
+                           "\r\nCache-Control: no-cache\r\n");
+    headers.append(chunked_ ? "Transfer-Encoding: chunked\r\n" : "");
+    headers.append("Connection: close\r\n\r\n");
+    iov[iovcnt++] = {&headers[0], headers.size()};
+    headers_sent_ = true;
+  }
+  char chunk_header[16];
+  if (size_ > 0) {
+    if (chunked_) {
+      const int n = snprintf(chunk_header, sizeof(chunk_header), "%zx\r\n",
+                             size_);
+      iov[iovcnt++] = {chunk_header, static_cast<size_t>(n)};
+    }
+    iov[iovcnt++] = {buffer_, size_};
+    if (chunked_) {
+      iov[iovcnt++] = {const_cast<char*>("\r\n"), 2};
+    }
+  }
+  Send(iov, iovcnt);
+  size_ = 0;
+}
+
+void HttpServer::Response::Finish() {
+  Flush();
+  if (chunked_) {
+    iovec iov = {const_cast<char*>("0\r\n\r\n"), 5};
+    Send(&iov, 1);
+  }
+}
+
+void HttpServer::Response::Send(iovec* iov, int iovcnt) {
+  msghdr msg = {};
+  msg.msg_iov = iov;
+  msg.msg_iovlen = iovcnt;
+  while (ok_ && msg.msg_iovlen > 0) {
+    const ssize_t sent = sendmsg(fd_, &msg, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) continue;
+      ok_ = false;  // Gone away or timed out.
+      return;
+    }
+    // Skip what was sent.
+    size_t remaining = sent;
+    while (msg.msg_iovlen > 0 && remaining >= msg.msg_iov->iov_len) {
+      remaining -= msg.msg_iov->iov_len;
+      ++msg.msg_iov;
+      --msg.msg_iovlen;
+    }
+    if (remaining > 0) {
+      msg.msg_iov->iov_base =
+          static_cast<char*>(msg.msg_iov->iov_base) + remaining;
+      msg.msg_iov->iov_len -= remaining;
+    }
+  }
+}
+
+HttpServer::HttpServer(int port, absl::Duration io_timeout, Handler handler)
+    : port_(port), io_timeout_(io_timeout), handler_(std::move(handler)) {}
+
+HttpServer::~HttpServer() {
+  if (thread_.joinable()) {
+    stopping_ = true;
+    const char c = 0;
+    while (write(wake_fds_[1], &c, 1) < 0 && errno == EINTR) {
+    }
+    thread_.join();
+  }
+  for (int fd : {listen_fd_, wake_fds_[0], wake_fds_[1]}) {
+    if (fd >= 0) close(fd);
+  }
+}
+
+bool HttpServer::Start() {
+  listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    std::cerr << "HttpServer: socket() failed: " << strerror(errno) << "\n";
+    return false;
+  }
+  const int one = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port_);
+  socklen_t length = sizeof(address);
+  if (bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      listen(listen_fd_, 16) != 0 ||
+      getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+                  &length) != 0) {
+    std::cerr << "HttpServer: can't listen on 127.0.0.1:" << port_ << ": "
+              << strerror(errno) << "\n";
+    return false;
+  }
+  port_ = ntohs(address.sin_port);
+  if (pipe2(wake_fds_, O_CLOEXEC) != 0) {
+    std::cerr << "HttpServer: pipe2() failed: " << strerror(errno) << "\n";
+    return false;
+  }
+  thread_ = std::thread(&HttpServer::Run, this);
+  return true;
+}
+
+void HttpServer::Run() {
+  while (true) {
+    pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {wake_fds_[0], POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) continue;
+      std::cerr << "HttpServer: poll() failed: " << strerror(errno) << "\n";
+      return;
+    }
+    if (fds[1].revents != 0) return;
+    const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) continue;
+    SetTimeout(fd, SO_RCVTIMEO, io_timeout_);
+    SetTimeout(fd, SO_SNDTIMEO, io_timeout_);
+    ServeConnection(fd);
+    close(fd);
+  }
+}
+
+void HttpServer::ServeConnection(int fd) {
+  // Read up to the end of the headers, which are otherwise ignored.
+  std::string data;
+  size_t end;
+  while ((end = data.find("\r\n\r\n")) == std::string::npos) {
+    if (data.size() >= kMaxRequestBytes) return;
+    char buffer[1024];
+    const ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return;
+    data.append(buffer, n);
+  }
+
+  Request request;
+  bool http_1_1 = false;
+  const bool valid = ParseRequestLine(
+      absl::string_view(data).substr(0, data.find("\r\n")), &request,
+      &http_1_1);
+  // HTTP/1.0 clients don't understand chunked encoding; their body ends when
+  // the connection is closed instead.
+  Response response(fd, http_1_1, &stopping_);
+  if (!valid) {
+    response.set_status(400);
+    response.set_content_type("text/plain");
+    response.Write("Bad request\n");
+  } else if (request.method != "GET") {
+    response.set_status(405);
+    response.set_content_type("text/plain");
+    response.Write("Only GET is supported\n");
+  } else {
+    handler_(request, &response);
+  }
+  response.Finish();
+}
+
+// static
+bool HttpServer::ParseRequestLine(absl::string_view line, Request* request,
+                                  bool* http_1_1) {
+  const size_t method_end = line.find(' ');
+  if (method_end == absl::string_view::npos) return false;
+  const size_t target_end = line.find(' ', method_end + 1);
+  if (target_end == absl::string_view::npos) return false;
+  const absl::string_view version = line.substr(target_end + 1);
+  if (version != "HTTP/1.0" && version != "HTTP/1.1") return false;
+  *http_1_1 = version == "HTTP/1.1";
+
+  request->method = std::string(line.substr(0, method_end));
+  absl::string_view target =
+      line.substr(method_end + 1, target_end - method_end - 1);
+  if (target.empty() || target[0] != '/') return false;
+  const size_t query_start = target.find('?');
+  request->path = UrlDecode(target.substr(0, query_start), false);
+  request->params.clear();
+  if (query_start == absl::string_view::npos) return true;
+  absl::string_view query = target.substr(query_start + 1);
+  while (!query.empty()) {
+    const size_t param_end = query.find('&');
+    const absl::string_view param = query.substr(0, param_end);
+    if (!param.empty()) {
+      const size_t equals = param.find('=');
+      const std::string name = UrlDecode(param.substr(0, equals), true);
+      request->params[name] =
+          equals == absl::string_view::npos
+              ? ""
+              : UrlDecode(param.substr(equals + 1), true);
+    }
+    if (param_end == absl::string_view::npos) break;
+    query.remove_prefix(param_end + 1);
+  }
+  return true;
+}
+
+}  // namespace zpages
+}  // namespace opencensus
@@ -0,0 +1,151 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_ZPAGES_INTERNAL_HTTP_SERVER_H_
+#define OPENCENSUS_ZPAGES_INTERNAL_HTTP_SERVER_H_
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace opencensus {
+namespace zpages {
+
+// HttpServer is a minimal HTTP/1.1 server for GET requests, listening on
+// 127.0.0.1 only. It serves one request per connection and one connection at a
+// time, on its own thread, which is enough for debug pages and keeps the
+// server from ever competing with the application for threads.
+//
+// Responses are streamed: the handler writes the body piece by piece into a
+// fixed-size buffer, which is sent as an HTTP chunk whenever it fills up.
+class HttpServer {
+ public:
+  struct Request {
+    std::string method;
+    std::string path;
+    // The decoded query parameters. If a parameter is repeated, the last value
+    // wins.
+    std::unordered_map<std::string, std::string> params;
+
+    // Returns the value of the parameter, or an empty string.
+    absl::string_view param(const std::string& name) const;
+  };
+
+  class Response {
+   public:
+    // The size of the buffer that is filled before each write to the socket.
+    static constexpr size_t kBufferSize = 16 << 10;
+
+    // The status and content type can only be set before the first byte of
+    // the body is sent.
+    void set_status(int status) { status_ = status; }
+    void set_content_type(absl::string_view content_type) {
+      content_type_ = std::string(content_type);
+    }
+
+    // Appends the concatenation of the arguments to the body, like
+    // absl::StrCat but without building a string.
+    void Write(const absl::AlphaNum& a) { Append(a.Piece()); }
+    template <typename... AV>
+    void Write(const absl::AlphaNum& a, const absl::AlphaNum& b,
+               const AV&... rest) {
+      Append(a.Piece());
+      Write(b, rest...);
+    }
+
+    // Appends text to the body, escaping the characters that are special in
+    // HTML.
+    void WriteEscaped(absl::string_view text);
+
+    // Returns false once the client has gone away, a write has timed out, or
+    // the server is shutting down. Further writes are discarded, so handlers
+    // that render many rows should check this and stop early.
+    bool ok() const { return ok_ && !stopping_->load(); }
+
+   private:
+    friend class HttpServer;
+
+    Response(int fd, bool chunked, const std::atomic<bool>* stopping)
+        : fd_(fd), chunked_(chunked), stopping_(stopping) {}
+
+    void Append(absl::string_view data);
+    // Sends the buffer, preceded by the headers the first time.
+    void Flush();
+    // Flushes, and ends a chunked body.
+    void Finish();
+    // Writes all of iov, or clears ok_.
+    void Send(iovec* iov, int iovcnt);
+
+    const int fd_;
+    const bool chunked_;
+    const std::atomic<bool>* const stopping_;
+    int status_ = 200;
+    std::string content_type_ = "text/html; charset=utf-8";
+    bool headers_sent_ = false;
+    bool ok_ = true;
+    size_t size_ = 0;
+    char buffer_[kBufferSize];
+  };
+
+  using Handler = std::function<void(const Request&, Response*)>;
+
+  // 'port' 0 picks a free port. Reading a request and each write of the
+  // response time out after 'io_timeout'.
+  HttpServer(int port, absl::Duration io_timeout, Handler handler);
+  // Stops the server, waiting for the request being served, if any.
+  ~HttpServer();
+
+  HttpServer(const HttpServer&) = delete;
+  HttpServer& operator=(const HttpServer&) = delete;
+
+  // Binds the socket and starts serving. Returns false if the socket can't be
+  // bound, e.g. because the port is in use.
+  bool Start();
+
+  // The port the server listens on, once started.
+  int port() const { return port_; }
+
+  // Parses the request line of an HTTP request, e.g.
+  // "GET /tracez?zspanname=a%20b HTTP/1.1". Returns false if it's malformed.
+  // 'http_1_1' is set to whether the client speaks HTTP/1.1.
+  static bool ParseRequestLine(absl::string_view line, Request* request,
+                               bool* http_1_1);
+
+ private:
+  void Run();
+  void ServeConnection(int fd);
+
+  int port_;
+  const absl::Duration io_timeout_;
+  const Handler handler_;
+  int listen_fd_ = -1;
+  // Written to wake up the server thread for shutdown.
+  int wake_fds_[2] = {-1, -1};
+  std::atomic<bool> stopping_{false};
+  std::thread thread_;
+};
+
+}  // namespace zpages
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_ZPAGES_INTERNAL_HTTP_SERVER_H_
@@ -0,0 +1,224 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/zpages/internal/http_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace zpages {
+namespace {
+
+// Connects to the server and sends 'request'. Returns the socket.
+int SendRequest(int port, absl::string_view request) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  EXPECT_LE(0, fd);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  EXPECT_EQ(0, connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                       sizeof(address)));
+  EXPECT_EQ(request.size(), send(fd, request.data(), request.size(), 0));
+  return fd;
+}
+
+// Sends 'request' and returns the whole response.
+std::string Fetch(int port, absl::string_view request) {
+  const int fd = SendRequest(port, request);
+  std::string response;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    response.append(buffer, n);
+  }
+  close(fd);
+  return response;
+}
+
+struct Response {
+  std::string headers;
+  std::string body;
+  std::vector<size_t> chunk_sizes;
+};
+
+// Splits a response into headers and body, decoding a chunked body.
+Response Parse(absl::string_view raw) {
+  Response response;
+  const size_t headers_end = raw.find("\r\n\r\n");
+  EXPECT_NE(absl::string_view::npos, headers_end);
+  response.headers = std::string(raw.substr(0, headers_end + 2));
+  absl::string_view body = raw.substr(headers_end + 4);
+  if (response.headers.find("Transfer-Encoding: chunked\r\n") ==
+      std::string::npos) {
+    response.body = std::string(body);
+    return response;
+  }
+  while (true) {
+    const size_t size_end = body.find("\r\n");
+    EXPECT_NE(absl::string_view::npos, size_end);
+    const size_t size =
+        strtoul(std::string(body.substr(0, size_end)).c_str(), nullptr, 16);
+    body.remove_prefix(size_end + 2);
+    if (size == 0) {
+      EXPECT_EQ("\r\n", body);
+      return response;
+    }
+    response.chunk_sizes.push_back(size);
+    response.body.append(body.data(), size);
+    EXPECT_EQ("\r\n", body.substr(size, 2));
+    body.remove_prefix(size + 2);
+  }
+}
+
+TEST(HttpServerTest, ParseRequestLine) {
+  HttpServer::Request request;
+  bool http_1_1;
+  ASSERT_TRUE(HttpServer::ParseRequestLine(
+      "GET /a%20b?x=1+2&y=%3C%3e&z&x=3 HTTP/1.1", &request, &http_1_1));
+  EXPECT_TRUE(http_1_1);
+  EXPECT_EQ("GET", request.method);
+  EXPECT_EQ("/a b", request.path);
+  EXPECT_EQ(3, request.params.size());
+  EXPECT_EQ("3", request.param("x"));
+  EXPECT_EQ("<>", request.param("y"));
+  EXPECT_EQ("", request.param("z"));
+  EXPECT_EQ(1, request.params.count("z"));
+  EXPECT_EQ("", request.param("missing"));
+
+  ASSERT_TRUE(HttpServer::ParseRequestLine("GET /%zz%4 HTTP/1.0", &request,
+                                           &http_1_1));
+  EXPECT_FALSE(http_1_1);
+  EXPECT_EQ("/%zz%4", request.path);
+  EXPECT_TRUE(request.params.empty());
+
+  EXPECT_FALSE(HttpServer::ParseRequestLine("GET /", &request, &http_1_1));
+  EXPECT_FALSE(
+      HttpServer::ParseRequestLine("GET / HTTP/2.0", &request, &http_1_1));
+  EXPECT_FALSE(
+      HttpServer::ParseRequestLine("GET x HTTP/1.1", &request, &http_1_1));
+}
+
+TEST(HttpServerTest, StreamsChunkedResponse) {
+  constexpr int kRows = 100000;
+  HttpServer server(0, absl::Seconds(10),
+                    [](const HttpServer::Request& /*request*/,
+                       HttpServer::Response* response) {
+                      response->set_content_type("text/plain");
+                      for (int i = 0; i < kRows; ++i) {
+                        response->Write("row ", i, "\n");
+                      }
+                    });
+  ASSERT_TRUE(server.Start());
+  ASSERT_NE(0, server.port());
+
+  const Response response = Parse(
+      Fetch(server.port(), "GET /rows HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+  EXPECT_EQ(0, response.headers.find("HTTP/1.1 200 OK\r\n"));
+  EXPECT_NE(std::string::npos,
+            response.headers.find("Content-Type: text/plain\r\n"));
+  std::string expected;
+  for (int i = 0; i < kRows; ++i) {
+    absl::StrAppend(&expected, "row ", i, "\n");
+  }
+  EXPECT_EQ(expected, response.body);
+  // Sent in buffer-sized pieces.
+  ASSERT_LT(1, response.chunk_sizes.size());
+  for (size_t i = 0; i + 1 < response.chunk_sizes.size(); ++i) {
+    EXPECT_EQ(HttpServer::Response::kBufferSize, response.chunk_sizes[i]);
+  }
+}
+
+TEST(HttpServerTest, Http10ResponseIsNotChunked) {
+  HttpServer server(0, absl::Seconds(10),
+                    [](const HttpServer::Request& request,
+                       HttpServer::Response* response) {
+                      response->Write(request.path, " ",
+                                      request.param("q"));
+                    });
+  ASSERT_TRUE(server.Start());
+  const Response response =
+      Parse(Fetch(server.port(), "GET /path?q=%26 HTTP/1.0\r\n\r\n"));
+  EXPECT_EQ(std::string::npos, response.headers.find("chunked"));
+  EXPECT_EQ("/path &", response.body);
+}
+
+TEST(HttpServerTest, Errors) {
+  bool called = false;
+  HttpServer server(0, absl::Seconds(10),
+                    [&called](const HttpServer::Request& /*request*/,
+                              HttpServer::Response* /*response*/) {
+                      called = true;
+                    });
+  ASSERT_TRUE(server.Start());
+  EXPECT_EQ(0, Fetch(server.port(), "POST / HTTP/1.1\r\n\r\n")
+                   .find("HTTP/1.1 405 Method Not Allowed\r\n"));
+  EXPECT_EQ(0, Fetch(server.port(), "nonsense\r\n\r\n")
+                   .find("HTTP/1.1 400 Bad Request\r\n"));
+  // Too long.
+  EXPECT_EQ("", Fetch(server.port(), std::string(20000, 'x')));
+  EXPECT_FALSE(called);
+}
+
+TEST(HttpServerTest, EscapesHtml) {
+  HttpServer server(0, absl::Seconds(10),
+                    [](const HttpServer::Request& /*request*/,
+                       HttpServer::Response* response) {
+                      response->WriteEscaped("<a href=\"x\">'&'</a>.");
+                    });
+  ASSERT_TRUE(server.Start());
+  EXPECT_EQ("&lt;a href=&quot;x&quot;&gt;&#39;&amp;&#39;&lt;/a&gt;.",
+            Parse(Fetch(server.port(), "GET / HTTP/1.1\r\n\r\n")).body);
+}
+
+TEST(HttpServerTest, StopsWritingWhenClientGoesAway) {
+  absl::Notification handler_done;
+  HttpServer server(0, absl::Seconds(10),
+                    [&handler_done](const HttpServer::Request& request,
+                                    HttpServer::Response* response) {
+                      if (request.path == "/forever") {
+                        while (response->ok()) {
+                          response->Write("more data\n");
+                        }
+                        handler_done.Notify();
+                      } else {
+                        response->Write("ok");
+                      }
+                    });
+  ASSERT_TRUE(server.Start());
+  const int fd = SendRequest(server.port(), "GET /forever HTTP/1.1\r\n\r\n");
+  char buffer[100];
+  EXPECT_LT(0, recv(fd, buffer, sizeof(buffer), 0));
+  close(fd);
+  EXPECT_TRUE(handler_done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  EXPECT_EQ("ok", Parse(Fetch(server.port(), "GET / HTTP/1.1\r\n\r\n")).body);
+}
+
+}  // namespace
+}  // namespace zpages
+}  // namespace opencensus
@@ -0,0 +1,480 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/zpages/internal/pages.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "opencensus/common/internal/clock.h"
+#include "opencensus/stats/distribution.h"
+#include "opencensus/stats/stats_exporter.h"
+#include "opencensus/stats/view_data.h"
+#include "opencensus/stats/view_descriptor.h"
+#include "opencensus/trace/exporter/annotation.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/local_span_store.h"
+#include "opencensus/trace/exporter/message_event.h"
+#include "opencensus/trace/exporter/running_span_store.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/status_code.h"
+
+namespace opencensus {
+namespace zpages {
+
+namespace {
+
+using ::opencensus::trace::exporter::AttributeValue;
+using ::opencensus::trace::exporter::LocalSpanStore;
+using ::opencensus::trace::exporter::MessageEvent;
+using ::opencensus::trace::exporter::RunningSpanStore;
+using ::opencensus::trace::exporter::SpanData;
+using Response = HttpServer::Response;
+
+enum SpanListType { kRunning = 0, kLatency = 1, kError = 2 };
+
+constexpr int kNumLatencyBuckets = LocalSpanStore::k100s_plus + 1;
+
+// The lower bounds of the latency buckets, and the upper bound of the last
+// one.
+constexpr uint64_t kLatencyBoundsNs[kNumLatencyBuckets + 1] = {
+    0,
+    10000,
+    100000,
+    1000000,
+    10000000,
+    100000000,
+    1000000000,
+    10000000000,
+    100000000000,
+    UINT64_MAX,
+};
+
+constexpr const char* kLatencyBucketNames[kNumLatencyBuckets] = {
+    "&gt;0us",   "&gt;10us", "&gt;100us", "&gt;1ms",  "&gt;10ms",
+    "&gt;100ms", "&gt;1s",   "&gt;10s",   "&gt;100s",
+};
+
+void WritePageStart(absl::string_view title, Response* response) {
+  response->Write(
+      "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>", title,
+      "</title><style>"
+      "body{font-family:sans-serif}"
+      "table{border-collapse:collapse}"
+      "td,th{padding:2px 8px;text-align:left;vertical-align:top}"
+      "tr:nth-child(even){background:#eee}"
+      "td.num{text-align:right}"
+      "pre{margin:0}"
+      "</style></head><body>\n<h1>",
+      title, "</h1>\n");
+}
+
+void WritePageEnd(Response* response) {
+  response->Write("</body></html>\n");
+}
+
+// Writes text percent-encoded for use in a query parameter.
+void WriteUrlEncoded(absl::string_view text, Response* response) {
+  static constexpr char kHex[] = "0123456789ABCDEF";
+  size_t start = 0;
+  for (size_t i = 0; i < text.size(); ++i) {
+    const unsigned char c = text[i];
+    if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+        (c >= 'A' && c <= 'Z') || c == '-' || c == '_' || c == '.' ||
+        c == '~') {
+      continue;
+    }
+    const char escape[3] = {'%', kHex[c >> 4], kHex[c & 15]};
+    response->Write(text.substr(start, i - start),
+                    absl::string_view(escape, 3));
+    start = i + 1;
+  }
+  response->Write(text.substr(start));
+}
+
+// Writes a link to a list of spans, or just the count if it's zero.
+void WriteSpanListLink(absl::string_view name, SpanListType type,
+                       int subtype, int count, Response* response) {
+  response->Write("<td class=\"num\">");
+  if (count == 0) {
+    response->Write("0</td>");
+    return;
+  }
+  response->Write("<a href=\"/tracez?zspanname=");
+  WriteUrlEncoded(name, response);
+  response->Write("&amp;ztype=", static_cast<int>(type));
+  if (type == kLatency) {
+    response->Write("&amp;zsubtype=", subtype);
+  }
+  response->Write("\">", count, "</a></td>");
+}
+
+void WriteTracezSummary(Response* response) {
+  struct Counts {
+    int running = 0;
+    int latency[kNumLatencyBuckets] = {};
+    int errors = 0;
+  };
+  // Sorted by span name.
+  std::map<std::string, Counts> counts;
+  const RunningSpanStore::Summary running = RunningSpanStore::GetSummary();
+  for (const auto& it : running.per_span_name_summary) {
+    counts[it.first].running = it.second.num_running_spans;
+  }
+  const LocalSpanStore::Summary local = LocalSpanStore::GetSummary();
+  for (const auto& it : local.per_span_name_summary) {
+    Counts& name_counts = counts[it.first];
+    for (const auto& bucket : it.second.number_of_latency_sampled_spans) {
+      name_counts.latency[bucket.first] = bucket.second;
+    }
+    for (const auto& error : it.second.number_of_error_sampled_spans) {
+      name_counts.errors += error.second;
+    }
+  }
+
+  if (!RunningSpanStore::IsEnabled()) {
+    response->Write(
+        "<p>Running spans aren't tracked: see "
+        "RunningSpanStore::Enable().</p>\n");
+  }
+  response->Write("<table>\n<tr><th>Span name</th><th>Running</th>");
+  for (const char* bucket_name : kLatencyBucketNames) {
+    response->Write("<th>", bucket_name, "</th>");
+  }
+  response->Write("<th>Errors</th></tr>\n");
+  for (const auto& it : counts) {
+    if (!response->ok()) return;
+    response->Write("<tr><td>");
+    response->WriteEscaped(it.first);
+    response->Write("</td>");
+    WriteSpanListLink(it.first, kRunning, 0, it.second.running, response);
+    for (int i = 0; i < kNumLatencyBuckets; ++i) {
+      WriteSpanListLink(it.first, kLatency, i, it.second.latency[i],
+                        response);
+    }
+    WriteSpanListLink(it.first, kError, 0, it.second.errors, response);
+    response->Write("</tr>\n");
+  }
+  response->Write("</table>\n");
+}
+
+void WriteTime(absl::Time time, Response* response) {
+  response->Write(
+      absl::FormatTime("%Y/%m/%d-%H:%M:%E6S", time, absl::UTCTimeZone()));
+}
+
+void WriteSeconds(absl::Duration duration, Response* response) {
+  char buffer[32];
+  const int n = snprintf(buffer, sizeof(buffer), "%.6f",
+                         absl::ToDoubleSeconds(duration));
+  response->Write(absl::string_view(buffer, n));
+}
+
+void WriteAttributes(
+    const std::unordered_map<std::string, AttributeValue>& attributes,
+    Response* response) {
+  for (const auto& attribute : attributes) {
+    response->Write(" ");
+    response->WriteEscaped(attribute.first);
+    response->Write("=");
+    switch (attribute.second.type()) {
+      case AttributeValue::Type::kString:
+        response->WriteEscaped(attribute.second.string_value());
+        break;
+      case AttributeValue::Type::kInt:
+        response->Write(attribute.second.int_value());
+        break;
+      case AttributeValue::Type::kBool:
+        response->Write(attribute.second.bool_value() ? "true" : "false");
+        break;
+    }
+  }
+}
+
+// Writes a row for the span, followed by a row for each of its events.
+void WriteSpan(const SpanData& span, absl::Time now, Response* response) {
+  response->Write("<tr><td>");
+  WriteTime(span.start_time(), response);
+  response->Write("</td><td class=\"num\">");
+  WriteSeconds((span.has_ended() ? span.end_time() : now) - span.start_time(),
+               response);
+  response->Write("</td><td>TraceId: ", span.context().trace_id().ToHex(),
+                  " SpanId: ", span.context().span_id().ToHex());
+  if (span.parent_span_id().IsValid()) {
+    response->Write(" ParentSpanId: ", span.parent_span_id().ToHex());
+  }
+  if (!span.status().ok()) {
+    response->Write(" Status: ");
+    response->WriteEscaped(span.status().ToString());
+  }
+  WriteAttributes(span.attributes(), response);
+  const SpanData::MessageEventSummary& messages =
+      span.message_event_summary();
+  if (messages.num_sent + messages.num_received > 0) {
+    response->Write("<br>Sent ", messages.num_sent, " messages, ",
+                    messages.sent_uncompressed_bytes, " bytes (",
+                    messages.sent_compressed_bytes, " compressed). Received ",
+                    messages.num_received, " messages, ",
+                    messages.received_uncompressed_bytes, " bytes (",
+                    messages.received_compressed_bytes, " compressed).");
+    if (span.message_events().dropped_events_count() > 0) {
+      response->Write(" ", span.message_events().dropped_events_count(),
+                      " message events not shown.");
+    }
+  }
+  if (span.num_strings_truncated() > 0) {
+    response->Write("<br>", span.num_strings_truncated(),
+                    " strings truncated to fit the span size limit.");
+  }
+  response->Write("</td></tr>\n");
+
+  // Annotations and message events, merged in time order.
+  const auto& annotations = span.annotations().events();
+  const auto& message_events = span.message_events().events();
+  size_t a = 0;
+  size_t m = 0;
+  while (a < annotations.size() || m < message_events.size()) {
+    const bool is_annotation =
+        m == message_events.size() ||
+        (a < annotations.size() &&
+         annotations[a].timestamp() <= message_events[m].timestamp());
+    const absl::Time timestamp = is_annotation
+                                     ? annotations[a].timestamp()
+                                     : message_events[m].timestamp();
+    response->Write("<tr><td>");
+    WriteTime(timestamp, response);
+    response->Write("</td><td class=\"num\">+");
+    WriteSeconds(timestamp - span.start_time(), response);
+    response->Write("</td><td>");
+    if (is_annotation) {
+      response->WriteEscaped(annotations[a].event().description());
+      WriteAttributes(annotations[a].event().attributes(), response);
+      ++a;
+    } else {
+      const MessageEvent& event = message_events[m].event();
+      response->Write(
+          event.type() == MessageEvent::Type::SENT ? "Sent" : "Received",
+          " message ", event.id(), ": ", event.uncompressed_size(),
+          " bytes (", event.compressed_size(), " compressed)");
+      ++m;
+    }
+    response->Write("</td></tr>\n");
+  }
+}
+
+template <typename SpanPtr>
+void WriteSpanList(std::vector<SpanPtr> spans, Response* response) {
+  std::sort(spans.begin(), spans.end(),
+            [](const SpanPtr& a, const SpanPtr& b) {
+              return a->start_time() < b->start_time();
+            });
+  const absl::Time now = common::Clock::Now();
+  response->Write(
+      "<table>\n<tr><th>When</th><th>Elapsed (s)</th><th></th></tr>\n");
+  for (const auto& span : spans) {
+    if (!response->ok()) return;
+    WriteSpan(*span, now, response);
+  }
+  response->Write("</table>\n");
+}
+
+void WriteTracezList(const HttpServer::Request& request, int max_spans,
+                     Response* response) {
+  const std::string name(request.param("zspanname"));
+  int type = -1;
+  int subtype = 0;
+  if (!absl::SimpleAtoi(request.param("ztype"), &type) ||
+      (type == kLatency &&
+       (!absl::SimpleAtoi(request.param("zsubtype"), &subtype) ||
+        subtype < 0 || subtype >= kNumLatencyBuckets))) {
+    type = -1;
+  }
+
+  response->Write("<p><a href=\"/tracez\">All span names</a></p>\n<h2>");
+  switch (type) {
+    case kRunning: {
+      response->Write("Running spans: ");
+      response->WriteEscaped(name);
+      response->Write("</h2>\n");
+      std::vector<SpanData> spans =
+          RunningSpanStore::GetRunningSpans({name, max_spans});
+      // Sorted by pointer, so the SpanData isn't moved around.
+      std::vector<const SpanData*> pointers;
+      pointers.reserve(spans.size());
+      for (const auto& span : spans) pointers.push_back(&span);
+      WriteSpanList(std::move(pointers), response);
+      return;
+    }
+    case kLatency:
+      response->Write("Latency samples ", kLatencyBucketNames[subtype], ": ");
+      response->WriteEscaped(name);
+      response->Write("</h2>\n");
+      WriteSpanList(LocalSpanStore::GetLatencySampledSpans(
+                        {name, max_spans, kLatencyBoundsNs[subtype],
+                         kLatencyBoundsNs[subtype + 1]}),
+                    response);
+      return;
+    case kError:
+      response->Write("Error samples: ");
+      response->WriteEscaped(name);
+      response->Write("</h2>\n");
+      WriteSpanList(
+          LocalSpanStore::GetErrorSampledSpans(
+              {name, max_spans, trace::StatusCode::OK, /*all_errors=*/true}),
+          response);
+      return;
+  }
+  response->Write("Invalid ztype or zsubtype</h2>\n");
+}
+
+void WriteDouble(double value, Response* response) {
+  char buffer[32];
+  const int n = snprintf(buffer, sizeof(buffer), "%.6g", value);
+  response->Write(absl::string_view(buffer, n));
+}
+
+void WriteValue(double value, Response* response) {
+  response->Write("<td class=\"num\">");
+  WriteDouble(value, response);
+  response->Write("</td>");
+}
+
+void WriteValue(int64_t value, Response* response) {
+  response->Write("<td class=\"num\">", value, "</td>");
+}
+
+void WriteValue(const stats::Distribution& value, Response* response) {
+  response->Write("<td class=\"num\">", value.count(), "</td>");
+  for (double field : {value.mean(), value.min(), value.max()}) {
+    WriteValue(value.count() == 0 ? 0.0 : field, response);
+  }
+}
+
+// Writes the rows of a view, sorted by tag values.
+template <typename T>
+void WriteRows(const stats::ViewData::DataMap<T>& data, Response* response) {
+  std::vector<const typename stats::ViewData::DataMap<T>::value_type*> rows;
+  rows.reserve(data.size());
+  for (const auto& row : data) rows.push_back(&row);
+  std::sort(rows.begin(), rows.end(),
+            [](const typename stats::ViewData::DataMap<T>::value_type* a,
+               const typename stats::ViewData::DataMap<T>::value_type* b) {
+              return a->first < b->first;
+            });
+  for (const auto* row : rows) {
+    if (!response->ok()) return;
+    response->Write("<tr>");
+    for (const auto& tag_value : row->first) {
+      response->Write("<td>");
+      response->WriteEscaped(tag_value);
+      response->Write("</td>");
+    }
+    WriteValue(row->second, response);
+    response->Write("</tr>\n");
+  }
+}
+
+void WriteView(const stats::ViewDescriptor& descriptor,
+               const stats::ViewData& data, Response* response) {
+  response->Write("<h2>");
+  response->WriteEscaped(descriptor.name());
+  response->Write("</h2>\n<p>");
+  response->WriteEscaped(descriptor.description());
+  response->Write("<br>Measure: ");
+  response->WriteEscaped(descriptor.measure_descriptor().name());
+  response->Write(" (");
+  response->WriteEscaped(descriptor.measure_descriptor().units());
+  response->Write(")<br>Aggregation: ");
+  response->WriteEscaped(descriptor.aggregation().DebugString());
+  response->Write(" over ");
+  response->WriteEscaped(descriptor.aggregation_window().DebugString());
+  response->Write("</p>\n<table>\n<tr>");
+  for (const auto& column : descriptor.columns()) {
+    response->Write("<th>");
+    response->WriteEscaped(column);
+    response->Write("</th>");
+  }
+  switch (data.type()) {
+    case stats::ViewData::Type::kDouble:
+      response->Write("<th>Value</th></tr>\n");
+      WriteRows(data.double_data(), response);
+      break;
+    case stats::ViewData::Type::kInt64:
+      response->Write("<th>Value</th></tr>\n");
+      WriteRows(data.int_data(), response);
+      break;
+    case stats::ViewData::Type::kDistribution:
+      response->Write(
+          "<th>Count</th><th>Mean</th><th>Min</th><th>Max</th></tr>\n");
+      WriteRows(data.distribution_data(), response);
+      break;
+  }
+  response->Write("</table>\n");
+}
+
+}  // namespace
+
+void RenderIndexPage(Response* response) {
+  WritePageStart("OpenCensus", response);
+  response->Write(
+      "<ul><li><a href=\"/tracez\">tracez</a>: spans</li>"
+      "<li><a href=\"/statsz\">statsz</a>: views</li></ul>\n");
+  WritePageEnd(response);
+}
+
+void RenderTracezPage(const HttpServer::Request& request, int max_spans,
+                      Response* response) {
+  WritePageStart("tracez", response);
+  if (request.params.count("zspanname") == 0) {
+    WriteTracezSummary(response);
+  } else {
+    WriteTracezList(request, max_spans, response);
+  }
+  WritePageEnd(response);
+}
+
+void RenderStatszPage(Response* response) {
+  WritePageStart("statsz", response);
+  const auto views = stats::StatsExporter::GetViewData();
+  if (views.empty()) {
+    response->Write(
+        "<p>No views are registered: see StatsExporter::AddView().</p>\n");
+  }
+  // ViewData can't be reassigned, so sort pointers by view name.
+  std::vector<const std::pair<stats::ViewDescriptor, stats::ViewData>*> sorted;
+  sorted.reserve(views.size());
+  for (const auto& view : views) sorted.push_back(&view);
+  std::sort(sorted.begin(), sorted.end(),
+            [](const std::pair<stats::ViewDescriptor, stats::ViewData>* a,
+               const std::pair<stats::ViewDescriptor, stats::ViewData>* b) {
+              return a->first.name() < b->first.name();
+            });
+  for (const auto* view : sorted) {
+    if (!response->ok()) break;
+    WriteView(view->first, view->second, response);
+  }
+  WritePageEnd(response);
+}
+
+}  // namespace zpages
+}  // namespace opencensus
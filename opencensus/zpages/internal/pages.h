@@ -0,0 +1,43 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_ZPAGES_INTERNAL_PAGES_H_
+#define OPENCENSUS_ZPAGES_INTERNAL_PAGES_H_
+
+#include "opencensus/zpages/internal/http_server.h"
+
+namespace opencensus {
+namespace zpages {
+
+// Renders the page that links to the others.
+void RenderIndexPage(HttpServer::Response* response);
+
+// Renders /tracez. Without parameters, it shows the number of running spans,
+// sampled spans per latency bucket, and sampled errors for each span name, as
+// links to the lists of spans:
+//   zspanname  The span name.
+//   ztype      0 for running spans, 1 for latency samples, 2 for errors.
+//   zsubtype   The latency bucket, for ztype=1.
+// Lists show at most 'max_spans' spans.
+void RenderTracezPage(const HttpServer::Request& request, int max_spans,
+                      HttpServer::Response* response);
+
+// Renders /statsz: a table of the current data of each view registered with
+// StatsExporter.
+void RenderStatszPage(HttpServer::Response* response);
+
+}  // namespace zpages
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_ZPAGES_INTERNAL_PAGES_H_
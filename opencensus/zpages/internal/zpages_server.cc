@@ -0,0 +1,58 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/zpages/zpages_server.h"
+
+#include <functional>
+
+#include "absl/memory/memory.h"
+#include "opencensus/zpages/internal/http_server.h"
+#include "opencensus/zpages/internal/pages.h"
+
+namespace opencensus {
+namespace zpages {
+
+namespace {
+
+void HandleRequest(int max_spans, const HttpServer::Request& request,
+                   HttpServer::Response* response) {
+  if (request.path == "/") {
+    RenderIndexPage(response);
+  } else if (request.path == "/tracez") {
+    RenderTracezPage(request, max_spans, response);
+  } else if (request.path == "/statsz") {
+    RenderStatszPage(response);
+  } else {
+    response->set_status(404);
+    response->set_content_type("text/plain");
+    response->Write("Not found\n");
+  }
+}
+
+}  // namespace
+
+ZPagesServer::ZPagesServer(const Options& options)
+    : server_(absl::make_unique<HttpServer>(
+          options.port, options.io_timeout,
+          std::bind(&HandleRequest, options.max_spans, std::placeholders::_1,
+                    std::placeholders::_2))) {}
+
+ZPagesServer::~ZPagesServer() = default;
+
+bool ZPagesServer::Start() { return server_->Start(); }
+
+int ZPagesServer::port() const { return server_->port(); }
+
+}  // namespace zpages
+}  // namespace opencensus
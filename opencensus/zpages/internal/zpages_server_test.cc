@@ -0,0 +1,153 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/zpages/zpages_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+#include "opencensus/stats/stats.h"
+#include "opencensus/trace/exporter/running_span_store.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+#include "opencensus/trace/status_code.h"
+
+namespace opencensus {
+namespace zpages {
+namespace {
+
+// Fetches 'path' with HTTP/1.0, so that the body isn't chunked. Returns the
+// whole response.
+std::string Get(int port, absl::string_view path) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  EXPECT_LE(0, fd);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  EXPECT_EQ(0, connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                       sizeof(address)));
+  const std::string request = absl::StrCat("GET ", path, " HTTP/1.0\r\n\r\n");
+  EXPECT_EQ(request.size(), send(fd, request.data(), request.size(), 0));
+  std::string response;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    response.append(buffer, n);
+  }
+  close(fd);
+  return response;
+}
+
+bool Contains(absl::string_view haystack, absl::string_view needle) {
+  return haystack.find(needle) != absl::string_view::npos;
+}
+
+class ZPagesServerTest : public ::testing::Test {
+ protected:
+  void SetUp() override { ASSERT_TRUE(server_.Start()); }
+
+  std::string Get(absl::string_view path) {
+    return ::opencensus::zpages::Get(server_.port(), path);
+  }
+
+  ZPagesServer server_{ZPagesServer::Options()};
+};
+
+TEST_F(ZPagesServerTest, Index) {
+  const std::string page = Get("/");
+  EXPECT_EQ(0, page.find("HTTP/1.1 200 OK\r\n"));
+  EXPECT_TRUE(Contains(page, "href=\"/tracez\""));
+  EXPECT_TRUE(Contains(page, "href=\"/statsz\""));
+  EXPECT_EQ(0, Get("/nothing").find("HTTP/1.1 404 Not Found\r\n"));
+}
+
+TEST_F(ZPagesServerTest, Tracez) {
+  trace::exporter::RunningSpanStore::Enable();
+  trace::AlwaysSampler sampler;
+  const trace::StartSpanOptions options = {&sampler};
+  auto running = trace::Span::StartSpan("zpages<&>", nullptr, options);
+  auto ended = trace::Span::StartSpan("zpages<&>", nullptr, options);
+  ended.AddAnnotation("An annotation");
+  ended.End();
+  auto failed = trace::Span::StartSpan("zpages<&>", nullptr, options);
+  failed.SetStatus(trace::StatusCode::NOT_FOUND, "missing");
+  failed.End();
+
+  const std::string summary = Get("/tracez");
+  EXPECT_TRUE(Contains(summary, "<td>zpages&lt;&amp;&gt;</td>"));
+  EXPECT_TRUE(Contains(summary,
+                       "href=\"/tracez?zspanname=zpages%3C%26%3E&amp;"
+                       "ztype=0\">1</a>"));
+  EXPECT_TRUE(Contains(summary,
+                       "href=\"/tracez?zspanname=zpages%3C%26%3E&amp;"
+                       "ztype=1&amp;zsubtype=0\">1</a>"));
+  EXPECT_TRUE(Contains(summary,
+                       "href=\"/tracez?zspanname=zpages%3C%26%3E&amp;"
+                       "ztype=2\">1</a>"));
+
+  const std::string running_list =
+      Get("/tracez?zspanname=zpages%3C%26%3E&ztype=0");
+  EXPECT_TRUE(Contains(running_list, running.context().span_id().ToHex()));
+  EXPECT_FALSE(Contains(running_list, ended.context().span_id().ToHex()));
+
+  const std::string latency_list =
+      Get("/tracez?zspanname=zpages%3C%26%3E&ztype=1&zsubtype=0");
+  EXPECT_TRUE(Contains(latency_list, ended.context().span_id().ToHex()));
+  EXPECT_TRUE(Contains(latency_list, "An annotation"));
+
+  const std::string error_list =
+      Get("/tracez?zspanname=zpages%3C%26%3E&ztype=2");
+  EXPECT_TRUE(Contains(error_list, failed.context().span_id().ToHex()));
+  EXPECT_TRUE(Contains(error_list, "NOT_FOUND: missing"));
+
+  EXPECT_TRUE(Contains(Get("/tracez?zspanname=x&ztype=1&zsubtype=9"),
+                       "Invalid ztype or zsubtype"));
+  running.End();
+}
+
+TEST_F(ZPagesServerTest, Statsz) {
+  const stats::MeasureInt measure =
+      stats::MeasureRegistry::RegisterInt("zpages_test/measure", "By", "");
+  stats::ViewDescriptor view;
+  view.set_name("zpages_test/view");
+  view.set_measure("zpages_test/measure");
+  view.set_aggregation(stats::Aggregation::Sum());
+  view.add_column("key");
+  view.set_description("A <test> view");
+  stats::StatsExporter::AddView(view);
+  stats::Record({{measure, 3}}, {{"key", "value1"}});
+  stats::Record({{measure, 4}}, {{"key", "value2"}});
+  stats::Record({{measure, 5}}, {{"key", "value2"}});
+
+  const std::string page = Get("/statsz");
+  EXPECT_TRUE(Contains(page, "<h2>zpages_test/view</h2>"));
+  EXPECT_TRUE(Contains(page, "A &lt;test&gt; view"));
+  EXPECT_TRUE(Contains(page, "<th>key</th><th>Value</th></tr>\n"
+                             "<tr><td>value1</td><td class=\"num\">3</td>"
+                             "</tr>\n<tr><td>value2</td><td class=\"num\">9"
+                             "</td></tr>\n"));
+  stats::StatsExporter::RemoveView("zpages_test/view");
+}
+
+}  // namespace
+}  // namespace zpages
+}  // namespace opencensus
@@ -0,0 +1,74 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_ZPAGES_ZPAGES_SERVER_H_
+#define OPENCENSUS_ZPAGES_ZPAGES_SERVER_H_
+
+#include <memory>
+
+#include "absl/time/time.h"
+
+namespace opencensus {
+namespace zpages {
+
+class HttpServer;
+
+// ZPagesServer serves in-process debug pages over HTTP, on 127.0.0.1 only:
+//   /tracez  For each span name: running spans, and the spans sampled by
+//            LocalSpanStore per latency bucket and with errors.
+//   /statsz  The current data of the views registered with StatsExporter.
+//
+// Pages are rendered on the server's own thread, never on application threads
+// or the shared background executor, from the snapshots returned by the
+// stores' query methods, so no library lock is held while a page is written.
+// They are streamed to the client as they are rendered, so a page with a very
+// large number of rows needs no more than a small fixed buffer.
+//
+// Running spans are only listed if RunningSpanStore::Enable() has been called.
+//
+// Example:
+//   opencensus::zpages::ZPagesServer server({8080});
+//   server.Start();
+class ZPagesServer {
+ public:
+  struct Options {
+    // The port to listen on. 0 picks a free port; see port().
+    int port = 0;
+    // The maximum number of spans in a list.
+    int max_spans = 100000;
+    // Reading a request and each write of the response time out after this.
+    absl::Duration io_timeout = absl::Seconds(10);
+  };
+
+  explicit ZPagesServer(const Options& options);
+  // Stops the server.
+  ~ZPagesServer();
+
+  ZPagesServer(const ZPagesServer&) = delete;
+  ZPagesServer& operator=(const ZPagesServer&) = delete;
+
+  // Starts serving. Returns false if the port can't be bound.
+  bool Start();
+
+  // The port the server listens on, once started.
+  int port() const;
+
+ private:
+  std::unique_ptr<HttpServer> server_;
+};
+
+}  // namespace zpages
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_ZPAGES_ZPAGES_SERVER_H_